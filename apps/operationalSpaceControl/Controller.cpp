@@ -81,16 +81,17 @@ void Controller::update(const Eigen::Vector3d& _targetPosition)
   // Get equation of motions
   Eigen::Vector3d x    = mEndEffector->getTransform().translation();
   Eigen::Vector3d dx   = mEndEffector->getLinearVelocity();
-  Eigen::MatrixXd invM = mRobot->getInvMassMatrix();                   // n x n
   Eigen::VectorXd Cg   = mRobot->getCoriolisAndGravityForces();        // n x 1
   math::LinearJacobian Jv   = mEndEffector->getLinearJacobian();       // 3 x n
   math::LinearJacobian dJv  = mEndEffector->getLinearJacobianDeriv();  // 3 x n
   Eigen::VectorXd dq        = mRobot->getVelocities();                 // n x 1
 
-  // Compute operational space values
-  Eigen::MatrixXd A = Jv*invM;                 // 3 x n
+  // Compute operational space values. Since the mass matrix is symmetric,
+  // Jv*invM is the transpose of invM*Jv^T, which doesn't require forming invM.
+  Eigen::MatrixXd A
+      = mRobot->multiplyInvMassMatrix(Jv.transpose()).transpose(); // 3 x n
   Eigen::Vector3d b = /*-(A*Cg) + */dJv*dq;    // 3 x 1
-  Eigen::MatrixXd M2 = Jv*invM*Jv.transpose(); // 3 x 3
+  Eigen::MatrixXd M2 = A*Jv.transpose();       // 3 x 3
 
   // Compute virtual operational space spring force at the end effector
   Eigen::Vector3d f = -mKp*(x - _targetPosition) - mKv*dx;
@@ -43,6 +43,7 @@
 #include "dart/dynamics/Joint.h"
 #include "dart/simulation/World.h"
 #include "dart/utils/SkelParser.h"
+#include "dart/utils/sdf/SdfParser.h"
 #include "dart/math/Helpers.h"
 #include "dart/config.h"
 
@@ -173,6 +174,128 @@ void print_results(const std::vector<double>& result)
   std::cout << "Std Dev: " << stddev << "\n";
 }
 
+void randomizePositions(dart::dynamics::Skeleton* skel)
+{
+  for(size_t i=0; i<skel->getNumDofs(); ++i)
+  {
+    dart::dynamics::DegreeOfFreedom* dof = skel->getDof(i);
+    dof->setPosition( dart::math::random(
+                        std::max(dof->getPositionLowerLimit(),-1.0),
+                        std::min(dof->getPositionUpperLimit(), 1.0)) );
+  }
+}
+
+// Compute the mass matrix one column at a time by running the public inverse
+// dynamics with a unit acceleration for each column. This is a reference for
+// the column-by-column approach, not the previous implementation of
+// getMassMatrix(), which reused the cached body quantities across the columns
+// and skipped the bodies below the joint of each column. Each inverse dynamics
+// pass here also recomputes the velocities and bias forces of the whole tree,
+// so the timings overstate the speedup over the previous implementation.
+double testInverseDynamicsMassMatrixSpeed(dart::dynamics::Skeleton* skel,
+                                          size_t numTests=1000)
+{
+  if(NULL==skel)
+    return 0;
+
+  const size_t dof = skel->getNumDofs();
+  const Eigen::Vector3d gravity = skel->getGravity();
+  skel->setGravity(Eigen::Vector3d::Zero());
+  skel->resetVelocities();
+
+  Eigen::MatrixXd M(dof, dof);
+  Eigen::VectorXd e = Eigen::VectorXd::Zero(dof);
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  for(size_t i=0; i<numTests; ++i)
+  {
+    randomizePositions(skel);
+
+    for(size_t j=0; j<dof; ++j)
+    {
+      e[j] = 1.0;
+      skel->setAccelerations(e);
+      skel->computeInverseDynamics();
+      M.col(j) = skel->getForces();
+      e[j] = 0.0;
+    }
+  }
+
+  end = std::chrono::system_clock::now();
+
+  // Make sure that both methods agree
+  const double error = (M - skel->getMassMatrix()).norm();
+  if(error > 1e-6)
+    std::cout << "Mass matrices differ by " << error << std::endl;
+
+  skel->setGravity(gravity);
+  skel->resetAccelerations();
+
+  std::chrono::duration<double> elapsed_seconds = end-start;
+  return elapsed_seconds.count();
+}
+
+double testCompositeMassMatrixSpeed(dart::dynamics::Skeleton* skel,
+                                    size_t numTests=1000)
+{
+  if(NULL==skel)
+    return 0;
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  for(size_t i=0; i<numTests; ++i)
+  {
+    randomizePositions(skel);
+    skel->getMassMatrix();
+  }
+
+  end = std::chrono::system_clock::now();
+
+  std::chrono::duration<double> elapsed_seconds = end-start;
+  return elapsed_seconds.count();
+}
+
+void runMassMatrixTest()
+{
+  std::vector<dart::simulation::World*> worlds;
+  worlds.push_back(dart::utils::SkelParser::readWorld(
+                     DART_DATA_PATH"skel/fullbody1.skel"));
+  worlds.push_back(new dart::simulation::World);
+  worlds.back()->addSkeleton(dart::utils::SdfParser::readSkeleton(
+                               DART_DATA_PATH"sdf/atlas/atlas_v3_no_head.sdf"));
+
+  std::vector<dart::dynamics::Skeleton*> skels;
+  skels.push_back(worlds[0]->getSkeleton("fullbody1"));
+  skels.push_back(worlds[1]->getSkeleton(0));
+
+  for(size_t i=0; i<skels.size(); ++i)
+  {
+    dart::dynamics::Skeleton* skel = skels[i];
+    std::cout << "\n" << skel->getName() << " (" << skel->getNumDofs()
+              << " DOFs)" << std::endl;
+
+    std::vector<double> column_results;
+    std::vector<double> composite_results;
+    for(size_t j=0; j<10; ++j)
+    {
+      column_results.push_back(testInverseDynamicsMassMatrixSpeed(skel));
+      composite_results.push_back(testCompositeMassMatrixSpeed(skel));
+    }
+
+    std::cout << "Column-by-column inverse dynamics (reference)\n";
+    print_results(column_results);
+
+    std::cout << "Composite rigid body algorithm\n";
+    print_results(composite_results);
+  }
+
+  for(size_t i=0; i<worlds.size(); ++i)
+    delete worlds[i];
+}
+
 std::vector<std::string> getSceneFiles()
 {
   std::vector<std::string> scenes;
@@ -214,10 +337,20 @@ std::vector<dart::simulation::World*> getWorlds()
 int main(int argc, char* argv[])
 {
   bool test_kinematics = false;
+  bool test_mass_matrix = false;
   for(int i=1; i<argc; ++i)
   {
     if(std::string(argv[i])=="-k")
       test_kinematics = true;
+    else if(std::string(argv[i])=="-m")
+      test_mass_matrix = true;
+  }
+
+  if(test_mass_matrix)
+  {
+    std::cout << "Testing mass matrix" << std::endl;
+    runMassMatrixTest();
+    return 0;
   }
 
   std::vector<dart::simulation::World*> worlds = getWorlds();
@@ -248,6 +381,9 @@ int main(int argc, char* argv[])
     std::cout << "\nPosition\n";
     print_results(position_results);
 
+    for(size_t i=0; i<worlds.size(); ++i)
+      delete worlds[i];
+
     return 0;
   }
 
@@ -261,4 +397,7 @@ int main(int argc, char* argv[])
 
   std::cout << "\n\n --- Final Dynamics Results --- \n\n";
   print_results(dynamics_results);
+
+  for(size_t i=0; i<worlds.size(); ++i)
+    delete worlds[i];
 }
@@ -39,18 +39,29 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "dart/common/Console.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/Skeleton.h"
+#include "dart/dynamics/SoftBodyNode.h"
 #include "dart/collision/CollisionNode.h"
 
 namespace dart {
 namespace collision {
 
 CollisionDetector::CollisionDetector()
-  : mNumMaxContacts(100) {
+  : mNumMaxContacts(100),
+    mIsQueryDirty(true),
+    mNumThreads(1),
+    mNumMaxContactsPerPair(0),
+    mNumSkippedPairs(0),
+    mNarrowphaseBuffers(1) {
 }
 
 CollisionDetector::~CollisionDetector() {
@@ -128,9 +139,7 @@ void CollisionDetector::addCollisionSkeletonNode(dynamics::BodyNode* _bodyNode,
   // Add the collision node to map (BodyNode -> CollisionNode)
   mBodyCollisionMap[_bodyNode] = collNode;
 
-  // Add collidable pairs for the collision node
-  mCollidablePairs.push_back(
-        std::vector<bool>(mCollisionNodes.size() - 1, true));
+  mIsQueryDirty = true;
 
   if (_isRecursive) {
     for (size_t i = 0; i < _bodyNode->getNumChildBodyNodes(); i++)
@@ -164,17 +173,11 @@ void CollisionDetector::removeCollisionSkeletonNode(
   // Remove collNode-_bodyNode pair from mBodyCollisionMap
   mBodyCollisionMap.erase(_bodyNode);
 
-  // Delete collNode
+  // Delete collNode, which also removes its pair exceptions from the other
+  // collision nodes
   delete collNode;
 
-  // Update mCollidablePairs
-  for (size_t i = iCollNode + 1; i < mCollidablePairs.size(); ++i) {
-    for (size_t j = 0; j < iCollNode; ++j)
-      mCollidablePairs[i-1][j] = mCollidablePairs[i][j];
-    for (size_t j = iCollNode + 1; j < mCollidablePairs[i].size(); ++j)
-      mCollidablePairs[i-1][j-1] = mCollidablePairs[i][j];
-  }
-  mCollidablePairs.pop_back();
+  mIsQueryDirty = true;
 
   if (_isRecursive) {
     for (size_t i = 0; i < _bodyNode->getNumChildBodyNodes(); i++)
@@ -190,6 +193,223 @@ bool CollisionDetector::detectCollision(dynamics::BodyNode* _node1,
                          _calculateContactPoints);
 }
 
+bool CollisionDetector::checkCollision(
+    const std::vector<dynamics::BodyNode*>& _bodyNodes) {
+  if (mIsQueryDirty || _bodyNodes != mQueryBodyNodes)
+    buildQueryPairs(_bodyNodes);
+
+  for (size_t i = 0; i < mQueryPairs.size(); ++i) {
+    QueryPair& pair = mQueryPairs[i];
+
+    // The collidable flags may change between queries, so they are not cached
+    if (!isCollidable(pair.node1, pair.node2))
+      continue;
+
+    const Eigen::Isometry3d& transform1
+        = pair.node1->getBodyNode()->getTransform();
+    const Eigen::Isometry3d& transform2
+        = pair.node2->getBodyNode()->getTransform();
+
+    if (pair.hasResult
+        && pair.transform1.matrix() == transform1.matrix()
+        && pair.transform2.matrix() == transform2.matrix()) {
+      if (pair.isColliding)
+        return true;
+      continue;
+    }
+
+    bool isColliding = detectCollision(pair.node1, pair.node2, false);
+
+    if (pair.isRigid) {
+      pair.hasResult = true;
+      pair.isColliding = isColliding;
+      pair.transform1 = transform1;
+      pair.transform2 = transform2;
+    }
+
+    if (isColliding)
+      return true;
+  }
+
+  return false;
+}
+
+void CollisionDetector::buildReplicaQuery(
+    const std::vector<dynamics::BodyNode*>& _bodyNodes,
+    const dynamics::Skeleton* _skeleton,
+    ReplicaQuery* _query) {
+  _query->skeleton = _skeleton;
+  findQueryPairs(_bodyNodes, &_query->pairs);
+
+  std::map<const dynamics::BodyNode*, int> skeletonIndices;
+  for (size_t i = 0; i < _skeleton->getNumBodyNodes(); ++i)
+    skeletonIndices[_skeleton->getBodyNode(i)] = static_cast<int>(i);
+
+  _query->bodyIndices.resize(_query->pairs.size());
+  _query->transforms.assign(2 * _query->pairs.size(),
+                            Eigen::Isometry3d::Identity());
+  for (size_t i = 0; i < _query->pairs.size(); ++i) {
+    dynamics::BodyNode* bodyNode1 = _query->pairs[i].first->getBodyNode();
+    dynamics::BodyNode* bodyNode2 = _query->pairs[i].second->getBodyNode();
+    std::map<const dynamics::BodyNode*, int>::const_iterator it1
+        = skeletonIndices.find(bodyNode1);
+    std::map<const dynamics::BodyNode*, int>::const_iterator it2
+        = skeletonIndices.find(bodyNode2);
+    _query->bodyIndices[i].first
+        = it1 != skeletonIndices.end() ? it1->second : -1;
+    _query->bodyIndices[i].second
+        = it2 != skeletonIndices.end() ? it2->second : -1;
+
+    // Evaluating a transform updates the body node, so the transforms of the
+    // body nodes that are not replicated are taken here rather than by the
+    // threads that check the query
+    if (_query->bodyIndices[i].first < 0)
+      _query->transforms[2 * i] = bodyNode1->getTransform();
+    if (_query->bodyIndices[i].second < 0)
+      _query->transforms[2 * i + 1] = bodyNode2->getTransform();
+  }
+}
+
+bool CollisionDetector::checkCollision(const ReplicaQuery& _query,
+                                       const dynamics::Skeleton* _replica) {
+  assert(_replica->getNumBodyNodes() == _query.skeleton->getNumBodyNodes());
+
+  for (size_t i = 0; i < _query.pairs.size(); ++i) {
+    CollisionNode* collNode1 = _query.pairs[i].first;
+    CollisionNode* collNode2 = _query.pairs[i].second;
+    if (!isCollidable(collNode1, collNode2))
+      continue;
+
+    int index1 = _query.bodyIndices[i].first;
+    int index2 = _query.bodyIndices[i].second;
+    const Eigen::Isometry3d& transform1
+        = index1 < 0 ? _query.transforms[2 * i]
+                     : _replica->getBodyNode(index1)->getTransform();
+    const Eigen::Isometry3d& transform2
+        = index2 < 0 ? _query.transforms[2 * i + 1]
+                     : _replica->getBodyNode(index2)->getTransform();
+
+    if (checkNodeCollision(collNode1, transform1, collNode2, transform2))
+      return true;
+  }
+
+  return false;
+}
+
+bool CollisionDetector::computeDistance(dynamics::BodyNode* _node1,
+                                        dynamics::BodyNode* _node2,
+                                        DistanceResult* _result) {
+  CollisionNode* collNode1 = getCollisionNode(_node1);
+  CollisionNode* collNode2 = getCollisionNode(_node2);
+  if (collNode1 == NULL || collNode2 == NULL) {
+    dtwarn << "Attempting to compute the distance of a body node that is not "
+           << "in CollisionDetector." << std::endl;
+    return false;
+  }
+
+  return computeNodeDistance(collNode1, _node1->getTransform(),
+                             collNode2, _node2->getTransform(), _result);
+}
+
+void CollisionDetector::computeDistances(
+    dynamics::Skeleton* _skeleton,
+    const std::vector<dynamics::Skeleton*>& _replicas,
+    const std::vector<Eigen::VectorXd>& _configurations,
+    const std::vector<std::pair<dynamics::BodyNode*,
+                                dynamics::BodyNode*> >& _pairs,
+    std::vector<DistanceResult>* _results) {
+  const size_t numPairs = _pairs.size();
+  _results->resize(_configurations.size() * numPairs);
+
+  // Index of the body node of each pair in _skeleton, or -1 if the body node
+  // is not in _skeleton
+  std::map<const dynamics::BodyNode*, int> skeletonIndices;
+  for (size_t i = 0; i < _skeleton->getNumBodyNodes(); ++i)
+    skeletonIndices[_skeleton->getBodyNode(i)] = static_cast<int>(i);
+
+  // The transforms of the other body nodes are evaluated here, because
+  // evaluating them updates the body nodes, which the threads would race on
+  std::vector<CollisionNode*> collNodes(2 * numPairs, NULL);
+  std::vector<int> bodyIndices(2 * numPairs, -1);
+  std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d> >
+      transforms(2 * numPairs, Eigen::Isometry3d::Identity());
+  for (size_t i = 0; i < numPairs; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      dynamics::BodyNode* bodyNode = j == 0 ? _pairs[i].first
+                                            : _pairs[i].second;
+      collNodes[2 * i + j] = getCollisionNode(bodyNode);
+      std::map<const dynamics::BodyNode*, int>::const_iterator it
+          = skeletonIndices.find(bodyNode);
+      if (it != skeletonIndices.end())
+        bodyIndices[2 * i + j] = it->second;
+      else
+        transforms[2 * i + j] = bodyNode->getTransform();
+    }
+  }
+
+  // Without replicas, the configurations are set to _skeleton serially, and
+  // its positions are restored afterwards
+  std::vector<dynamics::Skeleton*> skeletons = _replicas;
+  Eigen::VectorXd positions;
+  if (skeletons.empty()) {
+    skeletons.push_back(_skeleton);
+    positions = _skeleton->getPositions();
+  }
+  for (size_t i = 0; i < skeletons.size(); ++i) {
+    assert(skeletons[i]->getNumBodyNodes() == _skeleton->getNumBodyNodes());
+    assert(skeletons[i]->getNumDofs() == _skeleton->getNumDofs());
+  }
+
+  const int numConfigurations = static_cast<int>(_configurations.size());
+#ifdef _OPENMP
+  const int numThreads
+      = static_cast<int>(std::min(mNumThreads, skeletons.size()));
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numConfigurations; ++i) {
+#ifdef _OPENMP
+    dynamics::Skeleton* skeleton = skeletons[omp_get_thread_num()];
+#else
+    dynamics::Skeleton* skeleton = skeletons[0];
+#endif
+    skeleton->setPositions(_configurations[i]);
+    skeleton->computeForwardKinematics(true, false, false);
+
+    for (size_t j = 0; j < numPairs; ++j) {
+      DistanceResult& result = (*_results)[i * numPairs + j];
+      result.distance = std::numeric_limits<double>::infinity();
+      result.point1.setZero();
+      result.point2.setZero();
+      result.bodyNode1 = _pairs[j].first;
+      result.bodyNode2 = _pairs[j].second;
+
+      CollisionNode* collNode1 = collNodes[2 * j];
+      CollisionNode* collNode2 = collNodes[2 * j + 1];
+      if (collNode1 == NULL || collNode2 == NULL)
+        continue;
+
+      int index1 = bodyIndices[2 * j];
+      int index2 = bodyIndices[2 * j + 1];
+      const Eigen::Isometry3d& transform1
+          = index1 < 0 ? transforms[2 * j]
+                       : skeleton->getBodyNode(index1)->getTransform();
+      const Eigen::Isometry3d& transform2
+          = index2 < 0 ? transforms[2 * j + 1]
+                       : skeleton->getBodyNode(index2)->getTransform();
+
+      if (!computeNodeDistance(collNode1, transform1, collNode2, transform2,
+                               &result))
+        result.distance = std::numeric_limits<double>::infinity();
+    }
+  }
+
+  if (_replicas.empty()) {
+    _skeleton->setPositions(positions);
+    _skeleton->computeForwardKinematics(true, false, false);
+  }
+}
+
 size_t CollisionDetector::getNumContacts() {
   return mContacts.size();
 }
@@ -215,7 +435,7 @@ void CollisionDetector::enablePair(dynamics::BodyNode* _node1,
   CollisionNode* collisionNode1 = getCollisionNode(_node1);
   CollisionNode* collisionNode2 = getCollisionNode(_node2);
   if (collisionNode1 && collisionNode2)
-    setPairCollidable(collisionNode1, collisionNode2, true);
+    collisionNode1->setPairException(collisionNode2, true);
 }
 
 void CollisionDetector::disablePair(dynamics::BodyNode* _node1,
@@ -223,18 +443,137 @@ void CollisionDetector::disablePair(dynamics::BodyNode* _node1,
   CollisionNode* collisionNode1 = getCollisionNode(_node1);
   CollisionNode* collisionNode2 = getCollisionNode(_node2);
   if (collisionNode1 && collisionNode2)
-    setPairCollidable(collisionNode1, collisionNode2, false);
+    collisionNode1->setPairException(collisionNode2, false);
+}
+
+void CollisionDetector::resetPair(dynamics::BodyNode* _node1,
+                                  dynamics::BodyNode* _node2) {
+  CollisionNode* collisionNode1 = getCollisionNode(_node1);
+  CollisionNode* collisionNode2 = getCollisionNode(_node2);
+  if (collisionNode1 && collisionNode2)
+    collisionNode1->removePairException(collisionNode2);
+}
+
+void CollisionDetector::setCollisionFilter(dynamics::BodyNode* _bodyNode,
+                                           unsigned int _categoryBits,
+                                           unsigned int _maskBits) {
+  CollisionNode* collisionNode = getCollisionNode(_bodyNode);
+  if (collisionNode == NULL) {
+    dtwarn << "Body node [" << _bodyNode->getName() << "] is not in "
+           << "CollisionDetector." << std::endl;
+    return;
+  }
+
+  collisionNode->setCategoryBits(_categoryBits);
+  collisionNode->setMaskBits(_maskBits);
 }
 
 //==============================================================================
+void CollisionDetector::setNumThreads(size_t _numThreads) {
+  if (_numThreads == 0) {
+    dtwarn << "Attempting to set the number of threads to zero. Using a single "
+           << "thread instead." << std::endl;
+    _numThreads = 1;
+  }
+
+#ifndef _OPENMP
+  if (_numThreads > 1) {
+    dtwarn << "DART is built without OpenMP. Only a single thread will be "
+           << "used." << std::endl;
+  }
+#endif
+
+  mNumThreads = _numThreads;
+  mNarrowphaseBuffers.resize(mNumThreads);
+}
+
+size_t CollisionDetector::getNumThreads() const {
+  return mNumThreads;
+}
+
+void CollisionDetector::setNumMaxContactsPerPair(size_t _numMaxContacts) {
+  mNumMaxContactsPerPair = _numMaxContacts;
+}
+
+size_t CollisionDetector::getNumMaxContactsPerPair() const {
+  return mNumMaxContactsPerPair;
+}
+
+size_t CollisionDetector::getNumSkippedPairs() const {
+  return mNumSkippedPairs;
+}
+
+void CollisionDetector::beginNarrowphase(size_t _numPairs) {
+  for (size_t i = 0; i < mNarrowphaseBuffers.size(); ++i)
+    mNarrowphaseBuffers[i].contacts.clear();
+
+  mNarrowphaseRanges.resize(_numPairs);
+}
+
+size_t CollisionDetector::getNarrowphaseBufferIndex() const {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+void CollisionDetector::endNarrowphasePair(size_t _pair, size_t _buffer,
+                                           size_t _begin) {
+  std::vector<Contact>& contacts = mNarrowphaseBuffers[_buffer].contacts;
+  mNarrowphaseBuffers[_buffer].reducer.removeDuplicateContacts(&contacts,
+                                                               _begin, 1e-3);
+  size_t end = contacts.size();
+
+  mNarrowphaseRanges[_pair].buffer = _buffer;
+  mNarrowphaseRanges[_pair].begin = _begin;
+  mNarrowphaseRanges[_pair].end = end;
+}
+
+void CollisionDetector::endNarrowphase() {
+  // Each pair is checked by a single thread, so merging the pairs in their
+  // order gives the same contacts as the serial narrowphase. The candidate
+  // pairs are sorted by the collision nodes, so the contacts of a body pair
+  // are consecutive.
+  size_t pairBegin = mContacts.size();
+  for (size_t i = 0; i < mNarrowphaseRanges.size(); ++i) {
+    const NarrowphaseRange& range = mNarrowphaseRanges[i];
+    if (range.begin == range.end)
+      continue;
+
+    const std::vector<Contact>& contacts
+        = mNarrowphaseBuffers[range.buffer].contacts;
+    if (pairBegin < mContacts.size()
+        && (mContacts[pairBegin].bodyNode1 != contacts[range.begin].bodyNode1
+            || mContacts[pairBegin].bodyNode2
+               != contacts[range.begin].bodyNode2)) {
+      limitContacts(pairBegin);
+      pairBegin = mContacts.size();
+    }
+    mContacts.insert(mContacts.end(), contacts.begin() + range.begin,
+                     contacts.begin() + range.end);
+  }
+  limitContacts(pairBegin);
+}
+
+void CollisionDetector::limitContacts(size_t _begin) {
+  mContactReducer.limitContacts(&mContacts, _begin, mNumMaxContactsPerPair);
+}
+
 bool CollisionDetector::isCollidable(const CollisionNode* _node1,
                                      const CollisionNode* _node2)
 {
   dynamics::BodyNode* bn1 = _node1->getBodyNode();
   dynamics::BodyNode* bn2 = _node2->getBodyNode();
 
-  if (!getPairCollidable(_node1, _node2))
+  // Explicit pair exceptions take precedence over the categories and masks
+  bool isPairCollidable;
+  if (_node1->getPairException(_node2, &isPairCollidable)) {
+    if (!isPairCollidable)
+      return false;
+  } else if (!_node1->isMaskCollidable(_node2)) {
     return false;
+  }
 
   if (!bn1->isCollidable() || !bn2->isCollidable())
     return false;
@@ -259,61 +598,92 @@ bool CollisionDetector::isCollidable(const CollisionNode* _node1,
 }
 
 //==============================================================================
-bool CollisionDetector::containSkeleton(const dynamics::Skeleton* _skeleton)
-{
-  for (std::vector<dynamics::Skeleton*>::const_iterator it = mSkeletons.begin();
-       it != mSkeletons.end(); ++it)
-  {
-    if ((*it) == _skeleton)
-      return true;
-  }
-
+bool CollisionDetector::computeNodeDistance(
+    CollisionNode* /*_node1*/, const Eigen::Isometry3d& /*_transform1*/,
+    CollisionNode* /*_node2*/, const Eigen::Isometry3d& /*_transform2*/,
+    DistanceResult* /*_result*/) {
   return false;
 }
 
-bool CollisionDetector::getPairCollidable(const CollisionNode* _node1,
-                                          const CollisionNode* _node2)
-{
-  assert(_node1 != _node2);
+//==============================================================================
+bool CollisionDetector::checkNodeCollision(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2) {
+  DistanceResult result;
+  if (!computeNodeDistance(_node1, _transform1, _node2, _transform2, &result))
+    return false;
 
-  size_t index1 = _node1->getIndex();
-  size_t index2 = _node2->getIndex();
+  return result.distance <= 0.0;
+}
 
-  if (index1 < index2)
-    std::swap(index1, index2);
+//==============================================================================
+void CollisionDetector::buildQueryPairs(
+    const std::vector<dynamics::BodyNode*>& _bodyNodes) {
+  mQueryBodyNodes = _bodyNodes;
+  mQueryPairs.clear();
+  mIsQueryDirty = false;
+
+  std::vector<std::pair<CollisionNode*, CollisionNode*> > pairs;
+  findQueryPairs(_bodyNodes, &pairs);
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    QueryPair pair;
+    pair.node1 = pairs[i].first;
+    pair.node2 = pairs[i].second;
+    pair.isRigid
+        = !dynamic_cast<dynamics::SoftBodyNode*>(pair.node1->getBodyNode())
+          && !dynamic_cast<dynamics::SoftBodyNode*>(pair.node2->getBodyNode());
+    pair.hasResult = false;
+    pair.isColliding = false;
+    mQueryPairs.push_back(pair);
+  }
+}
 
-  // TODO(JS): Workaround
-  // If this fuction is called before all the body nodes in the world are not
-  // added to the collision detector than it cause seg fault. We just return
-  // false in that case.
-  if (index1 > mCollidablePairs.size() - 1
-      || index2 > mCollidablePairs.size() - 1)
-    return true;
+//==============================================================================
+void CollisionDetector::findQueryPairs(
+    const std::vector<dynamics::BodyNode*>& _bodyNodes,
+    std::vector<std::pair<CollisionNode*, CollisionNode*> >* _pairs) {
+  _pairs->clear();
+
+  // Order of each collision node in the queried body nodes, or -1 if the body
+  // node is not queried
+  std::vector<int> queryOrder(mCollisionNodes.size(), -1);
+  for (size_t i = 0; i < _bodyNodes.size(); ++i) {
+    CollisionNode* collNode = getCollisionNode(_bodyNodes[i]);
+    if (collNode && queryOrder[collNode->getIndex()] < 0)
+      queryOrder[collNode->getIndex()] = static_cast<int>(i);
+  }
 
-  return mCollidablePairs[index1][index2];
+  // Pair each queried node with the nodes that are not queried and with the
+  // queried nodes that come after it
+  for (size_t i = 0; i < mCollisionNodes.size(); ++i) {
+    CollisionNode* collNode1 = mCollisionNodes[i];
+    int order1 = queryOrder[i];
+    if (order1 < 0)
+      continue;
+
+    for (size_t j = 0; j < mCollisionNodes.size(); ++j) {
+      CollisionNode* collNode2 = mCollisionNodes[j];
+      int order2 = queryOrder[j];
+      if (i == j || (order2 >= 0 && order2 < order1))
+        continue;
+
+      _pairs->push_back(std::make_pair(collNode1, collNode2));
+    }
+  }
 }
 
-void CollisionDetector::setPairCollidable(const CollisionNode* _node1,
-                                          const CollisionNode* _node2,
-                                          bool _val)
+//==============================================================================
+bool CollisionDetector::containSkeleton(const dynamics::Skeleton* _skeleton)
 {
-  assert(_node1 != _node2);
-
-  size_t index1 = _node1->getIndex();
-  size_t index2 = _node2->getIndex();
-
-  if (index1 < index2)
-    std::swap(index1, index2);
-
-  // TODO(JS): Workaround
-  // If this fuction is called before all the body nodes in the world are not
-  // added to the collision detector than it cause seg fault. We just return in
-  // that case.
-  if (index1 > mCollidablePairs.size() - 1
-      || index2 > mCollidablePairs.size() - 1)
-    return;
+  for (std::vector<dynamics::Skeleton*>::const_iterator it = mSkeletons.begin();
+       it != mSkeletons.end(); ++it)
+  {
+    if ((*it) == _skeleton)
+      return true;
+  }
 
-  mCollidablePairs[index1][index2] = _val;
+  return false;
 }
 
 bool CollisionDetector::isAdjacentBodies(const dynamics::BodyNode* _bodyNode1,
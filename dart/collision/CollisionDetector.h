@@ -40,10 +40,13 @@
 
 #include <vector>
 #include <map>
+#include <utility>
 
 #include <Eigen/Dense>
+#include <Eigen/StdVector>
 
 #include "dart/collision/CollisionNode.h"
+#include "dart/collision/ContactReducer.h"
 
 namespace dart {
 namespace dynamics {
@@ -61,6 +64,20 @@ struct Contact {
   // To get byte-aligned Eigen vectors
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
+  /// Constructor. The triangle indices are -1 unless the detector that finds
+  /// the contact sets them.
+  Contact()
+    : bodyNode1(NULL),
+      bodyNode2(NULL),
+      shape1(NULL),
+      shape2(NULL),
+      penetrationDepth(0.0),
+      triID1(-1),
+      triID2(-1),
+      userData(NULL)
+  {
+  }
+
   /// Contact point w.r.t. the world frame
   Eigen::Vector3d point;
 
@@ -89,11 +106,11 @@ struct Contact {
   double penetrationDepth;
 
   // TODO(JS): triID1 will be deprecated when we don't use fcl_mesh
-  /// \brief
+  /// Index of the colliding triangle of the first shape, or -1
   int triID1;
 
   // TODO(JS): triID2 will be deprecated when we don't use fcl_mesh
-  /// \brief
+  /// Index of the colliding triangle of the second shape, or -1
   int triID2;
 
   // TODO(JS): userData is an experimental variable.
@@ -101,6 +118,51 @@ struct Contact {
   void* userData;
 };
 
+/// Result of a distance query between two body nodes
+struct DistanceResult {
+  // To get byte-aligned Eigen vectors
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// Minimum distance between the collision shapes of the body nodes. The
+  /// distance is negative if the shapes intersect, and its magnitude is the
+  /// penetration depth.
+  double distance;
+
+  /// Point of bodyNode1 closest to bodyNode2 w.r.t. the world frame
+  Eigen::Vector3d point1;
+
+  /// Point of bodyNode2 closest to bodyNode1 w.r.t. the world frame
+  Eigen::Vector3d point2;
+
+  /// First body node
+  dynamics::BodyNode* bodyNode1;
+
+  /// Second body node
+  dynamics::BodyNode* bodyNode2;
+};
+
+/// Pairs of collision nodes that CollisionDetector::checkCollision() checks
+/// for a set of body nodes of a skeleton, which several threads can check at
+/// the same time, each with its own replica of the skeleton
+struct ReplicaQuery {
+  /// Skeleton whose body nodes are placed at the transforms of a replica
+  const dynamics::Skeleton* skeleton;
+
+  /// Collision nodes of each pair
+  std::vector<std::pair<CollisionNode*, CollisionNode*> > pairs;
+
+  /// Indices of the body nodes of each pair in skeleton, or -1 for the body
+  /// nodes that are not in skeleton
+  std::vector<std::pair<int, int> > bodyIndices;
+
+  /// Transforms of the body nodes that are not in skeleton when the query was
+  /// built. The transforms of the first and the second body node of pair i are
+  /// at 2 * i and 2 * i + 1, so that checking does not read the body nodes,
+  /// whose transforms are evaluated lazily.
+  std::vector<Eigen::Isometry3d,
+              Eigen::aligned_allocator<Eigen::Isometry3d> > transforms;
+};
+
 /// \brief class CollisionDetector
 class CollisionDetector
 {
@@ -133,12 +195,25 @@ public:
   /// \brief
   virtual CollisionNode* createCollisionNode(dynamics::BodyNode* _bodyNode) = 0;
 
-  /// \brief
+  /// \brief Let _node1 and _node2 collide regardless of their collision
+  /// categories and masks
   void enablePair(dynamics::BodyNode* _node1, dynamics::BodyNode* _node2);
 
-  /// \brief
+  /// \brief Keep _node1 and _node2 from colliding regardless of their
+  /// collision categories and masks
   void disablePair(dynamics::BodyNode* _node1, dynamics::BodyNode* _node2);
 
+  /// \brief Let the collision categories and masks of _node1 and _node2 decide
+  /// whether they collide again
+  void resetPair(dynamics::BodyNode* _node1, dynamics::BodyNode* _node2);
+
+  /// \brief Set the collision categories _bodyNode belongs to and the ones it
+  /// collides with as bitfields. Two body nodes collide only if the category
+  /// of each one is in the mask of the other, unless the pair is enabled or
+  /// disabled explicitly. The body node must be added to the detector first.
+  void setCollisionFilter(dynamics::BodyNode* _bodyNode,
+                          unsigned int _categoryBits, unsigned int _maskBits);
+
   /// Return true if there exists at least one contact
   /// \param[in] _checkAllCollision True to detect every collisions
   /// \param[in] _calculateContactPoints True to get contact points
@@ -150,6 +225,59 @@ public:
   bool detectCollision(dynamics::BodyNode* _node1, dynamics::BodyNode* _node2,
                        bool _calculateContactPoints);
 
+  /// \brief Return true if any of _bodyNodes collides with another body node,
+  /// which is faster than detectCollision() when only a few bodies move, as in
+  /// motion planning. Pairs of body nodes that are not in _bodyNodes are not
+  /// checked, contacts are not computed, and the query stops at the first
+  /// collision. The result of a pair is reused as long as the transforms of
+  /// its rigid body nodes do not change, so the pairs of bodies that the
+  /// planner does not move are checked only once.
+  bool checkCollision(const std::vector<dynamics::BodyNode*>& _bodyNodes);
+
+  /// \brief Build into _query the pairs that checkCollision() checks for
+  /// _bodyNodes, whose body nodes of _skeleton are placed at the transforms of
+  /// a replica of _skeleton. The other body nodes stay at their transforms
+  /// when the query is built. The query is valid until collision nodes are
+  /// added or removed, or the other body nodes move.
+  void buildReplicaQuery(const std::vector<dynamics::BodyNode*>& _bodyNodes,
+                         const dynamics::Skeleton* _skeleton,
+                         ReplicaQuery* _query);
+
+  /// \brief Return true if any pair of _query collides when the body nodes of
+  /// the skeleton of _query are placed at the transforms of the corresponding
+  /// body nodes of _replica, which must have the same structure. Unlike
+  /// checkCollision(), this only reads the detector and caches nothing, so
+  /// several threads can check at the same time with their own replicas as
+  /// long as the detector is not modified meanwhile.
+  bool checkCollision(const ReplicaQuery& _query,
+                      const dynamics::Skeleton* _replica);
+
+  /// \brief Compute the minimum distance between the collision shapes of
+  /// _node1 and _node2 at their current transforms. Return false if the
+  /// detector does not support distance queries for their shapes.
+  bool computeDistance(dynamics::BodyNode* _node1, dynamics::BodyNode* _node2,
+                       DistanceResult* _result);
+
+  /// \brief Compute the minimum distances between the body node pairs _pairs
+  /// for each configuration in _configurations, which are the positions of
+  /// _skeleton. The configurations are split among the threads of the
+  /// detector, and each thread sets the positions of its own skeleton in
+  /// _replicas, which must have the same structure as _skeleton. Without
+  /// replicas, the configurations are set to _skeleton itself, whose positions
+  /// are restored before returning. Body nodes of the pairs that are not in
+  /// _skeleton stay at their current transforms, which are read before the
+  /// threads start.
+  /// _results holds the results of the pairs of the first configuration,
+  /// followed by the ones of the second configuration, and so on. The
+  /// distance of a pair whose shapes are not supported is infinity.
+  void computeDistances(
+      dynamics::Skeleton* _skeleton,
+      const std::vector<dynamics::Skeleton*>& _replicas,
+      const std::vector<Eigen::VectorXd>& _configurations,
+      const std::vector<std::pair<dynamics::BodyNode*,
+                                  dynamics::BodyNode*> >& _pairs,
+      std::vector<DistanceResult>* _results);
+
   /// \brief
   size_t getNumContacts();
 
@@ -168,11 +296,96 @@ public:
   /// \brief
   bool isCollidable(const CollisionNode* _node1, const CollisionNode* _node2);
 
+  /// \brief Set the number of threads used to run the narrowphase on the
+  /// candidate pairs of the broadphase. The contacts are reported in the same
+  /// order regardless of the number of threads. The default is 1 (serial).
+  void setNumThreads(size_t _numThreads);
+
+  /// \brief Get the number of threads used to run the narrowphase
+  size_t getNumThreads() const;
+
+  /// \brief Set the maximum number of contacts between two body nodes. When a
+  /// pair has more contacts, the deepest one and the ones spanning the largest
+  /// area of the contact region are kept, which keeps the LCP small. The
+  /// default is 0, which does not limit the number of contacts.
+  void setNumMaxContactsPerPair(size_t _numMaxContacts);
+
+  /// \brief Get the maximum number of contacts between two body nodes
+  size_t getNumMaxContactsPerPair() const;
+
+  /// \brief Get the number of candidate pairs of the last detectCollision()
+  /// whose narrowphase was skipped because their last separation distance
+  /// exceeded their relative motion since then. Only detectors that cache the
+  /// separation of the pairs skip any.
+  size_t getNumSkippedPairs() const;
+
 protected:
+  /// \brief Contacts found by a narrowphase thread
+  struct NarrowphaseBuffer {
+    /// \brief Contacts of the candidate pairs checked by the thread
+    std::vector<Contact> contacts;
+
+    /// \brief Reducer that removes the duplicate contacts of a pair
+    ContactReducer reducer;
+  };
+
+  /// \brief Contacts of a candidate pair in a narrowphase buffer
+  struct NarrowphaseRange {
+    /// \brief Index of the buffer
+    size_t buffer;
+
+    /// \brief Index of the first contact of the pair in the buffer
+    size_t begin;
+
+    /// \brief One past the index of the last contact of the pair
+    size_t end;
+  };
+
   /// \brief
   virtual bool detectCollision(CollisionNode* _node1, CollisionNode* _node2,
                                bool _calculateContactPoints) = 0;
 
+  /// \brief Compute the minimum distance between the collision shapes of
+  /// _node1 and _node2 placed at the body transforms _transform1 and
+  /// _transform2. This is called by several threads at the same time, so it
+  /// must not modify the detector or the collision nodes. Return false if the
+  /// shapes are not supported, which is the default.
+  virtual bool computeNodeDistance(CollisionNode* _node1,
+                                   const Eigen::Isometry3d& _transform1,
+                                   CollisionNode* _node2,
+                                   const Eigen::Isometry3d& _transform2,
+                                   DistanceResult* _result);
+
+  /// \brief Return true if the collision shapes of _node1 and _node2 placed at
+  /// the body transforms _transform1 and _transform2 intersect. This is called
+  /// by several threads at the same time, so it must not modify the detector
+  /// or the collision nodes. The default tells it from computeNodeDistance(),
+  /// so the shapes that computeNodeDistance() does not support never collide.
+  virtual bool checkNodeCollision(CollisionNode* _node1,
+                                  const Eigen::Isometry3d& _transform1,
+                                  CollisionNode* _node2,
+                                  const Eigen::Isometry3d& _transform2);
+
+  /// \brief Clear the narrowphase buffers before checking _numPairs candidate
+  /// pairs
+  void beginNarrowphase(size_t _numPairs);
+
+  /// \brief Return the index of the narrowphase buffer of the calling thread
+  size_t getNarrowphaseBufferIndex() const;
+
+  /// \brief Remove the duplicate contacts of candidate pair _pair, which were
+  /// added to the narrowphase buffer _buffer from index _begin on, and record
+  /// the contacts of the pair
+  void endNarrowphasePair(size_t _pair, size_t _buffer, size_t _begin);
+
+  /// \brief Append the contacts of all the candidate pairs to mContacts in the
+  /// order of the pairs
+  void endNarrowphase();
+
+  /// \brief Limit the contacts of mContacts from index _begin on, which are
+  /// the contacts of a single body pair, to mNumMaxContactsPerPair
+  void limitContacts(size_t _begin);
+
   /// \brief
   std::vector<Contact> mContacts;
 
@@ -185,18 +398,69 @@ protected:
   /// \brief Skeleton array
   std::vector<dynamics::Skeleton*> mSkeletons;
 
+  /// \brief Whether the query pairs need to be rebuilt because collision nodes
+  /// were added or removed
+  bool mIsQueryDirty;
+
+  /// \brief Number of threads used to run the narrowphase
+  size_t mNumThreads;
+
+  /// \brief Maximum number of contacts between two body nodes, or 0
+  size_t mNumMaxContactsPerPair;
+
+  /// \brief Number of candidate pairs skipped by the last detectCollision()
+  size_t mNumSkippedPairs;
+
+  /// \brief Reducer that limits the contacts of body pairs in mContacts
+  ContactReducer mContactReducer;
+
+  /// \brief Narrowphase buffers, one per thread
+  std::vector<NarrowphaseBuffer> mNarrowphaseBuffers;
+
+  /// \brief Contacts of each candidate pair in the narrowphase buffers
+  std::vector<NarrowphaseRange> mNarrowphaseRanges;
+
 private:
-  /// \brief Return true if _skeleton is contained
-  bool containSkeleton(const dynamics::Skeleton* _skeleton);
+  /// \brief Pair of collision nodes checked by checkCollision()
+  struct QueryPair {
+    // To get byte-aligned Eigen vectors
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  /// \brief
-  bool getPairCollidable(const CollisionNode* _node1,
-                         const CollisionNode* _node2);
+    /// \brief Collision node of a queried body node
+    CollisionNode* node1;
 
-  /// \brief
-  void setPairCollidable(const CollisionNode* _node1,
-                         const CollisionNode* _node2,
-                         bool _val);
+    /// \brief Collision node of another body node
+    CollisionNode* node2;
+
+    /// \brief Whether the shapes of both nodes are rigid, so the result only
+    /// depends on the transforms
+    bool isRigid;
+
+    /// \brief Whether isColliding, transform1 and transform2 are valid
+    bool hasResult;
+
+    /// \brief Result of the last check of the pair
+    bool isColliding;
+
+    /// \brief Transform of node1 in the last check of the pair
+    Eigen::Isometry3d transform1;
+
+    /// \brief Transform of node2 in the last check of the pair
+    Eigen::Isometry3d transform2;
+  };
+
+  /// \brief Build the query pairs of _bodyNodes
+  void buildQueryPairs(const std::vector<dynamics::BodyNode*>& _bodyNodes);
+
+  /// \brief Find the pairs of collision nodes to check for _bodyNodes, which
+  /// pair each queried node with the nodes that are not queried and with the
+  /// queried nodes that come after it
+  void findQueryPairs(
+      const std::vector<dynamics::BodyNode*>& _bodyNodes,
+      std::vector<std::pair<CollisionNode*, CollisionNode*> >* _pairs);
+
+  /// \brief Return true if _skeleton is contained
+  bool containSkeleton(const dynamics::Skeleton* _skeleton);
 
   /// \brief Return true if _bodyNode1 and _bodyNode2 are adjacent bodies
   bool isAdjacentBodies(const dynamics::BodyNode* _bodyNode1,
@@ -208,8 +472,11 @@ private:
   /// \brief
   std::map<const dynamics::BodyNode*, CollisionNode*> mBodyCollisionMap;
 
-  /// \brief
-  std::vector<std::vector<bool> > mCollidablePairs;
+  /// \brief Body nodes of the last checkCollision() query
+  std::vector<dynamics::BodyNode*> mQueryBodyNodes;
+
+  /// \brief Pairs of collision nodes of the last checkCollision() query
+  std::vector<QueryPair, Eigen::aligned_allocator<QueryPair> > mQueryPairs;
 };
 
 }  // namespace collision
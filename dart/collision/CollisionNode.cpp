@@ -41,10 +41,14 @@ namespace dart {
 namespace collision {
 
 CollisionNode::CollisionNode(dynamics::BodyNode* _bodyNode)
-  : mBodyNode(_bodyNode) {
+  : mBodyNode(_bodyNode),
+    mCategoryBits(0x1),
+    mMaskBits(~0u) {
 }
 
 CollisionNode::~CollisionNode() {
+  for (size_t i = 0; i < mPairExceptions.size(); ++i)
+    mPairExceptions[i].first->removePairExceptionImpl(this);
 }
 
 dynamics::BodyNode*CollisionNode::getBodyNode() const {
@@ -59,5 +63,71 @@ size_t CollisionNode::getIndex() const {
   return mIndex;
 }
 
+void CollisionNode::setCategoryBits(unsigned int _categoryBits) {
+  mCategoryBits = _categoryBits;
+}
+
+unsigned int CollisionNode::getCategoryBits() const {
+  return mCategoryBits;
+}
+
+void CollisionNode::setMaskBits(unsigned int _maskBits) {
+  mMaskBits = _maskBits;
+}
+
+unsigned int CollisionNode::getMaskBits() const {
+  return mMaskBits;
+}
+
+bool CollisionNode::isMaskCollidable(const CollisionNode* _other) const {
+  return (mCategoryBits & _other->mMaskBits) != 0
+      && (_other->mCategoryBits & mMaskBits) != 0;
+}
+
+void CollisionNode::setPairException(CollisionNode* _other,
+                                     bool _isCollidable) {
+  setPairExceptionImpl(_other, _isCollidable);
+  _other->setPairExceptionImpl(this, _isCollidable);
+}
+
+void CollisionNode::removePairException(CollisionNode* _other) {
+  removePairExceptionImpl(_other);
+  _other->removePairExceptionImpl(this);
+}
+
+bool CollisionNode::getPairException(const CollisionNode* _other,
+                                     bool* _isCollidable) const {
+  for (size_t i = 0; i < mPairExceptions.size(); ++i) {
+    if (mPairExceptions[i].first == _other) {
+      *_isCollidable = mPairExceptions[i].second;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void CollisionNode::setPairExceptionImpl(CollisionNode* _other,
+                                         bool _isCollidable) {
+  for (size_t i = 0; i < mPairExceptions.size(); ++i) {
+    if (mPairExceptions[i].first == _other) {
+      mPairExceptions[i].second = _isCollidable;
+      return;
+    }
+  }
+
+  mPairExceptions.push_back(std::make_pair(_other, _isCollidable));
+}
+
+void CollisionNode::removePairExceptionImpl(CollisionNode* _other) {
+  for (size_t i = 0; i < mPairExceptions.size(); ++i) {
+    if (mPairExceptions[i].first == _other) {
+      mPairExceptions[i] = mPairExceptions.back();
+      mPairExceptions.pop_back();
+      return;
+    }
+  }
+}
+
 }  // namespace collision
 }  // namespace dart
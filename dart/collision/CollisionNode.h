@@ -39,6 +39,8 @@
 #define DART_COLLISION_COLLISIONNODE_H_
 
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace dart {
 namespace dynamics {
@@ -67,12 +69,63 @@ public:
   /// \brief
   size_t getIndex() const;
 
+  /// \brief Set the collision categories this node belongs to as a bitfield.
+  /// The default is 0x1.
+  void setCategoryBits(unsigned int _categoryBits);
+
+  /// \brief Get the collision categories this node belongs to
+  unsigned int getCategoryBits() const;
+
+  /// \brief Set the collision categories this node collides with as a
+  /// bitfield. The default is all the categories.
+  void setMaskBits(unsigned int _maskBits);
+
+  /// \brief Get the collision categories this node collides with
+  unsigned int getMaskBits() const;
+
+  /// \brief Return true if the categories and the masks of this node and
+  /// _other let them collide
+  bool isMaskCollidable(const CollisionNode* _other) const;
+
+  /// \brief Set whether this node and _other collide regardless of their
+  /// categories and masks
+  void setPairException(CollisionNode* _other, bool _isCollidable);
+
+  /// \brief Remove the exception of the pair of this node and _other
+  void removePairException(CollisionNode* _other);
+
+  /// \brief Return true if the pair of this node and _other has an exception,
+  /// and store whether the pair collides in _isCollidable
+  bool getPairException(const CollisionNode* _other,
+                        bool* _isCollidable) const;
+
 protected:
   /// \brief
   dynamics::BodyNode* mBodyNode;
 
   /// \brief
   size_t mIndex;
+
+  /// \brief Collision categories this node belongs to
+  unsigned int mCategoryBits;
+
+  /// \brief Collision categories this node collides with
+  unsigned int mMaskBits;
+
+private:
+  /// \brief Set the exception of the pair of this node and _other on this
+  /// node only
+  void setPairExceptionImpl(CollisionNode* _other, bool _isCollidable);
+
+  /// \brief Remove the exception of the pair of this node and _other on this
+  /// node only
+  void removePairExceptionImpl(CollisionNode* _other);
+
+  /// \brief Exceptions of the pairs of this node and other nodes. The other
+  /// nodes keep the same exceptions, so a node can remove itself from them
+  /// when it is destroyed. Nodes rarely have more than a few exceptions, so a
+  /// linear search is fast.
+  std::vector<std::pair<CollisionNode*, bool> > mPairExceptions;
 };
 
 }  // namespace collision
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/collision/ContactReducer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "dart/math/Helpers.h"
+#include "dart/collision/CollisionDetector.h"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// Lexicographical order of projected points
+class ProjectedPointLess {
+public:
+  explicit ProjectedPointLess(const std::vector<double>& _points)
+    : mPoints(_points) {}
+
+  bool operator()(int _i, int _j) const {
+    if (mPoints[2 * _i] != mPoints[2 * _j])
+      return mPoints[2 * _i] < mPoints[2 * _j];
+    return mPoints[2 * _i + 1] < mPoints[2 * _j + 1];
+  }
+
+private:
+  const std::vector<double>& mPoints;
+};
+
+/// Cross product of (b - a) and (c - a) of projected points
+double cross(const std::vector<double>& _points, int _a, int _b, int _c) {
+  return (_points[2 * _b] - _points[2 * _a])
+         * (_points[2 * _c + 1] - _points[2 * _a + 1])
+         - (_points[2 * _b + 1] - _points[2 * _a + 1])
+         * (_points[2 * _c] - _points[2 * _a]);
+}
+
+}  // anonymous namespace
+
+//==============================================================================
+ContactReducer::ContactReducer() {
+}
+
+//==============================================================================
+void ContactReducer::removeDuplicateContacts(std::vector<Contact>* _contacts,
+                                             size_t _begin,
+                                             double _tolerance) {
+  assert(_tolerance > 0.0);
+
+  const int numContacts = static_cast<int>(_contacts->size() - _begin);
+  if (numContacts < 2)
+    return;
+
+  size_t numBuckets = 1;
+  while (numBuckets < 2 * static_cast<size_t>(numContacts))
+    numBuckets *= 2;
+  mBuckets.assign(numBuckets, -1);
+  mNextContacts.resize(numContacts);
+  mIsKept.assign(numContacts, true);
+
+  // A contact is a duplicate if a later contact is within the tolerance, so
+  // the contacts are visited from the last one, and every visited contact is
+  // added to the grid. Contacts within the tolerance are in adjacent cells.
+  const double tolerance2 = _tolerance * _tolerance;
+  const double invTolerance = 1.0 / _tolerance;
+  for (int i = numContacts - 1; i >= 0; --i) {
+    const Eigen::Vector3d& point = (*_contacts)[_begin + i].point;
+    long x = static_cast<long>(std::floor(point[0] * invTolerance));
+    long y = static_cast<long>(std::floor(point[1] * invTolerance));
+    long z = static_cast<long>(std::floor(point[2] * invTolerance));
+
+    for (long dx = -1; dx <= 1 && mIsKept[i]; ++dx) {
+      for (long dy = -1; dy <= 1 && mIsKept[i]; ++dy) {
+        for (long dz = -1; dz <= 1 && mIsKept[i]; ++dz) {
+          int j = mBuckets[getBucket(x + dx, y + dy, z + dz)];
+          for (; j >= 0; j = mNextContacts[j]) {
+            Eigen::Vector3d diff = point - (*_contacts)[_begin + j].point;
+            if (diff.dot(diff) < tolerance2) {
+              mIsKept[i] = false;
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    size_t bucket = getBucket(x, y, z);
+    mNextContacts[i] = mBuckets[bucket];
+    mBuckets[bucket] = i;
+  }
+
+  removeUnmarkedContacts(_contacts, _begin);
+}
+
+//==============================================================================
+void ContactReducer::limitContacts(std::vector<Contact>* _contacts,
+                                   size_t _begin, size_t _maxNumContacts) {
+  const size_t numContacts = _contacts->size() - _begin;
+  if (_maxNumContacts == 0 || numContacts <= _maxNumContacts)
+    return;
+
+  // Start from the deepest contact
+  int deepest = 0;
+  for (size_t i = 1; i < numContacts; ++i) {
+    if ((*_contacts)[_begin + i].penetrationDepth
+        > (*_contacts)[_begin + deepest].penetrationDepth)
+      deepest = i;
+  }
+
+  mIsKept.assign(numContacts, false);
+  mIsKept[deepest] = true;
+  if (_maxNumContacts == 1) {
+    removeUnmarkedContacts(_contacts, _begin);
+    return;
+  }
+
+  // Project the contacts onto the plane perpendicular to the contact normal of
+  // the deepest contact
+  Eigen::Vector3d normal = (*_contacts)[_begin + deepest].normal;
+  if (normal.norm() < 1e-12)
+    normal = Eigen::Vector3d::UnitZ();
+  normal.normalize();
+  Eigen::Vector3d axis1 = normal.unitOrthogonal();
+  Eigen::Vector3d axis2 = normal.cross(axis1);
+
+  mPoints.resize(2 * numContacts);
+  for (size_t i = 0; i < numContacts; ++i) {
+    const Eigen::Vector3d& point = (*_contacts)[_begin + i].point;
+    mPoints[2 * i] = axis1.dot(point);
+    mPoints[2 * i + 1] = axis2.dot(point);
+  }
+
+  // Only the corners of the contact area can widen the area of the selected
+  // contacts
+  computeConvexHull(numContacts);
+  const int numHull = static_cast<int>(mHull.size());
+
+  // Centroid of the convex hull
+  double cx = 0.0;
+  double cy = 0.0;
+  double area = 0.0;
+  for (int i = 0; i < numHull; ++i) {
+    int a = mHull[i];
+    int b = mHull[(i + 1) % numHull];
+    double q = mPoints[2 * a] * mPoints[2 * b + 1]
+               - mPoints[2 * b] * mPoints[2 * a + 1];
+    area += q;
+    cx += q * (mPoints[2 * a] + mPoints[2 * b]);
+    cy += q * (mPoints[2 * a + 1] + mPoints[2 * b + 1]);
+  }
+  if (std::abs(area) > 1e-12) {
+    cx /= 3.0 * area;
+    cy /= 3.0 * area;
+  } else {
+    cx = 0.0;
+    cy = 0.0;
+    for (int i = 0; i < numHull; ++i) {
+      cx += mPoints[2 * mHull[i]];
+      cy += mPoints[2 * mHull[i] + 1];
+    }
+    cx /= numHull;
+    cy /= numHull;
+  }
+
+  // Choose the corners whose angles around the centroid are closest to evenly
+  // spaced angles starting from the deepest contact
+  mAngles.resize(numContacts);
+  mAngles[deepest] = std::atan2(mPoints[2 * deepest + 1] - cy,
+                                mPoints[2 * deepest] - cx);
+  for (int i = 0; i < numHull; ++i) {
+    int k = mHull[i];
+    mAngles[k] = std::atan2(mPoints[2 * k + 1] - cy, mPoints[2 * k] - cx);
+  }
+
+  const size_t numSelections = _maxNumContacts;
+  for (size_t j = 1; j < numSelections; ++j) {
+    double angle = static_cast<double>(j) * (2.0 * DART_PI / numSelections)
+                   + mAngles[deepest];
+    if (angle > DART_PI)
+      angle -= 2.0 * DART_PI;
+
+    int selected = -1;
+    double minDiff = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < numHull; ++i) {
+      int k = mHull[i];
+      if (mIsKept[k])
+        continue;
+
+      double diff = std::abs(mAngles[k] - angle);
+      if (diff > DART_PI)
+        diff = 2.0 * DART_PI - diff;
+      if (diff < minDiff) {
+        minDiff = diff;
+        selected = k;
+      }
+    }
+
+    // All the corners are selected
+    if (selected < 0)
+      break;
+
+    mIsKept[selected] = true;
+  }
+
+  removeUnmarkedContacts(_contacts, _begin);
+}
+
+//==============================================================================
+size_t ContactReducer::getBucket(long _x, long _y, long _z) const {
+  size_t hash = static_cast<size_t>(_x) * 73856093u
+                ^ static_cast<size_t>(_y) * 19349663u
+                ^ static_cast<size_t>(_z) * 83492791u;
+  return hash & (mBuckets.size() - 1);
+}
+
+//==============================================================================
+void ContactReducer::removeUnmarkedContacts(std::vector<Contact>* _contacts,
+                                            size_t _begin) {
+  size_t end = _begin;
+  for (size_t i = 0; i < mIsKept.size(); ++i) {
+    if (!mIsKept[i])
+      continue;
+
+    if (end != _begin + i)
+      (*_contacts)[end] = (*_contacts)[_begin + i];
+    ++end;
+  }
+  _contacts->resize(end);
+}
+
+//==============================================================================
+void ContactReducer::computeConvexHull(size_t _numPoints) {
+  // Andrew's monotone chain
+  mSortedContacts.resize(_numPoints);
+  for (size_t i = 0; i < _numPoints; ++i)
+    mSortedContacts[i] = i;
+  std::sort(mSortedContacts.begin(), mSortedContacts.end(),
+            ProjectedPointLess(mPoints));
+
+  mHull.resize(2 * _numPoints);
+  size_t k = 0;
+
+  // Lower hull
+  for (size_t i = 0; i < _numPoints; ++i) {
+    while (k >= 2
+           && cross(mPoints, mHull[k - 2], mHull[k - 1], mSortedContacts[i])
+              <= 0.0)
+      --k;
+    mHull[k++] = mSortedContacts[i];
+  }
+
+  // Upper hull
+  for (size_t i = _numPoints - 1, lowerSize = k + 1; i > 0; --i) {
+    while (k >= lowerSize
+           && cross(mPoints, mHull[k - 2], mHull[k - 1], mSortedContacts[i - 1])
+              <= 0.0)
+      --k;
+    mHull[k++] = mSortedContacts[i - 1];
+  }
+
+  // The last point is the same as the first one
+  mHull.resize(k > 1 ? k - 1 : k);
+}
+
+}  // namespace collision
+}  // namespace dart
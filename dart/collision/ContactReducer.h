@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_COLLISION_CONTACTREDUCER_H_
+#define DART_COLLISION_CONTACTREDUCER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace dart {
+namespace collision {
+
+struct Contact;
+
+/// \brief ContactReducer removes duplicate contacts and limits the number of
+/// contacts between two bodies
+///
+/// The reducer keeps its scratch memory between calls, so reducing the
+/// contacts of every time step does not allocate once the memory has grown to
+/// the largest contact set. A reducer must not be used by several threads at
+/// the same time.
+class ContactReducer {
+public:
+  /// \brief Constructor
+  ContactReducer();
+
+  /// \brief Remove the contacts from index _begin on that are closer than
+  /// _tolerance to a later contact. The order of the remaining contacts is
+  /// kept. The contacts are hashed into a grid of cells of size _tolerance,
+  /// so only the contacts of neighboring cells are compared.
+  void removeDuplicateContacts(std::vector<Contact>* _contacts, size_t _begin,
+                               double _tolerance);
+
+  /// \brief Keep at most _maxNumContacts of the contacts from index _begin on.
+  /// The deepest contact is always kept. The others are chosen among the
+  /// corners of the contact area at evenly spaced angles around its centroid,
+  /// as cullPoints() does for box-box contacts, so that they span as much
+  /// area as possible. The order of the remaining contacts is kept.
+  void limitContacts(std::vector<Contact>* _contacts, size_t _begin,
+                     size_t _maxNumContacts);
+
+private:
+  /// \brief Return the hash bucket of grid cell (_x, _y, _z)
+  size_t getBucket(long _x, long _y, long _z) const;
+
+  /// \brief Remove the contacts from index _begin on that are not marked in
+  /// mIsKept
+  void removeUnmarkedContacts(std::vector<Contact>* _contacts, size_t _begin);
+
+  /// \brief Compute the convex hull of the projected points in mHull in
+  /// counterclockwise order
+  void computeConvexHull(size_t _numPoints);
+
+  /// \brief First contact of each hash bucket, or -1 if the bucket is empty
+  std::vector<int> mBuckets;
+
+  /// \brief Next contact in the same hash bucket, or -1
+  std::vector<int> mNextContacts;
+
+  /// \brief Whether each contact is kept
+  std::vector<bool> mIsKept;
+
+  /// \brief Contacts projected onto the contact plane, interleaved as x and y
+  std::vector<double> mPoints;
+
+  /// \brief Indices of the contacts sorted by the projected points
+  std::vector<int> mSortedContacts;
+
+  /// \brief Indices of the contacts on the convex hull of the projected points
+  std::vector<int> mHull;
+
+  /// \brief Angle of each contact around the centroid of the convex hull
+  std::vector<double> mAngles;
+};
+
+}  // namespace collision
+}  // namespace dart
+
+#endif  // DART_COLLISION_CONTACTREDUCER_H_
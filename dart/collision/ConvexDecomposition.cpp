@@ -0,0 +1,797 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/collision/ConvexDecomposition.h"
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <assimp/scene.h>
+
+#include "dart/dynamics/MeshShape.h"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// \brief Concavity of the decompositions of getConvexHulls() relative to the
+/// diagonal of the bounding box of the mesh
+const double DART_CONVEX_CONCAVITY = 0.03;
+
+/// \brief Maximum number of hulls of the decompositions of getConvexHulls()
+const size_t DART_CONVEX_MAX_NUM_HULLS = 16;
+
+/// \brief First line of the disk cache files
+const char* const DART_CONVEX_FILE_HEADER = "DART convex hulls 1";
+
+/// \brief Key of the hulls of a scene in the memory cache. Scenes loaded by
+/// MeshShape::loadMesh() are identified by the path and the modification time
+/// of their file, since the address of a released scene may be reused by
+/// another one, and other scenes by their address.
+struct ConvexHullsCacheKey {
+  /// \brief Scene that was not loaded from a file, or NULL
+  const aiScene* mesh;
+
+  /// \brief Canonical path of the file of the scene, or an empty string
+  std::string path;
+
+  /// \brief Modification time of the file
+  long modificationTime;
+
+  /// \brief Lexicographical ordering
+  bool operator<(const ConvexHullsCacheKey& _other) const {
+    if (mesh != _other.mesh)
+      return mesh < _other.mesh;
+    if (modificationTime != _other.modificationTime)
+      return modificationTime < _other.modificationTime;
+    return path < _other.path;
+  }
+};
+
+/// \brief Hulls of a scene in the memory cache
+struct ConvexHullsCacheEntry {
+  /// \brief Number of meshes, vertices and faces of the scene when the hulls
+  /// were computed, which detects a new scene at the address of a released
+  /// one
+  size_t numMeshes;
+
+  /// \brief Number of vertices of the scene
+  size_t numVertices;
+
+  /// \brief Number of faces of the scene
+  size_t numFaces;
+
+  /// \brief Hulls of the scene
+  std::shared_ptr<const ConvexHulls> hulls;
+};
+
+/// \brief Mutex that guards the memory cache and gIsDiskCacheEnabled
+std::mutex gConvexHullsMutex;
+
+/// \brief Memory cache of the hulls by scene
+std::map<ConvexHullsCacheKey, ConvexHullsCacheEntry> gConvexHullsCache;
+
+/// \brief Whether the hulls of mesh files are stored next to the files
+bool gIsDiskCacheEnabled = false;
+
+/// \brief Triangle of a convex hull under construction
+struct HullFace {
+  /// \brief Vertex indices, counterclockwise seen from outside
+  int vertices[3];
+
+  /// \brief Outward unit normal
+  Eigen::Vector3d normal;
+
+  /// \brief Distance of the plane of the face from the origin along normal
+  double offset;
+
+  /// \brief Whether the face is part of the hull
+  bool isAlive;
+};
+
+/// \brief Return the triangle _a, _b, _c of _points
+HullFace makeHullFace(const std::vector<Eigen::Vector3d>& _points,
+                      int _a, int _b, int _c) {
+  HullFace face;
+  face.vertices[0] = _a;
+  face.vertices[1] = _b;
+  face.vertices[2] = _c;
+  face.normal = (_points[_b] - _points[_a]).cross(_points[_c] - _points[_a]);
+  const double norm = face.normal.norm();
+  if (norm > 0.0)
+    face.normal /= norm;
+  face.offset = face.normal.dot(_points[_a]);
+  face.isAlive = true;
+  return face;
+}
+
+/// \brief Return the number of meshes, vertices and faces of _mesh
+void countElements(const aiScene* _mesh, ConvexHullsCacheEntry* _entry) {
+  _entry->numMeshes = _mesh->mNumMeshes;
+  _entry->numVertices = 0;
+  _entry->numFaces = 0;
+  for (unsigned int i = 0; i < _mesh->mNumMeshes; ++i) {
+    _entry->numVertices += _mesh->mMeshes[i]->mNumVertices;
+    _entry->numFaces += _mesh->mMeshes[i]->mNumFaces;
+  }
+}
+
+/// \brief Part of a mesh in a decomposition
+struct DecompositionPart {
+  /// \brief Triangles of the part
+  std::vector<int> triangles;
+
+  /// \brief Convex hull of the vertices of the triangles
+  ConvexHull hull;
+
+  /// \brief Largest depth of the surface of the part inside the hull, or 0 if
+  /// the part cannot be split
+  double concavity;
+
+  /// \brief Deepest point of the surface of the part inside the hull
+  Eigen::Vector3d deepestPoint;
+};
+
+/// \brief Order of triangles by the coordinate of their centroids along an
+/// axis
+class TriangleCentroidLess {
+public:
+  /// \brief Constructor
+  TriangleCentroidLess(const std::vector<Eigen::Vector3d>& _centroids,
+                       int _axis)
+    : mCentroids(_centroids), mAxis(_axis) {}
+
+  /// \brief Return true if the centroid of _triangle1 precedes the one of
+  /// _triangle2
+  bool operator()(int _triangle1, int _triangle2) const {
+    return mCentroids[_triangle1][mAxis] < mCentroids[_triangle2][mAxis];
+  }
+
+private:
+  /// \brief Centroids of the triangles
+  const std::vector<Eigen::Vector3d>& mCentroids;
+
+  /// \brief Axis
+  int mAxis;
+};
+
+/// \brief Predicate of the triangles whose vertices are all below a
+/// coordinate along an axis, up to a tolerance, so that the triangles lying in
+/// a cutting plane stay on one side
+class TriangleBelow {
+public:
+  /// \brief Constructor
+  TriangleBelow(const std::vector<Eigen::Vector3d>& _vertices,
+                const std::vector<Eigen::Vector3i>& _triangles,
+                int _axis, double _coordinate)
+    : mVertices(_vertices), mTriangles(_triangles), mAxis(_axis),
+      mCoordinate(_coordinate) {}
+
+  /// \brief Return true if the vertices of _triangle are below the coordinate
+  bool operator()(int _triangle) const {
+    for (int i = 0; i < 3; ++i) {
+      if (mVertices[mTriangles[_triangle][i]][mAxis] > mCoordinate)
+        return false;
+    }
+    return true;
+  }
+
+private:
+  /// \brief Vertices of the mesh
+  const std::vector<Eigen::Vector3d>& mVertices;
+
+  /// \brief Triangles of the mesh
+  const std::vector<Eigen::Vector3i>& mTriangles;
+
+  /// \brief Axis
+  int mAxis;
+
+  /// \brief Coordinate
+  double mCoordinate;
+};
+
+/// \brief Compute the hull and the concavity of _part. The concavity is the
+/// largest distance from a vertex or the centroid of a triangle along the
+/// normal of the triangle to the boundary of the hull, which is zero for the
+/// triangles on the boundary of the hull.
+void computePart(const std::vector<Eigen::Vector3d>& _vertices,
+                 const std::vector<Eigen::Vector3i>& _triangles,
+                 DecompositionPart* _part) {
+  std::vector<int> indices;
+  indices.reserve(3 * _part->triangles.size());
+  for (size_t i = 0; i < _part->triangles.size(); ++i) {
+    for (int j = 0; j < 3; ++j)
+      indices.push_back(_triangles[_part->triangles[i]][j]);
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  std::vector<Eigen::Vector3d> points(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    points[i] = _vertices[indices[i]];
+
+  std::vector<Eigen::Vector3i> hullTriangles;
+  ConvexDecomposition::computeConvexHull(points, &_part->hull,
+                                         &hullTriangles);
+
+  _part->concavity = 0.0;
+  _part->deepestPoint = points.empty() ? Eigen::Vector3d::Zero() : points[0];
+  if (hullTriangles.empty() || _part->triangles.size() < 2)
+    return;
+
+  std::vector<Eigen::Vector3d> normals(hullTriangles.size());
+  std::vector<double> offsets(hullTriangles.size());
+  for (size_t i = 0; i < hullTriangles.size(); ++i) {
+    const Eigen::Vector3d& a = _part->hull[hullTriangles[i][0]];
+    const Eigen::Vector3d& b = _part->hull[hullTriangles[i][1]];
+    const Eigen::Vector3d& c = _part->hull[hullTriangles[i][2]];
+    normals[i] = (b - a).cross(c - a).normalized();
+    offsets[i] = normals[i].dot(a);
+  }
+
+  for (size_t i = 0; i < _part->triangles.size(); ++i) {
+    const Eigen::Vector3i& triangle = _triangles[_part->triangles[i]];
+    Eigen::Vector3d samples[4];
+    for (int j = 0; j < 3; ++j)
+      samples[j] = _vertices[triangle[j]];
+    samples[3] = (samples[0] + samples[1] + samples[2]) / 3.0;
+
+    Eigen::Vector3d normal
+        = (samples[1] - samples[0]).cross(samples[2] - samples[0]);
+    const double norm = normal.norm();
+    if (!(norm > 0.0))
+      continue;
+    normal /= norm;
+
+    for (int j = 0; j < 4; ++j) {
+      double depth = std::numeric_limits<double>::infinity();
+      for (size_t k = 0; k < normals.size(); ++k) {
+        const double speed = normals[k].dot(normal);
+        if (speed > 0.0) {
+          depth = std::min(depth,
+                           (offsets[k] - normals[k].dot(samples[j])) / speed);
+        }
+      }
+
+      if (depth > _part->concavity
+          && depth < std::numeric_limits<double>::infinity()) {
+        _part->concavity = depth;
+        _part->deepestPoint = samples[j];
+      }
+    }
+  }
+}
+
+/// \brief Split _part into _below and _above by a plane perpendicular to one
+/// of the axes, and compute the hulls of both sides. Return false if the part
+/// cannot be split.
+bool splitPart(const std::vector<Eigen::Vector3d>& _vertices,
+               const std::vector<Eigen::Vector3i>& _triangles,
+               double _tolerance, const DecompositionPart& _part,
+               DecompositionPart* _below, DecompositionPart* _above) {
+  // Try the planes through the deepest point, which is usually near a concave
+  // corner, and keep the one that leaves the least concave sides
+  bool isSplit = false;
+  for (int axis = 0; axis < 3; ++axis) {
+    DecompositionPart below;
+    DecompositionPart above;
+    below.triangles = _part.triangles;
+    std::vector<int>::iterator middle = std::partition(
+          below.triangles.begin(), below.triangles.end(),
+          TriangleBelow(_vertices, _triangles, axis,
+                        _part.deepestPoint[axis] + _tolerance));
+    if (middle == below.triangles.begin() || middle == below.triangles.end())
+      continue;
+
+    above.triangles.assign(middle, below.triangles.end());
+    below.triangles.erase(middle, below.triangles.end());
+    computePart(_vertices, _triangles, &below);
+    computePart(_vertices, _triangles, &above);
+
+    if (!isSplit || std::max(below.concavity, above.concavity)
+                    < std::max(_below->concavity, _above->concavity)) {
+      *_below = below;
+      *_above = above;
+      isSplit = true;
+    }
+  }
+  if (isSplit)
+    return true;
+
+  // Otherwise cut through the median of the centroids along the longest axis
+  std::vector<Eigen::Vector3d> centroids(_triangles.size());
+  Eigen::Vector3d min = Eigen::Vector3d::Constant(
+                          std::numeric_limits<double>::infinity());
+  Eigen::Vector3d max = -min;
+  for (size_t i = 0; i < _part.triangles.size(); ++i) {
+    const int triangle = _part.triangles[i];
+    centroids[triangle] = (_vertices[_triangles[triangle][0]]
+                           + _vertices[_triangles[triangle][1]]
+                           + _vertices[_triangles[triangle][2]]) / 3.0;
+    min = min.cwiseMin(centroids[triangle]);
+    max = max.cwiseMax(centroids[triangle]);
+  }
+
+  if (_part.triangles.size() < 2)
+    return false;
+
+  int axis;
+  (max - min).maxCoeff(&axis);
+
+  std::vector<int> triangles = _part.triangles;
+  std::vector<int>::iterator middle
+      = triangles.begin() + triangles.size() / 2;
+  std::nth_element(triangles.begin(), middle, triangles.end(),
+                   TriangleCentroidLess(centroids, axis));
+
+  _below->triangles.assign(triangles.begin(), middle);
+  _above->triangles.assign(middle, triangles.end());
+  computePart(_vertices, _triangles, _below);
+  computePart(_vertices, _triangles, _above);
+  return true;
+}
+
+}  // namespace
+
+//==============================================================================
+std::shared_ptr<const ConvexHulls> ConvexDecomposition::getConvexHulls(
+    const aiScene* _mesh) {
+  assert(_mesh != NULL);
+
+  ConvexHullsCacheEntry entry;
+  countElements(_mesh, &entry);
+
+  ConvexHullsCacheKey key;
+  key.mesh = _mesh;
+  key.path = dynamics::MeshShape::getMeshPath(_mesh);
+  key.modificationTime = 0;
+  if (!key.path.empty()) {
+    struct stat status;
+    if (stat(key.path.c_str(), &status) == 0) {
+      key.mesh = NULL;
+      key.modificationTime = static_cast<long>(status.st_mtime);
+    } else {
+      key.path.clear();
+    }
+  }
+
+  // Decompose the mesh while holding the lock so that concurrent calls for the
+  // same scene wait for a single decomposition
+  std::lock_guard<std::mutex> lock(gConvexHullsMutex);
+
+  std::map<ConvexHullsCacheKey, ConvexHullsCacheEntry>::iterator it
+      = gConvexHullsCache.find(key);
+  if (it != gConvexHullsCache.end()
+      && it->second.numMeshes == entry.numMeshes
+      && it->second.numVertices == entry.numVertices
+      && it->second.numFaces == entry.numFaces) {
+    return it->second.hulls;
+  }
+
+  std::shared_ptr<ConvexHulls> hulls(new ConvexHulls());
+
+  std::string cacheFileName;
+  if (gIsDiskCacheEnabled && !key.path.empty())
+    cacheFileName = key.path + ".convex";
+
+  if (cacheFileName.empty()
+      || !loadConvexHulls(cacheFileName, key.modificationTime, hulls.get())) {
+    std::vector<Eigen::Vector3d> vertices;
+    std::vector<Eigen::Vector3i> triangles;
+    collectTriangles(_mesh, &vertices, &triangles);
+    decompose(vertices, triangles, DART_CONVEX_CONCAVITY,
+              DART_CONVEX_MAX_NUM_HULLS, hulls.get());
+
+    // The disk cache is optional, so a read-only mesh directory is fine
+    if (!cacheFileName.empty())
+      saveConvexHulls(cacheFileName, key.modificationTime, *hulls);
+  }
+
+  entry.hulls = hulls;
+  gConvexHullsCache[key] = entry;
+
+  return entry.hulls;
+}
+
+//==============================================================================
+void ConvexDecomposition::clearCache() {
+  std::lock_guard<std::mutex> lock(gConvexHullsMutex);
+  gConvexHullsCache.clear();
+}
+
+//==============================================================================
+void ConvexDecomposition::setDiskCacheEnabled(bool _isEnabled) {
+  std::lock_guard<std::mutex> lock(gConvexHullsMutex);
+  gIsDiskCacheEnabled = _isEnabled;
+}
+
+//==============================================================================
+bool ConvexDecomposition::isDiskCacheEnabled() {
+  std::lock_guard<std::mutex> lock(gConvexHullsMutex);
+  return gIsDiskCacheEnabled;
+}
+
+//==============================================================================
+size_t ConvexDecomposition::getNumCachedMeshes() {
+  std::lock_guard<std::mutex> lock(gConvexHullsMutex);
+  return gConvexHullsCache.size();
+}
+
+//==============================================================================
+void ConvexDecomposition::computeConvexHull(
+    const std::vector<Eigen::Vector3d>& _points, ConvexHull* _hull,
+    std::vector<Eigen::Vector3i>* _triangles) {
+  assert(_hull != NULL);
+
+  _hull->clear();
+  if (_triangles)
+    _triangles->clear();
+
+  const int numPoints = static_cast<int>(_points.size());
+  if (numPoints < 4) {
+    *_hull = _points;
+    return;
+  }
+
+  // Tolerance relative to the size of the point set
+  Eigen::Vector3d min = _points[0];
+  Eigen::Vector3d max = _points[0];
+  for (int i = 1; i < numPoints; ++i) {
+    min = min.cwiseMin(_points[i]);
+    max = max.cwiseMax(_points[i]);
+  }
+  const double epsilon = 1e-9 * std::max((max - min).norm(), 1e-12);
+
+  // Initial tetrahedron of extreme points
+  int indices[4] = {0, 0, 0, 0};
+  for (int i = 1; i < numPoints; ++i) {
+    if (_points[i][0] < _points[indices[0]][0])
+      indices[0] = i;
+  }
+
+  double best = 0.0;
+  for (int i = 0; i < numPoints; ++i) {
+    const double distance = (_points[i] - _points[indices[0]]).norm();
+    if (distance > best) {
+      best = distance;
+      indices[1] = i;
+    }
+  }
+  if (best <= epsilon) {
+    *_hull = _points;
+    return;
+  }
+
+  const Eigen::Vector3d axis
+      = (_points[indices[1]] - _points[indices[0]]).normalized();
+  best = 0.0;
+  for (int i = 0; i < numPoints; ++i) {
+    const Eigen::Vector3d offset = _points[i] - _points[indices[0]];
+    const double distance = (offset - offset.dot(axis) * axis).norm();
+    if (distance > best) {
+      best = distance;
+      indices[2] = i;
+    }
+  }
+  if (best <= epsilon) {
+    *_hull = _points;
+    return;
+  }
+
+  const Eigen::Vector3d normal
+      = axis.cross(_points[indices[2]] - _points[indices[0]]).normalized();
+  best = 0.0;
+  for (int i = 0; i < numPoints; ++i) {
+    const double distance
+        = std::abs(normal.dot(_points[i] - _points[indices[0]]));
+    if (distance > best) {
+      best = distance;
+      indices[3] = i;
+    }
+  }
+  if (best <= epsilon) {
+    *_hull = _points;
+    return;
+  }
+
+  std::vector<HullFace> faces;
+  std::map<std::pair<int, int>, int> edgeFaces;
+  const Eigen::Vector3d center = 0.25 * (_points[indices[0]]
+                                         + _points[indices[1]]
+                                         + _points[indices[2]]
+                                         + _points[indices[3]]);
+  const int tetrahedron[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+  for (int i = 0; i < 4; ++i) {
+    int a = indices[tetrahedron[i][0]];
+    int b = indices[tetrahedron[i][1]];
+    int c = indices[tetrahedron[i][2]];
+    HullFace face = makeHullFace(_points, a, b, c);
+    if (face.normal.dot(center) > face.offset)
+      face = makeHullFace(_points, a, c, b);
+
+    for (int j = 0; j < 3; ++j) {
+      edgeFaces[std::make_pair(face.vertices[j], face.vertices[(j + 1) % 3])]
+          = static_cast<int>(faces.size());
+    }
+    faces.push_back(face);
+  }
+
+  // Add the points one by one. The faces that a point sees form a connected
+  // region, which is replaced by a fan of faces from its horizon to the point.
+  std::vector<int> visited;
+  std::vector<char> isVisible;
+  std::vector<std::pair<int, int> > horizon;
+  for (int i = 0; i < numPoints; ++i) {
+    const Eigen::Vector3d& point = _points[i];
+
+    int start = -1;
+    double maxDistance = epsilon;
+    for (size_t j = 0; j < faces.size(); ++j) {
+      if (!faces[j].isAlive)
+        continue;
+
+      const double distance = faces[j].normal.dot(point) - faces[j].offset;
+      if (distance > maxDistance) {
+        maxDistance = distance;
+        start = static_cast<int>(j);
+      }
+    }
+    if (start < 0)
+      continue;
+
+    isVisible.assign(faces.size(), 0);
+    visited.clear();
+    visited.push_back(start);
+    isVisible[start] = 1;
+    horizon.clear();
+    for (size_t j = 0; j < visited.size(); ++j) {
+      const HullFace& face = faces[visited[j]];
+      for (int k = 0; k < 3; ++k) {
+        const int a = face.vertices[k];
+        const int b = face.vertices[(k + 1) % 3];
+        const int neighbor = edgeFaces[std::make_pair(b, a)];
+        if (isVisible[neighbor])
+          continue;
+
+        const HullFace& neighborFace = faces[neighbor];
+        if (neighborFace.normal.dot(point) - neighborFace.offset > epsilon) {
+          isVisible[neighbor] = 1;
+          visited.push_back(neighbor);
+        }
+      }
+    }
+
+    for (size_t j = 0; j < visited.size(); ++j) {
+      HullFace& face = faces[visited[j]];
+      face.isAlive = false;
+      for (int k = 0; k < 3; ++k) {
+        const int a = face.vertices[k];
+        const int b = face.vertices[(k + 1) % 3];
+        if (!isVisible[edgeFaces[std::make_pair(b, a)]])
+          horizon.push_back(std::make_pair(a, b));
+      }
+    }
+
+    for (size_t j = 0; j < visited.size(); ++j) {
+      const HullFace& face = faces[visited[j]];
+      for (int k = 0; k < 3; ++k)
+        edgeFaces.erase(std::make_pair(face.vertices[k],
+                                       face.vertices[(k + 1) % 3]));
+    }
+
+    for (size_t j = 0; j < horizon.size(); ++j) {
+      HullFace face
+          = makeHullFace(_points, horizon[j].first, horizon[j].second, i);
+      for (int k = 0; k < 3; ++k) {
+        edgeFaces[std::make_pair(face.vertices[k], face.vertices[(k + 1) % 3])]
+            = static_cast<int>(faces.size());
+      }
+      faces.push_back(face);
+    }
+  }
+
+  // Keep the points that are vertices of the remaining faces
+  std::vector<int> vertexIndices(numPoints, -1);
+  for (size_t i = 0; i < faces.size(); ++i) {
+    if (!faces[i].isAlive)
+      continue;
+
+    Eigen::Vector3i triangle;
+    for (int j = 0; j < 3; ++j) {
+      int& index = vertexIndices[faces[i].vertices[j]];
+      if (index < 0) {
+        index = static_cast<int>(_hull->size());
+        _hull->push_back(_points[faces[i].vertices[j]]);
+      }
+      triangle[j] = index;
+    }
+
+    if (_triangles)
+      _triangles->push_back(triangle);
+  }
+}
+
+//==============================================================================
+void ConvexDecomposition::decompose(
+    const std::vector<Eigen::Vector3d>& _vertices,
+    const std::vector<Eigen::Vector3i>& _triangles,
+    double _concavity, size_t _maxNumHulls, ConvexHulls* _hulls) {
+  assert(_hulls != NULL);
+
+  _hulls->clear();
+  if (_vertices.empty() || _triangles.empty())
+    return;
+
+  Eigen::Vector3d min = _vertices[0];
+  Eigen::Vector3d max = _vertices[0];
+  for (size_t i = 1; i < _vertices.size(); ++i) {
+    min = min.cwiseMin(_vertices[i]);
+    max = max.cwiseMax(_vertices[i]);
+  }
+  const double threshold = _concavity * (max - min).norm();
+  const double tolerance = 1e-9 * (max - min).norm();
+
+  std::vector<DecompositionPart> parts(1);
+  parts[0].triangles.resize(_triangles.size());
+  for (size_t i = 0; i < _triangles.size(); ++i)
+    parts[0].triangles[i] = static_cast<int>(i);
+  computePart(_vertices, _triangles, &parts[0]);
+
+  // Split the most concave part until all the parts are nearly convex
+  while (parts.size() < std::max(_maxNumHulls, static_cast<size_t>(1))) {
+    size_t worst = 0;
+    for (size_t i = 1; i < parts.size(); ++i) {
+      if (parts[i].concavity > parts[worst].concavity)
+        worst = i;
+    }
+    if (parts[worst].concavity <= threshold)
+      break;
+
+    DecompositionPart below;
+    DecompositionPart above;
+    if (!splitPart(_vertices, _triangles, tolerance, parts[worst], &below,
+                   &above)) {
+      parts[worst].concavity = 0.0;
+      continue;
+    }
+
+    parts[worst] = below;
+    parts.push_back(above);
+  }
+
+  _hulls->reserve(parts.size());
+  for (size_t i = 0; i < parts.size(); ++i) {
+    if (!parts[i].hull.empty())
+      _hulls->push_back(parts[i].hull);
+  }
+}
+
+//==============================================================================
+bool ConvexDecomposition::saveConvexHulls(const std::string& _fileName,
+                                          long _modificationTime,
+                                          const ConvexHulls& _hulls) {
+  std::ofstream file(_fileName.c_str());
+  if (!file.is_open())
+    return false;
+
+  file << DART_CONVEX_FILE_HEADER << "\n"
+       << _modificationTime << "\n"
+       << _hulls.size() << "\n"
+       << std::setprecision(17);
+  for (size_t i = 0; i < _hulls.size(); ++i) {
+    file << _hulls[i].size() << "\n";
+    for (size_t j = 0; j < _hulls[i].size(); ++j) {
+      file << _hulls[i][j][0] << " " << _hulls[i][j][1] << " "
+           << _hulls[i][j][2] << "\n";
+    }
+  }
+
+  return file.good();
+}
+
+//==============================================================================
+bool ConvexDecomposition::loadConvexHulls(const std::string& _fileName,
+                                          long _modificationTime,
+                                          ConvexHulls* _hulls) {
+  assert(_hulls != NULL);
+
+  std::ifstream file(_fileName.c_str());
+  if (!file.is_open())
+    return false;
+
+  std::string header;
+  std::getline(file, header);
+  long modificationTime;
+  size_t numHulls;
+  if (header != DART_CONVEX_FILE_HEADER
+      || !(file >> modificationTime >> numHulls)
+      || modificationTime != _modificationTime) {
+    return false;
+  }
+
+  ConvexHulls hulls(numHulls);
+  for (size_t i = 0; i < numHulls; ++i) {
+    size_t numVertices;
+    if (!(file >> numVertices))
+      return false;
+
+    hulls[i].resize(numVertices);
+    for (size_t j = 0; j < numVertices; ++j) {
+      if (!(file >> hulls[i][j][0] >> hulls[i][j][1] >> hulls[i][j][2]))
+        return false;
+    }
+  }
+
+  _hulls->swap(hulls);
+  return true;
+}
+
+//==============================================================================
+void ConvexDecomposition::collectTriangles(
+    const aiScene* _mesh, std::vector<Eigen::Vector3d>* _vertices,
+    std::vector<Eigen::Vector3i>* _triangles) {
+  for (unsigned int i = 0; i < _mesh->mNumMeshes; ++i) {
+    const aiMesh* mesh = _mesh->mMeshes[i];
+    const int offset = static_cast<int>(_vertices->size());
+    for (unsigned int j = 0; j < mesh->mNumVertices; ++j) {
+      const aiVector3D& vertex = mesh->mVertices[j];
+      _vertices->push_back(Eigen::Vector3d(vertex.x, vertex.y, vertex.z));
+    }
+    for (unsigned int j = 0; j < mesh->mNumFaces; ++j) {
+      const aiFace& face = mesh->mFaces[j];
+      if (face.mNumIndices != 3)
+        continue;
+
+      _triangles->push_back(Eigen::Vector3i(offset + face.mIndices[0],
+                                            offset + face.mIndices[1],
+                                            offset + face.mIndices[2]));
+    }
+  }
+}
+
+}  // namespace collision
+}  // namespace dart
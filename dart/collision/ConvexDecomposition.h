@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_COLLISION_CONVEXDECOMPOSITION_H_
+#define DART_COLLISION_CONVEXDECOMPOSITION_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+struct aiScene;
+
+namespace dart {
+namespace collision {
+
+/// \brief Vertices of a convex hull
+typedef std::vector<Eigen::Vector3d> ConvexHull;
+
+/// \brief Convex hulls that approximate a mesh
+typedef std::vector<ConvexHull> ConvexHulls;
+
+/// \brief ConvexDecomposition approximates meshes by a few convex hulls so
+/// that they can be collided by GJK and EPA like primitive shapes.
+///
+/// The decomposition splits the triangles of a mesh recursively until the
+/// surface of every part lies close to the boundary of the convex hull of the
+/// part, measured along the normals of the triangles, which are assumed to be
+/// counterclockwise seen from outside. The hulls of the meshes loaded by
+/// dynamics::MeshShape::loadMesh() are cached by the path and the modification
+/// time of the mesh file. If the disk cache is enabled, they are also stored
+/// next to the mesh file with the extension ".convex" and reused as long as
+/// the mesh file does not change.
+class ConvexDecomposition {
+public:
+  /// \brief Return the convex hulls of the unscaled vertices of _mesh. The
+  /// hulls are computed on the first call for a scene, or read from the disk
+  /// cache, and shared by all the later calls. This function is thread-safe,
+  /// but it locks the memory cache, so callers that collide meshes on every
+  /// step should keep the returned hulls.
+  static std::shared_ptr<const ConvexHulls> getConvexHulls(
+      const aiScene* _mesh);
+
+  /// \brief Remove the hulls of all the scenes from the memory cache
+  static void clearCache();
+
+  /// \brief Set whether the hulls of mesh files are stored next to the files
+  /// and read back by later processes. The default is false, since the mesh
+  /// directories may not be writable or may be under version control.
+  static void setDiskCacheEnabled(bool _isEnabled);
+
+  /// \brief Return whether the hulls of mesh files are stored next to the
+  /// files
+  static bool isDiskCacheEnabled();
+
+  /// \brief Return the number of hulls in the memory cache
+  static size_t getNumCachedMeshes();
+
+  /// \brief Compute the convex hull of _points. The vertices of the hull are
+  /// stored in _hull, and the vertex indices of its triangles, oriented
+  /// counterclockwise seen from outside, in _triangles unless it is NULL. If
+  /// the points are coplanar, _hull is a copy of _points and no triangles are
+  /// stored.
+  static void computeConvexHull(const std::vector<Eigen::Vector3d>& _points,
+                                ConvexHull* _hull,
+                                std::vector<Eigen::Vector3i>* _triangles
+                                    = NULL);
+
+  /// \brief Decompose the mesh of _vertices and _triangles into at most
+  /// _maxNumHulls convex hulls. A part is split while its surface is deeper
+  /// inside its hull than _concavity times the diagonal of the bounding box of
+  /// the mesh.
+  static void decompose(const std::vector<Eigen::Vector3d>& _vertices,
+                        const std::vector<Eigen::Vector3i>& _triangles,
+                        double _concavity, size_t _maxNumHulls,
+                        ConvexHulls* _hulls);
+
+  /// \brief Write _hulls to _fileName along with the modification time of the
+  /// mesh file. Return false if the file cannot be written.
+  static bool saveConvexHulls(const std::string& _fileName,
+                              long _modificationTime,
+                              const ConvexHulls& _hulls);
+
+  /// \brief Read _hulls from _fileName. Return false if the file cannot be
+  /// read or was written for a different modification time of the mesh file.
+  static bool loadConvexHulls(const std::string& _fileName,
+                              long _modificationTime,
+                              ConvexHulls* _hulls);
+
+private:
+  /// \brief Collect the vertices and the triangles of all the meshes of
+  /// _mesh
+  static void collectTriangles(const aiScene* _mesh,
+                               std::vector<Eigen::Vector3d>* _vertices,
+                               std::vector<Eigen::Vector3i>* _triangles);
+};
+
+}  // namespace collision
+}  // namespace dart
+
+#endif  // DART_COLLISION_CONVEXDECOMPOSITION_H_
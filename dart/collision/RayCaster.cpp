@@ -0,0 +1,917 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/collision/RayCaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <assimp/scene.h>
+
+#include "dart/common/Console.h"
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/BoxShape.h"
+#include "dart/dynamics/CylinderShape.h"
+#include "dart/dynamics/EllipsoidShape.h"
+#include "dart/dynamics/MeshShape.h"
+#include "dart/dynamics/PlaneShape.h"
+#include "dart/dynamics/Shape.h"
+#include "dart/dynamics/PointMass.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/dynamics/SoftBodyNode.h"
+#include "dart/dynamics/SoftMeshShape.h"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// \brief Smallest magnitude of a direction component that is not treated as
+/// parallel to an axis
+const double DART_RAY_EPSILON = 1e-12;
+
+/// \brief Maximum number of triangles in a leaf of a triangle hierarchy
+const int DART_RAY_LEAF_SIZE = 4;
+
+/// \brief Maximum depth of the traversal stack of a triangle hierarchy
+const int DART_RAY_STACK_SIZE = 64;
+
+/// \brief Return the inverse of each component of _direction. Components that
+/// are almost zero are replaced by a small value of the same sign so that the
+/// slab tests never multiply zero by infinity.
+Eigen::Vector3d computeInverseDirection(const Eigen::Vector3d& _direction) {
+  Eigen::Vector3d invDirection;
+  for (int i = 0; i < 3; ++i) {
+    double component = _direction[i];
+    if (std::abs(component) < DART_RAY_EPSILON)
+      component = component < 0.0 ? -DART_RAY_EPSILON : DART_RAY_EPSILON;
+    invDirection[i] = 1.0 / component;
+  }
+  return invDirection;
+}
+
+/// \brief Order of triangles by the coordinate of their centroids along an
+/// axis
+class CentroidLess {
+public:
+  /// \brief Constructor
+  CentroidLess(const std::vector<Eigen::Vector3d>& _centroids, int _axis)
+    : mCentroids(_centroids), mAxis(_axis) {}
+
+  /// \brief Return true if the centroid of _triangle1 precedes the one of
+  /// _triangle2
+  bool operator()(int _triangle1, int _triangle2) const {
+    return mCentroids[_triangle1][mAxis] < mCentroids[_triangle2][mAxis];
+  }
+
+private:
+  /// \brief Centroids of the triangles
+  const std::vector<Eigen::Vector3d>& mCentroids;
+
+  /// \brief Axis
+  int mAxis;
+};
+
+/// \brief Return true if the ray from _origin along _direction enters the box
+/// of half extents _halfExtents closer than *_distance from outside
+bool intersectBox(const Eigen::Vector3d& _halfExtents,
+                  const Eigen::Vector3d& _origin,
+                  const Eigen::Vector3d& _direction,
+                  double* _distance, Eigen::Vector3d* _normal) {
+  double enter = -std::numeric_limits<double>::infinity();
+  double exit = std::numeric_limits<double>::infinity();
+  int enterAxis = -1;
+
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(_direction[i]) < DART_RAY_EPSILON) {
+      if (std::abs(_origin[i]) > _halfExtents[i])
+        return false;
+      continue;
+    }
+
+    double t0 = (-_halfExtents[i] - _origin[i]) / _direction[i];
+    double t1 = (_halfExtents[i] - _origin[i]) / _direction[i];
+    if (t0 > t1)
+      std::swap(t0, t1);
+
+    if (t0 > enter) {
+      enter = t0;
+      enterAxis = i;
+    }
+    exit = std::min(exit, t1);
+  }
+
+  if (enterAxis < 0 || enter > exit || enter < 0.0 || enter >= *_distance)
+    return false;
+
+  *_distance = enter;
+  _normal->setZero();
+  (*_normal)[enterAxis] = _direction[enterAxis] > 0.0 ? -1.0 : 1.0;
+  return true;
+}
+
+/// \brief Return true if the ray from _origin along _direction enters the
+/// ellipsoid of radii _radii closer than *_distance from outside
+bool intersectEllipsoid(const Eigen::Vector3d& _radii,
+                        const Eigen::Vector3d& _origin,
+                        const Eigen::Vector3d& _direction,
+                        double* _distance, Eigen::Vector3d* _normal) {
+  // Intersect the unit sphere in the coordinates scaled by the radii
+  const Eigen::Vector3d origin = _origin.cwiseQuotient(_radii);
+  const Eigen::Vector3d direction = _direction.cwiseQuotient(_radii);
+
+  const double a = direction.squaredNorm();
+  const double b = origin.dot(direction);
+  const double c = origin.squaredNorm() - 1.0;
+  if (c <= 0.0)
+    return false;
+
+  const double discriminant = b * b - a * c;
+  if (discriminant < 0.0)
+    return false;
+
+  const double t = (-b - std::sqrt(discriminant)) / a;
+  if (t < 0.0 || t >= *_distance)
+    return false;
+
+  *_distance = t;
+  const Eigen::Vector3d point = _origin + t * _direction;
+  *_normal = point.cwiseQuotient(_radii.cwiseProduct(_radii)).normalized();
+  return true;
+}
+
+/// \brief Return true if the ray from _origin along _direction enters the
+/// cylinder of radius _radius and height _height along the z-axis closer than
+/// *_distance from outside
+bool intersectCylinder(double _radius, double _height,
+                       const Eigen::Vector3d& _origin,
+                       const Eigen::Vector3d& _direction,
+                       double* _distance, Eigen::Vector3d* _normal) {
+  double enter = -std::numeric_limits<double>::infinity();
+  double exit = std::numeric_limits<double>::infinity();
+  Eigen::Vector3d enterNormal = Eigen::Vector3d::Zero();
+
+  // Side
+  const double a = _direction.head<2>().squaredNorm();
+  const double b = _origin.head<2>().dot(_direction.head<2>());
+  const double c = _origin.head<2>().squaredNorm() - _radius * _radius;
+  if (a < DART_RAY_EPSILON) {
+    if (c > 0.0)
+      return false;
+  } else {
+    const double discriminant = b * b - a * c;
+    if (discriminant < 0.0)
+      return false;
+
+    const double sqrtDiscriminant = std::sqrt(discriminant);
+    enter = (-b - sqrtDiscriminant) / a;
+    exit = (-b + sqrtDiscriminant) / a;
+    enterNormal << _origin.head<2>() + enter * _direction.head<2>(), 0.0;
+    enterNormal /= _radius;
+  }
+
+  // Caps
+  const double halfHeight = 0.5 * _height;
+  if (std::abs(_direction[2]) < DART_RAY_EPSILON) {
+    if (std::abs(_origin[2]) > halfHeight)
+      return false;
+  } else {
+    double t0 = (-halfHeight - _origin[2]) / _direction[2];
+    double t1 = (halfHeight - _origin[2]) / _direction[2];
+    if (t0 > t1)
+      std::swap(t0, t1);
+
+    if (t0 > enter) {
+      enter = t0;
+      enterNormal = Eigen::Vector3d(0.0, 0.0,
+                                    _direction[2] > 0.0 ? -1.0 : 1.0);
+    }
+    exit = std::min(exit, t1);
+  }
+
+  if (enter > exit || enter < 0.0 || enter >= *_distance)
+    return false;
+
+  *_distance = enter;
+  *_normal = enterNormal;
+  return true;
+}
+
+/// \brief Return true if the ray from _origin along _direction hits the plane
+/// of normal _planeNormal through _planePoint from its front side closer than
+/// *_distance
+bool intersectPlane(const Eigen::Vector3d& _planeNormal,
+                    const Eigen::Vector3d& _planePoint,
+                    const Eigen::Vector3d& _origin,
+                    const Eigen::Vector3d& _direction,
+                    double* _distance, Eigen::Vector3d* _normal) {
+  const double height = _planeNormal.dot(_origin - _planePoint);
+  const double speed = _planeNormal.dot(_direction);
+  if (height <= 0.0 || speed > -DART_RAY_EPSILON)
+    return false;
+
+  const double t = -height / speed;
+  if (t >= *_distance)
+    return false;
+
+  *_distance = t;
+  *_normal = _planeNormal;
+  return true;
+}
+
+}  // namespace
+
+//==============================================================================
+RayCaster::RayCaster()
+  : mIsDirty(true),
+    mNumThreads(1) {
+}
+
+//==============================================================================
+RayCaster::~RayCaster() {
+  for (std::map<MeshKey, TriangleMesh*>::iterator it = mMeshes.begin();
+       it != mMeshes.end(); ++it) {
+    delete it->second;
+  }
+
+  for (size_t i = 0; i < mSoftMeshes.size(); ++i)
+    delete mSoftMeshes[i];
+}
+
+//==============================================================================
+void RayCaster::addSkeleton(dynamics::Skeleton* _skeleton) {
+  assert(_skeleton != NULL && "Null pointer skeleton is now allowed to add.");
+
+  if (std::find(mSkeletons.begin(), mSkeletons.end(), _skeleton)
+      != mSkeletons.end()) {
+    dtwarn << "Skeleton [" << _skeleton->getName()
+           << "] is already added to the ray caster." << std::endl;
+    return;
+  }
+
+  mSkeletons.push_back(_skeleton);
+  mIsDirty = true;
+}
+
+//==============================================================================
+void RayCaster::removeSkeleton(dynamics::Skeleton* _skeleton) {
+  std::vector<dynamics::Skeleton*>::iterator it
+      = std::find(mSkeletons.begin(), mSkeletons.end(), _skeleton);
+  if (it == mSkeletons.end())
+    return;
+
+  mSkeletons.erase(it);
+  mIsDirty = true;
+}
+
+//==============================================================================
+void RayCaster::removeAllSkeletons() {
+  mSkeletons.clear();
+  mIsDirty = true;
+}
+
+//==============================================================================
+void RayCaster::setNumThreads(size_t _numThreads) {
+  if (_numThreads == 0) {
+    dtwarn << "Attempting to set the number of threads to zero. Using a single "
+           << "thread instead." << std::endl;
+    _numThreads = 1;
+  }
+
+#ifndef _OPENMP
+  if (_numThreads > 1) {
+    dtwarn << "DART is built without OpenMP. Only a single thread will be "
+           << "used." << std::endl;
+  }
+#endif
+
+  mNumThreads = _numThreads;
+}
+
+//==============================================================================
+size_t RayCaster::getNumThreads() const {
+  return mNumThreads;
+}
+
+//==============================================================================
+bool RayCaster::castRay(const Eigen::Vector3d& _origin,
+                        const Eigen::Vector3d& _direction,
+                        double _maxDistance, RayHit* _hit) {
+  assert(_hit != NULL);
+
+  updateProxies();
+
+  if (mNearDistances.empty())
+    mNearDistances.resize(1);
+  castRayImpl(_origin, _direction, _maxDistance, &mNearDistances[0], _hit);
+
+  return _hit->isHit;
+}
+
+//==============================================================================
+void RayCaster::castRays(const std::vector<Eigen::Vector3d>& _origins,
+                         const std::vector<Eigen::Vector3d>& _directions,
+                         double _maxDistance, std::vector<RayHit>* _hits) {
+  assert(_hits != NULL);
+  assert(_origins.size() == _directions.size());
+
+  updateProxies();
+
+  _hits->resize(_directions.size());
+  if (mNearDistances.size() < mNumThreads)
+    mNearDistances.resize(mNumThreads);
+
+  const int numRays = static_cast<int>(_directions.size());
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mNumThreads);
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic, 16)
+#endif
+  for (int i = 0; i < numRays; ++i) {
+#ifdef _OPENMP
+    std::vector<double>* nearDistances = &mNearDistances[omp_get_thread_num()];
+#else
+    std::vector<double>* nearDistances = &mNearDistances[0];
+#endif
+    castRayImpl(_origins[i], _directions[i], _maxDistance, nearDistances,
+                &(*_hits)[i]);
+  }
+}
+
+//==============================================================================
+void RayCaster::castRays(const Eigen::Vector3d& _origin,
+                         const std::vector<Eigen::Vector3d>& _directions,
+                         double _maxDistance, std::vector<RayHit>* _hits) {
+  castRays(std::vector<Eigen::Vector3d>(_directions.size(), _origin),
+           _directions, _maxDistance, _hits);
+}
+
+//==============================================================================
+void RayCaster::TriangleMesh::build() {
+  const int numTriangles = static_cast<int>(triangles.size() / 3);
+
+  std::vector<Eigen::Vector3d> centroids(numTriangles);
+  for (int i = 0; i < numTriangles; ++i) {
+    centroids[i] = (vertices[triangles[3 * i]]
+                    + vertices[triangles[3 * i + 1]]
+                    + vertices[triangles[3 * i + 2]]) / 3.0;
+  }
+
+  mOrder.resize(numTriangles);
+  for (int i = 0; i < numTriangles; ++i)
+    mOrder[i] = i;
+
+  mNodes.clear();
+  if (numTriangles == 0)
+    return;
+
+  mNodes.reserve(2 * numTriangles / DART_RAY_LEAF_SIZE + 1);
+  buildNode(0, numTriangles, centroids);
+}
+
+//==============================================================================
+void RayCaster::TriangleMesh::buildNode(
+    int _begin, int _end, const std::vector<Eigen::Vector3d>& _centroids) {
+  Eigen::Vector3d min = Eigen::Vector3d::Constant(
+                          std::numeric_limits<double>::infinity());
+  Eigen::Vector3d max = -min;
+  Eigen::Vector3d centroidMin = min;
+  Eigen::Vector3d centroidMax = max;
+  for (int i = _begin; i < _end; ++i) {
+    const int triangle = mOrder[i];
+    for (int j = 0; j < 3; ++j) {
+      const Eigen::Vector3d& vertex = vertices[triangles[3 * triangle + j]];
+      min = min.cwiseMin(vertex);
+      max = max.cwiseMax(vertex);
+    }
+    centroidMin = centroidMin.cwiseMin(_centroids[triangle]);
+    centroidMax = centroidMax.cwiseMax(_centroids[triangle]);
+  }
+
+  const int nodeIndex = static_cast<int>(mNodes.size());
+  Node node;
+  for (int i = 0; i < 3; ++i) {
+    node.min[i] = min[i];
+    node.max[i] = max[i];
+  }
+  node.index = _begin;
+  node.numTriangles = _end - _begin;
+  mNodes.push_back(node);
+
+  if (_end - _begin <= DART_RAY_LEAF_SIZE)
+    return;
+
+  // Split at the median of the centroids along the longest axis
+  int axis;
+  (centroidMax - centroidMin).maxCoeff(&axis);
+  const int middle = (_begin + _end) / 2;
+  std::nth_element(mOrder.begin() + _begin, mOrder.begin() + middle,
+                   mOrder.begin() + _end, CentroidLess(_centroids, axis));
+
+  buildNode(_begin, middle, _centroids);
+  mNodes[nodeIndex].index = static_cast<int>(mNodes.size());
+  mNodes[nodeIndex].numTriangles = 0;
+  buildNode(middle, _end, _centroids);
+}
+
+//==============================================================================
+void RayCaster::TriangleMesh::refit() {
+  // The children of a node follow it, so the nodes are refit in reverse order
+  for (int i = static_cast<int>(mNodes.size()) - 1; i >= 0; --i) {
+    Node& node = mNodes[i];
+    if (node.numTriangles > 0) {
+      Eigen::Vector3d min = Eigen::Vector3d::Constant(
+                              std::numeric_limits<double>::infinity());
+      Eigen::Vector3d max = -min;
+      for (int j = node.index; j < node.index + node.numTriangles; ++j) {
+        const int triangle = mOrder[j];
+        for (int k = 0; k < 3; ++k) {
+          const Eigen::Vector3d& vertex
+              = vertices[triangles[3 * triangle + k]];
+          min = min.cwiseMin(vertex);
+          max = max.cwiseMax(vertex);
+        }
+      }
+      for (int j = 0; j < 3; ++j) {
+        node.min[j] = min[j];
+        node.max[j] = max[j];
+      }
+    } else {
+      const Node& child1 = mNodes[i + 1];
+      const Node& child2 = mNodes[node.index];
+      for (int j = 0; j < 3; ++j) {
+        node.min[j] = std::min(child1.min[j], child2.min[j]);
+        node.max[j] = std::max(child1.max[j], child2.max[j]);
+      }
+    }
+  }
+}
+
+//==============================================================================
+bool RayCaster::TriangleMesh::intersect(const Eigen::Vector3d& _origin,
+                                        const Eigen::Vector3d& _direction,
+                                        double* _distance,
+                                        Eigen::Vector3d* _normal) const {
+  if (mNodes.empty())
+    return false;
+
+  const Eigen::Vector3d invDirection = computeInverseDirection(_direction);
+  bool isHit = false;
+
+  int stack[DART_RAY_STACK_SIZE];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node& node = mNodes[stack[--stackSize]];
+
+    double near = 0.0;
+    double far = *_distance;
+    for (int i = 0; i < 3; ++i) {
+      const double t0 = (node.min[i] - _origin[i]) * invDirection[i];
+      const double t1 = (node.max[i] - _origin[i]) * invDirection[i];
+      near = std::max(near, std::min(t0, t1));
+      far = std::min(far, std::max(t0, t1));
+    }
+    if (near > far)
+      continue;
+
+    if (node.numTriangles == 0) {
+      assert(stackSize + 2 <= DART_RAY_STACK_SIZE);
+      stack[stackSize++] = node.index;
+      stack[stackSize++] = static_cast<int>(&node - &mNodes[0]) + 1;
+      continue;
+    }
+
+    // Moller-Trumbore test of the triangles of the leaf
+    for (int i = node.index; i < node.index + node.numTriangles; ++i) {
+      const int* triangle = &triangles[3 * mOrder[i]];
+      const Eigen::Vector3d& vertex0 = vertices[triangle[0]];
+      const Eigen::Vector3d edge1 = vertices[triangle[1]] - vertex0;
+      const Eigen::Vector3d edge2 = vertices[triangle[2]] - vertex0;
+
+      const Eigen::Vector3d p = _direction.cross(edge2);
+      const double determinant = edge1.dot(p);
+      if (std::abs(determinant) < DART_RAY_EPSILON)
+        continue;
+      const double invDeterminant = 1.0 / determinant;
+
+      const Eigen::Vector3d s = _origin - vertex0;
+      const double u = s.dot(p) * invDeterminant;
+      if (u < 0.0 || u > 1.0)
+        continue;
+
+      const Eigen::Vector3d q = s.cross(edge1);
+      const double v = _direction.dot(q) * invDeterminant;
+      if (v < 0.0 || u + v > 1.0)
+        continue;
+
+      const double t = edge2.dot(q) * invDeterminant;
+      if (t <= 0.0 || t >= *_distance)
+        continue;
+
+      *_distance = t;
+      *_normal = edge1.cross(edge2).normalized();
+      if (_normal->dot(_direction) > 0.0)
+        *_normal = -*_normal;
+      isHit = true;
+    }
+  }
+
+  return isHit;
+}
+
+//==============================================================================
+Eigen::Vector3d RayCaster::TriangleMesh::getMin() const {
+  if (mNodes.empty())
+    return Eigen::Vector3d::Zero();
+
+  return Eigen::Vector3d(mNodes[0].min[0], mNodes[0].min[1], mNodes[0].min[2]);
+}
+
+//==============================================================================
+Eigen::Vector3d RayCaster::TriangleMesh::getMax() const {
+  if (mNodes.empty())
+    return Eigen::Vector3d::Zero();
+
+  return Eigen::Vector3d(mNodes[0].max[0], mNodes[0].max[1], mNodes[0].max[2]);
+}
+
+//==============================================================================
+bool RayCaster::MeshKey::operator<(const MeshKey& _other) const {
+  if (mesh != _other.mesh)
+    return mesh < _other.mesh;
+
+  return std::lexicographical_compare(scale, scale + 3,
+                                      _other.scale, _other.scale + 3);
+}
+
+//==============================================================================
+void RayCaster::buildProxies() {
+  mProxies.clear();
+  mPlaneProxies.clear();
+
+  for (size_t i = 0; i < mSoftMeshes.size(); ++i)
+    delete mSoftMeshes[i];
+  mSoftMeshes.clear();
+
+  // Keep the triangles of the meshes that are still in use
+  std::map<MeshKey, TriangleMesh*> oldMeshes;
+  oldMeshes.swap(mMeshes);
+
+  for (size_t i = 0; i < mSkeletons.size(); ++i) {
+    dynamics::Skeleton* skeleton = mSkeletons[i];
+    for (size_t j = 0; j < skeleton->getNumBodyNodes(); ++j) {
+      dynamics::BodyNode* bodyNode = skeleton->getBodyNode(j);
+      if (!bodyNode->isCollidable())
+        continue;
+
+      for (size_t k = 0; k < bodyNode->getNumCollisionShapes(); ++k) {
+        dynamics::Shape* shape = bodyNode->getCollisionShape(k);
+
+        ShapeProxy proxy;
+        proxy.bodyNode = bodyNode;
+        proxy.shape = shape;
+        proxy.mesh = NULL;
+        proxy.transform = bodyNode->getTransform() * shape->getLocalTransform();
+
+        switch (shape->getShapeType()) {
+          case dynamics::Shape::BOX:
+          case dynamics::Shape::ELLIPSOID:
+          case dynamics::Shape::CYLINDER:
+            mProxies.push_back(proxy);
+            break;
+          case dynamics::Shape::PLANE:
+            mPlaneProxies.push_back(proxy);
+            break;
+          case dynamics::Shape::MESH:
+          {
+            dynamics::MeshShape* meshShape
+                = static_cast<dynamics::MeshShape*>(shape);
+            if (meshShape->getMesh() == NULL)
+              break;
+
+            MeshKey key;
+            key.mesh = meshShape->getMesh();
+            for (int l = 0; l < 3; ++l)
+              key.scale[l] = meshShape->getScale()[l];
+
+            std::map<MeshKey, TriangleMesh*>::iterator it
+                = oldMeshes.find(key);
+            if (it != oldMeshes.end()) {
+              mMeshes[key] = it->second;
+              oldMeshes.erase(it);
+            }
+            proxy.mesh = getMesh(key.mesh, meshShape->getScale());
+            mProxies.push_back(proxy);
+            break;
+          }
+          case dynamics::Shape::SOFT_MESH:
+          {
+            const dynamics::SoftMeshShape* softMeshShape
+                = static_cast<dynamics::SoftMeshShape*>(shape);
+            const aiMesh* mesh = softMeshShape->getAssimpMesh();
+            TriangleMesh* softMesh = new TriangleMesh();
+            softMesh->triangles.reserve(3 * mesh->mNumFaces);
+            for (unsigned int l = 0; l < mesh->mNumFaces; ++l) {
+              for (unsigned int m = 0; m < 3; ++m)
+                softMesh->triangles.push_back(mesh->mFaces[l].mIndices[m]);
+            }
+
+            // The hierarchy is built once and refit as the point masses move
+            setSoftMeshVertices(softMeshShape, softMesh);
+            softMesh->build();
+            mSoftMeshes.push_back(softMesh);
+
+            proxy.mesh = softMesh;
+            mProxies.push_back(proxy);
+            break;
+          }
+          default:
+            dtwarn << "Ray casting does not support the shape type of ["
+                   << bodyNode->getName() << "]." << std::endl;
+            break;
+        }
+      }
+    }
+  }
+
+  for (std::map<MeshKey, TriangleMesh*>::iterator it = oldMeshes.begin();
+       it != oldMeshes.end(); ++it) {
+    delete it->second;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    mBoxMin[i].resize(mProxies.size());
+    mBoxMax[i].resize(mProxies.size());
+  }
+
+  mIsDirty = false;
+}
+
+//==============================================================================
+void RayCaster::updateProxies() {
+  if (mIsDirty)
+    buildProxies();
+
+  for (size_t i = 0; i < mPlaneProxies.size(); ++i) {
+    ShapeProxy& proxy = mPlaneProxies[i];
+    proxy.transform = proxy.bodyNode->getTransform()
+                      * proxy.shape->getLocalTransform();
+  }
+
+  for (size_t i = 0; i < mProxies.size(); ++i) {
+    ShapeProxy& proxy = mProxies[i];
+    proxy.transform = proxy.bodyNode->getTransform()
+                      * proxy.shape->getLocalTransform();
+
+    Eigen::Vector3d center = Eigen::Vector3d::Zero();
+    Eigen::Vector3d halfExtents;
+    switch (proxy.shape->getShapeType()) {
+      case dynamics::Shape::BOX:
+        halfExtents = 0.5 * static_cast<const dynamics::BoxShape*>(
+                              proxy.shape)->getSize();
+        break;
+      case dynamics::Shape::ELLIPSOID:
+        halfExtents = 0.5 * static_cast<const dynamics::EllipsoidShape*>(
+                              proxy.shape)->getSize();
+        break;
+      case dynamics::Shape::CYLINDER:
+      {
+        const dynamics::CylinderShape* cylinder
+            = static_cast<const dynamics::CylinderShape*>(proxy.shape);
+        halfExtents << cylinder->getRadius(), cylinder->getRadius(),
+                       0.5 * cylinder->getHeight();
+        break;
+      }
+      case dynamics::Shape::SOFT_MESH:
+      {
+        // Refit the soft mesh to the current positions of the point masses
+        setSoftMeshVertices(
+            static_cast<const dynamics::SoftMeshShape*>(proxy.shape),
+            proxy.mesh);
+        proxy.mesh->refit();
+      }
+      // fall through
+      default:
+        center = 0.5 * (proxy.mesh->getMin() + proxy.mesh->getMax());
+        halfExtents = 0.5 * (proxy.mesh->getMax() - proxy.mesh->getMin());
+        break;
+    }
+
+    const Eigen::Vector3d worldCenter = proxy.transform * center;
+    const Eigen::Vector3d worldHalfExtents
+        = proxy.transform.linear().cwiseAbs() * halfExtents;
+    for (int j = 0; j < 3; ++j) {
+      mBoxMin[j][i] = worldCenter[j] - worldHalfExtents[j];
+      mBoxMax[j][i] = worldCenter[j] + worldHalfExtents[j];
+    }
+  }
+}
+
+//==============================================================================
+RayCaster::TriangleMesh* RayCaster::getMesh(const aiScene* _mesh,
+                                            const Eigen::Vector3d& _scale) {
+  MeshKey key;
+  key.mesh = _mesh;
+  for (int i = 0; i < 3; ++i)
+    key.scale[i] = _scale[i];
+
+  std::map<MeshKey, TriangleMesh*>::iterator it = mMeshes.find(key);
+  if (it != mMeshes.end())
+    return it->second;
+
+  TriangleMesh* mesh = new TriangleMesh();
+  for (unsigned int i = 0; i < _mesh->mNumMeshes; ++i) {
+    const aiMesh* subMesh = _mesh->mMeshes[i];
+    const int offset = static_cast<int>(mesh->vertices.size());
+    for (unsigned int j = 0; j < subMesh->mNumVertices; ++j) {
+      const aiVector3D& vertex = subMesh->mVertices[j];
+      mesh->vertices.push_back(Eigen::Vector3d(vertex.x * _scale[0],
+                                               vertex.y * _scale[1],
+                                               vertex.z * _scale[2]));
+    }
+    for (unsigned int j = 0; j < subMesh->mNumFaces; ++j) {
+      if (subMesh->mFaces[j].mNumIndices != 3)
+        continue;
+      for (unsigned int k = 0; k < 3; ++k)
+        mesh->triangles.push_back(offset + subMesh->mFaces[j].mIndices[k]);
+    }
+  }
+  mesh->build();
+
+  mMeshes[key] = mesh;
+  return mesh;
+}
+
+//==============================================================================
+void RayCaster::setSoftMeshVertices(const dynamics::SoftMeshShape* _shape,
+                                    TriangleMesh* _mesh) {
+  // The vertices of a soft mesh are the point masses of its soft body node.
+  // They are w.r.t. the body frame, but the mesh is placed by the transform of
+  // the shape.
+  const dynamics::SoftBodyNode* softBodyNode = _shape->getSoftBodyNode();
+  const Eigen::Isometry3d shapeInverse = _shape->getLocalTransform().inverse();
+  _mesh->vertices.resize(softBodyNode->getNumPointMasses());
+  for (size_t i = 0; i < _mesh->vertices.size(); ++i) {
+    _mesh->vertices[i]
+        = shapeInverse * softBodyNode->getPointMass(i)->getLocalPosition();
+  }
+}
+
+//==============================================================================
+void RayCaster::castRayImpl(const Eigen::Vector3d& _origin,
+                            const Eigen::Vector3d& _direction,
+                            double _maxDistance,
+                            std::vector<double>* _nearDistances,
+                            RayHit* _hit) const {
+  _hit->isHit = false;
+  _hit->distance = _maxDistance;
+  _hit->normal.setZero();
+  _hit->bodyNode = NULL;
+
+  double distance = _maxDistance;
+  Eigen::Vector3d normal;
+
+  // Test the ray against all the bounding boxes at once. The boxes are stored
+  // as arrays of each coordinate and the loop has no branches so that the
+  // compiler can vectorize it.
+  const size_t numProxies = mProxies.size();
+  _nearDistances->resize(numProxies);
+  const Eigen::Vector3d invDirection = computeInverseDirection(_direction);
+  const double ox = _origin[0];
+  const double oy = _origin[1];
+  const double oz = _origin[2];
+  const double ix = invDirection[0];
+  const double iy = invDirection[1];
+  const double iz = invDirection[2];
+  const double* minX = mBoxMin[0].empty() ? NULL : &mBoxMin[0][0];
+  const double* minY = mBoxMin[1].empty() ? NULL : &mBoxMin[1][0];
+  const double* minZ = mBoxMin[2].empty() ? NULL : &mBoxMin[2][0];
+  const double* maxX = mBoxMax[0].empty() ? NULL : &mBoxMax[0][0];
+  const double* maxY = mBoxMax[1].empty() ? NULL : &mBoxMax[1][0];
+  const double* maxZ = mBoxMax[2].empty() ? NULL : &mBoxMax[2][0];
+  double* nearDistances
+      = _nearDistances->empty() ? NULL : &(*_nearDistances)[0];
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < numProxies; ++i) {
+    const double x0 = (minX[i] - ox) * ix;
+    const double x1 = (maxX[i] - ox) * ix;
+    const double y0 = (minY[i] - oy) * iy;
+    const double y1 = (maxY[i] - oy) * iy;
+    const double z0 = (minZ[i] - oz) * iz;
+    const double z1 = (maxZ[i] - oz) * iz;
+    const double near = std::max(std::max(std::min(x0, x1), std::min(y0, y1)),
+                                 std::max(std::min(z0, z1), 0.0));
+    const double far = std::min(std::min(std::max(x0, x1), std::max(y0, y1)),
+                                std::min(std::max(z0, z1), _maxDistance));
+    nearDistances[i] = near <= far ? near : infinity;
+  }
+
+  for (size_t i = 0; i < numProxies; ++i) {
+    if (nearDistances[i] >= distance)
+      continue;
+
+    const ShapeProxy& proxy = mProxies[i];
+    const Eigen::Vector3d origin = proxy.transform.inverse() * _origin;
+    const Eigen::Vector3d direction
+        = proxy.transform.linear().transpose() * _direction;
+    if (intersectShape(proxy, origin, direction, &distance, &normal)) {
+      _hit->isHit = true;
+      _hit->normal = proxy.transform.linear() * normal;
+      _hit->bodyNode = proxy.bodyNode;
+    }
+  }
+
+  for (size_t i = 0; i < mPlaneProxies.size(); ++i) {
+    const ShapeProxy& proxy = mPlaneProxies[i];
+    const Eigen::Vector3d origin = proxy.transform.inverse() * _origin;
+    const Eigen::Vector3d direction
+        = proxy.transform.linear().transpose() * _direction;
+    if (intersectShape(proxy, origin, direction, &distance, &normal)) {
+      _hit->isHit = true;
+      _hit->normal = proxy.transform.linear() * normal;
+      _hit->bodyNode = proxy.bodyNode;
+    }
+  }
+
+  _hit->distance = distance;
+  _hit->point = _origin + distance * _direction;
+}
+
+//==============================================================================
+bool RayCaster::intersectShape(const ShapeProxy& _proxy,
+                               const Eigen::Vector3d& _origin,
+                               const Eigen::Vector3d& _direction,
+                               double* _distance, Eigen::Vector3d* _normal) {
+  switch (_proxy.shape->getShapeType()) {
+    case dynamics::Shape::BOX:
+      return intersectBox(
+            0.5 * static_cast<const dynamics::BoxShape*>(
+              _proxy.shape)->getSize(),
+            _origin, _direction, _distance, _normal);
+    case dynamics::Shape::ELLIPSOID:
+      return intersectEllipsoid(
+            0.5 * static_cast<const dynamics::EllipsoidShape*>(
+              _proxy.shape)->getSize(),
+            _origin, _direction, _distance, _normal);
+    case dynamics::Shape::CYLINDER:
+    {
+      const dynamics::CylinderShape* cylinder
+          = static_cast<const dynamics::CylinderShape*>(_proxy.shape);
+      return intersectCylinder(cylinder->getRadius(), cylinder->getHeight(),
+                               _origin, _direction, _distance, _normal);
+    }
+    case dynamics::Shape::PLANE:
+    {
+      const dynamics::PlaneShape* plane
+          = static_cast<const dynamics::PlaneShape*>(_proxy.shape);
+      return intersectPlane(plane->getNormal(), plane->getPoint(),
+                            _origin, _direction, _distance, _normal);
+    }
+    default:
+      return _proxy.mesh->intersect(_origin, _direction, _distance, _normal);
+  }
+}
+
+}  // namespace collision
+}  // namespace dart
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_COLLISION_RAYCASTER_H_
+#define DART_COLLISION_RAYCASTER_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+struct aiScene;
+
+namespace dart {
+namespace dynamics {
+class BodyNode;
+class Shape;
+class Skeleton;
+class SoftMeshShape;
+}  // namespace dynamics
+}  // namespace dart
+
+namespace dart {
+namespace collision {
+
+/// \brief Result of casting a ray
+struct RayHit {
+  // To get byte-aligned Eigen vectors
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// \brief Whether the ray hit a collision shape within the maximum distance
+  bool isHit;
+
+  /// \brief Distance from the origin of the ray to the hit point, or the
+  /// maximum distance if the ray did not hit anything
+  double distance;
+
+  /// \brief Hit point w.r.t. the world frame
+  Eigen::Vector3d point;
+
+  /// \brief Normal of the hit surface facing the origin of the ray w.r.t. the
+  /// world frame
+  Eigen::Vector3d normal;
+
+  /// \brief Body node of the hit collision shape, or NULL
+  dynamics::BodyNode* bodyNode;
+};
+
+/// \brief RayCaster casts rays against the collision shapes of skeletons
+///
+/// Boxes, ellipsoids, cylinders, planes, meshes and soft meshes are supported.
+/// The bounding boxes of the shapes are stored as separate arrays of each
+/// coordinate so that the compiler can vectorize the ray-box tests, and every
+/// mesh has its own bounding volume hierarchy of triangles. Batches of rays are
+/// cast by several threads. Boxes, ellipsoids, cylinders and planes that
+/// contain the origin of a ray are ignored, so a sensor can be placed inside
+/// the body that carries it. The triangles of meshes are two-sided.
+class RayCaster {
+public:
+  /// \brief Constructor
+  RayCaster();
+
+  /// \brief Destructor
+  ~RayCaster();
+
+  /// \brief Add the collision shapes of the body nodes of _skeleton
+  void addSkeleton(dynamics::Skeleton* _skeleton);
+
+  /// \brief Remove the collision shapes of the body nodes of _skeleton
+  void removeSkeleton(dynamics::Skeleton* _skeleton);
+
+  /// \brief Remove all the skeletons
+  void removeAllSkeletons();
+
+  /// \brief Set the number of threads used to cast batches of rays. The
+  /// default is 1 (serial).
+  void setNumThreads(size_t _numThreads);
+
+  /// \brief Get the number of threads used to cast batches of rays
+  size_t getNumThreads() const;
+
+  /// \brief Cast a ray from _origin along the unit vector _direction up to
+  /// _maxDistance. Return true if the ray hit a collision shape.
+  bool castRay(const Eigen::Vector3d& _origin,
+               const Eigen::Vector3d& _direction,
+               double _maxDistance, RayHit* _hit);
+
+  /// \brief Cast rays from _origins along the unit vectors _directions up to
+  /// _maxDistance
+  void castRays(const std::vector<Eigen::Vector3d>& _origins,
+                const std::vector<Eigen::Vector3d>& _directions,
+                double _maxDistance, std::vector<RayHit>* _hits);
+
+  /// \brief Cast rays from a single origin along the unit vectors _directions
+  /// up to _maxDistance
+  void castRays(const Eigen::Vector3d& _origin,
+                const std::vector<Eigen::Vector3d>& _directions,
+                double _maxDistance, std::vector<RayHit>* _hits);
+
+private:
+  /// \brief Bounding volume hierarchy of the triangles of a mesh
+  class TriangleMesh {
+  public:
+    /// \brief Build the hierarchy of the triangles of the vertices
+    void build();
+
+    /// \brief Update the bounding boxes of the hierarchy to the moved
+    /// vertices, keeping the tree that was built
+    void refit();
+
+    /// \brief Return true if the ray from _origin along _direction hits a
+    /// triangle closer than *_distance, and store the distance and the normal
+    /// of the triangle
+    bool intersect(const Eigen::Vector3d& _origin,
+                   const Eigen::Vector3d& _direction,
+                   double* _distance, Eigen::Vector3d* _normal) const;
+
+    /// \brief Minimum corner of the bounding box of the mesh
+    Eigen::Vector3d getMin() const;
+
+    /// \brief Maximum corner of the bounding box of the mesh
+    Eigen::Vector3d getMax() const;
+
+    /// \brief Vertices of the mesh
+    std::vector<Eigen::Vector3d> vertices;
+
+    /// \brief Vertex indices of the triangles, three per triangle
+    std::vector<int> triangles;
+
+  private:
+    /// \brief Node of the hierarchy
+    struct Node {
+      /// \brief Minimum corner of the bounding box
+      double min[3];
+
+      /// \brief Maximum corner of the bounding box
+      double max[3];
+
+      /// \brief Index of the second child of an inner node, whose first child
+      /// follows the node, or the first triangle of a leaf in mOrder
+      int index;
+
+      /// \brief Number of triangles of a leaf, or 0 for an inner node
+      int numTriangles;
+    };
+
+    /// \brief Build the subtree of the triangles mOrder[_begin.._end)
+    void buildNode(int _begin, int _end,
+                   const std::vector<Eigen::Vector3d>& _centroids);
+
+    /// \brief Nodes of the hierarchy in depth-first order
+    std::vector<Node> mNodes;
+
+    /// \brief Triangles in the order of the leaves
+    std::vector<int> mOrder;
+  };
+
+  /// \brief Collision shape and its world transform
+  struct ShapeProxy {
+    // To get byte-aligned Eigen vectors
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /// \brief Body node of the shape
+    dynamics::BodyNode* bodyNode;
+
+    /// \brief Collision shape
+    dynamics::Shape* shape;
+
+    /// \brief Triangles of a mesh or a soft mesh shape, or NULL
+    TriangleMesh* mesh;
+
+    /// \brief Transform of the shape w.r.t. the world frame
+    Eigen::Isometry3d transform;
+  };
+
+  typedef std::vector<ShapeProxy, Eigen::aligned_allocator<ShapeProxy> >
+      ShapeProxies;
+
+  /// \brief Key of the triangles of a mesh at a scale
+  struct MeshKey {
+    /// \brief Mesh
+    const aiScene* mesh;
+
+    /// \brief Scale
+    double scale[3];
+
+    /// \brief Lexicographical ordering
+    bool operator<(const MeshKey& _other) const;
+  };
+
+  /// \brief Rebuild the proxies of the skeletons
+  void buildProxies();
+
+  /// \brief Update the transforms, the bounding boxes and the soft meshes of
+  /// the proxies
+  void updateProxies();
+
+  /// \brief Return the triangles of _mesh scaled by _scale
+  TriangleMesh* getMesh(const aiScene* _mesh, const Eigen::Vector3d& _scale);
+
+  /// \brief Set the vertices of _mesh to the positions of the point masses of
+  /// the soft body node of _shape w.r.t. the frame of _shape
+  static void setSoftMeshVertices(const dynamics::SoftMeshShape* _shape,
+                                  TriangleMesh* _mesh);
+
+  /// \brief Cast a ray against the proxies, which are up to date.
+  /// _nearDistances is scratch memory for the ray-box tests.
+  void castRayImpl(const Eigen::Vector3d& _origin,
+                   const Eigen::Vector3d& _direction, double _maxDistance,
+                   std::vector<double>* _nearDistances, RayHit* _hit) const;
+
+  /// \brief Return true if the ray from _origin along _direction w.r.t. the
+  /// frame of the proxy hits the shape of the proxy closer than *_distance,
+  /// and store the distance and the normal w.r.t. the frame of the proxy
+  static bool intersectShape(const ShapeProxy& _proxy,
+                             const Eigen::Vector3d& _origin,
+                             const Eigen::Vector3d& _direction,
+                             double* _distance, Eigen::Vector3d* _normal);
+
+  /// \brief Skeletons whose collision shapes are cast against
+  std::vector<dynamics::Skeleton*> mSkeletons;
+
+  /// \brief Whether the proxies need to be rebuilt
+  bool mIsDirty;
+
+  /// \brief Number of threads used to cast batches of rays
+  size_t mNumThreads;
+
+  /// \brief Proxies of the bounded shapes
+  ShapeProxies mProxies;
+
+  /// \brief Proxies of the planes, which are unbounded
+  ShapeProxies mPlaneProxies;
+
+  /// \brief Minimum corners of the world bounding boxes of mProxies, one array
+  /// per coordinate
+  std::vector<double> mBoxMin[3];
+
+  /// \brief Maximum corners of the world bounding boxes of mProxies, one array
+  /// per coordinate
+  std::vector<double> mBoxMax[3];
+
+  /// \brief Triangles of the meshes, shared by the shapes of the same mesh
+  /// and scale
+  std::map<MeshKey, TriangleMesh*> mMeshes;
+
+  /// \brief Triangles of the soft meshes, which are refit before every cast
+  std::vector<TriangleMesh*> mSoftMeshes;
+
+  /// \brief Scratch memory of the ray-box tests, one per thread
+  std::vector<std::vector<double> > mNearDistances;
+};
+
+}  // namespace collision
+}  // namespace dart
+
+#endif  // DART_COLLISION_RAYCASTER_H_
@@ -36,12 +36,19 @@
 
 #include "dart/collision/dart/DARTCollide.h"
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 
 #include "dart/math/Helpers.h"
 #include "dart/dynamics/BoxShape.h"
 #include "dart/dynamics/EllipsoidShape.h"
 #include "dart/dynamics/CylinderShape.h"
+#include "dart/dynamics/MeshShape.h"
+#include "dart/dynamics/SoftMeshShape.h"
+#include "dart/dynamics/SoftBodyNode.h"
+#include "dart/dynamics/PointMass.h"
+#include "dart/collision/ConvexDecomposition.h"
 
 namespace dart {
 namespace collision {
@@ -57,6 +64,14 @@ static const int nCYLINDER_AXIS			 = 2;
 // Must be divisible by 4.
 static const int nCYLINDER_SEGMENT		 = 8;
 
+// Tolerance of the support values of the vertices of the contact faces of
+// convex geometries relative to the extent of the geometries along the normal
+static const double DART_CONTACT_FACE_TOLERANCE = 0.02;
+
+// Number of vertices of the polygons that approximate the caps of cylinders
+// in the contact faces of convex geometries
+static const int DART_CONTACT_FACE_CYLINDER_SEGMENTS = 16;
+
 typedef double dVector3[4];
 typedef double dVector3[4];
 typedef double dVector4[4];
@@ -1215,13 +1230,160 @@ int collideCylinderPlane(const double& cyl_rad, const double& half_height, const
   return 0;
 }
 
+//==============================================================================
+ConvexGeometry::ConvexGeometry(const dynamics::Shape* _shape,
+                               const Eigen::Isometry3d& _transform)
+  : shape(_shape),
+    vertices(NULL),
+    scale(Eigen::Vector3d::Ones()),
+    transform(_transform)
+{
+}
+
+//==============================================================================
+ConvexGeometry::ConvexGeometry(const std::vector<Eigen::Vector3d>* _vertices,
+                               const Eigen::Vector3d& _scale,
+                               const Eigen::Isometry3d& _transform)
+  : shape(NULL),
+    vertices(_vertices),
+    scale(_scale),
+    transform(_transform)
+{
+}
+
+typedef std::vector<ConvexGeometry, Eigen::aligned_allocator<ConvexGeometry> >
+    ConvexGeometries;
+
+//==============================================================================
+// Append the convex geometries of _shape at _T to _geometries, which are the
+// convex hulls _hulls for a mesh. If _hulls is NULL, the hulls of the mesh are
+// looked up, and _sharedHulls keeps them alive while the geometries are used.
+// The hull of a soft mesh is the point masses, which are stored in
+// _softMeshVertices. Return false if _shape is not supported.
+static bool getConvexGeometries(
+    const dynamics::Shape* _shape, const Eigen::Isometry3d& _T,
+    const ConvexHulls* _hulls,
+    std::shared_ptr<const ConvexHulls>* _sharedHulls,
+    std::vector<Eigen::Vector3d>* _softMeshVertices,
+    ConvexGeometries* _geometries)
+{
+  switch (_shape->getShapeType())
+  {
+    case dynamics::Shape::BOX:
+    case dynamics::Shape::ELLIPSOID:
+    case dynamics::Shape::CYLINDER:
+      _geometries->push_back(ConvexGeometry(_shape, _T));
+      return true;
+    case dynamics::Shape::MESH:
+    {
+      const dynamics::MeshShape* mesh
+          = static_cast<const dynamics::MeshShape*>(_shape);
+      if (mesh->getMesh() == NULL)
+        return false;
+
+      if (_hulls == NULL)
+      {
+        *_sharedHulls = ConvexDecomposition::getConvexHulls(mesh->getMesh());
+        _hulls = _sharedHulls->get();
+      }
+
+      for (size_t i = 0; i < _hulls->size(); ++i)
+      {
+        if (!(*_hulls)[i].empty())
+        {
+          _geometries->push_back(
+                ConvexGeometry(&(*_hulls)[i], mesh->getScale(), _T));
+        }
+      }
+      return true;
+    }
+    case dynamics::Shape::SOFT_MESH:
+    {
+      // The point masses are w.r.t. the body frame, and _T is the transform of
+      // the shape
+      const dynamics::SoftBodyNode* softBodyNode
+          = static_cast<const dynamics::SoftMeshShape*>(_shape)
+            ->getSoftBodyNode();
+      if (softBodyNode->getNumPointMasses() == 0)
+        return false;
+
+      const Eigen::Isometry3d shapeInverse
+          = _shape->getLocalTransform().inverse();
+      _softMeshVertices->resize(softBodyNode->getNumPointMasses());
+      for (size_t i = 0; i < _softMeshVertices->size(); ++i)
+      {
+        (*_softMeshVertices)[i]
+            = shapeInverse
+              * softBodyNode->getPointMass(i)->getLocalPosition();
+      }
+
+      _geometries->push_back(ConvexGeometry(_softMeshVertices,
+                                            Eigen::Vector3d::Ones(), _T));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+//==============================================================================
+// Collide the convex geometries of two shapes of which at least one is a mesh
+// or a soft mesh
+static int collideConvexGeometries(
+    const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+    const ConvexHulls* _hulls0,
+    const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+    const ConvexHulls* _hulls1,
+    std::vector<Contact>* _result)
+{
+  std::shared_ptr<const ConvexHulls> sharedHulls0;
+  std::shared_ptr<const ConvexHulls> sharedHulls1;
+  std::vector<Eigen::Vector3d> softMeshVertices0;
+  std::vector<Eigen::Vector3d> softMeshVertices1;
+  ConvexGeometries geometries0;
+  ConvexGeometries geometries1;
+  if (!getConvexGeometries(_shape0, _T0, _hulls0, &sharedHulls0,
+                           &softMeshVertices0, &geometries0)
+      || !getConvexGeometries(_shape1, _T1, _hulls1, &sharedHulls1,
+                              &softMeshVertices1, &geometries1))
+  {
+    return 0;
+  }
+
+  int numContacts = 0;
+  for (size_t i = 0; i < geometries0.size(); ++i)
+  {
+    for (size_t j = 0; j < geometries1.size(); ++j)
+      numContacts += collideConvex(geometries0[i], geometries1[j], _result);
+  }
+
+  return numContacts;
+}
+
 int collide(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
             const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
             std::vector<Contact>* _result)
+{
+  return collide(_shape0, _T0, NULL, _shape1, _T1, NULL, _result);
+}
+
+int collide(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+            const ConvexHulls* _hulls0,
+            const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+            const ConvexHulls* _hulls1,
+            std::vector<Contact>* _result)
 {
   dynamics::Shape::ShapeType LeftType = _shape0->getShapeType();
   dynamics::Shape::ShapeType RightType = _shape1->getShapeType();
 
+  if (LeftType == dynamics::Shape::MESH || RightType == dynamics::Shape::MESH
+      || LeftType == dynamics::Shape::SOFT_MESH
+      || RightType == dynamics::Shape::SOFT_MESH)
+  {
+    return collideConvexGeometries(_shape0, _T0, _hulls0, _shape1, _T1,
+                                   _hulls1, _result);
+  }
+
   switch(LeftType)
   {
     case dynamics::Shape::BOX:
@@ -1353,7 +1515,838 @@ int collide(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
   }
 }
 
+//==============================================================================
+// Return the support point of _geometry in direction _dir, which is the point
+// of the geometry farthest along _dir w.r.t. the world frame
+static Eigen::Vector3d computeSupportPoint(const ConvexGeometry& _geometry,
+                                           const Eigen::Vector3d& _dir)
+{
+  Eigen::Vector3d localDir = _geometry.transform.linear().transpose() * _dir;
+  Eigen::Vector3d point = Eigen::Vector3d::Zero();
 
+  if (_geometry.vertices)
+  {
+    const std::vector<Eigen::Vector3d>& vertices = *_geometry.vertices;
+    Eigen::Vector3d scaledDir = _geometry.scale.cwiseProduct(localDir);
+    double maxDot = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+      double dot = vertices[i].dot(scaledDir);
+      if (dot > maxDot)
+      {
+        maxDot = dot;
+        point = vertices[i];
+      }
+    }
+
+    return _geometry.transform * _geometry.scale.cwiseProduct(point);
+  }
+
+  switch (_geometry.shape->getShapeType())
+  {
+    case dynamics::Shape::BOX:
+    {
+      const Eigen::Vector3d& size
+          = static_cast<const dynamics::BoxShape*>(_geometry.shape)->getSize();
+      for (int i = 0; i < 3; ++i)
+        point[i] = localDir[i] >= 0.0 ? 0.5 * size[i] : -0.5 * size[i];
+      break;
+    }
+    case dynamics::Shape::ELLIPSOID:
+    {
+      Eigen::Vector3d radii = 0.5
+          * static_cast<const dynamics::EllipsoidShape*>(
+              _geometry.shape)->getSize();
+      Eigen::Vector3d scaledDir = radii.cwiseProduct(localDir);
+      double norm = scaledDir.norm();
+      if (norm > DART_COLLISION_EPS * DART_COLLISION_EPS)
+        point = radii.cwiseProduct(scaledDir) / norm;
+      break;
+    }
+    case dynamics::Shape::CYLINDER:
+    {
+      const dynamics::CylinderShape* cylinder
+          = static_cast<const dynamics::CylinderShape*>(_geometry.shape);
+      double norm = localDir.head<2>().norm();
+      if (norm > DART_COLLISION_EPS * DART_COLLISION_EPS)
+        point.head<2>() = cylinder->getRadius() / norm * localDir.head<2>();
+      point[2] = localDir[2] >= 0.0 ? 0.5 * cylinder->getHeight()
+                                    : -0.5 * cylinder->getHeight();
+      break;
+    }
+    default:
+      break;
+  }
+
+  return _geometry.transform * point;
+}
+
+//==============================================================================
+// Return the support point of the Minkowski difference of the geometries in
+// direction _dir, and store its witness points in _a and _b
+static Eigen::Vector3d computeSupportPoint(const ConvexGeometry& _geometry0,
+                                           const ConvexGeometry& _geometry1,
+                                           const Eigen::Vector3d& _dir,
+                                           Eigen::Vector3d* _a,
+                                           Eigen::Vector3d* _b)
+{
+  *_a = computeSupportPoint(_geometry0, _dir);
+  *_b = computeSupportPoint(_geometry1, -_dir);
+  return *_a - *_b;
+}
+
+//==============================================================================
+// Find the point of the simplex _w[0.._n) closest to the origin. The point is
+// the combination of the vertices weighted by _lambda, and the vertices of
+// zero weight are removed from the simplex along with their witness points.
+static Eigen::Vector3d computeClosestPointOnSimplex(
+    Eigen::Vector3d _w[4], Eigen::Vector3d _a[4], Eigen::Vector3d _b[4],
+    double _lambda[4], int* _n)
+{
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3>
+      SmallMatrix;
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 3, 1> SmallVector;
+
+  // The closest point lies in the relative interior of one of the faces of the
+  // simplex, so the projections of the origin onto the affine hulls of all the
+  // faces that lie inside the faces are compared
+  double minDistance2 = std::numeric_limits<double>::infinity();
+  Eigen::Vector3d closest = _w[0];
+  int bestMask = 1;
+  double bestLambda[4] = {1.0, 0.0, 0.0, 0.0};
+
+  for (int mask = 1; mask < (1 << *_n); ++mask)
+  {
+    int indices[4];
+    int m = 0;
+    for (int i = 0; i < *_n; ++i)
+    {
+      if (mask & (1 << i))
+        indices[m++] = i;
+    }
+
+    // Minimize |w0 + sum_j mu_j (w_j - w0)|^2
+    double lambda[4] = {1.0, 0.0, 0.0, 0.0};
+    if (m > 1)
+    {
+      SmallMatrix edges(3, m - 1);
+      for (int j = 1; j < m; ++j)
+        edges.col(j - 1) = _w[indices[j]] - _w[indices[0]];
+      SmallMatrix gram = edges.transpose() * edges;
+      SmallVector mu = gram.ldlt().solve(-edges.transpose() * _w[indices[0]]);
+
+      bool isInside = true;
+      for (int j = 1; j < m; ++j)
+      {
+        lambda[j] = mu[j - 1];
+        lambda[0] -= mu[j - 1];
+        if (!(mu[j - 1] > 0.0))
+          isInside = false;
+      }
+      if (!isInside || !(lambda[0] > 0.0))
+        continue;
+    }
+
+    Eigen::Vector3d point = Eigen::Vector3d::Zero();
+    for (int j = 0; j < m; ++j)
+      point += lambda[j] * _w[indices[j]];
+
+    double distance2 = point.squaredNorm();
+    if (distance2 < minDistance2)
+    {
+      minDistance2 = distance2;
+      closest = point;
+      bestMask = mask;
+      for (int j = 0; j < 4; ++j)
+        bestLambda[j] = lambda[j];
+    }
+  }
+
+  // Keep only the vertices of the closest face
+  int m = 0;
+  for (int i = 0; i < *_n; ++i)
+  {
+    if (!(bestMask & (1 << i)))
+      continue;
+
+    _w[m] = _w[i];
+    _a[m] = _a[i];
+    _b[m] = _b[i];
+    _lambda[m] = bestLambda[m];
+    ++m;
+  }
+  *_n = m;
+
+  return closest;
+}
+
+//==============================================================================
+// Run GJK on the Minkowski difference of the geometries, which is the set of
+// the vectors from the points of _geometry1 to the points of _geometry0. The
+// final simplex is stored in _w[0.._n) along with the witness points _a and
+// _b, and the point of the simplex closest to the origin is the combination
+// of the vertices weighted by _lambda. Return true if the geometries
+// intersect.
+static bool runGJK(const ConvexGeometry& _geometry0,
+                   const ConvexGeometry& _geometry1,
+                   Eigen::Vector3d _w[4], Eigen::Vector3d _a[4],
+                   Eigen::Vector3d _b[4], double _lambda[4], int* _n)
+{
+  Eigen::Vector3d dir = _geometry1.transform.translation()
+                        - _geometry0.transform.translation();
+  if (dir.squaredNorm() < DART_COLLISION_EPS * DART_COLLISION_EPS)
+    dir = Eigen::Vector3d::UnitX();
+  _w[0] = computeSupportPoint(_geometry0, _geometry1, dir, &_a[0], &_b[0]);
+  _lambda[0] = 1.0;
+  *_n = 1;
+  Eigen::Vector3d v = _w[0];
+
+  const int maxIterations = 64;
+  const double tolerance = 1e-10;
+  for (int iter = 0; iter < maxIterations; ++iter)
+  {
+    double v2 = v.squaredNorm();
+    if (v2 < tolerance * tolerance)
+      return true;
+
+    Eigen::Vector3d newA;
+    Eigen::Vector3d newB;
+    Eigen::Vector3d newW
+        = computeSupportPoint(_geometry0, _geometry1, -v, &newA, &newB);
+
+    // No point of the Minkowski difference is closer to the origin than v
+    if (v2 - v.dot(newW) <= tolerance * std::max(v2, 1.0))
+      return false;
+
+    for (int i = 0; i < *_n; ++i)
+    {
+      if (_w[i] == newW)
+        return false;
+    }
+
+    _w[*_n] = newW;
+    _a[*_n] = newA;
+    _b[*_n] = newB;
+    ++*_n;
+
+    v = computeClosestPointOnSimplex(_w, _a, _b, _lambda, _n);
+
+    // The origin is inside the tetrahedron
+    if (*_n == 4)
+      return true;
+  }
+
+  return false;
+}
+
+//==============================================================================
+// Face of the polytope of EPA
+struct PolytopeFace
+{
+  // Indices of the vertices, counterclockwise seen from outside
+  int vertices[3];
+
+  // Outward unit normal
+  Eigen::Vector3d normal;
+
+  // Distance of the plane of the face from the origin, or infinity if the face
+  // is degenerate
+  double distance;
+
+  // Whether the face is part of the polytope
+  bool isAlive;
+};
+
+//==============================================================================
+// Return the face _i, _j, _k of the polytope of the vertices _w
+static PolytopeFace makePolytopeFace(const std::vector<Eigen::Vector3d>& _w,
+                                     int _i, int _j, int _k)
+{
+  PolytopeFace face;
+  face.vertices[0] = _i;
+  face.vertices[1] = _j;
+  face.vertices[2] = _k;
+  face.normal = (_w[_j] - _w[_i]).cross(_w[_k] - _w[_i]);
+  double norm = face.normal.norm();
+  if (norm > DART_COLLISION_EPS * DART_COLLISION_EPS)
+  {
+    face.normal /= norm;
+    face.distance = face.normal.dot(_w[_i]);
+  }
+  else
+  {
+    face.distance = std::numeric_limits<double>::infinity();
+  }
+  face.isAlive = true;
+  return face;
+}
+
+//==============================================================================
+// Expand the simplex _w[0.._n) that contains the origin into a tetrahedron,
+// and run EPA to find the face of the Minkowski difference closest to the
+// origin. The contact is stored in _contact. Return false if the simplex
+// cannot be expanded, which happens when the geometries only touch.
+static bool runEPA(const ConvexGeometry& _geometry0,
+                   const ConvexGeometry& _geometry1,
+                   const Eigen::Vector3d _w[4], const Eigen::Vector3d _a[4],
+                   const Eigen::Vector3d _b[4], int _n, Contact* _contact)
+{
+  std::vector<Eigen::Vector3d> w(_w, _w + _n);
+  std::vector<Eigen::Vector3d> a(_a, _a + _n);
+  std::vector<Eigen::Vector3d> b(_b, _b + _n);
+  Eigen::Vector3d newA;
+  Eigen::Vector3d newB;
+  Eigen::Vector3d newW;
+
+  // Add a vertex off the line or the plane of a degenerate simplex
+  if (w.size() == 1)
+  {
+    for (int i = 0; i < 6 && w.size() < 2; ++i)
+    {
+      Eigen::Vector3d dir = Eigen::Vector3d::Unit(i / 2);
+      if (i % 2 == 1)
+        dir = -dir;
+      newW = computeSupportPoint(_geometry0, _geometry1, dir, &newA, &newB);
+      if ((newW - w[0]).norm() > DART_COLLISION_EPS)
+      {
+        w.push_back(newW);
+        a.push_back(newA);
+        b.push_back(newB);
+      }
+    }
+  }
+
+  if (w.size() == 2)
+  {
+    Eigen::Vector3d line = (w[1] - w[0]).normalized();
+    int axis;
+    line.cwiseAbs().minCoeff(&axis);
+    Eigen::Vector3d dir = line.cross(Eigen::Vector3d::Unit(axis)).normalized();
+    Eigen::AngleAxisd rotation(DART_PI / 3.0, line);
+    for (int i = 0; i < 6 && w.size() < 3; ++i)
+    {
+      newW = computeSupportPoint(_geometry0, _geometry1, dir, &newA, &newB);
+      if (line.cross(newW - w[0]).norm() > DART_COLLISION_EPS)
+      {
+        w.push_back(newW);
+        a.push_back(newA);
+        b.push_back(newB);
+      }
+      dir = rotation * dir;
+    }
+  }
+
+  if (w.size() == 3)
+  {
+    Eigen::Vector3d normal = (w[1] - w[0]).cross(w[2] - w[0]).normalized();
+    for (int i = 0; i < 2 && w.size() < 4; ++i)
+    {
+      newW = computeSupportPoint(_geometry0, _geometry1,
+                                 i == 0 ? normal : -normal, &newA, &newB);
+      if (std::abs(normal.dot(newW - w[0])) > DART_COLLISION_EPS)
+      {
+        w.push_back(newW);
+        a.push_back(newA);
+        b.push_back(newB);
+      }
+    }
+  }
+
+  if (w.size() < 4)
+    return false;
+
+  // Orient the faces of the tetrahedron outward
+  static const int tetrahedron[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2},
+                                        {0, 2, 3, 1}, {1, 3, 2, 0}};
+  std::vector<PolytopeFace> faces;
+  for (int i = 0; i < 4; ++i)
+  {
+    const int* v = tetrahedron[i];
+    if ((w[v[1]] - w[v[0]]).cross(w[v[2]] - w[v[0]]).dot(w[v[3]] - w[v[0]])
+        > 0.0)
+    {
+      faces.push_back(makePolytopeFace(w, v[0], v[2], v[1]));
+    }
+    else
+    {
+      faces.push_back(makePolytopeFace(w, v[0], v[1], v[2]));
+    }
+  }
+
+  // Push the face closest to the origin out to the boundary of the Minkowski
+  // difference until it cannot move
+  const int maxIterations = 256;
+  size_t closest = 0;
+  std::vector<std::pair<int, int> > horizon;
+  for (int iter = 0; iter < maxIterations; ++iter)
+  {
+    closest = faces.size();
+    for (size_t i = 0; i < faces.size(); ++i)
+    {
+      if (faces[i].isAlive
+          && (closest == faces.size()
+              || faces[i].distance < faces[closest].distance))
+      {
+        closest = i;
+      }
+    }
+    if (closest == faces.size()
+        || faces[closest].distance == std::numeric_limits<double>::infinity())
+    {
+      return false;
+    }
+
+    newW = computeSupportPoint(_geometry0, _geometry1, faces[closest].normal,
+                               &newA, &newB);
+    if (faces[closest].normal.dot(newW) - faces[closest].distance
+        < DART_COLLISION_EPS)
+    {
+      break;
+    }
+
+    const int index = static_cast<int>(w.size());
+    w.push_back(newW);
+    a.push_back(newA);
+    b.push_back(newB);
+
+    // Remove the faces seen from the new vertex, and connect the vertex to the
+    // edges of the hole, which are the edges of only one removed face
+    horizon.clear();
+    for (size_t i = 0; i < faces.size(); ++i)
+    {
+      PolytopeFace& face = faces[i];
+      if (!face.isAlive
+          || face.normal.dot(newW - w[face.vertices[0]]) <= 0.0)
+      {
+        continue;
+      }
+
+      face.isAlive = false;
+      for (int j = 0; j < 3; ++j)
+      {
+        std::pair<int, int> edge(face.vertices[j], face.vertices[(j + 1) % 3]);
+        std::vector<std::pair<int, int> >::iterator twin = std::find(
+              horizon.begin(), horizon.end(),
+              std::make_pair(edge.second, edge.first));
+        if (twin != horizon.end())
+          horizon.erase(twin);
+        else
+          horizon.push_back(edge);
+      }
+    }
+
+    for (size_t i = 0; i < horizon.size(); ++i)
+    {
+      faces.push_back(
+            makePolytopeFace(w, horizon[i].first, horizon[i].second, index));
+    }
+  }
+
+  // The contact points are the witness points of the projection of the
+  // origin onto the closest face
+  const PolytopeFace& face = faces[closest];
+  const Eigen::Vector3d projection = face.distance * face.normal;
+  const Eigen::Vector3d& w0 = w[face.vertices[0]];
+  const Eigen::Vector3d& w1 = w[face.vertices[1]];
+  const Eigen::Vector3d& w2 = w[face.vertices[2]];
+  const double area = (w1 - w0).cross(w2 - w0).dot(face.normal);
+  double lambda1 = (projection - w0).cross(w2 - w0).dot(face.normal) / area;
+  double lambda2 = (w1 - w0).cross(projection - w0).dot(face.normal) / area;
+  double lambda0 = 1.0 - lambda1 - lambda2;
+
+  Eigen::Vector3d point0 = lambda0 * a[face.vertices[0]]
+                           + lambda1 * a[face.vertices[1]]
+                           + lambda2 * a[face.vertices[2]];
+  Eigen::Vector3d point1 = lambda0 * b[face.vertices[0]]
+                           + lambda1 * b[face.vertices[1]]
+                           + lambda2 * b[face.vertices[2]];
+
+  _contact->point = 0.5 * (point0 + point1);
+  _contact->normal = -face.normal;
+  _contact->penetrationDepth = std::max(face.distance, 0.0);
+
+  return true;
+}
+
+//==============================================================================
+// Store in _face the vertices of _geometry w.r.t. the world frame whose
+// support values along _dir are within the tolerance of the maximum, which are
+// the vertices of the face, the edge or the vertex of the geometry that faces
+// _dir. Return false for an ellipsoid, which has no such vertices.
+static bool computeContactFace(const ConvexGeometry& _geometry,
+                               const Eigen::Vector3d& _dir,
+                               std::vector<Eigen::Vector3d>* _face)
+{
+  std::vector<Eigen::Vector3d> vertices;
+  if (_geometry.vertices)
+  {
+    vertices.reserve(_geometry.vertices->size());
+    for (size_t i = 0; i < _geometry.vertices->size(); ++i)
+    {
+      vertices.push_back(_geometry.transform
+                         * _geometry.scale.cwiseProduct(
+                             (*_geometry.vertices)[i]));
+    }
+  }
+  else if (_geometry.shape->getShapeType() == dynamics::Shape::BOX)
+  {
+    const Eigen::Vector3d& size
+        = static_cast<const dynamics::BoxShape*>(_geometry.shape)->getSize();
+    for (int i = 0; i < 8; ++i)
+    {
+      Eigen::Vector3d corner(i & 1 ? 0.5 * size[0] : -0.5 * size[0],
+                             i & 2 ? 0.5 * size[1] : -0.5 * size[1],
+                             i & 4 ? 0.5 * size[2] : -0.5 * size[2]);
+      vertices.push_back(_geometry.transform * corner);
+    }
+  }
+  else if (_geometry.shape->getShapeType() == dynamics::Shape::CYLINDER)
+  {
+    const dynamics::CylinderShape* cylinder
+        = static_cast<const dynamics::CylinderShape*>(_geometry.shape);
+    for (int i = 0; i < DART_CONTACT_FACE_CYLINDER_SEGMENTS; ++i)
+    {
+      double angle = 2.0 * DART_PI * i / DART_CONTACT_FACE_CYLINDER_SEGMENTS;
+      Eigen::Vector3d rim(cylinder->getRadius() * std::cos(angle),
+                          cylinder->getRadius() * std::sin(angle),
+                          0.5 * cylinder->getHeight());
+      vertices.push_back(_geometry.transform * rim);
+      rim[2] = -rim[2];
+      vertices.push_back(_geometry.transform * rim);
+    }
+  }
+  else
+  {
+    return false;
+  }
+
+  double maxDot = -std::numeric_limits<double>::infinity();
+  double minDot = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    maxDot = std::max(maxDot, vertices[i].dot(_dir));
+    minDot = std::min(minDot, vertices[i].dot(_dir));
+  }
+
+  const double tolerance = DART_CONTACT_FACE_TOLERANCE * (maxDot - minDot)
+                           + DART_COLLISION_EPS;
+  _face->clear();
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    if (vertices[i].dot(_dir) >= maxDot - tolerance)
+      _face->push_back(vertices[i]);
+  }
+
+  return !_face->empty();
+}
+
+//==============================================================================
+// Vertex of a contact face projected onto the plane of the contact normal
+struct ProjectedVertex
+{
+  // Coordinates in the plane
+  double x;
+  double y;
+
+  // Index of the vertex in the face
+  int index;
+};
+
+//==============================================================================
+// Lexicographical order of projected vertices
+class ProjectedVertexLess
+{
+public:
+  bool operator()(const ProjectedVertex& _vertex1,
+                  const ProjectedVertex& _vertex2) const
+  {
+    if (_vertex1.x != _vertex2.x)
+      return _vertex1.x < _vertex2.x;
+    return _vertex1.y < _vertex2.y;
+  }
+};
+
+//==============================================================================
+// Return twice the signed area of the triangle _o, _a, _b of projected
+// vertices, which is positive if the triangle is counterclockwise
+static double computeSignedArea(const ProjectedVertex& _o,
+                                const ProjectedVertex& _a,
+                                const ProjectedVertex& _b)
+{
+  return (_a.x - _o.x) * (_b.y - _o.y) - (_a.y - _o.y) * (_b.x - _o.x);
+}
+
+//==============================================================================
+// Replace the vertices of _face by the vertices of their convex hull projected
+// onto the plane of _normal, counterclockwise about _normal. The hull is a
+// segment or a single vertex if the projections are collinear or coincide.
+static void makeConvexPolygon(const Eigen::Vector3d& _normal,
+                              std::vector<Eigen::Vector3d>* _face)
+{
+  int axis;
+  _normal.cwiseAbs().minCoeff(&axis);
+  const Eigen::Vector3d u
+      = _normal.cross(Eigen::Vector3d::Unit(axis)).normalized();
+  const Eigen::Vector3d v = _normal.cross(u);
+
+  std::vector<ProjectedVertex> vertices(_face->size());
+  for (size_t i = 0; i < _face->size(); ++i)
+  {
+    vertices[i].x = u.dot((*_face)[i]);
+    vertices[i].y = v.dot((*_face)[i]);
+    vertices[i].index = static_cast<int>(i);
+  }
+  std::sort(vertices.begin(), vertices.end(), ProjectedVertexLess());
+
+  // Monotone chain, which drops the vertices on the edges of the hull
+  const double eps = DART_COLLISION_EPS * DART_COLLISION_EPS;
+  std::vector<ProjectedVertex> hull(2 * vertices.size());
+  int n = 0;
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    while (n >= 2
+           && computeSignedArea(hull[n - 2], hull[n - 1], vertices[i]) <= eps)
+      --n;
+    hull[n++] = vertices[i];
+  }
+  for (int i = static_cast<int>(vertices.size()) - 2, lower = n + 1; i >= 0;
+       --i)
+  {
+    while (n >= lower
+           && computeSignedArea(hull[n - 2], hull[n - 1], vertices[i]) <= eps)
+      --n;
+    hull[n++] = vertices[i];
+  }
+  if (n > 1)
+    --n;
+
+  // Coinciding projections leave a degenerate edge
+  if (n == 2 && std::abs(hull[0].x - hull[1].x) <= DART_COLLISION_EPS
+      && std::abs(hull[0].y - hull[1].y) <= DART_COLLISION_EPS)
+    n = 1;
+
+  std::vector<Eigen::Vector3d> polygon(n);
+  for (int i = 0; i < n; ++i)
+    polygon[i] = (*_face)[hull[i].index];
+  _face->swap(polygon);
+}
+
+//==============================================================================
+// Clip the convex polygon _incident by the planes through the edges of the
+// convex polygon _reference that are parallel to _normal. The vertices of
+// _reference are counterclockwise about _normal, and _incident may be a
+// segment or a single vertex.
+static void clipPolygon(const std::vector<Eigen::Vector3d>& _reference,
+                        const Eigen::Vector3d& _normal,
+                        std::vector<Eigen::Vector3d>* _incident)
+{
+  std::vector<Eigen::Vector3d> clipped;
+  for (size_t i = 0; i < _reference.size() && !_incident->empty(); ++i)
+  {
+    const Eigen::Vector3d& a = _reference[i];
+    const Eigen::Vector3d& b = _reference[(i + 1) % _reference.size()];
+    const Eigen::Vector3d inward = _normal.cross(b - a);
+
+    clipped.clear();
+    for (size_t j = 0; j < _incident->size(); ++j)
+    {
+      const Eigen::Vector3d& p = (*_incident)[j];
+      const Eigen::Vector3d& q = (*_incident)[(j + 1) % _incident->size()];
+      const double dp = inward.dot(p - a);
+      const double dq = inward.dot(q - a);
+      if (dp >= 0.0)
+        clipped.push_back(p);
+      if ((dp > 0.0 && dq < 0.0) || (dp < 0.0 && dq > 0.0))
+        clipped.push_back(p + dp / (dp - dq) * (q - p));
+    }
+    _incident->swap(clipped);
+  }
+}
+
+//==============================================================================
+// Add the contacts of the faces of the geometries that face each other along
+// the normal of _contact, which is the contact of the deepest penetration, to
+// _result. Return the number of contacts, which is zero if either face is a
+// single vertex or an edge against an edge.
+static int collideContactFaces(const ConvexGeometry& _geometry0,
+                               const ConvexGeometry& _geometry1,
+                               const Contact& _contact,
+                               std::vector<Contact>* _result)
+{
+  // The face of _geometry1 faces along the normal, and the one of _geometry0
+  // against it
+  std::vector<Eigen::Vector3d> reference;
+  std::vector<Eigen::Vector3d> incident;
+  if (!computeContactFace(_geometry1, _contact.normal, &reference)
+      || !computeContactFace(_geometry0, -_contact.normal, &incident))
+    return 0;
+
+  makeConvexPolygon(_contact.normal, &reference);
+  makeConvexPolygon(_contact.normal, &incident);
+
+  // The incident face is clipped by the reference face, which must be a
+  // polygon
+  Eigen::Vector3d normal = _contact.normal;
+  if (reference.size() < 3)
+  {
+    if (incident.size() < 3)
+      return 0;
+
+    reference.swap(incident);
+    std::reverse(reference.begin(), reference.end());
+    normal = -normal;
+  }
+
+  double height = -std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < reference.size(); ++i)
+    height = std::max(height, normal.dot(reference[i]));
+
+  clipPolygon(reference, normal, &incident);
+
+  const size_t begin = _result->size();
+  for (size_t i = 0; i < incident.size(); ++i)
+  {
+    // The incident vertices in front of the reference face do not touch it
+    const double depth = height - normal.dot(incident[i]);
+    if (depth < 0.0)
+      continue;
+
+    const Eigen::Vector3d point = incident[i] + 0.5 * depth * normal;
+    bool isDuplicate = false;
+    for (size_t j = begin; j < _result->size() && !isDuplicate; ++j)
+      isDuplicate = ((*_result)[j].point - point).norm() < DART_COLLISION_EPS;
+    if (isDuplicate)
+      continue;
+
+    Contact contact = _contact;
+    contact.point = point;
+    contact.penetrationDepth = depth;
+    _result->push_back(contact);
+  }
+
+  return static_cast<int>(_result->size() - begin);
+}
+
+//==============================================================================
+int collideConvex(const ConvexGeometry& _geometry0,
+                  const ConvexGeometry& _geometry1,
+                  std::vector<Contact>* _result)
+{
+  Eigen::Vector3d w[4];
+  Eigen::Vector3d a[4];
+  Eigen::Vector3d b[4];
+  double lambda[4];
+  int n;
+  if (!runGJK(_geometry0, _geometry1, w, a, b, lambda, &n))
+    return 0;
+
+  Contact contact;
+  if (!runEPA(_geometry0, _geometry1, w, a, b, n, &contact))
+    return 0;
+
+  // A single contact lets a body resting on a face rock about it, so the
+  // contact is replaced by the ones of the touching faces
+  int numContacts = collideContactFaces(_geometry0, _geometry1, contact,
+                                        _result);
+  if (numContacts > 0)
+    return numContacts;
+
+  _result->push_back(contact);
+  return 1;
+}
+
+//==============================================================================
+void distance(const ConvexGeometry& _geometry0,
+              const ConvexGeometry& _geometry1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1)
+{
+  Eigen::Vector3d w[4];
+  Eigen::Vector3d a[4];
+  Eigen::Vector3d b[4];
+  double lambda[4];
+  int n;
+  if (runGJK(_geometry0, _geometry1, w, a, b, lambda, &n))
+  {
+    *_distance = 0.0;
+    if (_point0)
+      *_point0 = a[0];
+    if (_point1)
+      *_point1 = a[0];
+    return;
+  }
+
+  Eigen::Vector3d point0 = Eigen::Vector3d::Zero();
+  Eigen::Vector3d point1 = Eigen::Vector3d::Zero();
+  for (int i = 0; i < n; ++i)
+  {
+    point0 += lambda[i] * a[i];
+    point1 += lambda[i] * b[i];
+  }
+
+  *_distance = (point0 - point1).norm();
+  if (_point0)
+    *_point0 = point0;
+  if (_point1)
+    *_point1 = point1;
+}
+
+//==============================================================================
+bool distance(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+              const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1)
+{
+  return distance(_shape0, _T0, NULL, _shape1, _T1, NULL, _distance,
+                  _point0, _point1);
+}
+
+//==============================================================================
+bool distance(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+              const ConvexHulls* _hulls0,
+              const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+              const ConvexHulls* _hulls1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1)
+{
+  std::shared_ptr<const ConvexHulls> sharedHulls0;
+  std::shared_ptr<const ConvexHulls> sharedHulls1;
+  std::vector<Eigen::Vector3d> softMeshVertices0;
+  std::vector<Eigen::Vector3d> softMeshVertices1;
+  ConvexGeometries geometries0;
+  ConvexGeometries geometries1;
+  if (!getConvexGeometries(_shape0, _T0, _hulls0, &sharedHulls0,
+                           &softMeshVertices0, &geometries0)
+      || !getConvexGeometries(_shape1, _T1, _hulls1, &sharedHulls1,
+                              &softMeshVertices1, &geometries1)
+      || geometries0.empty() || geometries1.empty())
+  {
+    return false;
+  }
+
+  *_distance = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < geometries0.size(); ++i)
+  {
+    for (size_t j = 0; j < geometries1.size(); ++j)
+    {
+      double distance;
+      Eigen::Vector3d point0;
+      Eigen::Vector3d point1;
+      collision::distance(geometries0[i], geometries1[j], &distance,
+                          &point0, &point1);
+      if (distance < *_distance)
+      {
+        *_distance = distance;
+        if (_point0)
+          *_point0 = point0;
+        if (_point1)
+          *_point1 = point1;
+      }
+    }
+  }
+
+  return true;
+}
 
 } // namespace collision
 } // namespace dart
@@ -42,6 +42,7 @@
 #include <Eigen/Dense>
 
 #include "dart/collision/CollisionDetector.h"
+#include "dart/collision/ConvexDecomposition.h"
 
 namespace dart {
 namespace dynamics {
@@ -52,10 +53,26 @@ class Shape;
 namespace dart {
 namespace collision {
 
+/// Collide two shapes and add the contacts to _result. A mesh is
+/// approximated by the convex hulls of ConvexDecomposition, which are collided
+/// with boxes, ellipsoids, cylinders and the hulls of other meshes by
+/// collideConvex(). A soft mesh is approximated by the convex hull of the
+/// point masses of its soft body node. The contacts carry no triangle
+/// indices. Return the number of contacts.
 int collide(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
             const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
             std::vector<Contact>* _result);
 
+/// Collide two shapes like collide() above with the convex hulls _hulls0 and
+/// _hulls1 of the shapes that are meshes, which the caller keeps so that the
+/// hulls are not looked up in ConvexDecomposition on every call. The hulls of
+/// a mesh are looked up if they are NULL, and ignored for other shapes.
+int collide(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+            const ConvexHulls* _hulls0,
+            const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+            const ConvexHulls* _hulls1,
+            std::vector<Contact>* _result);
+
 int collideBoxBox(const Eigen::Vector3d& size0, const Eigen::Isometry3d& T0,
                   const Eigen::Vector3d& size1, const Eigen::Isometry3d& T1,
                   std::vector<Contact>* result);
@@ -84,6 +101,78 @@ int collideCylinderPlane(
     const Eigen::Vector3d& plane_normal, const Eigen::Isometry3d& T1,
     std::vector<Contact>* result);
 
+/// Convex geometry for GJK and EPA, which is either a box, an ellipsoid or a
+/// cylinder, or the convex hull of a set of vertices scaled along each axis
+struct ConvexGeometry
+{
+  // To get byte-aligned Eigen vectors
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// Constructor for a box, an ellipsoid or a cylinder at _transform
+  ConvexGeometry(const dynamics::Shape* _shape,
+                 const Eigen::Isometry3d& _transform);
+
+  /// Constructor for the convex hull of _vertices scaled by _scale at
+  /// _transform. The vertices are not copied.
+  ConvexGeometry(const std::vector<Eigen::Vector3d>* _vertices,
+                 const Eigen::Vector3d& _scale,
+                 const Eigen::Isometry3d& _transform);
+
+  /// Primitive shape, or NULL for a convex hull
+  const dynamics::Shape* shape;
+
+  /// Vertices of the convex hull, or NULL for a primitive shape
+  const std::vector<Eigen::Vector3d>* vertices;
+
+  /// Scale of the vertices
+  Eigen::Vector3d scale;
+
+  /// Transform of the geometry w.r.t. the world frame
+  Eigen::Isometry3d transform;
+};
+
+/// Collide two convex geometries by GJK, and compute the normal of the
+/// deepest penetration by EPA. The contacts are the vertices of the faces of
+/// the geometries that face each other along the normal, clipped against each
+/// other, so that a box resting on a hull is supported at its corners. If
+/// either face is a single point, as for ellipsoids, the contact of the
+/// deepest penetration is the only one. The normal of the contacts points
+/// from _geometry1 to _geometry0. Return the number of contacts added to
+/// _result.
+int collideConvex(const ConvexGeometry& _geometry0,
+                  const ConvexGeometry& _geometry1,
+                  std::vector<Contact>* _result);
+
+/// Compute the minimum distance between two convex geometries by GJK. The
+/// distance is zero if the geometries intersect. The closest points are
+/// stored in _point0 and _point1 w.r.t. the world frame unless they are NULL.
+void distance(const ConvexGeometry& _geometry0,
+              const ConvexGeometry& _geometry1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1);
+
+/// Compute the minimum distance between two convex primitive shapes (box,
+/// ellipsoid and cylinder), meshes or soft meshes by GJK. A mesh is
+/// approximated by the convex hulls of ConvexDecomposition, and a soft mesh by
+/// the convex hull of its point masses. The distance is zero if the shapes
+/// intersect. The closest points are stored in _point0 and _point1 w.r.t. the
+/// world frame unless they are NULL. Return false if a shape is not
+/// supported.
+bool distance(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+              const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1);
+
+/// Compute the minimum distance between two shapes like distance() above with
+/// the convex hulls _hulls0 and _hulls1 of the shapes that are meshes, which
+/// are looked up if they are NULL as in collide().
+bool distance(const dynamics::Shape* _shape0, const Eigen::Isometry3d& _T0,
+              const ConvexHulls* _hulls0,
+              const dynamics::Shape* _shape1, const Eigen::Isometry3d& _T1,
+              const ConvexHulls* _hulls1,
+              double* _distance,
+              Eigen::Vector3d* _point0, Eigen::Vector3d* _point1);
+
 }  // namespace collision
 }  // namespace dart
 
@@ -36,17 +36,29 @@
 
 #include "dart/collision/dart/DARTCollisionDetector.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 #include "dart/dynamics/Shape.h"
 #include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/EllipsoidShape.h"
+#include "dart/dynamics/MeshShape.h"
+#include "dart/dynamics/SoftMeshShape.h"
+#include "dart/dynamics/SoftBodyNode.h"
+#include "dart/dynamics/PointMass.h"
+#include "dart/collision/ConvexDecomposition.h"
 #include "dart/collision/dart/DARTCollide.h"
+#include "dart/collision/dart/DARTCollisionNode.h"
 
 namespace dart {
 namespace collision {
 
 DARTCollisionDetector::DARTCollisionDetector()
-  : CollisionDetector() {
+  : CollisionDetector(),
+    mIsBroadphaseDirty(true),
+    mNumDetections(0) {
 }
 
 DARTCollisionDetector::~DARTCollisionDetector() {
@@ -54,7 +66,19 @@ DARTCollisionDetector::~DARTCollisionDetector() {
 
 CollisionNode* DARTCollisionDetector::createCollisionNode(
     dynamics::BodyNode* _bodyNode) {
-  return new CollisionNode(_bodyNode);
+  return new DARTCollisionNode(_bodyNode);
+}
+
+void DARTCollisionDetector::addCollisionSkeletonNode(
+    dynamics::BodyNode* _bodyNode, bool _isRecursive) {
+  CollisionDetector::addCollisionSkeletonNode(_bodyNode, _isRecursive);
+  mIsBroadphaseDirty = true;
+}
+
+void DARTCollisionDetector::removeCollisionSkeletonNode(
+    dynamics::BodyNode* _bodyNode, bool _isRecursive) {
+  CollisionDetector::removeCollisionSkeletonNode(_bodyNode, _isRecursive);
+  mIsBroadphaseDirty = true;
 }
 
 bool DARTCollisionDetector::detectCollision(bool /*_checkAllCollisions*/,
@@ -65,66 +89,50 @@ bool DARTCollisionDetector::detectCollision(bool /*_checkAllCollisions*/,
   for (size_t i = 0; i < mCollisionNodes.size(); i++)
     mCollisionNodes[i]->getBodyNode()->setColliding(false);
 
-  std::vector<Contact> contacts;
+  // Only the collidable shape pairs whose bounding boxes overlap reach the
+  // narrowphase
+  updateBroadphase();
+  findOverlappingPairs();
 
-  for (size_t i = 0; i < mCollisionNodes.size(); i++) {
-    for (size_t j = i + 1; j < mCollisionNodes.size(); j++) {
-      CollisionNode* collNode1 = mCollisionNodes[i];
-      CollisionNode* collNode2 = mCollisionNodes[j];
-      dynamics::BodyNode* BodyNode1 = collNode1->getBodyNode();
-      dynamics::BodyNode* BodyNode2 = collNode2->getBodyNode();
+  // Pairs that were separated by more than their relative motion since then
+  // cannot touch, which is common in quasi-static scenes
+  updatePairCaches();
 
-      if (!isCollidable(collNode1, collNode2))
-        continue;
+  // The pairs are independent, so they can be checked concurrently. Each
+  // thread adds the contacts to its own buffer, and the buffers are merged in
+  // the order of the pairs.
+  const int numPairs = static_cast<int>(mOverlappingPairs.size());
+  int numSkippedPairs = 0;
+  beginNarrowphase(numPairs);
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mNumThreads);
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic) reduction(+:numSkippedPairs)
+#endif
+  for (int i = 0; i < numPairs; ++i) {
+    const BroadphasePair& pair = mOverlappingPairs[i];
+    const BroadphaseProxy& proxy1 = mBroadphaseProxies[pair.proxy1];
+    const BroadphaseProxy& proxy2 = mBroadphaseProxies[pair.proxy2];
+    PairCache* cache = mOverlappingPairCaches[i];
 
-      for (size_t k = 0; k < BodyNode1->getNumCollisionShapes(); k++) {
-        for (size_t l = 0; l < BodyNode2->getNumCollisionShapes(); l++) {
-          int currContactNum = mContacts.size();
-
-          contacts.clear();
-          collide(BodyNode1->getCollisionShape(k),
-                  BodyNode1->getTransform()
-                  * BodyNode1->getCollisionShape(k)->getLocalTransform(),
-                  BodyNode2->getCollisionShape(l),
-                  BodyNode2->getTransform()
-                  * BodyNode2->getCollisionShape(l)->getLocalTransform(),
-                  &contacts);
-
-          size_t numContacts = contacts.size();
-
-          for (unsigned int m = 0; m < numContacts; ++m) {
-            Contact contactPair;
-            contactPair = contacts[m];
-            contactPair.bodyNode1 = BodyNode1;
-            contactPair.bodyNode2 = BodyNode2;
-            assert(contactPair.bodyNode1 != NULL);
-            assert(contactPair.bodyNode2 != NULL);
-
-            mContacts.push_back(contactPair);
-          }
+    size_t buffer = getNarrowphaseBufferIndex();
+    size_t begin = mNarrowphaseBuffers[buffer].contacts.size();
 
-          std::vector<bool> markForDeletion(numContacts, false);
-          for (size_t m = 0; m < numContacts; m++) {
-            for (size_t n = m + 1; n < numContacts; n++) {
-              Eigen::Vector3d diff =
-                  mContacts[currContactNum + m].point -
-                  mContacts[currContactNum + n].point;
-              if (diff.dot(diff) < 1e-6) {
-                markForDeletion[m] = true;
-                break;
-              }
-            }
-          }
+    if (isSeparated(proxy1, proxy2, *cache)) {
+      ++numSkippedPairs;
+    } else {
+      collideShapes(proxy1, proxy2, &mNarrowphaseBuffers[buffer].contacts);
 
-          for (int m = numContacts - 1; m >= 0; m--)
-          {
-            if (markForDeletion[m])
-              mContacts.erase(mContacts.begin() + currContactNum + m);
-          }
-        }
-      }
+      if (mNarrowphaseBuffers[buffer].contacts.size() == begin)
+        cacheSeparation(proxy1, proxy2, cache);
+      else
+        cache->separation = -1.0;
     }
+
+    endNarrowphasePair(i, buffer, begin);
   }
+  mNumSkippedPairs = static_cast<size_t>(numSkippedPairs);
+  endNarrowphase();
 
   for (size_t i = 0; i < mContacts.size(); ++i)
   {
@@ -136,27 +144,476 @@ bool DARTCollisionDetector::detectCollision(bool /*_checkAllCollisions*/,
   return !mContacts.empty();
 }
 
+void DARTCollisionDetector::collideShapes(const BroadphaseProxy& _proxy1,
+                                          const BroadphaseProxy& _proxy2,
+                                          std::vector<Contact>* _contacts) {
+  dynamics::BodyNode* BodyNode1 = _proxy1.node->getBodyNode();
+  dynamics::BodyNode* BodyNode2 = _proxy2.node->getBodyNode();
+  dynamics::Shape* shape1 = BodyNode1->getCollisionShape(_proxy1.shapeIndex);
+  dynamics::Shape* shape2 = BodyNode2->getCollisionShape(_proxy2.shapeIndex);
+
+  size_t currContactNum = _contacts->size();
+
+  collide(shape1, _proxy1.transform, _proxy1.hulls.get(),
+          shape2, _proxy2.transform, _proxy2.hulls.get(), _contacts);
+
+  for (size_t m = currContactNum; m < _contacts->size(); ++m) {
+    Contact& contactPair = (*_contacts)[m];
+    contactPair.bodyNode1 = BodyNode1;
+    contactPair.bodyNode2 = BodyNode2;
+    contactPair.shape1 = shape1;
+    contactPair.shape2 = shape2;
+    assert(contactPair.bodyNode1 != NULL);
+    assert(contactPair.bodyNode2 != NULL);
+  }
+}
+
+void DARTCollisionDetector::updateBroadphase() {
+  // Rebuild the proxies when collision nodes were added or removed, or when
+  // the collision shapes of the body nodes changed
+  if (!mIsBroadphaseDirty) {
+    size_t numProxies = 0;
+    for (size_t i = 0; i < mCollisionNodes.size(); ++i) {
+      dynamics::BodyNode* bodyNode = mCollisionNodes[i]->getBodyNode();
+      for (size_t j = 0; j < bodyNode->getNumCollisionShapes(); ++j) {
+        if (isSupportedShape(bodyNode->getCollisionShape(j)))
+          ++numProxies;
+      }
+    }
+
+    mIsBroadphaseDirty = numProxies != mBroadphaseProxies.size();
+  }
+
+  if (mIsBroadphaseDirty) {
+    mBroadphaseProxies.clear();
+    mPairCaches.clear();
+    for (size_t i = 0; i < mCollisionNodes.size(); ++i) {
+      dynamics::BodyNode* bodyNode = mCollisionNodes[i]->getBodyNode();
+      for (size_t j = 0; j < bodyNode->getNumCollisionShapes(); ++j) {
+        if (!isSupportedShape(bodyNode->getCollisionShape(j)))
+          continue;
+
+        BroadphaseProxy proxy;
+        proxy.node = mCollisionNodes[i];
+        proxy.shapeIndex = j;
+        proxy.id = mBroadphaseProxies.size();
+        proxy.mesh = NULL;
+        mBroadphaseProxies.push_back(proxy);
+      }
+    }
+
+    mIsBroadphaseDirty = false;
+  }
+
+  // Update the world bounding boxes from the body transforms
+  for (size_t i = 0; i < mBroadphaseProxies.size(); ++i) {
+    BroadphaseProxy& proxy = mBroadphaseProxies[i];
+    dynamics::BodyNode* bodyNode = proxy.node->getBodyNode();
+    dynamics::Shape* shape = bodyNode->getCollisionShape(proxy.shapeIndex);
+
+    proxy.transform = bodyNode->getTransform() * shape->getLocalTransform();
+
+    Eigen::Vector3d localCenter;
+    Eigen::Vector3d localHalfExtents;
+    computeLocalBoundingBox(&proxy, &localCenter, &localHalfExtents);
+    Eigen::Vector3d center = proxy.transform * localCenter;
+    Eigen::Vector3d halfExtents
+        = proxy.transform.linear().cwiseAbs() * localHalfExtents;
+    proxy.min = center - halfExtents;
+    proxy.max = center + halfExtents;
+    proxy.radius = localCenter.norm() + localHalfExtents.norm();
+  }
+
+  // Sort the proxies along the x-axis. Bodies move little between time steps,
+  // so the order is nearly kept and insertion sort runs in linear time.
+  for (size_t i = 1; i < mBroadphaseProxies.size(); ++i) {
+    if (mBroadphaseProxies[i - 1].min[0] <= mBroadphaseProxies[i].min[0])
+      continue;
+
+    BroadphaseProxy proxy = mBroadphaseProxies[i];
+    size_t j = i;
+    for (; j > 0 && mBroadphaseProxies[j - 1].min[0] > proxy.min[0]; --j)
+      mBroadphaseProxies[j] = mBroadphaseProxies[j - 1];
+    mBroadphaseProxies[j] = proxy;
+  }
+}
+
+void DARTCollisionDetector::findOverlappingPairs() {
+  mOverlappingPairs.clear();
+
+  // Sweep along the x-axis and test the other axes of the pairs whose x
+  // intervals overlap
+  const size_t numProxies = mBroadphaseProxies.size();
+  for (size_t i = 0; i < numProxies; ++i) {
+    const BroadphaseProxy& proxy1 = mBroadphaseProxies[i];
+
+    for (size_t j = i + 1; j < numProxies; ++j) {
+      const BroadphaseProxy& proxy2 = mBroadphaseProxies[j];
+
+      if (proxy2.min[0] > proxy1.max[0])
+        break;
+
+      if (proxy1.node == proxy2.node)
+        continue;
+
+      if (proxy2.min[1] > proxy1.max[1] || proxy1.min[1] > proxy2.max[1]
+          || proxy2.min[2] > proxy1.max[2] || proxy1.min[2] > proxy2.max[2])
+        continue;
+
+      if (!isCollidable(proxy1.node, proxy2.node))
+        continue;
+
+      BroadphasePair pair;
+      if (proxy1.node->getIndex() < proxy2.node->getIndex()) {
+        pair.proxy1 = i;
+        pair.proxy2 = j;
+      } else {
+        pair.proxy1 = j;
+        pair.proxy2 = i;
+      }
+      mOverlappingPairs.push_back(pair);
+    }
+  }
+
+  // Report the pairs in the order of the collision nodes and their shapes so
+  // that the contacts do not depend on the sweep order
+  std::sort(mOverlappingPairs.begin(), mOverlappingPairs.end(),
+            BroadphasePairLess(mBroadphaseProxies));
+}
+
+void DARTCollisionDetector::updatePairCaches() {
+  ++mNumDetections;
+
+  mOverlappingPairCaches.resize(mOverlappingPairs.size());
+  for (size_t i = 0; i < mOverlappingPairs.size(); ++i) {
+    const BroadphasePair& pair = mOverlappingPairs[i];
+    PairCacheKey key(mBroadphaseProxies[pair.proxy1].id,
+                     mBroadphaseProxies[pair.proxy2].id);
+
+    PairCacheMap::iterator it = mPairCaches.find(key);
+    if (it == mPairCaches.end()) {
+      PairCache cache;
+      cache.separation = -1.0;
+      it = mPairCaches.insert(std::make_pair(key, cache)).first;
+    }
+
+    it->second.detection = mNumDetections;
+    mOverlappingPairCaches[i] = &it->second;
+  }
+
+  // The separation of pairs whose bounding boxes stopped overlapping is not
+  // kept, since the shapes may have moved arbitrarily far meanwhile
+  for (PairCacheMap::iterator it = mPairCaches.begin();
+       it != mPairCaches.end();) {
+    if (it->second.detection != mNumDetections)
+      mPairCaches.erase(it++);
+    else
+      ++it;
+  }
+}
+
+bool DARTCollisionDetector::isSeparated(const BroadphaseProxy& _proxy1,
+                                        const BroadphaseProxy& _proxy2,
+                                        const PairCache& _cache) {
+  if (_cache.separation <= 0.0)
+    return false;
+
+  // A point at distance r from the origin of a shape moves by at most
+  // |dp| + r * |R1 - R0|, where the operator norm of the difference of the
+  // rotations is 2 sin(theta / 2) = sqrt(3 - tr(R0^T R1))
+  const Eigen::Isometry3d* from[2] = {&_cache.transform1, &_cache.transform2};
+  const BroadphaseProxy* to[2] = {&_proxy1, &_proxy2};
+  double motion = 0.0;
+  for (int i = 0; i < 2; ++i) {
+    const double trace
+        = from[i]->linear().cwiseProduct(to[i]->transform.linear()).sum();
+    motion += (to[i]->transform.translation()
+               - from[i]->translation()).norm()
+              + to[i]->radius * std::sqrt(std::max(3.0 - trace, 0.0));
+  }
+
+  return motion < _cache.separation;
+}
+
+void DARTCollisionDetector::cacheSeparation(const BroadphaseProxy& _proxy1,
+                                            const BroadphaseProxy& _proxy2,
+                                            PairCache* _cache) {
+  const dynamics::Shape* shape1
+      = _proxy1.node->getBodyNode()->getCollisionShape(_proxy1.shapeIndex);
+  const dynamics::Shape* shape2
+      = _proxy2.node->getBodyNode()->getCollisionShape(_proxy2.shapeIndex);
+
+  // Soft meshes deform, so their motion is not bounded by the transforms
+  if (shape1->getShapeType() == dynamics::Shape::SOFT_MESH
+      || shape2->getShapeType() == dynamics::Shape::SOFT_MESH) {
+    _cache->separation = -1.0;
+    return;
+  }
+
+  double separation;
+  if (!distance(shape1, _proxy1.transform, _proxy1.hulls.get(),
+                shape2, _proxy2.transform, _proxy2.hulls.get(),
+                &separation, NULL, NULL)) {
+    _cache->separation = -1.0;
+    return;
+  }
+
+  // collide() treats an ellipsoid as a sphere whose diameter is the first size
+  // component, which may reach out of the ellipsoid by the difference of the
+  // radii, except against meshes. Cylinders are collided as boxes inside
+  // them, which only adds separation.
+  const dynamics::Shape* shapes[2] = {shape1, shape2};
+  for (int i = 0; i < 2; ++i) {
+    if (shapes[i]->getShapeType() != dynamics::Shape::ELLIPSOID)
+      continue;
+
+    const Eigen::Vector3d& size
+        = static_cast<const dynamics::EllipsoidShape*>(shapes[i])->getSize();
+    separation -= 0.5 * std::max(size[0] - size.minCoeff(), 0.0);
+  }
+
+  _cache->transform1 = _proxy1.transform;
+  _cache->transform2 = _proxy2.transform;
+  _cache->separation = separation - 1e-6;
+}
+
+bool DARTCollisionDetector::isSupportedShape(const dynamics::Shape* _shape) {
+  switch (_shape->getShapeType()) {
+    case dynamics::Shape::BOX:
+    case dynamics::Shape::ELLIPSOID:
+    case dynamics::Shape::CYLINDER:
+      return true;
+    case dynamics::Shape::MESH:
+      return static_cast<const dynamics::MeshShape*>(_shape)->getMesh()
+             != NULL;
+    case dynamics::Shape::SOFT_MESH:
+      return static_cast<const dynamics::SoftMeshShape*>(_shape)
+             ->getSoftBodyNode()->getNumPointMasses() > 0;
+    default:
+      return false;
+  }
+}
+
+void DARTCollisionDetector::computeLocalBoundingBox(
+    BroadphaseProxy* _proxy, Eigen::Vector3d* _center,
+    Eigen::Vector3d* _halfExtents) {
+  const dynamics::Shape* shape
+      = _proxy->node->getBodyNode()->getCollisionShape(_proxy->shapeIndex);
+
+  switch (shape->getShapeType()) {
+    case dynamics::Shape::ELLIPSOID: {
+      // Ellipsoids are collided as spheres whose diameter is the first size
+      // component, except against meshes
+      const dynamics::EllipsoidShape* ellipsoid
+          = static_cast<const dynamics::EllipsoidShape*>(shape);
+      _center->setZero();
+      _halfExtents->setConstant(ellipsoid->getSize().maxCoeff() * 0.5);
+      break;
+    }
+    case dynamics::Shape::MESH: {
+      // Meshes are collided as their convex hulls, which are resolved along
+      // with their bounds once per proxy and scene, and the bounds are scaled
+      // on every update
+      const dynamics::MeshShape* mesh
+          = static_cast<const dynamics::MeshShape*>(shape);
+      if (_proxy->mesh != mesh->getMesh()) {
+        _proxy->hulls = ConvexDecomposition::getConvexHulls(mesh->getMesh());
+        _proxy->mesh = mesh->getMesh();
+        _proxy->meshMin.setZero();
+        _proxy->meshMax.setZero();
+        const ConvexHulls& hulls = *_proxy->hulls;
+        bool isEmpty = true;
+        for (size_t i = 0; i < hulls.size(); ++i) {
+          for (size_t j = 0; j < hulls[i].size(); ++j) {
+            const Eigen::Vector3d& vertex = hulls[i][j];
+            _proxy->meshMin = isEmpty ? vertex
+                                      : _proxy->meshMin.cwiseMin(vertex);
+            _proxy->meshMax = isEmpty ? vertex
+                                      : _proxy->meshMax.cwiseMax(vertex);
+            isEmpty = false;
+          }
+        }
+      }
+
+      const Eigen::Vector3d& scale = mesh->getScale();
+      *_center = 0.5 * scale.cwiseProduct(_proxy->meshMin + _proxy->meshMax);
+      *_halfExtents = 0.5 * scale.cwiseProduct(
+                        _proxy->meshMax - _proxy->meshMin).cwiseAbs();
+      break;
+    }
+    case dynamics::Shape::SOFT_MESH: {
+      // Soft meshes are collided as the convex hulls of their point masses,
+      // which move on every update. Reading the positions here also updates
+      // their transforms before the narrowphase reads them concurrently.
+      const dynamics::SoftBodyNode* softBodyNode
+          = static_cast<const dynamics::SoftMeshShape*>(shape)
+            ->getSoftBodyNode();
+      const Eigen::Isometry3d shapeInverse
+          = shape->getLocalTransform().inverse();
+      Eigen::Vector3d min = Eigen::Vector3d::Zero();
+      Eigen::Vector3d max = Eigen::Vector3d::Zero();
+      for (size_t i = 0; i < softBodyNode->getNumPointMasses(); ++i) {
+        const Eigen::Vector3d vertex
+            = shapeInverse * softBodyNode->getPointMass(i)->getLocalPosition();
+        min = i == 0 ? vertex : min.cwiseMin(vertex);
+        max = i == 0 ? vertex : max.cwiseMax(vertex);
+      }
+
+      *_center = 0.5 * (min + max);
+      *_halfExtents = 0.5 * (max - min);
+      break;
+    }
+    default:
+      // Cylinders are collided as boxes inside their bounding boxes
+      _center->setZero();
+      *_halfExtents = shape->getBoundingBoxDim() * 0.5;
+      break;
+  }
+}
+
+DARTCollisionDetector::BroadphasePairLess::BroadphasePairLess(
+    const BroadphaseProxies& _proxies)
+  : mProxies(_proxies) {
+}
+
+bool DARTCollisionDetector::BroadphasePairLess::operator()(
+    const BroadphasePair& _pair1, const BroadphasePair& _pair2) const {
+  const BroadphaseProxy& a1 = mProxies[_pair1.proxy1];
+  const BroadphaseProxy& a2 = mProxies[_pair1.proxy2];
+  const BroadphaseProxy& b1 = mProxies[_pair2.proxy1];
+  const BroadphaseProxy& b2 = mProxies[_pair2.proxy2];
+
+  if (a1.node->getIndex() != b1.node->getIndex())
+    return a1.node->getIndex() < b1.node->getIndex();
+
+  if (a2.node->getIndex() != b2.node->getIndex())
+    return a2.node->getIndex() < b2.node->getIndex();
+
+  if (a1.shapeIndex != b1.shapeIndex)
+    return a1.shapeIndex < b1.shapeIndex;
+
+  return a2.shapeIndex < b2.shapeIndex;
+}
+
 bool DARTCollisionDetector::detectCollision(CollisionNode* _collNode1,
                                             CollisionNode* _collNode2,
-                                            bool /*_calculateContactPoints*/) {
+                                            bool _calculateContactPoints) {
   std::vector<Contact> contacts;
   dynamics::BodyNode* BodyNode1 = _collNode1->getBodyNode();
   dynamics::BodyNode* BodyNode2 = _collNode2->getBodyNode();
+  const DARTCollisionNode* node1 = static_cast<DARTCollisionNode*>(_collNode1);
+  const DARTCollisionNode* node2 = static_cast<DARTCollisionNode*>(_collNode2);
 
   for (size_t i = 0; i < BodyNode1->getNumCollisionShapes(); i++) {
     for (size_t j = 0; j < BodyNode2->getNumCollisionShapes(); j++) {
       collide(BodyNode1->getCollisionShape(i),
               BodyNode1->getTransform()
               * BodyNode1->getCollisionShape(i)->getLocalTransform(),
+              node1->getConvexHulls(i),
               BodyNode2->getCollisionShape(j),
               BodyNode2->getTransform()
               * BodyNode2->getCollisionShape(j)->getLocalTransform(),
+              node2->getConvexHulls(j),
               &contacts);
+
+      if (!_calculateContactPoints && !contacts.empty())
+        return true;
     }
   }
 
   return contacts.size() > 0 ? true : false;
 }
 
+bool DARTCollisionDetector::computeNodeDistance(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2,
+    DistanceResult* _result) {
+  dynamics::BodyNode* bodyNode1 = _node1->getBodyNode();
+  dynamics::BodyNode* bodyNode2 = _node2->getBodyNode();
+  const DARTCollisionNode* node1 = static_cast<DARTCollisionNode*>(_node1);
+  const DARTCollisionNode* node2 = static_cast<DARTCollisionNode*>(_node2);
+
+  _result->distance = std::numeric_limits<double>::infinity();
+  _result->point1.setZero();
+  _result->point2.setZero();
+  _result->bodyNode1 = bodyNode1;
+  _result->bodyNode2 = bodyNode2;
+
+  std::vector<Contact> contacts;
+  for (size_t i = 0; i < bodyNode1->getNumCollisionShapes(); i++) {
+    const dynamics::Shape* shape1 = bodyNode1->getCollisionShape(i);
+    const ConvexHulls* hulls1 = node1->getConvexHulls(i);
+    Eigen::Isometry3d shapeTransform1 = _transform1
+                                        * shape1->getLocalTransform();
+
+    for (size_t j = 0; j < bodyNode2->getNumCollisionShapes(); j++) {
+      const dynamics::Shape* shape2 = bodyNode2->getCollisionShape(j);
+      const ConvexHulls* hulls2 = node2->getConvexHulls(j);
+      Eigen::Isometry3d shapeTransform2 = _transform2
+                                          * shape2->getLocalTransform();
+
+      double distance;
+      Eigen::Vector3d point1;
+      Eigen::Vector3d point2;
+      if (!collision::distance(shape1, shapeTransform1, hulls1,
+                               shape2, shapeTransform2, hulls2,
+                               &distance, &point1, &point2))
+        return false;
+
+      // GJK only tells that the shapes intersect, so the penetration depth is
+      // taken from the deepest contact
+      if (distance <= 0.0) {
+        contacts.clear();
+        collide(shape1, shapeTransform1, hulls1,
+                shape2, shapeTransform2, hulls2, &contacts);
+        for (size_t k = 0; k < contacts.size(); ++k) {
+          if (-contacts[k].penetrationDepth < distance) {
+            distance = -contacts[k].penetrationDepth;
+            point1 = contacts[k].point;
+            point2 = contacts[k].point;
+          }
+        }
+      }
+
+      if (distance < _result->distance) {
+        _result->distance = distance;
+        _result->point1 = point1;
+        _result->point2 = point2;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool DARTCollisionDetector::checkNodeCollision(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2) {
+  dynamics::BodyNode* bodyNode1 = _node1->getBodyNode();
+  dynamics::BodyNode* bodyNode2 = _node2->getBodyNode();
+  const DARTCollisionNode* node1 = static_cast<DARTCollisionNode*>(_node1);
+  const DARTCollisionNode* node2 = static_cast<DARTCollisionNode*>(_node2);
+
+  std::vector<Contact> contacts;
+  for (size_t i = 0; i < bodyNode1->getNumCollisionShapes(); i++) {
+    dynamics::Shape* shape1 = bodyNode1->getCollisionShape(i);
+    const ConvexHulls* hulls1 = node1->getConvexHulls(i);
+    Eigen::Isometry3d shapeTransform1 = _transform1
+                                        * shape1->getLocalTransform();
+
+    for (size_t j = 0; j < bodyNode2->getNumCollisionShapes(); j++) {
+      dynamics::Shape* shape2 = bodyNode2->getCollisionShape(j);
+      collide(shape1, shapeTransform1, hulls1,
+              shape2, _transform2 * shape2->getLocalTransform(),
+              node2->getConvexHulls(j), &contacts);
+
+      if (!contacts.empty())
+        return true;
+    }
+  }
+
+  return false;
+}
+
 }  // namespace collision
 }  // namespace dart
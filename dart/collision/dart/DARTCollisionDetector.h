@@ -37,7 +37,18 @@
 #ifndef  DART_COLLISION_DART_DARTCOLLISIONDETECTOR_H_
 #define  DART_COLLISION_DART_DARTCOLLISIONDETECTOR_H_
 
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
 #include "dart/collision/CollisionDetector.h"
+#include "dart/collision/ConvexDecomposition.h"
+
+struct aiScene;
 
 namespace dart {
 namespace collision {
@@ -51,6 +62,14 @@ public:
   /// \brief Default destructor
   virtual ~DARTCollisionDetector();
 
+  // Documentation inherited
+  virtual void addCollisionSkeletonNode(dynamics::BodyNode* _bodyNode,
+                                        bool _isRecursive = false);
+
+  // Documentation inherited
+  virtual void removeCollisionSkeletonNode(dynamics::BodyNode* _bodyNode,
+                                           bool _isRecursive = false);
+
   // Documentation inherited
   virtual CollisionNode* createCollisionNode(dynamics::BodyNode* _bodyNode);
 
@@ -63,6 +82,182 @@ protected:
   virtual bool detectCollision(CollisionNode* _collNode1,
                                CollisionNode* _collNode2,
                                bool _calculateContactPoints);
+
+  // Documentation inherited
+  virtual bool computeNodeDistance(CollisionNode* _node1,
+                                   const Eigen::Isometry3d& _transform1,
+                                   CollisionNode* _node2,
+                                   const Eigen::Isometry3d& _transform2,
+                                   DistanceResult* _result);
+
+  // Documentation inherited
+  virtual bool checkNodeCollision(CollisionNode* _node1,
+                                  const Eigen::Isometry3d& _transform1,
+                                  CollisionNode* _node2,
+                                  const Eigen::Isometry3d& _transform2);
+
+private:
+  /// \brief World bounding box of a collision shape in the broadphase
+  struct BroadphaseProxy {
+    // To get byte-aligned Eigen vectors
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /// \brief Collision node of the shape
+    CollisionNode* node;
+
+    /// \brief Index of the shape in the collision shapes of the body node
+    size_t shapeIndex;
+
+    /// \brief Index of the proxy when the proxies were built, which identifies
+    /// the proxy in the pair cache after sorting
+    size_t id;
+
+    /// \brief Transform of the shape w.r.t. the world frame
+    Eigen::Isometry3d transform;
+
+    /// \brief Upper bound of the distance from the origin of the shape to its
+    /// points
+    double radius;
+
+    /// \brief Minimum corner of the bounding box w.r.t. the world frame
+    Eigen::Vector3d min;
+
+    /// \brief Maximum corner of the bounding box w.r.t. the world frame
+    Eigen::Vector3d max;
+
+    /// \brief Scene of a mesh shape when hulls, meshMin and meshMax were
+    /// resolved, or NULL
+    const aiScene* mesh;
+
+    /// \brief Convex hulls of the mesh, which are resolved once so that the
+    /// narrowphase does not look them up in ConvexDecomposition
+    std::shared_ptr<const ConvexHulls> hulls;
+
+    /// \brief Minimum corner of the bounding box of the unscaled convex hulls
+    /// of the mesh
+    Eigen::Vector3d meshMin;
+
+    /// \brief Maximum corner of the bounding box of the unscaled convex hulls
+    /// of the mesh
+    Eigen::Vector3d meshMax;
+  };
+
+  typedef std::vector<BroadphaseProxy,
+                      Eigen::aligned_allocator<BroadphaseProxy> >
+      BroadphaseProxies;
+
+  /// \brief Pair of proxies whose bounding boxes overlap. The collision node
+  /// of proxy1 precedes the one of proxy2.
+  struct BroadphasePair {
+    /// \brief Index of the first proxy
+    size_t proxy1;
+
+    /// \brief Index of the second proxy
+    size_t proxy2;
+  };
+
+  /// \brief Order of pairs by the indices of the collision nodes and the
+  /// shapes
+  class BroadphasePairLess {
+  public:
+    /// \brief Constructor
+    explicit BroadphasePairLess(const BroadphaseProxies& _proxies);
+
+    /// \brief Return true if _pair1 precedes _pair2
+    bool operator()(const BroadphasePair& _pair1,
+                    const BroadphasePair& _pair2) const;
+
+  private:
+    /// \brief Proxies the pairs refer to
+    const BroadphaseProxies& mProxies;
+  };
+
+  /// \brief Separation of a pair of proxies at their last narrowphase, which
+  /// lets the narrowphase be skipped while the shapes move less than that
+  struct PairCache {
+    // To get byte-aligned Eigen vectors
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /// \brief Transform of the first shape at the last narrowphase
+    Eigen::Isometry3d transform1;
+
+    /// \brief Transform of the second shape at the last narrowphase
+    Eigen::Isometry3d transform2;
+
+    /// \brief Lower bound of the distance between the shapes at transform1 and
+    /// transform2, or a negative value if the shapes were not separated
+    double separation;
+
+    /// \brief Value of mNumDetections when the proxies were last a candidate
+    /// pair
+    size_t detection;
+  };
+
+  typedef std::pair<size_t, size_t> PairCacheKey;
+
+  typedef std::map<PairCacheKey, PairCache, std::less<PairCacheKey>,
+                   Eigen::aligned_allocator<
+                     std::pair<const PairCacheKey, PairCache> > >
+      PairCacheMap;
+
+  /// \brief Update the bounding boxes of the proxies and keep them sorted
+  /// along the x-axis
+  void updateBroadphase();
+
+  /// \brief Find the collidable pairs of proxies of different collision nodes
+  /// whose bounding boxes overlap by sweep and prune
+  void findOverlappingPairs();
+
+  /// \brief Run the narrowphase on the shapes of two proxies and add the
+  /// contacts to _contacts
+  void collideShapes(const BroadphaseProxy& _proxy1,
+                     const BroadphaseProxy& _proxy2,
+                     std::vector<Contact>* _contacts);
+
+  /// \brief Find the cache of every candidate pair, and remove the caches of
+  /// the pairs that are no longer candidates
+  void updatePairCaches();
+
+  /// \brief Return true if the shapes of the proxies cannot touch because
+  /// they moved less than their cached separation
+  static bool isSeparated(const BroadphaseProxy& _proxy1,
+                          const BroadphaseProxy& _proxy2,
+                          const PairCache& _cache);
+
+  /// \brief Cache the separation of the shapes of the proxies, which have no
+  /// contacts at their current transforms
+  static void cacheSeparation(const BroadphaseProxy& _proxy1,
+                              const BroadphaseProxy& _proxy2,
+                              PairCache* _cache);
+
+  /// \brief Return true if the narrowphase supports _shape
+  static bool isSupportedShape(const dynamics::Shape* _shape);
+
+  /// \brief Compute the center and the half extents of the bounding box of
+  /// the shape of _proxy w.r.t. the frame of the shape. The bounding box of
+  /// the convex hulls of a mesh is kept in _proxy, and the bounding box of a
+  /// soft mesh is computed from its point masses on every call.
+  static void computeLocalBoundingBox(BroadphaseProxy* _proxy,
+                                      Eigen::Vector3d* _center,
+                                      Eigen::Vector3d* _halfExtents);
+
+  /// \brief Broadphase proxies of all the supported collision shapes
+  BroadphaseProxies mBroadphaseProxies;
+
+  /// \brief Whether mBroadphaseProxies needs to be rebuilt
+  bool mIsBroadphaseDirty;
+
+  /// \brief Overlapping pairs found by the broadphase
+  std::vector<BroadphasePair> mOverlappingPairs;
+
+  /// \brief Caches of the candidate pairs keyed by the ids of their proxies
+  PairCacheMap mPairCaches;
+
+  /// \brief Cache of each pair of mOverlappingPairs
+  std::vector<PairCache*> mOverlappingPairCaches;
+
+  /// \brief Number of calls of detectCollision()
+  size_t mNumDetections;
 };
 
 }  // namespace collision
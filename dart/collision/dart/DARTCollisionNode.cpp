@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/collision/dart/DARTCollisionNode.h"
+
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/MeshShape.h"
+
+namespace dart {
+namespace collision {
+
+//==============================================================================
+DARTCollisionNode::DARTCollisionNode(dynamics::BodyNode* _bodyNode)
+  : CollisionNode(_bodyNode),
+    mMeshes(_bodyNode->getNumCollisionShapes(), NULL),
+    mHulls(_bodyNode->getNumCollisionShapes()) {
+  for (size_t i = 0; i < _bodyNode->getNumCollisionShapes(); ++i) {
+    const dynamics::Shape* shape = _bodyNode->getCollisionShape(i);
+    if (shape->getShapeType() != dynamics::Shape::MESH)
+      continue;
+
+    const aiScene* mesh
+        = static_cast<const dynamics::MeshShape*>(shape)->getMesh();
+    if (mesh == NULL)
+      continue;
+
+    mMeshes[i] = mesh;
+    mHulls[i] = ConvexDecomposition::getConvexHulls(mesh);
+  }
+}
+
+//==============================================================================
+DARTCollisionNode::~DARTCollisionNode() {
+}
+
+//==============================================================================
+const ConvexHulls* DARTCollisionNode::getConvexHulls(size_t _shapeIndex) const {
+  if (_shapeIndex >= mMeshes.size() || mMeshes[_shapeIndex] == NULL
+      || _shapeIndex >= mBodyNode->getNumCollisionShapes())
+    return NULL;
+
+  // A mesh whose scene was replaced falls back to the lookup in collide()
+  const dynamics::Shape* shape = mBodyNode->getCollisionShape(_shapeIndex);
+  if (shape->getShapeType() != dynamics::Shape::MESH
+      || static_cast<const dynamics::MeshShape*>(shape)->getMesh()
+         != mMeshes[_shapeIndex])
+    return NULL;
+
+  return mHulls[_shapeIndex].get();
+}
+
+}  // namespace collision
+}  // namespace dart
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COLLISION_DART_DARTCOLLISIONNODE_H_
+#define DART_COLLISION_DART_DARTCOLLISIONNODE_H_
+
+#include <memory>
+#include <vector>
+
+#include "dart/collision/CollisionNode.h"
+#include "dart/collision/ConvexDecomposition.h"
+
+struct aiScene;
+
+namespace dart {
+namespace dynamics {
+class BodyNode;
+}  // namespace dynamics
+}  // namespace dart
+
+namespace dart {
+namespace collision {
+
+/// \brief Collision node of DARTCollisionDetector, which keeps the convex
+/// hulls of the mesh shapes of its body node
+class DARTCollisionNode : public CollisionNode {
+public:
+  /// \brief Constructor. The convex hulls of the meshes are resolved here
+  /// rather than in the first query that involves them.
+  explicit DARTCollisionNode(dynamics::BodyNode* _bodyNode);
+
+  /// \brief Destructor
+  virtual ~DARTCollisionNode();
+
+  /// \brief Return the convex hulls of the collision shape whose index is
+  /// _shapeIndex if it is a mesh whose scene has not changed since the node
+  /// was created, or NULL. This function is thread-safe.
+  const ConvexHulls* getConvexHulls(size_t _shapeIndex) const;
+
+private:
+  /// \brief Scene of each collision shape that is a mesh when its hulls were
+  /// resolved, or NULL
+  std::vector<const aiScene*> mMeshes;
+
+  /// \brief Convex hulls of each scene of mMeshes
+  std::vector<std::shared_ptr<const ConvexHulls> > mHulls;
+};
+
+}  // namespace collision
+}  // namespace dart
+
+#endif  // DART_COLLISION_DART_DARTCOLLISIONNODE_H_
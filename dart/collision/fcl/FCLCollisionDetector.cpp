@@ -37,6 +37,8 @@
 
 #include "dart/collision/fcl/FCLCollisionDetector.h"
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "dart/dynamics/Shape.h"
@@ -48,15 +50,42 @@ namespace dart {
 namespace collision {
 
 FCLCollisionDetector::FCLCollisionDetector()
-  : CollisionDetector() {
+  : CollisionDetector(),
+    mBroadPhaseManager(new fcl::DynamicAABBTreeCollisionManager()),
+    mIsBroadPhaseDirty(false) {
 }
 
 FCLCollisionDetector::~FCLCollisionDetector() {
+  // The collision objects are deleted by the collision nodes
+  delete mBroadPhaseManager;
 }
 
 CollisionNode* FCLCollisionDetector::createCollisionNode(
     dynamics::BodyNode* _bodyNode) {
-  return new FCLCollisionNode(_bodyNode);
+  FCLCollisionNode* collNode = new FCLCollisionNode(_bodyNode);
+
+  for (int i = 0; i < collNode->getNumCollisionGeometries(); ++i)
+    mBroadPhaseManager->registerObject(collNode->getCollisionObject(i));
+  mIsBroadPhaseDirty = true;
+
+  return collNode;
+}
+
+void FCLCollisionDetector::removeCollisionSkeletonNode(
+    dynamics::BodyNode* _bodyNode, bool _isRecursive) {
+  for (size_t i = 0; i < mCollisionNodes.size(); ++i) {
+    if (mCollisionNodes[i]->getBodyNode() != _bodyNode)
+      continue;
+
+    FCLCollisionNode* collNode =
+        static_cast<FCLCollisionNode*>(mCollisionNodes[i]);
+    for (int j = 0; j < collNode->getNumCollisionGeometries(); ++j)
+      mBroadPhaseManager->unregisterObject(collNode->getCollisionObject(j));
+    mIsBroadPhaseDirty = true;
+    break;
+  }
+
+  CollisionDetector::removeCollisionSkeletonNode(_bodyNode, _isRecursive);
 }
 
 bool FCLCollisionDetector::detectCollision(bool _checkAllCollisions,
@@ -68,8 +97,6 @@ bool FCLCollisionDetector::detectCollision(bool _checkAllCollisions,
   for (size_t i = 0; i < mCollisionNodes.size(); i++)
     mCollisionNodes[i]->getBodyNode()->setColliding(false);
 
-  fcl::CollisionResult result;
-
   // only evaluate contact points if data structure for returning the contact
   // points was provided
   fcl::CollisionRequest request;
@@ -79,71 +106,57 @@ bool FCLCollisionDetector::detectCollision(bool _checkAllCollisions,
   //    request.num_max_cost_sources;
   //    request.use_approximate_cost;
 
+  // Move the collision objects to the current body transforms and refit the
+  // broadphase tree to their new bounding boxes. The tree is set up once for
+  // all the nodes added or removed since the last detection.
   for (size_t i = 0; i < mCollisionNodes.size(); i++) {
-    for (size_t j = i + 1; j < mCollisionNodes.size(); j++) {
-      result.clear();
-      FCLCollisionNode* collNode1 =
-          static_cast<FCLCollisionNode*>(mCollisionNodes[i]);
-      FCLCollisionNode* collNode2 =
-          static_cast<FCLCollisionNode*>(mCollisionNodes[j]);
-
-      if (!isCollidable(collNode1, collNode2))
-        continue;
+    FCLCollisionNode* collNode =
+        static_cast<FCLCollisionNode*>(mCollisionNodes[i]);
+    collNode->updateCollisionObjects();
+  }
+  mBroadPhaseManager->update();
+  if (mIsBroadPhaseDirty) {
+    mBroadPhaseManager->setup();
+    mIsBroadPhaseDirty = false;
+  }
 
-      for (int k = 0; k < collNode1->getNumCollisionGeometries(); k++) {
-        for (int l = 0; l < collNode2->getNumCollisionGeometries(); l++) {
-          int currContactNum = mContacts.size();
-          fcl::collide(collNode1->getCollisionGeometry(k),
-                       collNode1->getFCLTransform(k),
-                       collNode2->getCollisionGeometry(l),
-                       collNode2->getFCLTransform(l),
-                       request, result);
-
-          unsigned int numContacts = result.numContacts();
-
-          for (unsigned int m = 0; m < numContacts; ++m) {
-            const fcl::Contact& contact = result.getContact(m);
-
-            Contact contactPair;
-            contactPair.point(0) = contact.pos[0];
-            contactPair.point(1) = contact.pos[1];
-            contactPair.point(2) = contact.pos[2];
-            contactPair.normal(0) = contact.normal[0];
-            contactPair.normal(1) = contact.normal[1];
-            contactPair.normal(2) = contact.normal[2];
-            contactPair.bodyNode1 = findCollisionNode(contact.o1)->getBodyNode();
-            contactPair.bodyNode2 = findCollisionNode(contact.o2)->getBodyNode();
-            assert(contactPair.bodyNode1 != NULL);
-            assert(contactPair.bodyNode2 != NULL);
-//            contactPair.bdID1 =
-//                collisionNodePair.collisionNode1->getBodyNodeID();
-//            contactPair.bdID2 =
-//                collisionNodePair.collisionNode2->getBodyNodeID();
-            contactPair.penetrationDepth = contact.penetration_depth;
-
-            mContacts.push_back(contactPair);
-          }
+  // Only the collidable pairs whose bounding boxes overlap reach the
+  // narrowphase. They are sorted so that the contacts are reported in the same
+  // order regardless of the internal order of the broadphase tree.
+  mCandidatePairs.clear();
+  mBroadPhaseManager->collide(this,
+                              &FCLCollisionDetector::collectCandidatePair);
+  std::sort(mCandidatePairs.begin(), mCandidatePairs.end());
 
-          std::vector<bool>markForDeletion(numContacts, false);
-          for (size_t m = 0; m < numContacts; m++) {
-            for (size_t n = m + 1; n < numContacts; n++) {
-              Eigen::Vector3d diff =
-                  mContacts[currContactNum + m].point -
-                  mContacts[currContactNum + n].point;
-              if (diff.dot(diff) < 1e-6) {
-                markForDeletion[m] = true;
-                break;
-              }
-            }
-          }
-          for (int m = numContacts - 1; m >= 0; m--) {
-            if (markForDeletion[m])
-              mContacts.erase(mContacts.begin() + currContactNum + m);
-          }
-        }
-      }
-    }
+  // The pairs are independent, so they can be checked concurrently. Each
+  // thread adds the contacts to its own buffer, and the buffers are merged in
+  // the order of the pairs.
+  const int numPairs = static_cast<int>(mCandidatePairs.size());
+  beginNarrowphase(numPairs);
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mNumThreads);
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numPairs; i++) {
+    const CandidatePair& pair = mCandidatePairs[i];
+    FCLCollisionNode* collNode1 = pair.data1->collisionNode;
+    FCLCollisionNode* collNode2 = pair.data2->collisionNode;
+
+    size_t buffer = getNarrowphaseBufferIndex();
+    std::vector<Contact>& contacts = mNarrowphaseBuffers[buffer].contacts;
+    size_t currContactNum = contacts.size();
+
+    fcl::CollisionResult result;
+    fcl::collide(collNode1->getCollisionObject(pair.data1->index),
+                 collNode2->getCollisionObject(pair.data2->index),
+                 request, result);
+
+    addContacts(result, collNode1, collNode2, &contacts);
+
+    endNarrowphasePair(i, buffer, currContactNum);
   }
+  endNarrowphase();
 
   for (size_t i = 0; i < mContacts.size(); ++i)
   {
@@ -158,8 +171,209 @@ bool FCLCollisionDetector::detectCollision(bool _checkAllCollisions,
 bool FCLCollisionDetector::detectCollision(CollisionNode* _node1,
                                            CollisionNode* _node2,
                                            bool _calculateContactPoints) {
-  // TODO(JS): function not implemented
-  assert(false);
+  FCLCollisionNode* collNode1 = static_cast<FCLCollisionNode*>(_node1);
+  FCLCollisionNode* collNode2 = static_cast<FCLCollisionNode*>(_node2);
+  collNode1->updateCollisionObjects();
+  collNode2->updateCollisionObjects();
+
+  // A single contact is enough to tell whether the nodes collide
+  fcl::CollisionRequest request;
+  request.enable_contact = _calculateContactPoints;
+  request.num_max_contacts = _calculateContactPoints ? mNumMaxContacts : 1;
+
+  bool collision = false;
+  for (int i = 0; i < collNode1->getNumCollisionGeometries(); ++i) {
+    fcl::CollisionObject* object1 = collNode1->getCollisionObject(i);
+
+    for (int j = 0; j < collNode2->getNumCollisionGeometries(); ++j) {
+      fcl::CollisionObject* object2 = collNode2->getCollisionObject(j);
+      if (!object1->getAABB().overlap(object2->getAABB()))
+        continue;
+
+      fcl::CollisionResult result;
+      fcl::collide(object1, object2, request, result);
+      if (!result.isCollision())
+        continue;
+
+      collision = true;
+      if (!_calculateContactPoints)
+        return true;
+
+      addContacts(result, collNode1, collNode2, &mContacts);
+    }
+  }
+
+  return collision;
+}
+
+bool FCLCollisionDetector::computeNodeDistance(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2,
+    DistanceResult* _result) {
+  FCLCollisionNode* collNode1 = static_cast<FCLCollisionNode*>(_node1);
+  FCLCollisionNode* collNode2 = static_cast<FCLCollisionNode*>(_node2);
+
+  _result->distance = std::numeric_limits<double>::infinity();
+  _result->point1.setZero();
+  _result->point2.setZero();
+  _result->bodyNode1 = collNode1->getBodyNode();
+  _result->bodyNode2 = collNode2->getBodyNode();
+
+  // The geometries are placed by the given transforms instead of their
+  // collision objects, which may be used by other threads at the same time
+  fcl::DistanceRequest distanceRequest(true);
+  fcl::CollisionRequest collisionRequest;
+  collisionRequest.enable_contact = true;
+  collisionRequest.num_max_contacts = mNumMaxContacts;
+
+  for (int i = 0; i < collNode1->getNumCollisionGeometries(); ++i) {
+    const fcl::CollisionGeometry* geometry1
+        = collNode1->getCollisionGeometry(i);
+    fcl::Transform3f transform1 = collNode1->getFCLTransform(i, _transform1);
+
+    for (int j = 0; j < collNode2->getNumCollisionGeometries(); ++j) {
+      const fcl::CollisionGeometry* geometry2
+          = collNode2->getCollisionGeometry(j);
+      fcl::Transform3f transform2 = collNode2->getFCLTransform(j, _transform2);
+
+      fcl::DistanceResult distanceResult;
+      fcl::distance(geometry1, transform1, geometry2, transform2,
+                    distanceRequest, distanceResult);
+
+      double distance = distanceResult.min_distance;
+      const fcl::Vec3f& p1 = distanceResult.nearest_points[0];
+      const fcl::Vec3f& p2 = distanceResult.nearest_points[1];
+      Eigen::Vector3d point1(p1[0], p1[1], p1[2]);
+      Eigen::Vector3d point2(p2[0], p2[1], p2[2]);
+
+      // FCL does not report the penetration depth of intersecting geometries,
+      // so it is taken from the deepest contact
+      if (distance <= 0.0) {
+        distance = 0.0;
+        fcl::CollisionResult collisionResult;
+        fcl::collide(geometry1, transform1, geometry2, transform2,
+                     collisionRequest, collisionResult);
+        for (size_t k = 0; k < collisionResult.numContacts(); ++k) {
+          const fcl::Contact& contact = collisionResult.getContact(k);
+          if (-contact.penetration_depth < distance) {
+            distance = -contact.penetration_depth;
+            point1 = Eigen::Vector3d(contact.pos[0], contact.pos[1],
+                                     contact.pos[2]);
+            point2 = point1;
+          }
+        }
+      }
+
+      if (distance < _result->distance) {
+        _result->distance = distance;
+        _result->point1 = point1;
+        _result->point2 = point2;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool FCLCollisionDetector::checkNodeCollision(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2) {
+  FCLCollisionNode* collNode1 = static_cast<FCLCollisionNode*>(_node1);
+  FCLCollisionNode* collNode2 = static_cast<FCLCollisionNode*>(_node2);
+
+  // The geometries are placed by the given transforms instead of their
+  // collision objects, which may be used by other threads at the same time
+  fcl::CollisionRequest request;
+
+  for (int i = 0; i < collNode1->getNumCollisionGeometries(); ++i) {
+    const fcl::CollisionGeometry* geometry1
+        = collNode1->getCollisionGeometry(i);
+    fcl::Transform3f transform1 = collNode1->getFCLTransform(i, _transform1);
+
+    for (int j = 0; j < collNode2->getNumCollisionGeometries(); ++j) {
+      const fcl::CollisionGeometry* geometry2
+          = collNode2->getCollisionGeometry(j);
+      fcl::Transform3f transform2 = collNode2->getFCLTransform(j, _transform2);
+
+      fcl::CollisionResult result;
+      fcl::collide(geometry1, transform1, geometry2, transform2,
+                   request, result);
+      if (result.isCollision())
+        return true;
+    }
+  }
+
+  return false;
+}
+
+void FCLCollisionDetector::addContacts(const fcl::CollisionResult& _result,
+                                       FCLCollisionNode* _node1,
+                                       FCLCollisionNode* _node2,
+                                       std::vector<Contact>* _contacts) {
+  unsigned int numContacts = _result.numContacts();
+
+  for (unsigned int m = 0; m < numContacts; ++m) {
+    const fcl::Contact& contact = _result.getContact(m);
+
+    Contact contactPair;
+    contactPair.point(0) = contact.pos[0];
+    contactPair.point(1) = contact.pos[1];
+    contactPair.point(2) = contact.pos[2];
+    contactPair.normal(0) = contact.normal[0];
+    contactPair.normal(1) = contact.normal[1];
+    contactPair.normal(2) = contact.normal[2];
+    contactPair.bodyNode1 = _node1->getBodyNode();
+    contactPair.bodyNode2 = _node2->getBodyNode();
+    assert(contactPair.bodyNode1 != NULL);
+    assert(contactPair.bodyNode2 != NULL);
+    contactPair.penetrationDepth = contact.penetration_depth;
+
+    _contacts->push_back(contactPair);
+  }
+}
+
+bool FCLCollisionDetector::CandidatePair::operator<(
+    const CandidatePair& _other) const {
+  size_t node1 = data1->collisionNode->getIndex();
+  size_t otherNode1 = _other.data1->collisionNode->getIndex();
+  if (node1 != otherNode1)
+    return node1 < otherNode1;
+
+  size_t node2 = data2->collisionNode->getIndex();
+  size_t otherNode2 = _other.data2->collisionNode->getIndex();
+  if (node2 != otherNode2)
+    return node2 < otherNode2;
+
+  if (data1->index != _other.data1->index)
+    return data1->index < _other.data1->index;
+
+  return data2->index < _other.data2->index;
+}
+
+bool FCLCollisionDetector::collectCandidatePair(fcl::CollisionObject* _o1,
+                                                fcl::CollisionObject* _o2,
+                                                void* _data) {
+  FCLCollisionDetector* cd = static_cast<FCLCollisionDetector*>(_data);
+  FCLUserData* data1 = static_cast<FCLUserData*>(_o1->getUserData());
+  FCLUserData* data2 = static_cast<FCLUserData*>(_o2->getUserData());
+
+  // Shapes of the same body node never collide with each other
+  if (data1->collisionNode == data2->collisionNode)
+    return false;
+
+  if (!cd->isCollidable(data1->collisionNode, data2->collisionNode))
+    return false;
+
+  // Keep the collision node of the lower index first
+  if (data2->collisionNode->getIndex() < data1->collisionNode->getIndex())
+    std::swap(data1, data2);
+
+  CandidatePair pair;
+  pair.data1 = data1;
+  pair.data2 = data2;
+  cd->mCandidatePairs.push_back(pair);
+
+  // Returning false lets the broadphase report all the remaining pairs
   return false;
 }
 
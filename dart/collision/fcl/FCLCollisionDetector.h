@@ -38,7 +38,12 @@
 #ifndef DART_COLLISION_FCL_FCLCOLLISIONDETECTOR_H_
 #define DART_COLLISION_FCL_FCLCOLLISIONDETECTOR_H_
 
+#include <vector>
+
+#include <fcl/collision.h>
+#include <fcl/distance.h>
 #include <fcl/collision_object.h>
+#include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
 
 #include "dart/collision/CollisionDetector.h"
 
@@ -46,6 +51,7 @@ namespace dart {
 namespace collision {
 
 class FCLCollisionNode;
+struct FCLUserData;
 
 /// \brief
 class FCLCollisionDetector : public CollisionDetector {
@@ -59,6 +65,10 @@ public:
   // Documentation inherited
   virtual CollisionNode* createCollisionNode(dynamics::BodyNode* _bodyNode);
 
+  // Documentation inherited
+  virtual void removeCollisionSkeletonNode(dynamics::BodyNode* _bodyNode,
+                                           bool _isRecursive = false);
+
   // Documentation inherited
   virtual bool detectCollision(bool _checkAllCollisions,
                                bool _calculateContactPoints);
@@ -69,6 +79,55 @@ public:
 protected:
   virtual bool detectCollision(CollisionNode* _node1, CollisionNode* _node2,
                                bool _calculateContactPoints);
+
+  // Documentation inherited
+  virtual bool computeNodeDistance(CollisionNode* _node1,
+                                   const Eigen::Isometry3d& _transform1,
+                                   CollisionNode* _node2,
+                                   const Eigen::Isometry3d& _transform2,
+                                   DistanceResult* _result);
+
+  // Documentation inherited
+  virtual bool checkNodeCollision(CollisionNode* _node1,
+                                  const Eigen::Isometry3d& _transform1,
+                                  CollisionNode* _node2,
+                                  const Eigen::Isometry3d& _transform2);
+
+private:
+  /// \brief Pair of collision geometries whose bounding boxes overlap
+  struct CandidatePair {
+    /// \brief User data of the first collision object
+    FCLUserData* data1;
+
+    /// \brief User data of the second collision object
+    FCLUserData* data2;
+
+    /// \brief Ordering by the indices of the collision nodes and geometries
+    bool operator<(const CandidatePair& _other) const;
+  };
+
+  /// \brief Callback of the broadphase manager that collects the collidable
+  /// pairs of collision objects whose bounding boxes overlap
+  static bool collectCandidatePair(fcl::CollisionObject* _o1,
+                                   fcl::CollisionObject* _o2,
+                                   void* _data);
+
+  /// \brief Append the contacts of _result between the collision objects of
+  /// _node1 and _node2 to _contacts
+  static void addContacts(const fcl::CollisionResult& _result,
+                          FCLCollisionNode* _node1, FCLCollisionNode* _node2,
+                          std::vector<Contact>* _contacts);
+
+  /// \brief Broadphase manager of the collision objects of all the collision
+  /// nodes
+  fcl::DynamicAABBTreeCollisionManager* mBroadPhaseManager;
+
+  /// \brief Whether collision objects were registered or unregistered since
+  /// the broadphase manager was set up last
+  bool mIsBroadPhaseDirty;
+
+  /// \brief Candidate pairs found by the broadphase in this detection
+  std::vector<CandidatePair> mCandidatePairs;
 };
 
 }  // namespace collision
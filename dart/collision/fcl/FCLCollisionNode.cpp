@@ -37,6 +37,7 @@
 #include "dart/collision/fcl/FCLCollisionNode.h"
 
 #include <assimp/scene.h>
+#include <boost/shared_ptr.hpp>
 #include <fcl/shape/geometric_shapes.h>
 #include <fcl/shape/geometric_shape_to_BVH_model.h>
 
@@ -45,6 +46,7 @@
 #include "dart/dynamics/EllipsoidShape.h"
 #include "dart/dynamics/CylinderShape.h"
 #include "dart/dynamics/MeshShape.h"
+#include "dart/collision/fcl/FCLMeshCache.h"
 
 namespace dart {
 namespace collision {
@@ -54,7 +56,7 @@ FCLCollisionNode::FCLCollisionNode(dynamics::BodyNode* _bodyNode)
   : CollisionNode(_bodyNode) {
   for (size_t i = 0; i < _bodyNode->getNumCollisionShapes(); i++) {
     dynamics::Shape* shape = _bodyNode->getCollisionShape(i);
-    mShapes.push_back(shape);
+    boost::shared_ptr<fcl::CollisionGeometry> sharedGeometry;
     switch (shape->getShapeType()) {
       case dynamics::Shape::BOX: {
         dynamics::BoxShape* box
@@ -89,12 +91,12 @@ FCLCollisionNode::FCLCollisionNode(dynamics::BodyNode* _bodyNode)
         dynamics::MeshShape* shapeMesh
             = dynamic_cast<dynamics::MeshShape *>(shape);
 
-        if (shapeMesh)
-          mCollisionGeometries.push_back(
-                createMesh<fcl::OBBRSS>(shapeMesh->getScale()[0],
-                                        shapeMesh->getScale()[1],
-                                        shapeMesh->getScale()[2],
-                                        shapeMesh->getMesh()));
+        // Bodies that use the same mesh share the BVH model
+        if (shapeMesh) {
+          sharedGeometry = FCLMeshCache::getMesh(shapeMesh->getMesh(),
+                                                 shapeMesh->getScale());
+          mCollisionGeometries.push_back(sharedGeometry.get());
+        }
         break;
       }
       default: {
@@ -104,11 +106,32 @@ FCLCollisionNode::FCLCollisionNode(dynamics::BodyNode* _bodyNode)
         break;
       }
     }
+
+    if (mCollisionGeometries.size() == mShapes.size())
+      continue;
+
+    // Keep the shapes aligned with the geometries, and create a collision
+    // object for the broadphase of the detector. The object owns the geometry
+    // unless the geometry is shared with other collision nodes.
+    mShapes.push_back(shape);
+    if (!sharedGeometry)
+      sharedGeometry.reset(mCollisionGeometries.back());
+    mCollisionObjects.push_back(new fcl::CollisionObject(
+        sharedGeometry, getFCLTransform(mCollisionObjects.size())));
+  }
+
+  mUserData.resize(mCollisionObjects.size());
+  for (size_t i = 0; i < mCollisionObjects.size(); ++i) {
+    mUserData[i].collisionNode = this;
+    mUserData[i].index = i;
+    mCollisionObjects[i]->setUserData(&mUserData[i]);
   }
 }
 
 //==============================================================================
 FCLCollisionNode::~FCLCollisionNode() {
+  for (size_t i = 0; i < mCollisionObjects.size(); ++i)
+    delete mCollisionObjects[i];
 }
 
 //==============================================================================
@@ -123,7 +146,13 @@ fcl::CollisionGeometry*FCLCollisionNode::getCollisionGeometry(int _idx) const {
 
 //==============================================================================
 fcl::Transform3f FCLCollisionNode::getFCLTransform(int _idx) const {
-  Eigen::Isometry3d worldTrans = mBodyNode->getTransform()
+  return getFCLTransform(_idx, mBodyNode->getTransform());
+}
+
+//==============================================================================
+fcl::Transform3f FCLCollisionNode::getFCLTransform(
+    int _idx, const Eigen::Isometry3d& _bodyTransform) const {
+  Eigen::Isometry3d worldTrans = _bodyTransform
                                  * mShapes[_idx]->getLocalTransform();
 
   return fcl::Transform3f(
@@ -133,6 +162,19 @@ fcl::Transform3f FCLCollisionNode::getFCLTransform(int _idx) const {
         fcl::Vec3f(worldTrans(0, 3), worldTrans(1, 3), worldTrans(2, 3)));
 }
 
+//==============================================================================
+fcl::CollisionObject* FCLCollisionNode::getCollisionObject(int _idx) const {
+  return mCollisionObjects[_idx];
+}
+
+//==============================================================================
+void FCLCollisionNode::updateCollisionObjects() {
+  for (size_t i = 0; i < mCollisionObjects.size(); ++i) {
+    mCollisionObjects[i]->setTransform(getFCLTransform(i));
+    mCollisionObjects[i]->computeAABB();
+  }
+}
+
 //==============================================================================
 template<class BV>
 fcl::BVHModel<BV>* createMesh(float _scaleX, float _scaleY, float _scaleZ,
@@ -42,6 +42,7 @@
 #include <assimp/scene.h>
 #include <Eigen/Dense>
 #include <fcl/collision.h>
+#include <fcl/collision_object.h>
 #include <fcl/BVH/BVH_model.h>
 
 #include "dart/collision/CollisionNode.h"
@@ -56,6 +57,17 @@ class Shape;
 namespace dart {
 namespace collision {
 
+class FCLCollisionNode;
+
+/// \brief Data attached to the FCL collision objects of FCLCollisionNode
+struct FCLUserData {
+  /// \brief Collision node that owns the collision object
+  FCLCollisionNode* collisionNode;
+
+  /// \brief Index of the collision geometry in the collision node
+  int index;
+};
+
 /// \brief
 class FCLCollisionNode : public CollisionNode {
 public:
@@ -74,10 +86,31 @@ public:
   /// \brief
   fcl::Transform3f getFCLTransform(int _idx) const;
 
+  /// \brief Return the transform of the collision geometry whose index is
+  /// _idx when the body node is at _bodyTransform
+  fcl::Transform3f getFCLTransform(
+      int _idx, const Eigen::Isometry3d& _bodyTransform) const;
+
+  /// \brief Return the FCL collision object of the collision geometry whose
+  /// index is _idx. The user data of the object is an FCLUserData.
+  fcl::CollisionObject* getCollisionObject(int _idx) const;
+
+  /// \brief Update the transforms and the bounding boxes of the collision
+  /// objects from the transform of the body node
+  void updateCollisionObjects();
+
 private:
   /// \brief
   std::vector<fcl::CollisionGeometry*> mCollisionGeometries;
 
+  /// \brief Collision objects of mCollisionGeometries. The objects own the
+  /// geometries, which may be shared with other collision nodes through
+  /// FCLMeshCache.
+  std::vector<fcl::CollisionObject*> mCollisionObjects;
+
+  /// \brief User data of mCollisionObjects
+  std::vector<FCLUserData> mUserData;
+
   /// \brief
   std::vector<dynamics::Shape*> mShapes;
 };
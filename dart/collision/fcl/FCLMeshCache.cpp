@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/collision/fcl/FCLMeshCache.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dart {
+namespace collision {
+
+std::map<FCLMeshCache::Key, boost::weak_ptr<FCLMeshCache::Model> >
+    FCLMeshCache::mMeshes;
+
+std::mutex FCLMeshCache::mMutex;
+
+//==============================================================================
+boost::shared_ptr<FCLMeshCache::Model> FCLMeshCache::getMesh(
+    const aiScene* _mesh,
+    const Eigen::Vector3d& _scale,
+    const Eigen::Isometry3d& _transform) {
+  assert(_mesh);
+
+  Key key;
+  key.mesh = _mesh;
+  for (int i = 0; i < 3; ++i)
+    key.parameters[i] = _scale[i];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j)
+      key.parameters[3 + 4 * i + j] = _transform(i, j);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  boost::shared_ptr<Model> model = mMeshes[key].lock();
+  if (model)
+    return model;
+
+  // Building the model while holding the lock makes concurrent requests for
+  // the same mesh wait for a single build instead of building it twice
+  removeExpiredMeshes();
+  model.reset(createModel(_mesh, _scale, _transform));
+  mMeshes[key] = model;
+
+  return model;
+}
+
+//==============================================================================
+size_t FCLMeshCache::getNumMeshes() {
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  removeExpiredMeshes();
+
+  return mMeshes.size();
+}
+
+//==============================================================================
+bool FCLMeshCache::Key::operator<(const Key& _other) const {
+  if (mesh != _other.mesh)
+    return mesh < _other.mesh;
+
+  return std::lexicographical_compare(parameters, parameters + 15,
+                                      _other.parameters,
+                                      _other.parameters + 15);
+}
+
+//==============================================================================
+FCLMeshCache::Model* FCLMeshCache::createModel(
+    const aiScene* _mesh,
+    const Eigen::Vector3d& _scale,
+    const Eigen::Isometry3d& _transform) {
+  Model* model = new Model;
+  model->beginModel();
+  for (unsigned int i = 0; i < _mesh->mNumMeshes; i++) {
+    const aiMesh* mesh = _mesh->mMeshes[i];
+    for (unsigned int j = 0; j < mesh->mNumFaces; j++) {
+      fcl::Vec3f vertices[3];
+      for (unsigned int k = 0; k < 3; k++) {
+        const aiVector3D& vertex = mesh->mVertices[mesh->mFaces[j].mIndices[k]];
+        Eigen::Vector3d point = _transform * Eigen::Vector3d(
+            vertex.x * _scale[0], vertex.y * _scale[1], vertex.z * _scale[2]);
+        vertices[k] = fcl::Vec3f(point[0], point[1], point[2]);
+      }
+      model->addTriangle(vertices[0], vertices[1], vertices[2]);
+    }
+  }
+  model->endModel();
+
+  return model;
+}
+
+//==============================================================================
+void FCLMeshCache::removeExpiredMeshes() {
+  std::map<Key, boost::weak_ptr<Model> >::iterator it = mMeshes.begin();
+  while (it != mMeshes.end()) {
+    if (it->second.expired())
+      mMeshes.erase(it++);
+    else
+      ++it;
+  }
+}
+
+}  // namespace collision
+}  // namespace dart
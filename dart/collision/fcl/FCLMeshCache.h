@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_COLLISION_FCL_FCLMESHCACHE_H_
+#define DART_COLLISION_FCL_FCLMESHCACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+
+#include <assimp/scene.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <Eigen/Dense>
+#include <fcl/BVH/BVH_model.h>
+
+namespace dart {
+namespace collision {
+
+/// \brief Cache of the BVH models of mesh shapes shared by collision nodes
+///
+/// Mesh shapes that use the same mesh with the same scale and the same baked
+/// transform, such as the links of many copies of a robot, share a single BVH
+/// model instead of building one each. The cache only holds weak references,
+/// so a model is freed when the last collision node that uses it is destroyed.
+/// The cache is shared by all the collision detectors and is thread-safe.
+class FCLMeshCache {
+public:
+  /// \brief BVH model type of the cached meshes
+  typedef fcl::BVHModel<fcl::OBBRSS> Model;
+
+  /// \brief Return the BVH model of _mesh scaled by _scale and transformed by
+  /// _transform. The model is built only if no collision node holds a model of
+  /// the same mesh, scale, and transform.
+  static boost::shared_ptr<Model> getMesh(
+      const aiScene* _mesh,
+      const Eigen::Vector3d& _scale,
+      const Eigen::Isometry3d& _transform = Eigen::Isometry3d::Identity());
+
+  /// \brief Return the number of BVH models that are currently shared through
+  /// this cache
+  static size_t getNumMeshes();
+
+private:
+  /// \brief Identity of a cached BVH model
+  struct Key {
+    /// \brief Mesh
+    const aiScene* mesh;
+
+    /// \brief Scale followed by the upper 3x4 block of the transform
+    double parameters[15];
+
+    /// \brief Lexicographical ordering of the mesh and the parameters
+    bool operator<(const Key& _other) const;
+  };
+
+  /// \brief Build the BVH model of _mesh
+  static Model* createModel(const aiScene* _mesh,
+                            const Eigen::Vector3d& _scale,
+                            const Eigen::Isometry3d& _transform);
+
+  /// \brief Remove the entries whose models are no longer used
+  static void removeExpiredMeshes();
+
+  /// \brief Cached BVH models
+  static std::map<Key, boost::weak_ptr<Model> > mMeshes;
+
+  /// \brief Mutex that guards mMeshes
+  static std::mutex mMutex;
+};
+
+}  // namespace collision
+}  // namespace dart
+
+#endif  // DART_COLLISION_FCL_FCLMESHCACHE_H_
@@ -39,6 +39,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include <fcl/collision.h>
 
@@ -56,19 +57,49 @@ namespace collision {
 
 //==============================================================================
 FCLMeshCollisionDetector::FCLMeshCollisionDetector()
+  : mBroadPhaseManager(new fcl::DynamicAABBTreeCollisionManager()),
+    mIsBroadPhaseDirty(false)
 {
 }
 
 //==============================================================================
 FCLMeshCollisionDetector::~FCLMeshCollisionDetector()
 {
+  // The collision objects are deleted by the collision nodes
+  delete mBroadPhaseManager;
 }
 
 //==============================================================================
 CollisionNode*FCLMeshCollisionDetector::createCollisionNode(
     dynamics::BodyNode* _bodyNode)
 {
-  return new FCLMeshCollisionNode(_bodyNode);
+  FCLMeshCollisionNode* collNode = new FCLMeshCollisionNode(_bodyNode);
+
+  for (size_t i = 0; i < collNode->mCollisionObjects.size(); ++i)
+    mBroadPhaseManager->registerObject(collNode->mCollisionObjects[i]);
+  mIsBroadPhaseDirty = true;
+
+  return collNode;
+}
+
+//==============================================================================
+void FCLMeshCollisionDetector::removeCollisionSkeletonNode(
+    dynamics::BodyNode* _bodyNode, bool _isRecursive)
+{
+  for (size_t i = 0; i < mCollisionNodes.size(); ++i)
+  {
+    if (mCollisionNodes[i]->getBodyNode() != _bodyNode)
+      continue;
+
+    FCLMeshCollisionNode* collNode
+        = static_cast<FCLMeshCollisionNode*>(mCollisionNodes[i]);
+    for (size_t j = 0; j < collNode->mCollisionObjects.size(); ++j)
+      mBroadPhaseManager->unregisterObject(collNode->mCollisionObjects[j]);
+    mIsBroadPhaseDirty = true;
+    break;
+  }
+
+  CollisionDetector::removeCollisionSkeletonNode(_bodyNode, _isRecursive);
 }
 
 //==============================================================================
@@ -79,9 +110,39 @@ bool FCLMeshCollisionDetector::detectCollision(bool _checkAllCollisions,
   // Clear previous contact informations
   //----------------------------------------------------------------------------
 
-  // Update the positions of vertices on meshs
-  for (size_t i = 0; i < mCollisionNodes.size(); ++i)
-    static_cast<FCLMeshCollisionNode*>(mCollisionNodes[i])->updateShape();
+  // Evaluate the lazy transforms of the body nodes and the point masses first.
+  // Evaluating them writes the cached transforms of the parent frames, which
+  // are shared between the nodes, so it has to be done serially.
+  const int numNodes = static_cast<int>(mCollisionNodes.size());
+  for (int i = 0; i < numNodes; ++i)
+  {
+    static_cast<FCLMeshCollisionNode*>(mCollisionNodes[i])->updateTransforms();
+  }
+
+  // Update the positions of vertices on meshs, and move the collision objects
+  // to the current body transforms. The transforms are clean and the nodes own
+  // their soft meshes, so the vertex updates and the refits run concurrently.
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mNumThreads);
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numNodes; ++i)
+  {
+    FCLMeshCollisionNode* collNode
+        = static_cast<FCLMeshCollisionNode*>(mCollisionNodes[i]);
+    collNode->updateShape();
+    collNode->updateCollisionObjects();
+  }
+
+  // Refit the broadphase tree to the new bounding boxes. The tree is set up
+  // once for all the nodes added or removed since the last detection.
+  mBroadPhaseManager->update();
+  if (mIsBroadPhaseDirty)
+  {
+    mBroadPhaseManager->setup();
+    mIsBroadPhaseDirty = false;
+  }
 
   // Clear previous contacts
   mContacts.clear();
@@ -92,33 +153,38 @@ bool FCLMeshCollisionDetector::detectCollision(bool _checkAllCollisions,
 
   bool collision = false;
 
-  FCLMeshCollisionNode* FCLMeshCollisionNode1 = NULL;
-  FCLMeshCollisionNode* FCLMeshCollisionNode2 = NULL;
+  // Only the collidable node pairs whose bounding boxes overlap reach the
+  // narrowphase. A node pair is reported once per overlapping mesh pair, so the
+  // pairs are sorted to drop the duplicates and to visit them in a fixed order.
+  mCandidatePairs.clear();
+  mBroadPhaseManager->collide(this,
+                              &FCLMeshCollisionDetector::collectCandidatePair);
+  std::sort(mCandidatePairs.begin(), mCandidatePairs.end(),
+            &FCLMeshCollisionDetector::compareCandidatePairs);
+  mCandidatePairs.erase(std::unique(mCandidatePairs.begin(),
+                                    mCandidatePairs.end()),
+                        mCandidatePairs.end());
 
-  for (size_t i = 0; i < mCollisionNodes.size(); i++)
+  for (size_t i = 0; i < mCandidatePairs.size(); i++)
   {
-    FCLMeshCollisionNode1
-        = static_cast<FCLMeshCollisionNode*>(mCollisionNodes[i]);
-    for (size_t j = i + 1; j < mCollisionNodes.size(); j++)
+    FCLMeshCollisionNode* FCLMeshCollisionNode1 = mCandidatePairs[i].first;
+    FCLMeshCollisionNode* FCLMeshCollisionNode2 = mCandidatePairs[i].second;
+
+    std::vector<Contact>* contactPoints
+        = _calculateContactPoints ? &mContacts : NULL;
+    size_t numContacts = mContacts.size();
+    if (FCLMeshCollisionNode1->detectCollision(FCLMeshCollisionNode2,
+                                               contactPoints,
+                                               mNumMaxContacts))
     {
-      FCLMeshCollisionNode2
-          = static_cast<FCLMeshCollisionNode*>(mCollisionNodes[j]);
-      if (!isCollidable(FCLMeshCollisionNode1, FCLMeshCollisionNode2))
-        continue;
-
-      std::vector<Contact>* contactPoints
-          = _calculateContactPoints ? &mContacts : NULL;
-      if (FCLMeshCollisionNode1->detectCollision(FCLMeshCollisionNode2,
-                                                 contactPoints,
-                                                 mNumMaxContacts))
-      {
-        collision = true;
-        mCollisionNodes[i]->getBodyNode()->setColliding(true);
-        mCollisionNodes[j]->getBodyNode()->setColliding(true);
+      limitContacts(numContacts);
 
-        if (!_checkAllCollisions)
-          return true;
-      }
+      collision = true;
+      FCLMeshCollisionNode1->getBodyNode()->setColliding(true);
+      FCLMeshCollisionNode2->getBodyNode()->setColliding(true);
+
+      if (!_checkAllCollisions)
+        return true;
     }
   }
 
@@ -140,6 +206,157 @@ bool FCLMeshCollisionDetector::detectCollision(CollisionNode* _node1,
         mNumMaxContacts);
 }
 
+//==============================================================================
+bool FCLMeshCollisionDetector::computeNodeDistance(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2,
+    DistanceResult* _result)
+{
+  FCLMeshCollisionNode* collisionNode1 =
+      static_cast<FCLMeshCollisionNode*>(_node1);
+  FCLMeshCollisionNode* collisionNode2 =
+      static_cast<FCLMeshCollisionNode*>(_node2);
+
+  _result->distance = std::numeric_limits<double>::infinity();
+  _result->point1.setZero();
+  _result->point2.setZero();
+  _result->bodyNode1 = collisionNode1->getBodyNode();
+  _result->bodyNode2 = collisionNode2->getBodyNode();
+
+  // The meshes are placed by the given transforms as in checkNodeCollision()
+  fcl::Transform3f transform1
+      = FCLMeshCollisionNode::getFclTransform(_transform1);
+  fcl::Transform3f transform2
+      = FCLMeshCollisionNode::getFclTransform(_transform2);
+  fcl::DistanceRequest distanceRequest(true);
+  fcl::CollisionRequest collisionRequest;
+  collisionRequest.enable_contact = true;
+  collisionRequest.num_max_contacts = mNumMaxContacts;
+
+  for (size_t i = 0; i < collisionNode1->mMeshes.size(); i++)
+  {
+    for (size_t j = 0; j < collisionNode2->mMeshes.size(); j++)
+    {
+      fcl::DistanceResult distanceResult;
+      fcl::distance(collisionNode1->mMeshes[i], transform1,
+                    collisionNode2->mMeshes[j], transform2,
+                    distanceRequest, distanceResult);
+
+      // FCL reports the nearest points of two meshes in the frame of the
+      // first mesh
+      double distance = distanceResult.min_distance;
+      fcl::Vec3f p1 = transform1.transform(distanceResult.nearest_points[0]);
+      fcl::Vec3f p2 = transform1.transform(distanceResult.nearest_points[1]);
+      Eigen::Vector3d point1(p1[0], p1[1], p1[2]);
+      Eigen::Vector3d point2(p2[0], p2[1], p2[2]);
+
+      // FCL does not report the penetration depth of intersecting meshes, so
+      // it is taken from the deepest contact
+      if (distance <= 0.0)
+      {
+        distance = 0.0;
+        fcl::CollisionResult collisionResult;
+        fcl::collide(collisionNode1->mMeshes[i], transform1,
+                     collisionNode2->mMeshes[j], transform2,
+                     collisionRequest, collisionResult);
+        for (size_t k = 0; k < collisionResult.numContacts(); ++k)
+        {
+          const fcl::Contact& contact = collisionResult.getContact(k);
+          if (-contact.penetration_depth < distance)
+          {
+            distance = -contact.penetration_depth;
+            point1 = Eigen::Vector3d(contact.pos[0], contact.pos[1],
+                                     contact.pos[2]);
+            point2 = point1;
+          }
+        }
+      }
+
+      if (distance < _result->distance)
+      {
+        _result->distance = distance;
+        _result->point1 = point1;
+        _result->point2 = point2;
+      }
+    }
+  }
+
+  return true;
+}
+
+//==============================================================================
+bool FCLMeshCollisionDetector::checkNodeCollision(
+    CollisionNode* _node1, const Eigen::Isometry3d& _transform1,
+    CollisionNode* _node2, const Eigen::Isometry3d& _transform2)
+{
+  FCLMeshCollisionNode* collisionNode1 =
+      static_cast<FCLMeshCollisionNode*>(_node1);
+  FCLMeshCollisionNode* collisionNode2 =
+      static_cast<FCLMeshCollisionNode*>(_node2);
+
+  // The meshes are placed by the given transforms instead of the world
+  // transforms of the nodes, which may be used by other threads at the same
+  // time
+  fcl::Transform3f transform1
+      = FCLMeshCollisionNode::getFclTransform(_transform1);
+  fcl::Transform3f transform2
+      = FCLMeshCollisionNode::getFclTransform(_transform2);
+  fcl::CollisionRequest request;
+
+  for (size_t i = 0; i < collisionNode1->mMeshes.size(); i++)
+  {
+    for (size_t j = 0; j < collisionNode2->mMeshes.size(); j++)
+    {
+      fcl::CollisionResult result;
+      fcl::collide(collisionNode1->mMeshes[i], transform1,
+                   collisionNode2->mMeshes[j], transform2,
+                   request, result);
+      if (result.isCollision())
+        return true;
+    }
+  }
+
+  return false;
+}
+
+//==============================================================================
+bool FCLMeshCollisionDetector::compareCandidatePairs(
+    const CandidatePair& _pair1, const CandidatePair& _pair2)
+{
+  if (_pair1.first->getIndex() != _pair2.first->getIndex())
+    return _pair1.first->getIndex() < _pair2.first->getIndex();
+
+  return _pair1.second->getIndex() < _pair2.second->getIndex();
+}
+
+//==============================================================================
+bool FCLMeshCollisionDetector::collectCandidatePair(fcl::CollisionObject* _o1,
+                                                    fcl::CollisionObject* _o2,
+                                                    void* _data)
+{
+  FCLMeshCollisionDetector* cd = static_cast<FCLMeshCollisionDetector*>(_data);
+  FCLMeshCollisionNode* collNode1
+      = static_cast<FCLMeshCollisionNode*>(_o1->getUserData());
+  FCLMeshCollisionNode* collNode2
+      = static_cast<FCLMeshCollisionNode*>(_o2->getUserData());
+
+  // Meshes of the same body node never collide with each other
+  if (collNode1 == collNode2)
+    return false;
+
+  if (!cd->isCollidable(collNode1, collNode2))
+    return false;
+
+  // Keep the collision node of the lower index first
+  if (collNode2->getIndex() < collNode1->getIndex())
+    std::swap(collNode1, collNode2);
+
+  cd->mCandidatePairs.push_back(CandidatePair(collNode1, collNode2));
+
+  // Returning false lets the broadphase report all the remaining pairs
+  return false;
+}
+
 //==============================================================================
 void FCLMeshCollisionDetector::draw()
 {
@@ -38,6 +38,12 @@
 #ifndef DART_COLLISION_FCL_MESH_FCLMESHCOLLISIONDETECTOR_H_
 #define DART_COLLISION_FCL_MESH_FCLMESHCOLLISIONDETECTOR_H_
 
+#include <utility>
+#include <vector>
+
+#include <fcl/collision_object.h>
+#include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+
 #include "dart/collision/CollisionDetector.h"
 
 namespace dart {
@@ -49,6 +55,8 @@ class PointMass;
 
 namespace collision {
 
+class FCLMeshCollisionNode;
+
 ///
 class FCLMeshCollisionDetector : public CollisionDetector
 {
@@ -62,6 +70,10 @@ public:
   // Documentation inherited
   virtual CollisionNode* createCollisionNode(dynamics::BodyNode* _bodyNode);
 
+  // Documentation inherited
+  virtual void removeCollisionSkeletonNode(dynamics::BodyNode* _bodyNode,
+                                           bool _isRecursive = false);
+
   // Documentation inherited
   virtual bool detectCollision(bool _checkAllCollisions,
                                bool _calculateContactPoints);
@@ -72,6 +84,44 @@ public:
 
   ///
   void draw();
+
+protected:
+  // Documentation inherited
+  virtual bool computeNodeDistance(CollisionNode* _node1,
+                                   const Eigen::Isometry3d& _transform1,
+                                   CollisionNode* _node2,
+                                   const Eigen::Isometry3d& _transform2,
+                                   DistanceResult* _result);
+
+  // Documentation inherited
+  virtual bool checkNodeCollision(CollisionNode* _node1,
+                                  const Eigen::Isometry3d& _transform1,
+                                  CollisionNode* _node2,
+                                  const Eigen::Isometry3d& _transform2);
+
+private:
+  /// Pair of collision nodes whose bounding boxes overlap
+  typedef std::pair<FCLMeshCollisionNode*, FCLMeshCollisionNode*> CandidatePair;
+
+  /// Ordering of candidate pairs by the indices of the collision nodes
+  static bool compareCandidatePairs(const CandidatePair& _pair1,
+                                    const CandidatePair& _pair2);
+
+  /// Callback of the broadphase manager that collects the collidable pairs of
+  /// collision nodes whose bounding boxes overlap
+  static bool collectCandidatePair(fcl::CollisionObject* _o1,
+                                   fcl::CollisionObject* _o2,
+                                   void* _data);
+
+  /// Broadphase manager of the collision objects of all the collision nodes
+  fcl::DynamicAABBTreeCollisionManager* mBroadPhaseManager;
+
+  /// Whether collision objects were registered or unregistered since the
+  /// broadphase manager was set up last
+  bool mIsBroadPhaseDirty;
+
+  /// Candidate pairs found by the broadphase in this detection
+  std::vector<CandidatePair> mCandidatePairs;
 };
 
 }  // namespace collision
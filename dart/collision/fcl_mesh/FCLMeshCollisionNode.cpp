@@ -37,9 +37,11 @@
 
 #include "dart/collision/fcl_mesh/FCLMeshCollisionNode.h"
 
+#include <cmath>
 #include <iostream>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
 #include <fcl/shape/geometric_shapes.h>
 #include <fcl/shape/geometric_shape_to_BVH_model.h>
 #include <fcl/BVH/BVH_model.h>
@@ -51,7 +53,10 @@
 #include "dart/dynamics/EllipsoidShape.h"
 #include "dart/dynamics/CylinderShape.h"
 #include "dart/dynamics/SoftMeshShape.h"
+#include "dart/dynamics/SoftBodyNode.h"
+#include "dart/dynamics/PointMass.h"
 #include "dart/renderer/LoadOpengl.h"
+#include "dart/collision/fcl/FCLMeshCache.h"
 #include "dart/collision/fcl_mesh/CollisionShapes.h"
 #include "dart/collision/fcl_mesh/FCLMeshCollisionDetector.h"
 
@@ -70,11 +75,14 @@ FCLMeshCollisionNode::FCLMeshCollisionNode(dynamics::BodyNode* _bodyNode)
   using dart::dynamics::MeshShape;
   using dart::dynamics::SoftMeshShape;
 
+  evalRT();
+
   // Create meshes according to types of the shapes
   for (size_t i = 0; i < _bodyNode->getNumCollisionShapes(); i++)
   {
     Shape* shape = _bodyNode->getCollisionShape(i);
     fcl::Transform3f shapeT = getFclTransform(shape->getLocalTransform());
+    boost::shared_ptr<fcl::BVHModel<fcl::OBBRSS> > sharedMesh;
     switch (shape->getShapeType())
     {
       case Shape::ELLIPSOID:
@@ -115,12 +123,13 @@ FCLMeshCollisionNode::FCLMeshCollisionNode(dynamics::BodyNode* _bodyNode)
       }
       case dynamics::Shape::MESH:
       {
+        // Bodies that use the same mesh with the same local transform share
+        // the BVH model
         MeshShape* shapeMesh = static_cast<MeshShape*>(shape);
-        mMeshes.push_back(createMesh<fcl::OBBRSS>(shapeMesh->getScale()[0],
-                                                  shapeMesh->getScale()[1],
-                                                  shapeMesh->getScale()[2],
-                                                  shapeMesh->getMesh(),
-                                                  shapeT));
+        sharedMesh = FCLMeshCache::getMesh(shapeMesh->getMesh(),
+                                           shapeMesh->getScale(),
+                                           shape->getLocalTransform());
+        mMeshes.push_back(sharedMesh.get());
         break;
       }
       case dynamics::Shape::SOFT_MESH:
@@ -137,14 +146,27 @@ FCLMeshCollisionNode::FCLMeshCollisionNode(dynamics::BodyNode* _bodyNode)
         break;
       }
     }
+
+    if (mMeshes.size() == mCollisionObjects.size())
+      continue;
+
+    // Create a collision object for the broadphase of the detector. The object
+    // owns the mesh unless the mesh is shared with other collision nodes.
+    if (!sharedMesh)
+      sharedMesh.reset(mMeshes.back());
+    fcl::CollisionObject* object
+        = new fcl::CollisionObject(sharedMesh, mFclWorldTrans);
+    object->setUserData(this);
+    mCollisionObjects.push_back(object);
   }
 }
 
 //==============================================================================
 FCLMeshCollisionNode::~FCLMeshCollisionNode()
 {
-  for (size_t i = 0; i < mMeshes.size(); i++)
-    delete mMeshes[i];
+  // The meshes are deleted with the collision objects that own them
+  for (size_t i = 0; i < mCollisionObjects.size(); i++)
+    delete mCollisionObjects[i];
 }
 
 //==============================================================================
@@ -160,7 +182,10 @@ bool FCLMeshCollisionNode::detectCollision(FCLMeshCollisionNode* _otherNode,
   {
     for (size_t j = 0; j < _otherNode->mMeshes.size(); j++)
     {
-      fcl::CollisionResult res;
+      // The result and the buffers below are reused so that their memory is
+      // not reallocated for every mesh pair
+      fcl::CollisionResult& res = mCollisionResult;
+      res.clear();
       fcl::CollisionRequest req;
 
       // only evaluate contact points if data structure for returning the
@@ -189,8 +214,8 @@ bool FCLMeshCollisionNode::detectCollision(FCLMeshCollisionNode* _otherNode,
       int numNoContacts = 0;
       int numContacts = 0;
 
-      std::vector<Contact> unfilteredContactPoints;
-      unfilteredContactPoints.reserve(res.numContacts());
+      std::vector<Contact>& unfilteredContactPoints = mUnfilteredContacts;
+      unfilteredContactPoints.clear();
 
       for (size_t k = 0; k < res.numContacts(); k++)
       {
@@ -242,22 +267,12 @@ bool FCLMeshCollisionNode::detectCollision(FCLMeshCollisionNode* _otherNode,
       const double ZERO = 0.000001;
       const double ZERO2 = ZERO*ZERO;
 
-      std::vector<bool> markForDeletion(unfilteredContactPoints.size(), false);
+      // remove all the repeated points
+      mContactReducer.removeDuplicateContacts(&unfilteredContactPoints, 0,
+                                              std::sqrt(3.0) * ZERO);
 
-      // mark all the repeated points
-      for (unsigned int k = 0; k < unfilteredContactPoints.size(); k++)
-      {
-        for (unsigned int l = k + 1; l < unfilteredContactPoints.size(); l++)
-        {
-          Eigen::Vector3d diff = unfilteredContactPoints[k].point
-                                 - unfilteredContactPoints[l].point;
-          if (diff.dot(diff) < 3 * ZERO2)
-          {
-            markForDeletion[k] = true;
-            break;
-          }
-        }
-      }
+      std::vector<bool>& markForDeletion = mMarkForDeletion;
+      markForDeletion.assign(unfilteredContactPoints.size(), false);
 
       // remove all the co-linear contact points
       for (size_t k = 0; k < unfilteredContactPoints.size(); k++)
@@ -311,31 +326,29 @@ void FCLMeshCollisionNode::updateShape()
   for (size_t i = 0; i < mBodyNode->getNumCollisionShapes(); i++)
   {
     Shape* shape = mBodyNode->getCollisionShape(i);
-    fcl::Transform3f shapeT = getFclTransform(shape->getLocalTransform());
     switch (shape->getShapeType())
     {
       case dynamics::Shape::SOFT_MESH:
       {
+        // The vertices of the model are the point masses, so each of them is
+        // transformed once, without going through the assimp mesh
         SoftMeshShape* softMeshShape = static_cast<SoftMeshShape*>(shape);
-        const aiMesh* mesh = softMeshShape->getAssimpMesh();
-        softMeshShape->update();
+        dynamics::SoftBodyNode* softBodyNode
+            = softMeshShape->getSoftBodyNode();
+        const Eigen::Isometry3d& shapeT = shape->getLocalTransform();
 
-        mMeshes[i]->beginUpdateModel();
-
-        for (unsigned int j = 0; j < mesh->mNumFaces; j++)
+        mSoftMeshVertices.resize(softBodyNode->getNumPointMasses());
+        for (size_t j = 0; j < mSoftMeshVertices.size(); j++)
         {
-          fcl::Vec3f vertices[3];
-          for (unsigned int k = 0; k < 3; k++)
-          {
-            const aiVector3D& vertex
-                = mesh->mVertices[mesh->mFaces[j].mIndices[k]];
-            vertices[k] = fcl::Vec3f(vertex.x, vertex.y, vertex.z);
-            vertices[k] = shapeT.transform(vertices[k]);
-          }
-          mMeshes[i]->updateTriangle(vertices[0], vertices[1], vertices[2]);
+          const Eigen::Vector3d vertex
+              = shapeT * softBodyNode->getPointMass(j)->getLocalPosition();
+          mSoftMeshVertices[j].setValue(vertex[0], vertex[1], vertex[2]);
         }
 
-        mMeshes[i]->endUpdateModel();
+        mMeshes[i]->beginUpdateModel();
+        mMeshes[i]->updateSubModel(mSoftMeshVertices);
+        mMeshes[i]->endUpdateModel(true, true);
+        mMeshes[i]->computeLocalAABB();
         break;
       }
       default:
@@ -346,6 +359,36 @@ void FCLMeshCollisionNode::updateShape()
   }
 }
 
+//==============================================================================
+void FCLMeshCollisionNode::updateTransforms()
+{
+  mBodyNode->getTransform();
+
+  for (size_t i = 0; i < mBodyNode->getNumCollisionShapes(); i++)
+  {
+    dynamics::Shape* shape = mBodyNode->getCollisionShape(i);
+    if (shape->getShapeType() != dynamics::Shape::SOFT_MESH)
+      continue;
+
+    dynamics::SoftBodyNode* softBodyNode
+        = static_cast<dynamics::SoftMeshShape*>(shape)->getSoftBodyNode();
+    for (size_t j = 0; j < softBodyNode->getNumPointMasses(); j++)
+      softBodyNode->getPointMass(j)->getLocalPosition();
+  }
+}
+
+//==============================================================================
+void FCLMeshCollisionNode::updateCollisionObjects()
+{
+  evalRT();
+
+  for (size_t i = 0; i < mCollisionObjects.size(); i++)
+  {
+    mCollisionObjects[i]->setTransform(mFclWorldTrans);
+    mCollisionObjects[i]->computeAABB();
+  }
+}
+
 //==============================================================================
 void FCLMeshCollisionNode::evalRT()
 {
@@ -459,22 +502,24 @@ fcl::BVHModel<BV>* createSoftMesh(const aiMesh* _mesh,
                                   const fcl::Transform3f& _transform)
 {
   assert(_mesh);
-  fcl::BVHModel<BV>* model = new fcl::BVHModel<BV>;
-  model->beginModel();
+  std::vector<fcl::Vec3f> vertices(_mesh->mNumVertices);
+  for (unsigned int i = 0; i < _mesh->mNumVertices; i++)
+  {
+    const aiVector3D& vertex = _mesh->mVertices[i];
+    vertices[i] = _transform.transform(
+                    fcl::Vec3f(vertex.x, vertex.y, vertex.z));
+  }
 
+  std::vector<fcl::Triangle> triangles(_mesh->mNumFaces);
   for (unsigned int i = 0; i < _mesh->mNumFaces; i++)
   {
-    fcl::Vec3f vertices[3];
-    for (unsigned int j = 0; j < 3; j++)
-    {
-      const aiVector3D& vertex
-          = _mesh->mVertices[_mesh->mFaces[i].mIndices[j]];
-      vertices[j] = fcl::Vec3f(vertex.x, vertex.y, vertex.z);
-      vertices[j] = _transform.transform(vertices[j]);
-    }
-    model->addTriangle(vertices[0], vertices[1], vertices[2]);
+    const unsigned int* indices = _mesh->mFaces[i].mIndices;
+    triangles[i] = fcl::Triangle(indices[0], indices[1], indices[2]);
   }
 
+  fcl::BVHModel<BV>* model = new fcl::BVHModel<BV>;
+  model->beginModel(triangles.size(), vertices.size());
+  model->addSubModel(vertices, triangles);
   model->endModel();
   return model;
 }
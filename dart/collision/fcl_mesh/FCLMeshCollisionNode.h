@@ -43,10 +43,12 @@
 #include <assimp/mesh.h>
 #include <Eigen/Dense>
 #include <fcl/collision.h>
+#include <fcl/collision_object.h>
 #include <fcl/BVH/BVH_model.h>
 
 #include "dart/collision/CollisionNode.h"
 #include "dart/collision/CollisionDetector.h"
+#include "dart/collision/ContactReducer.h"
 #include "dart/collision/fcl_mesh/tri_tri_intersection_test.h"
 
 namespace dart {
@@ -74,6 +76,11 @@ public:
   ///
   std::vector<fcl::BVHModel<fcl::OBBRSS>*> mMeshes;
 
+  /// Collision objects of mMeshes for the broadphase of the collision
+  /// detector. The objects own the meshes, which may be shared with other
+  /// collision nodes through FCLMeshCache. The user data is this node.
+  std::vector<fcl::CollisionObject*> mCollisionObjects;
+
   ///
   fcl::Transform3f mFclWorldTrans;
 
@@ -84,9 +91,20 @@ public:
   virtual bool detectCollision(FCLMeshCollisionNode* _otherNode,
                                std::vector<Contact>* _contactPoints,
                                int _max_num_contact);
-  ///
+  /// Update the vertices of the soft meshes from the positions of the point
+  /// masses. Each point mass is transformed once, and the BVH is refit once.
   void updateShape();
 
+  /// Bring the lazily evaluated transforms of the body node and of the point
+  /// masses of its soft meshes up to date. Evaluating them writes to the
+  /// parent frames, so this is called serially before updateShape() and
+  /// updateCollisionObjects() run concurrently over the nodes.
+  void updateTransforms();
+
+  /// Update the transforms and the bounding boxes of the collision objects
+  /// from the transform of the body node
+  void updateCollisionObjects();
+
   ///
   void evalRT();
 
@@ -119,9 +137,27 @@ private:
 
   ///
   static double triArea(fcl::Vec3f p1, fcl::Vec3f p2, fcl::Vec3f p3);
+
+  /// Reducer that removes the repeated contact points of detectCollision()
+  ContactReducer mContactReducer;
+
+  /// Result of the mesh pairs of detectCollision()
+  fcl::CollisionResult mCollisionResult;
+
+  /// Contact points of a mesh pair before the repeated and co-linear ones are
+  /// removed by detectCollision()
+  std::vector<Contact> mUnfilteredContacts;
+
+  /// Whether each of mUnfilteredContacts is co-linear with two others
+  std::vector<bool> mMarkForDeletion;
+
+  /// Vertices of a soft mesh w.r.t. the body frame, reused by updateShape()
+  std::vector<fcl::Vec3f> mSoftMeshVertices;
 };
 
-///
+/// Create a BVH model of a soft mesh whose vertices are shared by the
+/// triangles in the order of the point masses, so that updateShape() can
+/// replace them in one pass
 template<class BV>
 fcl::BVHModel<BV>* createSoftMesh(const aiMesh* _mesh,
                                   const fcl::Transform3f& _transform);
@@ -36,6 +36,7 @@
 
 #include "dart/constraint/ConstraintBase.h"
 
+#include <cassert>
 #include <cmath>
 #include <cstring>
 #include <iomanip>
@@ -63,6 +64,21 @@ size_t ConstraintBase::getDimension() const
   return mDim;
 }
 
+//==============================================================================
+bool ConstraintBase::isJacobianAvailable() const
+{
+  return false;
+}
+
+//==============================================================================
+void ConstraintBase::getJacobian(ConstraintJacobian* _jacobian)
+{
+  assert(_jacobian != NULL && "Null pointer is not allowed.");
+
+  _jacobian->blocks.clear();
+  _jacobian->cfm = 0.0;
+}
+
 //==============================================================================
 dynamics::Skeleton* ConstraintBase::compressPath(dynamics::Skeleton* _skeleton)
 {
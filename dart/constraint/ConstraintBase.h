@@ -38,6 +38,9 @@
 #define DART_CONSTRAINT_CONSTRAINTBASE_H_
 
 #include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
 
 #include "dart/common/Deprecated.h"
 
@@ -74,6 +77,34 @@ struct ConstraintInfo
   double invTimeStep;
 };
 
+/// ConstraintJacobianBlock is a dense block of constraint Jacobian rows acting
+/// on a subset of the generalized coordinates of a single skeleton
+struct ConstraintJacobianBlock
+{
+  /// Skeleton that the block acts on
+  dynamics::Skeleton* skeleton;
+
+  /// Indices of the generalized coordinates in the skeleton that the columns of
+  /// the block correspond to
+  std::vector<size_t> indices;
+
+  /// Jacobian values. The number of rows is the dimension of the constraint and
+  /// the number of columns is the size of indices.
+  Eigen::MatrixXd jacobian;
+};
+
+/// ConstraintJacobian is a sparse Jacobian of a constraint with respect to the
+/// generalized velocities of the constrained skeletons
+struct ConstraintJacobian
+{
+  /// Nonzero blocks. Blocks acting on the same skeleton are summed up.
+  std::vector<ConstraintJacobianBlock> blocks;
+
+  /// Constraint force mixing parameter that scales the diagonal of the
+  /// constraint's own block in the LCP matrix
+  double cfm;
+};
+
 /// Constraint is a base class of concrete constraints classes
 class ConstraintBase
 {
@@ -93,6 +124,15 @@ public:
   /// Get velocity change due to the uint impulse
   virtual void getVelocityChange(double* _vel, bool _withCfm) = 0;
 
+  /// Return true if this constraint provides its Jacobian by getJacobian(). The
+  /// LCP solvers then build the constraint's rows of the LCP matrix as
+  /// J * M^-1 * J^T instead of by unit impulse tests.
+  virtual bool isJacobianAvailable() const;
+
+  /// Get the sparse Jacobian of this constraint. Called only when
+  /// isJacobianAvailable() returns true.
+  virtual void getJacobian(ConstraintJacobian* _jacobian);
+
   /// Excite the constraint
   virtual void excite() = 0;
 
@@ -36,9 +36,17 @@
 
 #include "dart/constraint/ConstraintSolver.h"
 
+#include <algorithm>
+#include <functional>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "dart/common/Console.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/SoftBodyNode.h"
+#include "dart/dynamics/PointMass.h"
 #include "dart/dynamics/Joint.h"
 #include "dart/dynamics/Skeleton.h"
 #include "dart/collision/fcl_mesh/FCLMeshCollisionDetector.h"
@@ -54,6 +62,8 @@
 #include "dart/constraint/DantzigLCPSolver.h"
 #include "dart/constraint/PGSLCPSolver.h"
 
+#define DART_CONTACT_MATCHING_DISTANCE 1e-2
+
 namespace dart {
 namespace constraint {
 
@@ -63,7 +73,11 @@ using namespace dynamics;
 ConstraintSolver::ConstraintSolver(double _timeStep)
   : mCollisionDetector(new collision::FCLMeshCollisionDetector()),
     mTimeStep(_timeStep),
-    mLCPSolver(new DantzigLCPSolver(mTimeStep))
+    mLCPSolvers(1, new DantzigLCPSolver(mTimeStep)),
+    mIsJointConstraintDirty(true),
+    mNumConstrainedGroups(0),
+    mWarmStarting(false),
+    mLCPSolverType(DANTZIG)
 {
   assert(_timeStep > 0.0);
 }
@@ -72,6 +86,17 @@ ConstraintSolver::ConstraintSolver(double _timeStep)
 ConstraintSolver::~ConstraintSolver()
 {
   delete mCollisionDetector;
+
+  for (const auto& lcpSolver : mLCPSolvers)
+    delete lcpSolver;
+
+  for (const auto& contactConstraint : mContactConstraints)
+    delete contactConstraint;
+
+  for (const auto& softContactConstraint : mSoftContactConstraints)
+    delete softContactConstraint;
+
+  destroyJointConstraints();
 }
 
 //==============================================================================
@@ -85,6 +110,7 @@ void ConstraintSolver::addSkeleton(Skeleton* _skeleton)
     mSkeletons.push_back(_skeleton);
     mCollisionDetector->addSkeleton(_skeleton);
     mConstrainedGroups.reserve(mSkeletons.size());
+    mIsJointConstraintDirty = true;
   }
   else
   {
@@ -108,6 +134,7 @@ void ConstraintSolver::addSkeletons(const std::vector<Skeleton*>& _skeletons)
     {
       mSkeletons.push_back(*it);
       mCollisionDetector->addSkeleton(*it);
+      mIsJointConstraintDirty = true;
 
       ++numAddedSkeletons;
     }
@@ -133,6 +160,8 @@ void ConstraintSolver::removeSkeleton(Skeleton* _skeleton)
                      mSkeletons.end());
     mCollisionDetector->removeSkeleton(_skeleton);
     mConstrainedGroups.reserve(mSkeletons.size());
+    mPersistentContacts.clear();
+    mIsJointConstraintDirty = true;
   }
   else
   {
@@ -158,6 +187,8 @@ void ConstraintSolver::removeSkeletons(
       mSkeletons.erase(remove(mSkeletons.begin(), mSkeletons.end(), *it),
                        mSkeletons.end());
       mCollisionDetector->removeSkeleton(*it);
+      mPersistentContacts.clear();
+      mIsJointConstraintDirty = true;
 
       ++numRemovedSkeletons;
     }
@@ -176,6 +207,8 @@ void ConstraintSolver::removeAllSkeletons()
 {
   mCollisionDetector->removeAllSkeletons();
   mSkeletons.clear();
+  mPersistentContacts.clear();
+  mIsJointConstraintDirty = true;
 }
 
 //==============================================================================
@@ -222,8 +255,8 @@ void ConstraintSolver::setTimeStep(double _timeStep)
   assert(_timeStep > 0.0 && "Time step should be positive value.");
   mTimeStep = _timeStep;
 
-  if (mLCPSolver)
-    mLCPSolver->setTimeStep(mTimeStep);
+  for (const auto& lcpSolver : mLCPSolvers)
+    lcpSolver->setTimeStep(mTimeStep);
 }
 
 //==============================================================================
@@ -232,6 +265,77 @@ double ConstraintSolver::getTimeStep() const
   return mTimeStep;
 }
 
+//==============================================================================
+void ConstraintSolver::setNumThreads(size_t _numThreads)
+{
+  if (_numThreads == 0)
+  {
+    dtwarn << "Attempting to set the number of threads to zero. Using a single "
+           << "thread instead." << std::endl;
+    _numThreads = 1;
+  }
+
+#ifndef _OPENMP
+  if (_numThreads > 1)
+  {
+    dtwarn << "DART is built without OpenMP. Only a single thread will be "
+           << "used." << std::endl;
+  }
+#endif
+
+  for (size_t i = _numThreads; i < mLCPSolvers.size(); ++i)
+    delete mLCPSolvers[i];
+  mLCPSolvers.resize(_numThreads, NULL);
+
+  for (size_t i = 0; i < mLCPSolvers.size(); ++i)
+  {
+    if (mLCPSolvers[i] == NULL)
+      mLCPSolvers[i] = createLCPSolver();
+  }
+}
+
+//==============================================================================
+size_t ConstraintSolver::getNumThreads() const
+{
+  return mLCPSolvers.size();
+}
+
+//==============================================================================
+void ConstraintSolver::setLCPSolverType(LCPSolverType _type)
+{
+  if (_type == mLCPSolverType)
+    return;
+
+  mLCPSolverType = _type;
+
+  for (size_t i = 0; i < mLCPSolvers.size(); ++i)
+  {
+    delete mLCPSolvers[i];
+    mLCPSolvers[i] = createLCPSolver();
+  }
+}
+
+//==============================================================================
+ConstraintSolver::LCPSolverType ConstraintSolver::getLCPSolverType() const
+{
+  return mLCPSolverType;
+}
+
+//==============================================================================
+void ConstraintSolver::setWarmStarting(bool _warmStarting)
+{
+  mWarmStarting = _warmStarting;
+
+  if (!mWarmStarting)
+    mPersistentContacts.clear();
+}
+
+//==============================================================================
+bool ConstraintSolver::isWarmStarting() const
+{
+  return mWarmStarting;
+}
+
 //==============================================================================
 void ConstraintSolver::setCollisionDetector(
     collision::CollisionDetector* _collisionDetector)
@@ -269,6 +373,10 @@ void ConstraintSolver::solve()
 
   // Solve constrained groups
   solveConstrainedGroups();
+
+  // Keep the contact forces to warm start the next time step
+  if (mWarmStarting)
+    updatePersistentContacts();
 }
 
 //==============================================================================
@@ -348,35 +456,78 @@ void ConstraintSolver::updateConstraints()
   mCollisionDetector->clearAllContacts();
   mCollisionDetector->detectCollision(true, true);
 
-  // Destroy previous contact constraints
-  for (const auto& contactConstraint : mContactConstraints)
-    delete contactConstraint;
-  mContactConstraints.clear();
-
-  // Destroy previous soft contact constraints
-  for (const auto& softContactConstraint : mSoftContactConstraints)
-    delete softContactConstraint;
-  mSoftContactConstraints.clear();
+  // Reset the colliding state and refresh the point mass grid of every soft
+  // body in contact once, so that the soft contacts do not scan the point
+  // masses
+  mSoftContactBodyNodes.clear();
+  for (size_t i = 0; i < mCollisionDetector->getNumContacts(); ++i)
+  {
+    const collision::Contact& ct = mCollisionDetector->getContact(i);
+    dynamics::BodyNode* bodyNodes[2] = {ct.bodyNode1, ct.bodyNode2};
+    for (int j = 0; j < 2; ++j)
+    {
+      dynamics::SoftBodyNode* softBodyNode
+          = dynamic_cast<dynamics::SoftBodyNode*>(bodyNodes[j]);
+      if (softBodyNode)
+        mSoftContactBodyNodes.push_back(softBodyNode);
+    }
+  }
+  std::sort(mSoftContactBodyNodes.begin(), mSoftContactBodyNodes.end());
+  mSoftContactBodyNodes.erase(std::unique(mSoftContactBodyNodes.begin(),
+                                          mSoftContactBodyNodes.end()),
+                              mSoftContactBodyNodes.end());
+  for (size_t i = 0; i < mSoftContactBodyNodes.size(); ++i)
+  {
+    dynamics::SoftBodyNode* softBodyNode = mSoftContactBodyNodes[i];
+    for (size_t j = 0; j < softBodyNode->getNumPointMasses(); ++j)
+      softBodyNode->getPointMass(j)->setColliding(false);
+    softBodyNode->updatePointMassIndex();
+  }
 
-  // Create new contact constraints
+  // Reuse the contact constraint objects of the previous time step. The pools
+  // only grow, so a steady number of contacts does not allocate.
+  size_t numContactConstraints = 0;
+  size_t numSoftContactConstraints = 0;
   for (size_t i = 0; i < mCollisionDetector->getNumContacts(); ++i)
   {
     collision::Contact& ct = mCollisionDetector->getContact(i);
 
     if (isSoftContact(ct))
     {
-      mSoftContactConstraints.push_back(
-            new SoftContactConstraint(ct, mTimeStep));
+      if (numSoftContactConstraints < mSoftContactConstraints.size())
+      {
+        mSoftContactConstraints[numSoftContactConstraints]->reset(ct,
+                                                                  mTimeStep);
+      }
+      else
+      {
+        mSoftContactConstraints.push_back(
+              new SoftContactConstraint(ct, mTimeStep));
+      }
+
+      ++numSoftContactConstraints;
     }
     else
     {
-      mContactConstraints.push_back(new ContactConstraint(ct, mTimeStep));
+      if (numContactConstraints < mContactConstraints.size())
+        mContactConstraints[numContactConstraints]->reset(ct, mTimeStep);
+      else
+        mContactConstraints.push_back(new ContactConstraint(ct, mTimeStep));
+
+      if (mWarmStarting)
+      {
+        warmStartContactConstraint(mContactConstraints[numContactConstraints],
+                                   ct);
+      }
+
+      ++numContactConstraints;
     }
   }
 
   // Add the new contact constraints to dynamic constraint list
-  for (const auto& contactConstraint : mContactConstraints)
+  for (size_t i = 0; i < numContactConstraints; ++i)
   {
+    ContactConstraint* contactConstraint = mContactConstraints[i];
     contactConstraint->update();
 
     if (contactConstraint->isActive())
@@ -384,8 +535,9 @@ void ConstraintSolver::updateConstraints()
   }
 
   // Add the new soft contact constraints to dynamic constraint list
-  for (const auto& softContactConstraint : mSoftContactConstraints)
+  for (size_t i = 0; i < numSoftContactConstraints; ++i)
   {
+    SoftContactConstraint* softContactConstraint = mSoftContactConstraints[i];
     softContactConstraint->update();
 
     if (softContactConstraint->isActive())
@@ -393,25 +545,13 @@ void ConstraintSolver::updateConstraints()
   }
 
   //----------------------------------------------------------------------------
-  // Update automatic constraints: joint limit constraints
+  // Update automatic constraints: joint limit and joint Coulomb friction
+  // constraints
   //----------------------------------------------------------------------------
-  // Destroy previous joint limit constraints
-  for (const auto& jointLimitConstraint : mJointLimitConstraints)
-    delete jointLimitConstraint;
-  mJointLimitConstraints.clear();
-
-  // Create new joint limit constraints
-  for (const auto& skel : mSkeletons)
-  {
-    const size_t numBodyNodes = skel->getNumBodyNodes();
-    for (size_t i = 0; i < numBodyNodes; i++)
-    {
-      dynamics::Joint* joint = skel->getBodyNode(i)->getParentJoint();
-
-      if (joint->isDynamic() && joint->isPositionLimited())
-        mJointLimitConstraints.push_back(new JointLimitConstraint(joint));
-    }
-  }
+  // The joint constraints persist over time steps and are only rebuilt when the
+  // set of joints that need them changes
+  if (mIsJointConstraintDirty || isJointConstraintChanged())
+    buildJointConstraints();
 
   // Add active joint limit
   for (auto& jointLimitConstraint : mJointLimitConstraints)
@@ -422,15 +562,22 @@ void ConstraintSolver::updateConstraints()
       mActiveConstraints.push_back(jointLimitConstraint);
   }
 
-  //----------------------------------------------------------------------------
-  // Update automatic constraints: joint Coulomb friction constraints
-  //----------------------------------------------------------------------------
-  // Destroy previous joint limit constraints
-  for (const auto& jointFrictionConstraint : mJointCoulombFrictionConstraints)
-    delete jointFrictionConstraint;
-  mJointCoulombFrictionConstraints.clear();
+  // Add active joint Coulomb friction
+  for (auto& jointFrictionConstraint : mJointCoulombFrictionConstraints)
+  {
+    jointFrictionConstraint->update();
+
+    if (jointFrictionConstraint->isActive())
+      mActiveConstraints.push_back(jointFrictionConstraint);
+  }
+}
+
+//==============================================================================
+bool ConstraintSolver::isJointConstraintChanged() const
+{
+  size_t numJointLimitConstraints = 0;
+  size_t numJointFrictionConstraints = 0;
 
-  // Create new joint limit constraints
   for (const auto& skel : mSkeletons)
   {
     const size_t numBodyNodes = skel->getNumBodyNodes();
@@ -438,37 +585,115 @@ void ConstraintSolver::updateConstraints()
     {
       dynamics::Joint* joint = skel->getBodyNode(i)->getParentJoint();
 
-      if (joint->isDynamic())
+      if (needsJointLimitConstraint(joint))
       {
-        const size_t dof = joint->getNumDofs();
-        for (size_t i = 0; i < dof; ++i)
+        if (numJointLimitConstraints >= mJointLimitConstraints.size()
+            || mJointLimitConstraints[numJointLimitConstraints]->mJoint
+               != joint)
         {
-          if (joint->getCoulombFriction(i) != 0.0)
-          {
-            mJointCoulombFrictionConstraints.push_back(
-                  new JointCoulombFrictionConstraint(joint));
-            break;
-          }
+          return true;
         }
+
+        ++numJointLimitConstraints;
+      }
+
+      if (needsJointCoulombFrictionConstraint(joint))
+      {
+        if (numJointFrictionConstraints
+              >= mJointCoulombFrictionConstraints.size()
+            || mJointCoulombFrictionConstraints[numJointFrictionConstraints]
+                 ->mJoint != joint)
+        {
+          return true;
+        }
+
+        ++numJointFrictionConstraints;
       }
     }
   }
 
-  // Add active joint limit
-  for (auto& jointFrictionConstraint : mJointCoulombFrictionConstraints)
+  return numJointLimitConstraints != mJointLimitConstraints.size()
+      || numJointFrictionConstraints != mJointCoulombFrictionConstraints.size();
+}
+
+//==============================================================================
+void ConstraintSolver::buildJointConstraints()
+{
+  destroyJointConstraints();
+
+  for (const auto& skel : mSkeletons)
   {
-    jointFrictionConstraint->update();
+    const size_t numBodyNodes = skel->getNumBodyNodes();
+    for (size_t i = 0; i < numBodyNodes; i++)
+    {
+      dynamics::Joint* joint = skel->getBodyNode(i)->getParentJoint();
 
-    if (jointFrictionConstraint->isActive())
-      mActiveConstraints.push_back(jointFrictionConstraint);
+      if (needsJointLimitConstraint(joint))
+        mJointLimitConstraints.push_back(new JointLimitConstraint(joint));
+
+      if (needsJointCoulombFrictionConstraint(joint))
+      {
+        mJointCoulombFrictionConstraints.push_back(
+              new JointCoulombFrictionConstraint(joint));
+      }
+    }
+  }
+
+  mIsJointConstraintDirty = false;
+}
+
+//==============================================================================
+void ConstraintSolver::destroyJointConstraints()
+{
+  for (const auto& jointLimitConstraint : mJointLimitConstraints)
+    delete jointLimitConstraint;
+  mJointLimitConstraints.clear();
+
+  for (const auto& jointFrictionConstraint : mJointCoulombFrictionConstraints)
+    delete jointFrictionConstraint;
+  mJointCoulombFrictionConstraints.clear();
+}
+
+//==============================================================================
+LCPSolver* ConstraintSolver::createLCPSolver() const
+{
+  if (mLCPSolverType == PGS)
+    return new PGSLCPSolver(mTimeStep);
+
+  return new DantzigLCPSolver(mTimeStep);
+}
+
+//==============================================================================
+bool ConstraintSolver::needsJointLimitConstraint(dynamics::Joint* _joint)
+{
+  return _joint->isDynamic() && _joint->isPositionLimited();
+}
+
+//==============================================================================
+bool ConstraintSolver::needsJointCoulombFrictionConstraint(
+    dynamics::Joint* _joint)
+{
+  if (!_joint->isDynamic())
+    return false;
+
+  const size_t dof = _joint->getNumDofs();
+  for (size_t i = 0; i < dof; ++i)
+  {
+    if (_joint->getCoulombFriction(i) != 0.0)
+      return true;
   }
+
+  return false;
 }
 
 //==============================================================================
 void ConstraintSolver::buildConstrainedGroups()
 {
-  // Clear constrained groups
-  mConstrainedGroups.clear();
+  // Empty the constrained groups. The group objects are kept to reuse the
+  // memory of their constraint lists.
+  for (size_t i = 0; i < mNumConstrainedGroups; ++i)
+    mConstrainedGroups[i].removeAllConstraints();
+  mNumConstrainedGroups = 0;
 
   // Exit if there is no active constraint
   if (mActiveConstraints.empty())
@@ -492,11 +717,9 @@ void ConstraintSolver::buildConstrainedGroups()
     bool found = false;
     dynamics::Skeleton* skel = (*it)->getRootSkeleton();
 
-    for (std::vector<ConstrainedGroup>::const_iterator itConstGroup
-         = mConstrainedGroups.begin();
-         itConstGroup != mConstrainedGroups.end(); ++itConstGroup)
+    for (size_t i = 0; i < mNumConstrainedGroups; ++i)
     {
-      if ((*itConstGroup).mRootSkeleton == skel)
+      if (mConstrainedGroups[i].mRootSkeleton == skel)
       {
         found = true;
         break;
@@ -506,10 +729,12 @@ void ConstraintSolver::buildConstrainedGroups()
     if (found)
       continue;
 
-    ConstrainedGroup newConstGroup;
-    newConstGroup.mRootSkeleton = skel;
-    skel->mUnionIndex = mConstrainedGroups.size();
-    mConstrainedGroups.push_back(newConstGroup);
+    if (mNumConstrainedGroups == mConstrainedGroups.size())
+      mConstrainedGroups.push_back(ConstrainedGroup());
+
+    mConstrainedGroups[mNumConstrainedGroups].mRootSkeleton = skel;
+    skel->mUnionIndex = mNumConstrainedGroups;
+    ++mNumConstrainedGroups;
   }
 
   // Add active constraints to constrained groups
@@ -533,10 +758,25 @@ void ConstraintSolver::buildConstrainedGroups()
 //==============================================================================
 void ConstraintSolver::solveConstrainedGroups()
 {
-  for (std::vector<ConstrainedGroup>::iterator it = mConstrainedGroups.begin();
-       it != mConstrainedGroups.end(); ++it)
+  // Constrained groups can be solved concurrently. A constraint only applies
+  // impulses to (and reads velocity changes of) reactive bodies, and all the
+  // skeletons of the reactive bodies of a constraint are united into the same
+  // group. Non-reactive bodies shared by several groups are only read, and
+  // every constraint writes contact forces to its own contacts.
+  const int numGroups = static_cast<int>(mNumConstrainedGroups);
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mLCPSolvers.size());
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numGroups; ++i)
   {
-    mLCPSolver->solve(&(*it));
+#ifdef _OPENMP
+    LCPSolver* lcpSolver = mLCPSolvers[omp_get_thread_num()];
+#else
+    LCPSolver* lcpSolver = mLCPSolvers[0];
+#endif
+    lcpSolver->solve(&mConstrainedGroups[i]);
   }
 }
 
@@ -550,5 +790,89 @@ bool ConstraintSolver::isSoftContact(const collision::Contact& _contact) const
   return false;
 }
 
+//==============================================================================
+void ConstraintSolver::updatePersistentContacts()
+{
+  mPersistentContacts.clear();
+
+  for (size_t i = 0; i < mCollisionDetector->getNumContacts(); ++i)
+  {
+    const collision::Contact& ct = mCollisionDetector->getContact(i);
+
+    // Soft contacts and contacts between immobile bodies are not solved, so
+    // their forces are meaningless
+    if (isSoftContact(ct))
+      continue;
+
+    if (!ct.bodyNode1->isReactive() && !ct.bodyNode2->isReactive())
+      continue;
+
+    PersistentContact contact;
+    contact.bodyNode1  = ct.bodyNode1;
+    contact.bodyNode2  = ct.bodyNode2;
+    contact.shape1     = ct.shape1;
+    contact.shape2     = ct.shape2;
+    contact.localPoint = ct.bodyNode1->getTransform().inverse() * ct.point;
+    contact.force      = ct.force;
+
+    mPersistentContacts.push_back(contact);
+  }
+
+  std::sort(mPersistentContacts.begin(), mPersistentContacts.end());
+}
+
+//==============================================================================
+void ConstraintSolver::warmStartContactConstraint(
+    ContactConstraint* _constraint, const collision::Contact& _contact) const
+{
+  PersistentContact key;
+  key.bodyNode1 = _contact.bodyNode1;
+  key.bodyNode2 = _contact.bodyNode2;
+  key.shape1    = _contact.shape1;
+  key.shape2    = _contact.shape2;
+
+  std::vector<PersistentContact>::const_iterator it
+      = std::lower_bound(mPersistentContacts.begin(),
+                         mPersistentContacts.end(), key);
+
+  if (it == mPersistentContacts.end() || key < *it)
+    return;
+
+  // Pick the closest contact between the same shapes within the matching
+  // distance
+  const Eigen::Vector3d localPoint
+      = _contact.bodyNode1->getTransform().inverse() * _contact.point;
+  double minDistance = DART_CONTACT_MATCHING_DISTANCE;
+  const PersistentContact* match = NULL;
+  for (; it != mPersistentContacts.end() && !(key < *it); ++it)
+  {
+    double distance = (it->localPoint - localPoint).norm();
+    if (distance < minDistance)
+    {
+      minDistance = distance;
+      match = &(*it);
+    }
+  }
+
+  if (match)
+    _constraint->setInitialContactForce(0, match->force);
+}
+
+//==============================================================================
+bool ConstraintSolver::PersistentContact::operator<(
+    const PersistentContact& _other) const
+{
+  if (bodyNode1 != _other.bodyNode1)
+    return std::less<dynamics::BodyNode*>()(bodyNode1, _other.bodyNode1);
+
+  if (bodyNode2 != _other.bodyNode2)
+    return std::less<dynamics::BodyNode*>()(bodyNode2, _other.bodyNode2);
+
+  if (shape1 != _other.shape1)
+    return std::less<dynamics::Shape*>()(shape1, _other.shape1);
+
+  return std::less<dynamics::Shape*>()(shape2, _other.shape2);
+}
+
 }  // namespace constraint
 }  // namespace dart
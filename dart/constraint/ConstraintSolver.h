@@ -47,7 +47,11 @@
 namespace dart {
 
 namespace dynamics {
+class BodyNode;
+class Joint;
+class Shape;
 class Skeleton;
+class SoftBodyNode;
 }  // namespace dynamics
 
 namespace constraint {
@@ -69,6 +73,16 @@ class LCPSolver;
 class ConstraintSolver
 {
 public:
+  /// Type of the LCP solvers that solve the constrained groups
+  enum LCPSolverType
+  {
+    /// Dantzig's pivoting method, which solves each LCP from scratch
+    DANTZIG,
+
+    /// Projected Gauss-Seidel, which iterates from an initial guess
+    PGS
+  };
+
   /// Constructor
   explicit ConstraintSolver(double _timeStep);
 
@@ -108,6 +122,29 @@ public:
   /// Get time step
   double getTimeStep() const;
 
+  /// Set the number of threads used to solve the constrained groups. The
+  /// constrained groups are disjoint, so each of them can be solved by a
+  /// different thread with its own LCP solver. The default is 1 (serial).
+  void setNumThreads(size_t _numThreads);
+
+  /// Get the number of threads used to solve the constrained groups
+  size_t getNumThreads() const;
+
+  /// Set the type of the LCP solvers. The default is DANTZIG.
+  void setLCPSolverType(LCPSolverType _type);
+
+  /// Get the type of the LCP solvers
+  LCPSolverType getLCPSolverType() const;
+
+  /// Set whether contact constraints start the LCP solve from the impulses of
+  /// the matching contacts in the previous time step. The default is false.
+  /// Only the PGS solver makes use of the initial guess, so warm starting
+  /// the DANTZIG solver only adds the cost of matching the contacts.
+  void setWarmStarting(bool _warmStarting);
+
+  /// Return true if contact constraints are warm started
+  bool isWarmStarting() const;
+
   /// Set collision detector
   void setCollisionDetector(collision::CollisionDetector* _collisionDetector);
 
@@ -142,38 +179,116 @@ private:
   /// Return true if at least one of colliding body is soft body
   bool isSoftContact(const collision::Contact& _contact) const;
 
+  /// Return true if the set of joints that need joint limit or joint Coulomb
+  /// friction constraints differs from the one the constraints were built for
+  bool isJointConstraintChanged() const;
+
+  /// Rebuild the joint limit and joint Coulomb friction constraints
+  void buildJointConstraints();
+
+  /// Destroy the joint limit and joint Coulomb friction constraints
+  void destroyJointConstraints();
+
+  /// Create an LCP solver of mLCPSolverType
+  LCPSolver* createLCPSolver() const;
+
+  /// Return true if _joint needs a joint limit constraint
+  static bool needsJointLimitConstraint(dynamics::Joint* _joint);
+
+  /// Return true if _joint needs a joint Coulomb friction constraint
+  static bool needsJointCoulombFrictionConstraint(dynamics::Joint* _joint);
+
+  /// Store the contact forces of this time step to warm start the contact
+  /// constraints of the next time step
+  void updatePersistentContacts();
+
+  /// Set the initial contact force of _constraint from the matching contact of
+  /// the previous time step, if any
+  void warmStartContactConstraint(ContactConstraint* _constraint,
+                                  const collision::Contact& _contact) const;
+
+  /// Contact of the previous time step that can warm start a new contact
+  struct PersistentContact
+  {
+    /// First colliding body node
+    dynamics::BodyNode* bodyNode1;
+
+    /// Second colliding body node
+    dynamics::BodyNode* bodyNode2;
+
+    /// First colliding shape
+    dynamics::Shape* shape1;
+
+    /// Second colliding shape
+    dynamics::Shape* shape2;
+
+    /// Contact point w.r.t. the frame of bodyNode1
+    Eigen::Vector3d localPoint;
+
+    /// Contact force acting on bodyNode1 w.r.t. the world frame
+    Eigen::Vector3d force;
+
+    /// Ordering by the colliding body nodes and shapes
+    bool operator<(const PersistentContact& _other) const;
+  };
+
   /// Collision detector
   collision::CollisionDetector* mCollisionDetector;
 
   /// Time step
   double mTimeStep;
 
-  /// LCP solver
-  LCPSolver* mLCPSolver;
+  /// LCP solvers. There is one solver per thread so that each thread solving
+  /// constrained groups owns its own LCP scratch memory.
+  std::vector<LCPSolver*> mLCPSolvers;
 
   /// Skeleton list
   std::vector<dynamics::Skeleton*> mSkeletons;
 
-  /// Contact constraints those are automatically created
+  /// Contact constraints those are automatically created. The objects are
+  /// reused over time steps, so only the leading ones that match the current
+  /// contacts are in use.
   std::vector<ContactConstraint*> mContactConstraints;
 
-  /// Soft contact constraints those are automatically created
+  /// Soft contact constraints those are automatically created. The objects are
+  /// reused over time steps like mContactConstraints.
   std::vector<SoftContactConstraint*> mSoftContactConstraints;
 
+  /// Soft body nodes of the soft contacts of the current time step
+  std::vector<dynamics::SoftBodyNode*> mSoftContactBodyNodes;
+
   /// Joint limit constraints those are automatically created
   std::vector<JointLimitConstraint*> mJointLimitConstraints;
 
-  /// Joint limit constraints those are automatically created
+  /// Joint Coulomb friction constraints those are automatically created
   std::vector<JointCoulombFrictionConstraint*> mJointCoulombFrictionConstraints;
 
+  /// Whether the joint constraints need to be rebuilt because skeletons were
+  /// added or removed
+  bool mIsJointConstraintDirty;
+
   /// Constraints that manually added
   std::vector<ConstraintBase*> mManualConstraints;
 
   /// Active constraints
   std::vector<ConstraintBase*> mActiveConstraints;
 
-  /// Constraint group list
+  /// Constraint group list. Only the first mNumConstrainedGroups groups are in
+  /// use, and the rest are kept to reuse their memory.
   std::vector<ConstrainedGroup> mConstrainedGroups;
+
+  /// Number of constrained groups in use
+  size_t mNumConstrainedGroups;
+
+  /// Whether contact constraints are warm started
+  bool mWarmStarting;
+
+  /// Type of the LCP solvers
+  LCPSolverType mLCPSolverType;
+
+  /// Contacts of the previous time step sorted by the colliding body nodes and
+  /// shapes
+  std::vector<PersistentContact> mPersistentContacts;
 };
 
 }  // namespace constraint
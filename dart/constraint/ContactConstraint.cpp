@@ -36,6 +36,7 @@
 
 #include "dart/constraint/ContactConstraint.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/common/Console.h"
@@ -88,8 +89,31 @@ ContactConstraint::ContactConstraint(collision::Contact& _contact,
     mIsBounceOn(false),
     mActive(false)
 {
+  reset(_contact, _timeStep);
+
+  //----------------------------------------------------------------------------
+  // Union finding
+  //----------------------------------------------------------------------------
+//  uniteSkeletons();
+}
+
+//==============================================================================
+ContactConstraint::~ContactConstraint()
+{
+}
+
+//==============================================================================
+void ContactConstraint::reset(collision::Contact& _contact, double _timeStep)
+{
+  mTimeStep = _timeStep;
+  mFirstFrictionalDirection = Eigen::Vector3d::UnitZ();
+  mAppliedImpulseIndex = -1;
+  mActive = false;
+
   // TODO(JS): Assumed single contact
+  mContacts.clear();
   mContacts.push_back(&_contact);
+  mInitialContactForces.assign(mContacts.size(), Eigen::Vector3d::Zero());
 
   // TODO(JS):
   mBodyNode1 = _contact.bodyNode1;
@@ -152,7 +176,7 @@ ContactConstraint::ContactConstraint(collision::Contact& _contact,
       collision::Contact* ct = mContacts[i];
 
       // TODO(JS): Assumed that the number of tangent basis is 2.
-      Eigen::MatrixXd D = getTangentBasisMatrixODE(ct->normal);
+      Eigen::Matrix<double, 3, 2> D = getTangentBasisMatrixODE(ct->normal);
 
       assert(std::fabs(ct->normal.dot(D.col(0))) < DART_EPSILON);
       assert(std::fabs(ct->normal.dot(D.col(1))) < DART_EPSILON);
@@ -259,16 +283,6 @@ ContactConstraint::ContactConstraint(collision::Contact& _contact,
       mJacobians2[i].tail<3>().noalias() = bodyDirection2;
     }
   }
-
-  //----------------------------------------------------------------------------
-  // Union finding
-  //----------------------------------------------------------------------------
-//  uniteSkeletons();
-}
-
-//==============================================================================
-ContactConstraint::~ContactConstraint()
-{
 }
 
 //==============================================================================
@@ -378,6 +392,22 @@ const Eigen::Vector3d& ContactConstraint::getFrictionDirection1() const
   return mFirstFrictionalDirection;
 }
 
+//==============================================================================
+void ContactConstraint::setInitialContactForce(size_t _index,
+                                               const Eigen::Vector3d& _force)
+{
+  assert(_index < mInitialContactForces.size() && "Invalid Index.");
+  mInitialContactForces[_index] = _force;
+}
+
+//==============================================================================
+const Eigen::Vector3d& ContactConstraint::getInitialContactForce(
+    size_t _index) const
+{
+  assert(_index < mInitialContactForces.size() && "Invalid Index.");
+  return mInitialContactForces[_index];
+}
+
 //==============================================================================
 void ContactConstraint::update()
 {
@@ -469,11 +499,23 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
       _info->b[index] += bouncingVelocity;
 //      std::cout << "_lcp->b[_idx]: " << _lcp->b[_idx] << std::endl;
 
-      // TODO(JS): Initial guess
-      // x
-      _info->x[index] = 0.0;
-      _info->x[index + 1] = 0.0;
-      _info->x[index + 2] = 0.0;
+      // Initial guess from the contact force of the previous time step
+      const Eigen::Vector3d& initialForce = mInitialContactForces[i];
+      if (initialForce.isZero())
+      {
+        _info->x[index] = 0.0;
+        _info->x[index + 1] = 0.0;
+        _info->x[index + 2] = 0.0;
+      }
+      else
+      {
+        Eigen::Matrix<double, 3, 2> D
+            = getTangentBasisMatrixODE(mContacts[i]->normal);
+        _info->x[index] = std::max(
+              initialForce.dot(mContacts[i]->normal) * mTimeStep, 0.0);
+        _info->x[index + 1] = initialForce.dot(D.col(0)) * mTimeStep;
+        _info->x[index + 2] = initialForce.dot(D.col(1)) * mTimeStep;
+      }
 
       // Increase index
       index += 3;
@@ -535,9 +577,10 @@ void ContactConstraint::getInformation(ConstraintInfo* _info)
       _info->b[i] += bouncingVelocity;
 //      std::cout << "_lcp->b[_idx]: " << _lcp->b[_idx] << std::endl;
 
-      // TODO(JS): Initial guess
-      // x
-      _info->x[i] = 0.0;
+      // Initial guess from the contact force of the previous time step
+      _info->x[i] = std::max(
+            mInitialContactForces[i].dot(mContacts[i]->normal) * mTimeStep,
+            0.0);
 
       // Increase index
     }
@@ -642,6 +685,56 @@ void ContactConstraint::getVelocityChange(double* _vel, bool _withCfm)
   }
 }
 
+//==============================================================================
+bool ContactConstraint::isJacobianAvailable() const
+{
+  return true;
+}
+
+//==============================================================================
+void ContactConstraint::getJacobian(ConstraintJacobian* _jacobian)
+{
+  assert(_jacobian != NULL && "Null pointer is not allowed.");
+
+  _jacobian->cfm = mConstraintForceMixing;
+
+  dynamics::BodyNode* bodyNodes[2] = {mBodyNode1, mBodyNode2};
+  const std::vector<Eigen::Vector6d,
+      Eigen::aligned_allocator<Eigen::Vector6d> >* jacobians[2]
+      = {&mJacobians1, &mJacobians2};
+
+  // Resize the blocks rather than rebuilding them to reuse their memory
+  size_t numBlocks = 0;
+  for (size_t i = 0; i < 2; ++i)
+  {
+    if (bodyNodes[i]->isReactive())
+      ++numBlocks;
+  }
+  _jacobian->blocks.resize(numBlocks);
+
+  size_t blockIndex = 0;
+  for (size_t i = 0; i < 2; ++i)
+  {
+    dynamics::BodyNode* bodyNode = bodyNodes[i];
+    if (!bodyNode->isReactive())
+      continue;
+
+    // The contact Jacobians are expressed in the body frame, so map them to
+    // the generalized coordinates through the body Jacobian
+    const math::Jacobian& bodyJacobian = bodyNode->getBodyJacobian();
+
+    ConstraintJacobianBlock& block = _jacobian->blocks[blockIndex++];
+    block.skeleton = bodyNode->getSkeleton();
+    block.indices  = bodyNode->getDependentGenCoordIndices();
+    block.jacobian.resize(mDim, bodyJacobian.cols());
+    for (size_t j = 0; j < mDim; ++j)
+    {
+      block.jacobian.row(j).noalias()
+          = (*jacobians[i])[j].transpose() * bodyJacobian;
+    }
+  }
+}
+
 //==============================================================================
 void ContactConstraint::excite()
 {
@@ -699,7 +792,8 @@ void ContactConstraint::applyImpulse(double* _lambda)
       assert(!math::isNan(_lambda[index]));
 
       // Add contact impulse (force) toward the tangential w.r.t. world frame
-      Eigen::MatrixXd D = getTangentBasisMatrixODE(mContacts[i]->normal);
+      Eigen::Matrix<double, 3, 2> D
+          = getTangentBasisMatrixODE(mContacts[i]->normal);
       mContacts[i]->force += D.col(0) * _lambda[index] / mTimeStep;
 
       // Tangential direction-1 impulsive force
@@ -797,14 +891,15 @@ void ContactConstraint::updateFirstFrictionalDirection()
 }
 
 //==============================================================================
-Eigen::MatrixXd ContactConstraint::getTangentBasisMatrixODE(
+Eigen::Matrix<double, 3, 2>
+ContactConstraint::getTangentBasisMatrixODE(
     const Eigen::Vector3d& _n)
 {
   // TODO(JS): Use mNumFrictionConeBases
   // Check if the number of bases is even number.
 //  bool isEvenNumBases = mNumFrictionConeBases % 2 ? true : false;
 
-  Eigen::MatrixXd T(Eigen::MatrixXd::Zero(3, 2));
+  Eigen::Matrix<double, 3, 2> T;
 
   // Pick an arbitrary vector to take the cross product of (in this case,
   // Z-axis)
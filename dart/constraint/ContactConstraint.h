@@ -103,6 +103,15 @@ public:
   /// Get first frictional direction
   const Eigen::Vector3d& getFrictionDirection1() const;
 
+  /// Set the contact force that the initial guess of the constraint impulse of
+  /// the _index-th contact is computed from. The constraint solver sets it to
+  /// the force of the matching contact in the previous time step.
+  void setInitialContactForce(size_t _index, const Eigen::Vector3d& _force);
+
+  /// Get the contact force that the initial guess of the constraint impulse of
+  /// the _index-th contact is computed from
+  const Eigen::Vector3d& getInitialContactForce(size_t _index) const;
+
   //----------------------------------------------------------------------------
   // Friendship
   //----------------------------------------------------------------------------
@@ -127,6 +136,12 @@ protected:
   // Documentation inherited
   virtual void getVelocityChange(double* _vel, bool _withCfm);
 
+  // Documentation inherited
+  virtual bool isJacobianAvailable() const;
+
+  // Documentation inherited
+  virtual void getJacobian(ConstraintJacobian* _jacobian);
+
   // Documentation inherited
   virtual void excite();
 
@@ -146,6 +161,10 @@ protected:
   virtual bool isActive() const;
 
 private:
+  /// Reinitialize this constraint for _contact so that the constraint object
+  /// can be reused for a new contact
+  void reset(collision::Contact& _contact, double _timeStep);
+
   /// Get change in relative velocity at contact point due to external impulse
   /// \param[out] _relVel Change in relative velocity at contact point of the
   ///                     two colliding bodies
@@ -155,7 +174,8 @@ private:
   void updateFirstFrictionalDirection();
 
   ///
-  Eigen::MatrixXd getTangentBasisMatrixODE(const Eigen::Vector3d& _n);
+  Eigen::Matrix<double, 3, 2> getTangentBasisMatrixODE(
+      const Eigen::Vector3d& _n);
 
 private:
   /// Time step
@@ -173,6 +193,9 @@ private:
   /// First frictional direction
   Eigen::Vector3d mFirstFrictionalDirection;
 
+  /// Contact forces used as the initial guess of the constraint impulses
+  std::vector<Eigen::Vector3d> mInitialContactForces;
+
   /// Coefficient of Friction
   double mFrictionCoeff;
 
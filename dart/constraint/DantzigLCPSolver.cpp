@@ -71,13 +71,23 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
   // Build LCP terms by aggregating them from constraints
   size_t n = _group->getTotalDimension();
   int nSkip = dPAD(n);
-  double* A = new double[n * nSkip];
-  double* x = new double[n];
-  double* b = new double[n];
-  double* w = new double[n];
-  double* lo = new double[n];
-  double* hi = new double[n];
-  int* findex = new int[n];
+
+  // Take the LCP terms from the workspace of this solver rather than
+  // allocating them for every group
+  size_t workspaceSize = getWorkspaceBlockSize<double>(n * nSkip)
+                         + 5 * getWorkspaceBlockSize<double>(n)
+                         + getWorkspaceBlockSize<int>(n)
+                         + getWorkspaceBlockSize<size_t>(numConstraints)
+                         + getWorkspaceBlockSize<char>(
+                               dEstimateSolveLCPMemoryReq(n, true));
+  char* workspace = reserveWorkspace(workspaceSize);
+  double* A = takeWorkspaceBlock<double>(&workspace, n * nSkip);
+  double* x = takeWorkspaceBlock<double>(&workspace, n);
+  double* b = takeWorkspaceBlock<double>(&workspace, n);
+  double* w = takeWorkspaceBlock<double>(&workspace, n);
+  double* lo = takeWorkspaceBlock<double>(&workspace, n);
+  double* hi = takeWorkspaceBlock<double>(&workspace, n);
+  int* findex = takeWorkspaceBlock<int>(&workspace, n);
 
   // Set w to 0 and findex to -1
 #ifndef NDEBUG
@@ -87,7 +97,7 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
   std::memset(findex, -1, n * sizeof(int));
 
   // Compute offset indices
-  size_t* offset = new size_t[n];
+  size_t* offset = takeWorkspaceBlock<size_t>(&workspace, numConstraints);
   offset[0] = 0;
 //  std::cout << "offset[" << 0 << "]: " << offset[0] << std::endl;
   for (size_t i = 1; i < numConstraints; ++i)
@@ -116,45 +126,17 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
     // Fill vectors: lo, hi, b, w
     constraint->getInformation(&constInfo);
 
-    // Fill a matrix by impulse tests: A
-    constraint->excite();
+    // Adjust findex for global index
     for (size_t j = 0; j < constraint->getDimension(); ++j)
     {
-      // Adjust findex for global index
       if (findex[offset[i] + j] >= 0)
         findex[offset[i] + j] += offset[i];
-
-      // Apply impulse for mipulse test
-      constraint->applyUnitImpulse(j);
-
-      // Fill upper triangle blocks of A matrix
-      int index = nSkip * (offset[i] + j) + offset[i];
-      constraint->getVelocityChange(A + index, true);
-      for (size_t k = i + 1; k < numConstraints; ++k)
-      {
-        index = nSkip * (offset[i] + j) + offset[k];
-        _group->getConstraint(k)->getVelocityChange(A + index, false);
-      }
-
-      // Filling symmetric part of A matrix
-      for (size_t k = 0; k < i; ++k)
-      {
-        for (size_t l = 0; l < _group->getConstraint(k)->getDimension(); ++l)
-        {
-          int index1 = nSkip * (offset[i] + j) + offset[k] + l;
-          int index2 = nSkip * (offset[k] + l) + offset[i] + j;
-
-          A[index1] = A[index2];
-        }
-      }
     }
-
-    assert(isSymmetric(n, A, offset[i],
-                       offset[i] + constraint->getDimension() - 1));
-
-    constraint->unexcite();
   }
 
+  // Fill a matrix: A
+  buildLCPMatrix(_group, A, nSkip, offset);
+
   assert(isSymmetric(n, A));
 
   // Print LCP formulation
@@ -163,7 +145,7 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
 //  std::cout << std::endl;
 
   // Solve LCP using ODE's Dantzig algorithm
-  dSolveLCP(n, A, x, b, w, 0, lo, hi, findex);
+  dSolveLCP(n, A, x, b, w, 0, lo, hi, findex, workspace);
 
   // Print LCP formulation
 //  dtdbg << "After solve:" << std::endl;
@@ -178,15 +160,6 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
     constraint->excite();
   }
 
-  delete[] offset;
-
-  delete[] A;
-  delete[] x;
-  delete[] b;
-  delete[] w;
-  delete[] lo;
-  delete[] hi;
-  delete[] findex;
 }
 
 //==============================================================================
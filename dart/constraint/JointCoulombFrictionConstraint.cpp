@@ -240,6 +240,37 @@ void JointCoulombFrictionConstraint::getVelocityChange(double* _delVel,
   assert(localIndex == mDim);
 }
 
+//==============================================================================
+bool JointCoulombFrictionConstraint::isJacobianAvailable() const
+{
+  return true;
+}
+
+//==============================================================================
+void JointCoulombFrictionConstraint::getJacobian(ConstraintJacobian* _jacobian)
+{
+  assert(_jacobian != NULL && "Null pointer is not allowed.");
+
+  _jacobian->blocks.resize(1);
+  _jacobian->cfm = mConstraintForceMixing;
+
+  // Each active degree of freedom is constrained independently, so the
+  // Jacobian is a selection of the joint's generalized coordinates
+  ConstraintJacobianBlock& block = _jacobian->blocks[0];
+  block.skeleton = mJoint->getSkeleton();
+  block.indices.clear();
+
+  size_t dof = mJoint->getNumDofs();
+  for (size_t i = 0; i < dof; ++i)
+  {
+    if (mActive[i])
+      block.indices.push_back(mJoint->getIndexInSkeleton(i));
+  }
+  assert(block.indices.size() == mDim);
+
+  block.jacobian = Eigen::MatrixXd::Identity(mDim, mDim);
+}
+
 //==============================================================================
 void JointCoulombFrictionConstraint::excite()
 {
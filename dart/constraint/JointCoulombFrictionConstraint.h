@@ -92,6 +92,12 @@ protected:
   // Documentation inherited
   virtual void getVelocityChange(double* _delVel, bool _withCfm);
 
+  // Documentation inherited
+  virtual bool isJacobianAvailable() const;
+
+  // Documentation inherited
+  virtual void getJacobian(ConstraintJacobian* _jacobian);
+
   // Documentation inherited
   virtual void excite();
 
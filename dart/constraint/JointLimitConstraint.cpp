@@ -348,6 +348,37 @@ void JointLimitConstraint::getVelocityChange(double* _delVel, bool _withCfm)
   assert(localIndex == mDim);
 }
 
+//==============================================================================
+bool JointLimitConstraint::isJacobianAvailable() const
+{
+  return true;
+}
+
+//==============================================================================
+void JointLimitConstraint::getJacobian(ConstraintJacobian* _jacobian)
+{
+  assert(_jacobian != NULL && "Null pointer is not allowed.");
+
+  _jacobian->blocks.resize(1);
+  _jacobian->cfm = mConstraintForceMixing;
+
+  // Each active degree of freedom is constrained independently, so the
+  // Jacobian is a selection of the joint's generalized coordinates
+  ConstraintJacobianBlock& block = _jacobian->blocks[0];
+  block.skeleton = mJoint->getSkeleton();
+  block.indices.clear();
+
+  size_t dof = mJoint->getNumDofs();
+  for (size_t i = 0; i < dof; ++i)
+  {
+    if (mActive[i])
+      block.indices.push_back(mJoint->getIndexInSkeleton(i));
+  }
+  assert(block.indices.size() == mDim);
+
+  block.jacobian = Eigen::MatrixXd::Identity(mDim, mDim);
+}
+
 //==============================================================================
 void JointLimitConstraint::excite()
 {
@@ -36,8 +36,15 @@
 
 #include "dart/constraint/LCPSolver.h"
 
+#include <algorithm>
 #include <cassert>
 
+#include "dart/constraint/ConstraintBase.h"
+#include "dart/constraint/ConstrainedGroup.h"
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/Skeleton.h"
+
 namespace dart {
 namespace constraint {
 
@@ -55,13 +62,303 @@ double LCPSolver::getTimeStep() const
 }
 
 //==============================================================================
-LCPSolver::LCPSolver(double _timeStep) : mTimeStep(_timeStep)
+const size_t LCPSolver::WORKSPACE_ALIGNMENT;
+
+//==============================================================================
+LCPSolver::LCPSolver(double _timeStep)
+  : mTimeStep(_timeStep),
+    mWorkspaceMemory(NULL),
+    mWorkspace(NULL),
+    mWorkspaceSize(0),
+    mNumJacobianSkeletons(0)
 {
 }
 
 //==============================================================================
 LCPSolver::~LCPSolver()
 {
+  delete[] mWorkspaceMemory;
+}
+
+//==============================================================================
+char* LCPSolver::reserveWorkspace(size_t _size)
+{
+  if (_size <= mWorkspaceSize)
+    return mWorkspace;
+
+  // Grow geometrically so that slowly growing groups reallocate rarely
+  size_t size = std::max(_size, 2 * mWorkspaceSize);
+
+  delete[] mWorkspaceMemory;
+  mWorkspaceMemory = new char[size + WORKSPACE_ALIGNMENT - 1];
+
+  size_t address = reinterpret_cast<size_t>(mWorkspaceMemory);
+  size_t padding = (WORKSPACE_ALIGNMENT - address % WORKSPACE_ALIGNMENT)
+                   % WORKSPACE_ALIGNMENT;
+  mWorkspace = mWorkspaceMemory + padding;
+  mWorkspaceSize = size;
+
+  return mWorkspace;
+}
+
+//==============================================================================
+void LCPSolver::buildLCPMatrix(ConstrainedGroup* _group, double* _A,
+                               size_t _nSkip, const size_t* _offset)
+{
+  size_t numConstraints = _group->getNumConstraints();
+
+  //----------------------------------------------------------------------------
+  // Collect the Jacobians of the constraints that provide them
+  //----------------------------------------------------------------------------
+  // The Jacobians and the per skeleton lists are members so that their memory
+  // is reused over time steps
+  if (mJacobians.size() < numConstraints)
+    mJacobians.resize(numConstraints);
+  mIsJacobianUsed.assign(numConstraints, false);
+  mNumJacobianSkeletons = 0;
+
+  std::vector<ConstraintJacobian>& jacobians = mJacobians;
+  std::vector<bool>& isJacobianUsed = mIsJacobianUsed;
+
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    ConstraintBase* constraint = _group->getConstraint(i);
+    if (!constraint->isJacobianAvailable())
+      continue;
+
+    constraint->getJacobian(&jacobians[i]);
+
+    bool isDynamic = true;
+    for (size_t j = 0; j < jacobians[i].blocks.size(); ++j)
+    {
+      if (!isImpulseResponseDynamic(jacobians[i].blocks[j].skeleton))
+      {
+        isDynamic = false;
+        break;
+      }
+    }
+
+    if (!isDynamic)
+      continue;
+
+    isJacobianUsed[i] = true;
+
+    for (size_t j = 0; j < jacobians[i].blocks.size(); ++j)
+    {
+      std::vector<size_t>& constraints
+          = getJacobianSkeletonConstraints(jacobians[i].blocks[j].skeleton);
+      if (constraints.empty() || constraints.back() != i)
+        constraints.push_back(i);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Assemble J * M^-1 * J^T blocks skeleton by skeleton
+  //----------------------------------------------------------------------------
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    if (!isJacobianUsed[i])
+      continue;
+
+    size_t dimI = _group->getConstraint(i)->getDimension();
+    for (size_t k = 0; k < numConstraints; ++k)
+    {
+      if (!isJacobianUsed[k])
+        continue;
+
+      size_t dimK = _group->getConstraint(k)->getDimension();
+      for (size_t j = 0; j < dimI; ++j)
+      {
+        double* row = _A + _nSkip * (_offset[i] + j) + _offset[k];
+        for (size_t l = 0; l < dimK; ++l)
+          row[l] = 0.0;
+      }
+    }
+  }
+
+  for (size_t s = 0; s < mNumJacobianSkeletons; ++s)
+  {
+    dynamics::Skeleton* skeleton = mJacobianSkeletons[s].first;
+    const std::vector<size_t>& constraints = mJacobianSkeletons[s].second;
+
+    // Column offsets of the constraints in the stacked transposed Jacobian
+    std::vector<size_t>& columns = mJacobianColumns;
+    columns.resize(constraints.size());
+    size_t numColumns = 0;
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+      columns[i] = numColumns;
+      numColumns += _group->getConstraint(constraints[i])->getDimension();
+    }
+
+    // The dense matrices below are mapped to member buffers that only grow, so
+    // that no memory is allocated once the buffers are large enough
+    size_t numDofs = skeleton->getNumDofs();
+    if (mJacobianTransposeMemory.size() < numDofs * numColumns)
+    {
+      mJacobianTransposeMemory.resize(numDofs * numColumns);
+      mInvMassJacobianTransposeMemory.resize(numDofs * numColumns);
+    }
+    if (mJacobianBlockMemory.size() < numColumns * numColumns)
+      mJacobianBlockMemory.resize(numColumns * numColumns);
+
+    // Stack the transposed Jacobian rows acting on this skeleton
+    Eigen::Map<Eigen::MatrixXd> JT(mJacobianTransposeMemory.data(), numDofs,
+                                   numColumns);
+    JT.setZero();
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+      const ConstraintJacobian& jacobian = jacobians[constraints[i]];
+      for (size_t j = 0; j < jacobian.blocks.size(); ++j)
+      {
+        const ConstraintJacobianBlock& block = jacobian.blocks[j];
+        if (block.skeleton != skeleton)
+          continue;
+
+        for (size_t l = 0; l < block.indices.size(); ++l)
+        {
+          JT.row(block.indices[l]).segment(columns[i], block.jacobian.rows())
+              += block.jacobian.col(l).transpose();
+        }
+      }
+    }
+
+    // The LTDL factorization of the mass matrix keeps this O(n) per column
+    Eigen::Map<Eigen::MatrixXd> MinvJT(mInvMassJacobianTransposeMemory.data(),
+                                       numDofs, numColumns);
+    MinvJT = JT;
+    skeleton->solveMassMatrixInPlace(MinvJT);
+
+    Eigen::Map<Eigen::MatrixXd> JMinvJT(mJacobianBlockMemory.data(),
+                                        numColumns, numColumns);
+    JMinvJT.noalias() = JT.transpose() * MinvJT;
+
+    // Scatter the dense block to the LCP matrix
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+      size_t dimI = _group->getConstraint(constraints[i])->getDimension();
+      for (size_t k = 0; k < constraints.size(); ++k)
+      {
+        size_t dimK = _group->getConstraint(constraints[k])->getDimension();
+        for (size_t j = 0; j < dimI; ++j)
+        {
+          double* row = _A + _nSkip * (_offset[constraints[i]] + j)
+                        + _offset[constraints[k]];
+          for (size_t l = 0; l < dimK; ++l)
+            row[l] += JMinvJT(columns[i] + j, columns[k] + l);
+        }
+      }
+    }
+  }
+
+  // Add small values to the diagonal to keep it away from singular, similar to
+  // cfm variable in ODE
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    if (!isJacobianUsed[i])
+      continue;
+
+    for (size_t j = 0; j < _group->getConstraint(i)->getDimension(); ++j)
+    {
+      double& diagonal = _A[_nSkip * (_offset[i] + j) + _offset[i] + j];
+      diagonal += diagonal * jacobians[i].cfm;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Fill the remaining rows by impulse tests
+  //----------------------------------------------------------------------------
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    if (isJacobianUsed[i])
+      continue;
+
+    ConstraintBase* constraint = _group->getConstraint(i);
+
+    constraint->excite();
+    for (size_t j = 0; j < constraint->getDimension(); ++j)
+    {
+      // Apply impulse for mipulse test
+      constraint->applyUnitImpulse(j);
+
+      // Fill upper triangle blocks of A matrix and the blocks of the constraints
+      // assembled from Jacobians
+      double* row = _A + _nSkip * (_offset[i] + j);
+      constraint->getVelocityChange(row + _offset[i], true);
+      for (size_t k = 0; k < numConstraints; ++k)
+      {
+        if (k > i || (k != i && isJacobianUsed[k]))
+          _group->getConstraint(k)->getVelocityChange(row + _offset[k], false);
+      }
+
+      // Filling symmetric part of A matrix
+      for (size_t k = 0; k < numConstraints; ++k)
+      {
+        if (k == i)
+          continue;
+
+        for (size_t l = 0; l < _group->getConstraint(k)->getDimension(); ++l)
+        {
+          size_t index1 = _nSkip * (_offset[i] + j) + _offset[k] + l;
+          size_t index2 = _nSkip * (_offset[k] + l) + _offset[i] + j;
+
+          if (k < i && !isJacobianUsed[k])
+            _A[index1] = _A[index2];
+          else if (isJacobianUsed[k])
+            _A[index2] = _A[index1];
+        }
+      }
+    }
+
+    constraint->unexcite();
+  }
+}
+
+//==============================================================================
+std::vector<size_t>& LCPSolver::getJacobianSkeletonConstraints(
+    dynamics::Skeleton* _skeleton)
+{
+  // Constrained groups rarely involve more than a few skeletons, so a linear
+  // search is cheaper than a map
+  for (size_t i = 0; i < mNumJacobianSkeletons; ++i)
+  {
+    if (mJacobianSkeletons[i].first == _skeleton)
+      return mJacobianSkeletons[i].second;
+  }
+
+  if (mNumJacobianSkeletons == mJacobianSkeletons.size())
+    mJacobianSkeletons.resize(mNumJacobianSkeletons + 1);
+
+  std::pair<dynamics::Skeleton*, std::vector<size_t> >& entry
+      = mJacobianSkeletons[mNumJacobianSkeletons++];
+  entry.first = _skeleton;
+  entry.second.clear();
+
+  return entry.second;
+}
+
+//==============================================================================
+bool LCPSolver::isImpulseResponseDynamic(dynamics::Skeleton* _skeleton)
+{
+  // The point masses of soft body nodes add to the articulated inertia but
+  // not to the rigid mass matrix
+  if (_skeleton->getNumSoftBodyNodes() > 0)
+    return false;
+
+  for (size_t i = 0; i < _skeleton->getNumBodyNodes(); ++i)
+  {
+    dynamics::Joint::ActuatorType type
+        = _skeleton->getBodyNode(i)->getParentJoint()->getActuatorType();
+
+    if (type != dynamics::Joint::FORCE
+        && type != dynamics::Joint::PASSIVE
+        && type != dynamics::Joint::SERVO)
+    {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 }  // namespace constraint
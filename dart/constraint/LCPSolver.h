@@ -37,7 +37,18 @@
 #ifndef DART_CONSTRAINT_LCPSOLVER_H_
 #define DART_CONSTRAINT_LCPSOLVER_H_
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "dart/constraint/ConstraintBase.h"
+
 namespace dart {
+
+namespace dynamics {
+class Skeleton;
+}  // namespace dynamics
+
 namespace constraint {
 
 class ConstrainedGroup;
@@ -46,6 +57,9 @@ class ConstrainedGroup;
 class LCPSolver
 {
 public:
+  /// Destructor
+  virtual ~LCPSolver();
+
   /// Solve constriant impulses for a constrained group
   virtual void solve(ConstrainedGroup* _group) = 0;
 
@@ -59,14 +73,105 @@ protected:
   /// Constructor
   LCPSolver(double _timeStep);
 
-  /// Destructor
-  virtual ~LCPSolver();
+  /// Return scratch memory of at least _size bytes aligned to
+  /// WORKSPACE_ALIGNMENT. The memory is owned by this solver and is only
+  /// reallocated when _size exceeds the largest size requested so far, so
+  /// solving constrained groups of steady sizes does not allocate memory. The
+  /// memory is valid until the next call.
+  char* reserveWorkspace(size_t _size);
+
+  /// Return the size of the workspace block of _count elements of T
+  template <typename T>
+  static size_t getWorkspaceBlockSize(size_t _count);
+
+  /// Return the workspace block of _count elements of T that begins at
+  /// _workspace, and advance _workspace to the next block
+  template <typename T>
+  static T* takeWorkspaceBlock(char** _workspace, size_t _count);
+
+  /// Fill the LCP matrix, A, of _group whose row stride is _nSkip. _offset is
+  /// the row index of the first row of each constraint. The blocks between
+  /// constraints that provide their Jacobians are assembled as J * M^-1 * J^T
+  /// per skeleton. The rows of the other constraints are filled by unit impulse
+  /// tests.
+  void buildLCPMatrix(ConstrainedGroup* _group, double* _A, size_t _nSkip,
+                      const size_t* _offset);
+
+  /// Return the list of the constraints acting on _skeleton among the ones
+  /// whose Jacobians are used to build the LCP matrix, adding an empty list if
+  /// there is none yet
+  std::vector<size_t>& getJacobianSkeletonConstraints(
+      dynamics::Skeleton* _skeleton);
+
+  /// Return true if the impulse response of _skeleton is its inverse mass
+  /// matrix, which is not the case if any joint is kinematically actuated or
+  /// if it has soft body nodes
+  static bool isImpulseResponseDynamic(dynamics::Skeleton* _skeleton);
 
 protected:
+  /// Alignment of the workspace blocks, which is the size of a cache line
+  static const size_t WORKSPACE_ALIGNMENT = 64;
+
   /// Simulation time step
   double mTimeStep;
+
+private:
+  /// Memory allocated for the workspace, which is not necessarily aligned
+  char* mWorkspaceMemory;
+
+  /// Aligned workspace in mWorkspaceMemory
+  char* mWorkspace;
+
+  /// Size of mWorkspace in bytes
+  size_t mWorkspaceSize;
+
+  /// Jacobians of the constraints used to build the LCP matrix
+  std::vector<ConstraintJacobian> mJacobians;
+
+  /// Whether the Jacobian of each constraint is used to build the LCP matrix
+  std::vector<bool> mIsJacobianUsed;
+
+  /// Skeletons constrained by the constraints whose Jacobians are used, and
+  /// the constraints acting on each of them. Only the first
+  /// mNumJacobianSkeletons entries are in use, and the rest are kept to reuse
+  /// their memory.
+  std::vector<std::pair<dynamics::Skeleton*, std::vector<size_t> > >
+      mJacobianSkeletons;
+
+  /// Number of entries of mJacobianSkeletons in use
+  size_t mNumJacobianSkeletons;
+
+  /// Column offsets of the constraints in the stacked transposed Jacobian
+  std::vector<size_t> mJacobianColumns;
+
+  /// Memory of the stacked transposed Jacobian of a skeleton
+  std::vector<double> mJacobianTransposeMemory;
+
+  /// Memory of the product of the inverse mass matrix and the stacked
+  /// transposed Jacobian of a skeleton
+  std::vector<double> mInvMassJacobianTransposeMemory;
+
+  /// Memory of the J * M^-1 * J^T block of a skeleton
+  std::vector<double> mJacobianBlockMemory;
 };
 
+//==============================================================================
+template <typename T>
+size_t LCPSolver::getWorkspaceBlockSize(size_t _count)
+{
+  return (_count * sizeof(T) + WORKSPACE_ALIGNMENT - 1)
+         / WORKSPACE_ALIGNMENT * WORKSPACE_ALIGNMENT;
+}
+
+//==============================================================================
+template <typename T>
+T* LCPSolver::takeWorkspaceBlock(char** _workspace, size_t _count)
+{
+  T* block = reinterpret_cast<T*>(*_workspace);
+  *_workspace += getWorkspaceBlockSize<T>(_count);
+  return block;
+}
+
 } // namespace constraint
 } // namespace dart
 
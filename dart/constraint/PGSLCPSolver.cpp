@@ -71,13 +71,22 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
   // Build LCP terms by aggregating them from constraints
   size_t n = _group->getTotalDimension();
   int nSkip = dPAD(n);
-  double* A = new double[n * nSkip];
-  double* x = new double[n];
-  double* b = new double[n];
-  double* w = new double[n];
-  double* lo = new double[n];
-  double* hi = new double[n];
-  int* findex = new int[n];
+
+  // Take the LCP terms from the workspace of this solver rather than
+  // allocating them for every group
+  size_t workspaceSize = getWorkspaceBlockSize<double>(n * nSkip)
+                         + 5 * getWorkspaceBlockSize<double>(n)
+                         + getWorkspaceBlockSize<int>(n)
+                         + getWorkspaceBlockSize<size_t>(numConstraints)
+                         + getWorkspaceBlockSize<int>(n);
+  char* workspace = reserveWorkspace(workspaceSize);
+  double* A = takeWorkspaceBlock<double>(&workspace, n * nSkip);
+  double* x = takeWorkspaceBlock<double>(&workspace, n);
+  double* b = takeWorkspaceBlock<double>(&workspace, n);
+  double* w = takeWorkspaceBlock<double>(&workspace, n);
+  double* lo = takeWorkspaceBlock<double>(&workspace, n);
+  double* hi = takeWorkspaceBlock<double>(&workspace, n);
+  int* findex = takeWorkspaceBlock<int>(&workspace, n);
 
   // Set w to 0 and findex to -1
 #ifndef NDEBUG
@@ -87,7 +96,7 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
   std::memset(findex, -1, n * sizeof(int));
 
   // Compute offset indices
-  size_t* offset = new size_t[n];
+  size_t* offset = takeWorkspaceBlock<size_t>(&workspace, numConstraints);
   offset[0] = 0;
   //  std::cout << "offset[" << 0 << "]: " << offset[0] << std::endl;
   for (size_t i = 1; i < numConstraints; ++i)
@@ -116,45 +125,17 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
     // Fill vectors: lo, hi, b, w
     constraint->getInformation(&constInfo);
 
-    // Fill a matrix by impulse tests: A
-    constraint->excite();
+    // Adjust findex for global index
     for (size_t j = 0; j < constraint->getDimension(); ++j)
     {
-      // Adjust findex for global index
       if (findex[offset[i] + j] >= 0)
         findex[offset[i] + j] += offset[i];
-
-      // Apply impulse for mipulse test
-      constraint->applyUnitImpulse(j);
-
-      // Fill upper triangle blocks of A matrix
-      int index = nSkip * (offset[i] + j) + offset[i];
-      constraint->getVelocityChange(A + index, true);
-      for (size_t k = i + 1; k < numConstraints; ++k)
-      {
-        index = nSkip * (offset[i] + j) + offset[k];
-        _group->getConstraint(k)->getVelocityChange(A + index, false);
-      }
-
-      // Filling symmetric part of A matrix
-      for (size_t k = 0; k < i; ++k)
-      {
-        for (size_t l = 0; l < _group->getConstraint(k)->getDimension(); ++l)
-        {
-          int index1 = nSkip * (offset[i] + j) + offset[k] + l;
-          int index2 = nSkip * (offset[k] + l) + offset[i] + j;
-
-          A[index1] = A[index2];
-        }
-      }
     }
-
-    assert(isSymmetric(n, A, offset[i],
-                       offset[i] + constraint->getDimension() - 1));
-
-    constraint->unexcite();
   }
 
+  // Fill a matrix: A
+  buildLCPMatrix(_group, A, nSkip, offset);
+
   assert(isSymmetric(n, A));
 
   // Print LCP formulation
@@ -166,7 +147,8 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
 //  dSolveLCP(n, A, x, b, w, 0, lo, hi, findex);
   PGSOption option;
   option.setDefault();
-  solvePGS(n, nSkip, 0, A, x, b, lo, hi, findex, &option);
+  int* order = takeWorkspaceBlock<int>(&workspace, n);
+  solvePGS(n, nSkip, 0, A, x, b, lo, hi, findex, &option, order);
 
   // Print LCP formulation
   //  dtdbg << "After solve:" << std::endl;
@@ -181,15 +163,6 @@ void PGSLCPSolver::solve(ConstrainedGroup* _group)
     constraint->excite();
   }
 
-  delete[] offset;
-
-  delete[] A;
-  delete[] x;
-  delete[] b;
-  delete[] w;
-  delete[] lo;
-  delete[] hi;
-  delete[] findex;
 }
 
 //==============================================================================
@@ -346,7 +319,8 @@ void PGSLCPSolver::print(size_t _n, double* _A, double* _x,
 #endif
 
 bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
-              double * lo, double * hi, int * findex, PGSOption * option)
+              double * lo, double * hi, int * findex, PGSOption * option,
+              int* order)
 {
   // LDLT solver will work !!!
   //if (nub == n)
@@ -361,7 +335,12 @@ bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
   double one_minus_sor_w = 1.0 - (option->sor_w);
 
   //--- ORDERING & SCALING & INITIAL LOOP & Test
-  int* order = new int[n];
+  int* allocatedOrder = NULL;
+  if (order == NULL)
+  {
+    allocatedOrder = new int[n];
+    order = allocatedOrder;
+  }
 
   n_new = 0;
   sentinel = true;
@@ -419,7 +398,7 @@ bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
   }
   if (sentinel)
   {
-    delete[] order;
+    delete[] allocatedOrder;
     return true;
   }
 
@@ -503,7 +482,7 @@ bool solvePGS(int n, int nskip, int /*nub*/, double * A, double * x, double * b,
     if (sentinel)
       break;
   }
-  delete[] order;
+  delete[] allocatedOrder;
   return sentinel;
 }
 
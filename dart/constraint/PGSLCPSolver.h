@@ -83,10 +83,12 @@ struct PGSOption
   void setDefault();
 };
 
+/// Solve the LCP by projected Gauss-Seidel. order is scratch memory of n
+/// integers, which is allocated internally if it is NULL.
 bool solvePGS(int n, int nskip, int /*nub*/, double* A,
                             double* x, double * b,
                             double * lo, double * hi, int * findex,
-                            PGSOption * option);
+                            PGSOption * option, int* order = NULL);
 
 
 } // namespace constraint
@@ -107,25 +107,49 @@ SoftContactConstraint::SoftContactConstraint(
     mIsBounceOn(false),
     mActive(false)
 {
+  reset(_contact, _timeStep);
+
+  //----------------------------------------------------------------------------
+  // Union finding
+  //----------------------------------------------------------------------------
+//  uniteSkeletons();
+}
+
+//==============================================================================
+SoftContactConstraint::~SoftContactConstraint()
+{
+}
+
+//==============================================================================
+void SoftContactConstraint::reset(collision::Contact& _contact,
+                                  double _timeStep)
+{
+  mTimeStep = _timeStep;
+  mBodyNode1 = _contact.bodyNode1;
+  mBodyNode2 = _contact.bodyNode2;
+  mSoftBodyNode1 = dynamic_cast<dynamics::SoftBodyNode*>(mBodyNode1);
+  mSoftBodyNode2 = dynamic_cast<dynamics::SoftBodyNode*>(mBodyNode2);
+  mPointMass1 = NULL;
+  mPointMass2 = NULL;
+  mSoftCollInfo
+      = static_cast<collision::SoftCollisionInfo*>(_contact.userData);
+  mFirstFrictionalDirection = Eigen::Vector3d::UnitZ();
+  mAppliedImpulseIndex = -1;
+  mActive = false;
+
   // TODO(JS): Assumed single contact
+  mContacts.clear();
   mContacts.push_back(&_contact);
 
-  // Set the colliding state of body nodes and point masses to false
-  if (mSoftBodyNode1)
-  {
-    for (size_t i = 0; i < mSoftBodyNode1->getNumPointMasses(); ++i)
-      mSoftBodyNode1->getPointMass(i)->setColliding(false);
-  }
-  if (mSoftBodyNode2)
-  {
-    for (size_t i = 0; i < mSoftBodyNode2->getNumPointMasses(); ++i)
-      mSoftBodyNode2->getPointMass(i)->setColliding(false);
-  }
+  // The colliding state of the point masses is reset once per time step by
+  // ConstraintSolver rather than once per contact
 
-  // Select colling point mass based on trimesh ID
+  // Select colling point mass based on trimesh ID. Detectors that do not
+  // report the colliding shapes leave them NULL.
   if (mSoftBodyNode1)
   {
-    if (_contact.shape1->getShapeType() == dynamics::Shape::SOFT_MESH)
+    if (_contact.shape1
+        && _contact.shape1->getShapeType() == dynamics::Shape::SOFT_MESH)
     {
       mPointMass1 = selectCollidingPointMass(mSoftBodyNode1, _contact.point,
                                              _contact.triID1);
@@ -133,7 +157,8 @@ SoftContactConstraint::SoftContactConstraint(
   }
   if (mSoftBodyNode2)
   {
-    if (_contact.shape2->getShapeType() == dynamics::Shape::SOFT_MESH)
+    if (_contact.shape2
+        && _contact.shape2->getShapeType() == dynamics::Shape::SOFT_MESH)
     {
       mPointMass2 = selectCollidingPointMass(mSoftBodyNode2, _contact.point,
                                              _contact.triID2);
@@ -197,7 +222,7 @@ SoftContactConstraint::SoftContactConstraint(
       collision::Contact* ct = mContacts[i];
 
       // TODO(JS): Assumed that the number of tangent basis is 2.
-      Eigen::MatrixXd D = getTangentBasisMatrixODE(ct->normal);
+      Eigen::Matrix<double, 3, 2> D = getTangentBasisMatrixODE(ct->normal);
 
       assert(std::fabs(ct->normal.dot(D.col(0))) < DART_EPSILON);
       assert(std::fabs(ct->normal.dot(D.col(1))) < DART_EPSILON);
@@ -304,16 +329,6 @@ SoftContactConstraint::SoftContactConstraint(
       mJacobians2[i].tail<3>().noalias() = bodyDirection2;
     }
   }
-
-  //----------------------------------------------------------------------------
-  // Union finding
-  //----------------------------------------------------------------------------
-//  uniteSkeletons();
-}
-
-//==============================================================================
-SoftContactConstraint::~SoftContactConstraint()
-{
 }
 
 //==============================================================================
@@ -799,7 +814,8 @@ void SoftContactConstraint::applyImpulse(double* _lambda)
       assert(!math::isNan(_lambda[index]));
 
       // Add contact impulse (force) toward the tangential w.r.t. world frame
-      Eigen::MatrixXd D = getTangentBasisMatrixODE(mContacts[i]->normal);
+      Eigen::Matrix<double, 3, 2> D
+          = getTangentBasisMatrixODE(mContacts[i]->normal);
       mContacts[i]->force += D.col(0) * _lambda[index] / mTimeStep;
 
       // Tangential direction-1 impulsive force
@@ -960,14 +976,15 @@ void SoftContactConstraint::updateFirstFrictionalDirection()
 }
 
 //==============================================================================
-Eigen::MatrixXd SoftContactConstraint::getTangentBasisMatrixODE(
+Eigen::Matrix<double, 3, 2>
+SoftContactConstraint::getTangentBasisMatrixODE(
     const Eigen::Vector3d& _n)
 {
   // TODO(JS): Use mNumFrictionConeBases
   // Check if the number of bases is even number.
 //  bool isEvenNumBases = mNumFrictionConeBases % 2 ? true : false;
 
-  Eigen::MatrixXd T(Eigen::MatrixXd::Zero(3, 2));
+  Eigen::Matrix<double, 3, 2> T;
 
   // Pick an arbitrary vector to take the cross product of (in this case,
   // Z-axis)
@@ -1030,6 +1047,15 @@ static PointMassT selectCollidingPointMassT(
 {
   PointMassT pointMass = NULL;
 
+  // Contacts without a triangle of the soft mesh take the nearest point mass
+  // from the grid of the soft body
+  if (_faceId < 0
+      || static_cast<size_t>(_faceId) >= _softBodyNode->getNumFaces())
+  {
+    return _softBodyNode->getPointMass(
+          _softBodyNode->findNearestPointMass(_point));
+  }
+
   const Eigen::Vector3i& face = _softBodyNode->getFace(_faceId);
 
   PointMassT pm0 = _softBodyNode->getPointMass(face[0]);
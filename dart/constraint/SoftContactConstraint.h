@@ -149,6 +149,10 @@ protected:
   virtual bool isActive() const;
 
 private:
+  /// Reinitialize this constraint for _contact so that the constraint object
+  /// can be reused for a new contact
+  void reset(collision::Contact& _contact, double _timeStep);
+
   /// Get change in relative velocity at contact point due to external impulse
   /// \param[out] _vel Change in relative velocity at contact point of the two
   ///                  colliding bodies
@@ -158,10 +162,13 @@ private:
   void updateFirstFrictionalDirection();
 
   ///
-  Eigen::MatrixXd getTangentBasisMatrixODE(const Eigen::Vector3d& _n);
+  Eigen::Matrix<double, 3, 2> getTangentBasisMatrixODE(
+      const Eigen::Vector3d& _n);
 
   /// Find the nearest point mass from _point in a face, of which id is _faceId
-  /// in _softBodyNode.
+  /// in _softBodyNode. If _faceId is not a face of _softBodyNode, the nearest
+  /// point mass of the whole body is found by
+  /// SoftBodyNode::findNearestPointMass().
   dynamics::PointMass* selectCollidingPointMass(
       dynamics::SoftBodyNode* _softBodyNode,
       const Eigen::Vector3d& _point,
@@ -169,7 +176,8 @@ private:
 
   /// Find the nearest point mass from _point in a face, of which id is _faceId
   /// in _softBodyNode. Returns a pointer to a const, and is usable with a const
-  /// SoftBodyNode.
+  /// SoftBodyNode. If _faceId is not a face of _softBodyNode, the nearest
+  /// point mass of the whole body is found.
   const dynamics::PointMass* selectCollidingPointMass(
       const dynamics::SoftBodyNode* _softBodyNode,
       const Eigen::Vector3d& _point,
@@ -115,6 +115,7 @@ BodyNode::BodyNode(const std::string& _name)
     mFext_F(Eigen::Vector6d::Zero()),
     mM_dV(Eigen::Vector6d::Zero()),
     mM_F(Eigen::Vector6d::Zero()),
+    mCompositeInertia(Eigen::Matrix6d::Identity()),
     mInvM_c(Eigen::Vector6d::Zero()),
     mInvM_U(Eigen::Vector6d::Zero()),
     mArbitrarySpatial(Eigen::Vector6d::Zero()),
@@ -2024,6 +2025,68 @@ void BodyNode::aggregateAugMassMatrix(Eigen::MatrixXd* _MCol, size_t _col,
   }
 }
 
+//==============================================================================
+void BodyNode::updateCompositeInertia()
+{
+  mCompositeInertia = mI;
+
+  for (const auto& child : mChildBodyNodes)
+  {
+    mCompositeInertia += math::transformInertia(
+          child->mParentJoint->getLocalTransform().inverse(),
+          child->mCompositeInertia);
+  }
+
+  assert(!math::isNan(mCompositeInertia));
+
+  // The local Jacobian is copied into memory that is kept between the updates
+  // because getLocalJacobian() returns a dynamic size copy
+  mCompositeJacobian.resize(6, mParentJoint->getNumDofs());
+  mParentJoint->setLocalJacobianTo(mCompositeJacobian, 0);
+}
+
+//==============================================================================
+void BodyNode::aggregateCompositeMassMatrix(Eigen::MatrixXd* _M)
+{
+  const size_t dof = mParentJoint->getNumDofs();
+  if (dof == 0)
+    return;
+
+  const size_t iStart = mParentJoint->getIndexInSkeleton(0);
+  const math::Jacobian& S = mCompositeJacobian;
+
+  // Diagonal block
+  mCompositeForces.noalias() = mCompositeInertia * S;
+  _M->block(iStart, iStart, dof, dof).noalias()
+      = S.transpose() * mCompositeForces;
+
+  // Off-diagonal blocks are nonzero only for the ancestors of this body, so we
+  // walk up to the root transforming the spatial forces to each ancestor frame.
+  const BodyNode* child = this;
+  const BodyNode* ancestor = mParentBodyNode;
+  while (ancestor)
+  {
+    const Eigen::Isometry3d& T = child->mParentJoint->getLocalTransform();
+    for (size_t i = 0; i < dof; ++i)
+      mCompositeForces.col(i) = math::dAdInvT(T, mCompositeForces.col(i));
+
+    const size_t ancestorDof = ancestor->mParentJoint->getNumDofs();
+    if (ancestorDof > 0)
+    {
+      const size_t jStart = ancestor->mParentJoint->getIndexInSkeleton(0);
+      _M->block(jStart, iStart, ancestorDof, dof).noalias()
+          = ancestor->mCompositeJacobian.transpose() * mCompositeForces;
+      _M->block(iStart, jStart, dof, ancestorDof)
+          = _M->block(jStart, iStart, ancestorDof, dof).transpose();
+    }
+
+    child = ancestor;
+    ancestor = ancestor->mParentBodyNode;
+  }
+
+  assert(!math::isNan(mCompositeForces));
+}
+
 //==============================================================================
 void BodyNode::updateInvMassMatrix()
 {
@@ -2153,13 +2216,14 @@ void BodyNode::_updateBodyJacobian() const
            == static_cast<size_t>(mBodyJacobian.cols()));
 
     assert(mParentJoint);
-    mBodyJacobian.leftCols(ascendantDof) =
-        math::AdInvTJac(mParentJoint->getLocalTransform(),
-                        mParentBodyNode->getJacobian());
+    const Eigen::Isometry3d& T = mParentJoint->getLocalTransform();
+    const math::Jacobian& parentJacobian = mParentBodyNode->getJacobian();
+    for (size_t i = 0; i < ascendantDof; ++i)
+      mBodyJacobian.col(i) = math::AdInvT(T, parentJacobian.col(i));
   }
 
   // Local Jacobian
-  mBodyJacobian.rightCols(localDof) = mParentJoint->getLocalJacobian();
+  mParentJoint->setLocalJacobianTo(mBodyJacobian, ascendantDof);
 
   mIsBodyJacobianDirty = false;
 }
@@ -986,6 +986,18 @@ protected:
   virtual void aggregateAugMassMatrix(Eigen::MatrixXd* _MCol, size_t _col,
                                       double _timeStep);
 
+  /// Update the composite rigid body inertia of this body and the local
+  /// Jacobian of its parent joint. The composite inertias of the child bodies
+  /// should be updated before calling this.
+  virtual void updateCompositeInertia();
+
+  /// Fill the blocks of the mass matrix that couple the parent joint of this
+  /// body with the parent joints of this body and all its ancestors using the
+  /// composite rigid body algorithm. Blocks that couple joints that are not on
+  /// the same path to the root are zero and left untouched. The composite
+  /// inertias of all the bodies should be updated before calling this.
+  virtual void aggregateCompositeMassMatrix(Eigen::MatrixXd* _M);
+
   ///
   virtual void updateInvMassMatrix();
   virtual void updateInvAugMassMatrix();
@@ -1168,6 +1180,19 @@ protected:
   Eigen::Vector6d mM_dV;
   Eigen::Vector6d mM_F;
 
+  /// Composite rigid body inertia of this body and all its descendants
+  /// expressed in this body frame
+  math::Inertia mCompositeInertia;
+
+  /// Cache data for composite rigid body algorithm. Spatial forces in the
+  /// frame of the current ancestor body that are caused by unit accelerations
+  /// of the parent joint of this body.
+  math::Jacobian mCompositeForces;
+
+  /// Cache data for composite rigid body algorithm. Local Jacobian of the
+  /// parent joint of this body.
+  math::Jacobian mCompositeJacobian;
+
   /// Cache data for inverse mass matrix of the system.
   Eigen::Vector6d mInvM_c;
   Eigen::Vector6d mInvM_U;
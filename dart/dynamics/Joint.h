@@ -486,6 +486,10 @@ public:
   /// w.r.t. local generalized coordinate
   virtual const math::Jacobian getLocalJacobian() const = 0;
 
+  /// Set the local Jacobian to the columns of _J starting at _col. Unlike
+  /// getLocalJacobian(), this doesn't create a dynamic size copy.
+  virtual void setLocalJacobianTo(math::Jacobian& _J, size_t _col) const = 0;
+
   /// Get time derivative of generalized Jacobian from parent body node
   /// to child body node w.r.t. local generalized coordinate
   virtual const math::Jacobian getLocalJacobianTimeDeriv() const = 0;
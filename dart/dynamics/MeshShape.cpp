@@ -37,8 +37,14 @@
 
 #include "dart/dynamics/MeshShape.h"
 
+#include <sys/stat.h>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <string>
 
 #include <assimp/Importer.hpp>
@@ -51,6 +57,62 @@
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+/// Scene of a mesh file loaded by MeshShape::loadMesh()
+struct MeshCacheEntry
+{
+  /// Imported scene
+  const aiScene* scene;
+
+  /// Modification time of the file when it was imported
+  time_t modificationTime;
+};
+
+/// Mutex that guards the mesh cache
+std::mutex gMeshCacheMutex;
+
+/// Scenes of the mesh files by canonical path
+std::map<std::string, MeshCacheEntry> gMeshCache;
+
+/// Number of MeshShapes using each scene loaded by MeshShape::loadMesh(),
+/// including the scenes of files that changed since they were loaded
+std::map<const aiScene*, size_t> gMeshReferences;
+
+/// Number of loadMesh() calls that returned a cached scene
+size_t gNumMeshCacheHits = 0;
+
+/// Number of loadMesh() calls that imported the file
+size_t gNumMeshCacheMisses = 0;
+
+/// Return the canonical path of _fileName, or _fileName if it cannot be
+/// resolved
+std::string getCanonicalPath(const std::string& _fileName)
+{
+#ifdef _WIN32
+  char path[_MAX_PATH];
+  if (_fullpath(path, _fileName.c_str(), _MAX_PATH))
+    return path;
+#else
+  char path[PATH_MAX];
+  if (realpath(_fileName.c_str(), path))
+    return path;
+#endif
+  return _fileName;
+}
+
+/// Return the modification time of _fileName, or 0 if it cannot be read
+time_t getModificationTime(const std::string& _fileName)
+{
+  struct stat status;
+  if (stat(_fileName.c_str(), &status) != 0)
+    return 0;
+
+  return status.st_mtime;
+}
+
+}  // anonymous namespace
+
 MeshShape::MeshShape(const Eigen::Vector3d& _scale, const aiScene* _mesh)
   : Shape(MESH),
     mMesh(_mesh),
@@ -60,12 +122,14 @@ MeshShape::MeshShape(const Eigen::Vector3d& _scale, const aiScene* _mesh)
   assert(_scale[0] > 0.0);
   assert(_scale[1] > 0.0);
   assert(_scale[2] > 0.0);
+  retainMesh(mMesh);
   _updateBoundingBoxDim();
   computeVolume();
   initMeshes();
 }
 
 MeshShape::~MeshShape() {
+  releaseMesh(mMesh);
 }
 
 const aiScene* MeshShape::getMesh() const {
@@ -74,6 +138,8 @@ const aiScene* MeshShape::getMesh() const {
 
 void MeshShape::setMesh(const aiScene* _mesh) {
   assert(_mesh);
+  retainMesh(_mesh);
+  releaseMesh(mMesh);
   mMesh = _mesh;
   _updateBoundingBoxDim();
   computeVolume();
@@ -169,6 +235,113 @@ void MeshShape::_updateBoundingBoxDim() {
 }
 
 const aiScene* MeshShape::loadMesh(const std::string& _fileName) {
+  std::string path = getCanonicalPath(_fileName);
+  time_t modificationTime = getModificationTime(path);
+
+  // Import the file while holding the lock so that concurrent loads of the
+  // same file wait for a single import
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+
+  std::map<std::string, MeshCacheEntry>::iterator it = gMeshCache.find(path);
+  if (it != gMeshCache.end()) {
+    if (it->second.modificationTime == modificationTime) {
+      ++gNumMeshCacheHits;
+      return it->second.scene;
+    }
+
+    // The file changed since it was imported. The old scene is released now
+    // if no MeshShape uses it, or otherwise with the last MeshShape using it.
+    const aiScene* oldScene = it->second.scene;
+    gMeshCache.erase(it);
+    if (gMeshReferences[oldScene] == 0) {
+      gMeshReferences.erase(oldScene);
+      aiReleaseImport(oldScene);
+    }
+  }
+
+  ++gNumMeshCacheMisses;
+  const aiScene* scene = importMesh(_fileName);
+  if (!scene)
+    return NULL;
+
+  MeshCacheEntry entry;
+  entry.scene = scene;
+  entry.modificationTime = modificationTime;
+  gMeshCache[path] = entry;
+  gMeshReferences[scene] = 0;
+
+  return scene;
+}
+
+void MeshShape::releaseUnusedMeshes() {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+
+  std::map<std::string, MeshCacheEntry>::iterator it = gMeshCache.begin();
+  while (it != gMeshCache.end()) {
+    const aiScene* scene = it->second.scene;
+    if (gMeshReferences[scene] == 0) {
+      gMeshReferences.erase(scene);
+      aiReleaseImport(scene);
+      gMeshCache.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t MeshShape::getNumMeshCacheHits() {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+  return gNumMeshCacheHits;
+}
+
+size_t MeshShape::getNumMeshCacheMisses() {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+  return gNumMeshCacheMisses;
+}
+
+std::string MeshShape::getMeshPath(const aiScene* _mesh) {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+
+  std::map<std::string, MeshCacheEntry>::const_iterator it;
+  for (it = gMeshCache.begin(); it != gMeshCache.end(); ++it) {
+    if (it->second.scene == _mesh)
+      return it->first;
+  }
+
+  return std::string();
+}
+
+void MeshShape::retainMesh(const aiScene* _mesh) {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+
+  std::map<const aiScene*, size_t>::iterator it = gMeshReferences.find(_mesh);
+  if (it != gMeshReferences.end())
+    ++it->second;
+}
+
+void MeshShape::releaseMesh(const aiScene* _mesh) {
+  std::lock_guard<std::mutex> lock(gMeshCacheMutex);
+
+  std::map<const aiScene*, size_t>::iterator it = gMeshReferences.find(_mesh);
+  if (it == gMeshReferences.end() || it->second == 0)
+    return;
+
+  --it->second;
+  if (it->second > 0)
+    return;
+
+  // Scenes that are still cached are kept for the next loadMesh() call
+  std::map<std::string, MeshCacheEntry>::const_iterator itCache;
+  for (itCache = gMeshCache.begin(); itCache != gMeshCache.end(); ++itCache) {
+    if (itCache->second.scene == _mesh)
+      return;
+  }
+
+  gMeshReferences.erase(it);
+  aiReleaseImport(_mesh);
+}
+
+const aiScene* MeshShape::importMesh(const std::string& _fileName) {
   aiPropertyStore* propertyStore = aiCreatePropertyStore();
   // remove points and lines
   aiSetImportPropertyInteger(propertyStore,
@@ -182,10 +355,12 @@ const aiScene* MeshShape::loadMesh(const std::string& _fileName) {
                                    aiProcess_SortByPType            |
                                    aiProcess_OptimizeMeshes,
                                    NULL, propertyStore);
-  if(!scene)
+  aiReleasePropertyStore(propertyStore);
+  if(!scene) {
     dtwarn << "[MeshShape] Assimp could not load file: '" << _fileName << "'. "
            << "This will likely result in a segmentation fault." << std::endl;
-  aiReleasePropertyStore(propertyStore);
+    return NULL;
+  }
 
   // Assimp rotates collada files such that the up-axis (specified in the
   // collada file) aligns with assimp's y-axis. Here we are reverting this
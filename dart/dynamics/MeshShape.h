@@ -79,9 +79,29 @@ public:
             const Eigen::Vector4d& _col = Eigen::Vector4d::Ones(),
             bool _default = true) const;
 
-  /// \brief
+  /// \brief Load the mesh of _fileName. Meshes are cached by their canonical
+  /// path and modification time, so loading a file again returns the same
+  /// scene as long as the file has not changed. Cached scenes are kept while
+  /// any MeshShape uses them, and unused ones are kept until
+  /// releaseUnusedMeshes() is called. This function is thread-safe.
   static const aiScene* loadMesh(const std::string& _fileName);
 
+  /// \brief Release the cached scenes that no MeshShape uses. The scenes
+  /// returned by loadMesh() must not be used after this call unless a
+  /// MeshShape holds them.
+  static void releaseUnusedMeshes();
+
+  /// \brief Return the number of loadMesh() calls that returned a cached
+  /// scene
+  static size_t getNumMeshCacheHits();
+
+  /// \brief Return the number of loadMesh() calls that imported the file
+  static size_t getNumMeshCacheMisses();
+
+  /// \brief Return the canonical path of the file that _mesh was loaded from
+  /// by loadMesh(), or an empty string if _mesh is not a cached scene
+  static std::string getMeshPath(const aiScene* _mesh);
+
   // Documentation inherited.
   virtual Eigen::Matrix3d computeInertia(double _mass) const;
 
@@ -93,6 +113,16 @@ private:
   /// \brief
   void _updateBoundingBoxDim();
 
+  /// \brief Import the mesh of _fileName with Assimp
+  static const aiScene* importMesh(const std::string& _fileName);
+
+  /// \brief Add a reference to _mesh if it was loaded by loadMesh()
+  static void retainMesh(const aiScene* _mesh);
+
+  /// \brief Remove a reference to _mesh if it was loaded by loadMesh(), and
+  /// release it if it is no longer cached and used
+  static void releaseMesh(const aiScene* _mesh);
+
   /// \brief
   const aiScene* mMesh;
 
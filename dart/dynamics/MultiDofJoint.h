@@ -341,6 +341,9 @@ protected:
   // Documentation inherited
   const math::Jacobian getLocalJacobian() const override;
 
+  // Documentation inherited
+  void setLocalJacobianTo(math::Jacobian& _J, size_t _col) const override;
+
   /// Fixed-size version of getLocalJacobian()
   const Eigen::Matrix<double, 6, DOF>& getLocalJacobianStatic() const;
 
@@ -1665,6 +1668,14 @@ const math::Jacobian MultiDofJoint<DOF>::getLocalJacobian() const
   return mJacobian;
 }
 
+//==============================================================================
+template <size_t DOF>
+void MultiDofJoint<DOF>::setLocalJacobianTo(math::Jacobian& _J,
+                                            size_t _col) const
+{
+  _J.template block<6, DOF>(0, _col) = getLocalJacobianStatic();
+}
+
 //==============================================================================
 template <size_t DOF>
 const Eigen::Matrix<double, 6, DOF>&
@@ -921,6 +921,12 @@ const math::Jacobian SingleDofJoint::getLocalJacobian() const
   return mJacobian;
 }
 
+//==============================================================================
+void SingleDofJoint::setLocalJacobianTo(math::Jacobian& _J, size_t _col) const
+{
+  _J.col(_col) = getLocalJacobianStatic();
+}
+
 //==============================================================================
 const Eigen::Vector6d& SingleDofJoint::getLocalJacobianStatic() const
 {
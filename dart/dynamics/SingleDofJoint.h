@@ -345,6 +345,9 @@ protected:
   // Documentation inherited
   const math::Jacobian getLocalJacobian() const override;
 
+  // Documentation inherited
+  void setLocalJacobianTo(math::Jacobian& _J, size_t _col) const override;
+
   /// Fixed-size version of getLocalJacobian()
   const Eigen::Vector6d& getLocalJacobianStatic() const;
 
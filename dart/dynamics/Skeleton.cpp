@@ -73,6 +73,7 @@ Skeleton::Skeleton(const std::string& _name)
     mIsAugMassMatrixDirty(true),
     mIsInvMassMatrixDirty(true),
     mIsInvAugMassMatrixDirty(true),
+    mIsMassMatrixLTDLDirty(true),
     mIsCoriolisForcesDirty(true),
     mIsGravityForcesDirty(true),
     mIsCoriolisAndGravityForcesDirty(true),
@@ -478,6 +479,18 @@ void Skeleton::init(double _timeStep, const Eigen::Vector3d& _gravity)
     mNumDofs += joint->getNumDofs();
   }
 
+  // The parent of a generalized coordinate is the one right before it in the
+  // list of generalized coordinates that its child body depends on
+  mDofParentIndices.resize(mNumDofs);
+  for (size_t i = 0; i < numBodyNodes; ++i)
+  {
+    const std::vector<size_t>& indices
+        = mBodyNodes[i]->getDependentGenCoordIndices();
+    const size_t numDofsOfJoint = mBodyNodes[i]->getParentJoint()->getNumDofs();
+    for (size_t j = indices.size() - numDofsOfJoint; j < indices.size(); ++j)
+      mDofParentIndices[indices[j]] = (j == 0) ? -1 : indices[j - 1];
+  }
+
   // Compute transformations, velocities, and partial accelerations
 //  computeForwardDynamicsRecursionPartA(); // No longer needed with auto-update
 
@@ -487,6 +500,7 @@ void Skeleton::init(double _timeStep, const Eigen::Vector3d& _gravity)
   mAugM = Eigen::MatrixXd::Zero(dof, dof);
   mInvM = Eigen::MatrixXd::Zero(dof, dof);
   mInvAugM = Eigen::MatrixXd::Zero(dof, dof);
+  mMassMatrixLTDL = Eigen::MatrixXd::Zero(dof, dof);
   mCvec = Eigen::VectorXd::Zero(dof);
   mG    = Eigen::VectorXd::Zero(dof);
   mCg   = Eigen::VectorXd::Zero(dof);
@@ -1228,6 +1242,131 @@ const Eigen::MatrixXd& Skeleton::getInvAugMassMatrix()
   return mInvAugM;
 }
 
+//==============================================================================
+Eigen::MatrixXd Skeleton::multiplyInvMassMatrix(const Eigen::MatrixXd& _x)
+{
+  const size_t dof = getNumDofs();
+  assert(static_cast<size_t>(_x.rows()) == dof);
+
+  Eigen::MatrixXd result(dof, _x.cols());
+  if (dof == 0)
+    return result;
+
+  // Leaf bodies never query the articulated inertia of a child, so make sure
+  // the projected inertias of their joints are up to date before the sweep
+  if (mIsArticulatedInertiaDirty)
+    updateArticulatedInertia();
+
+  // Backup the origianl internal force
+  Eigen::VectorXd originalInternalForce = getForces();
+
+  for (int j = 0; j < _x.cols(); ++j)
+  {
+    setForces(_x.col(j));
+
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->updateInvMassMatrix();
+    }
+
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->aggregateInvMassMatrix(&result, j);
+    }
+  }
+
+  // Restore the origianl internal force
+  setForces(originalInternalForce);
+
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXd Skeleton::multiplyInvAugMassMatrix(const Eigen::MatrixXd& _x)
+{
+  const size_t dof = getNumDofs();
+  assert(static_cast<size_t>(_x.rows()) == dof);
+
+  Eigen::MatrixXd result(dof, _x.cols());
+  if (dof == 0)
+    return result;
+
+  // Leaf bodies never query the articulated inertia of a child, so make sure
+  // the projected inertias of their joints are up to date before the sweep
+  if (mIsArticulatedInertiaDirty)
+    updateArticulatedInertia();
+
+  // Backup the origianl internal force
+  Eigen::VectorXd originalInternalForce = getForces();
+
+  for (int j = 0; j < _x.cols(); ++j)
+  {
+    setForces(_x.col(j));
+
+    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+         it != mBodyNodes.rend(); ++it)
+    {
+      (*it)->updateInvAugMassMatrix();
+    }
+
+    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
+         it != mBodyNodes.end(); ++it)
+    {
+      (*it)->aggregateInvAugMassMatrix(&result, j, mTimeStep);
+    }
+  }
+
+  // Restore the origianl internal force
+  setForces(originalInternalForce);
+
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXd Skeleton::solveMassMatrix(const Eigen::MatrixXd& _b)
+{
+  Eigen::MatrixXd x = _b;
+  solveMassMatrixInPlace(Eigen::Map<Eigen::MatrixXd>(x.data(), x.rows(),
+                                                     x.cols()));
+
+  return x;
+}
+
+//==============================================================================
+void Skeleton::solveMassMatrixInPlace(Eigen::Map<Eigen::MatrixXd> _x)
+{
+  assert(static_cast<size_t>(_x.rows()) == getNumDofs());
+
+  if (mIsMassMatrixDirty)
+    updateMassMatrix();
+
+  if (mIsMassMatrixLTDLDirty)
+    updateMassMatrixLTDL();
+
+  const Eigen::MatrixXd& H = mMassMatrixLTDL;
+  const int dof = static_cast<int>(getNumDofs());
+
+  // Solve L^T * y = b
+  for (int i = dof - 1; i >= 0; --i)
+  {
+    for (int j = mDofParentIndices[i]; j >= 0; j = mDofParentIndices[j])
+      _x.row(j) -= H(i, j) * _x.row(i);
+  }
+
+  // Solve D * z = y
+  for (int i = 0; i < dof; ++i)
+    _x.row(i) /= H(i, i);
+
+  // Solve L * x = z
+  for (int i = 0; i < dof; ++i)
+  {
+    for (int j = mDofParentIndices[i]; j >= 0; j = mDofParentIndices[j])
+      _x.row(i) -= H(i, j) * _x.row(j);
+  }
+}
+
 //==============================================================================
 const Eigen::VectorXd& Skeleton::getCoriolisForces()
 {
@@ -1384,9 +1523,8 @@ void Skeleton::unregisterJoint(Joint* _oldJoint)
 //==============================================================================
 void Skeleton::notifyArticulatedInertiaUpdate()
 {
-  if(mIsArticulatedInertiaDirty)
-    return;
-
+  // Note that we can't return early when the articulated inertia is already
+  // dirty because the other quantities below can be updated independently.
   mIsArticulatedInertiaDirty = true;
   mIsMassMatrixDirty = true;
   mIsAugMassMatrixDirty = true;
@@ -1418,48 +1556,23 @@ void Skeleton::updateMassMatrix()
   assert(static_cast<size_t>(mM.cols()) == getNumDofs()
          && static_cast<size_t>(mM.rows()) == getNumDofs());
 
+  // Composite rigid body algorithm: a backward pass accumulates the composite
+  // inertias, and then only the blocks of the joints on the same path to the
+  // root are filled. The others are zero due to the branches of the tree.
   mM.setZero();
-
-  // Backup the origianl internal force
-  Eigen::VectorXd originalGenAcceleration = getAccelerations();
-
-  size_t dof = getNumDofs();
-  Eigen::VectorXd e = Eigen::VectorXd::Zero(dof);
-  for (size_t j = 0; j < dof; ++j)
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
   {
-    e[j] = 1.0;
-    setAccelerations(e);
-
-    // Prepare cache data
-    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
-         it != mBodyNodes.end(); ++it)
-    {
-      (*it)->updateMassMatrix();
-    }
-
-    // Mass matrix
-    for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
-         it != mBodyNodes.rend(); ++it)
-    {
-      (*it)->aggregateMassMatrix(&mM, j);
-      size_t localDof = (*it)->mParentJoint->getNumDofs();
-      if (localDof > 0)
-      {
-        size_t iStart = (*it)->mParentJoint->getIndexInSkeleton(0);
-
-        if (iStart + localDof < j)
-          break;
-      }
-    }
-
-    e[j] = 0.0;
+    (*it)->updateCompositeInertia();
+  }
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
+  {
+    (*it)->aggregateCompositeMassMatrix(&mM);
   }
-  mM.triangularView<Eigen::StrictlyUpper>() = mM.transpose();
-
-  // Restore the origianl generalized accelerations
-  setAccelerations(originalGenAcceleration);
 
   mIsMassMatrixDirty = false;
+  mIsMassMatrixLTDLDirty = true;
 }
 
 //==============================================================================
@@ -1471,47 +1584,28 @@ void Skeleton::updateAugMassMatrix()
   assert(static_cast<size_t>(mAugM.cols()) == getNumDofs()
          && static_cast<size_t>(mAugM.rows()) == getNumDofs());
 
+  // Composite rigid body algorithm. See updateMassMatrix().
   mAugM.setZero();
-
-  // Backup the origianl internal force
-  Eigen::VectorXd originalGenAcceleration = getAccelerations();
-
-  int dof = getNumDofs();
-  Eigen::VectorXd e = Eigen::VectorXd::Zero(dof);
-  for (int j = 0; j < dof; ++j)
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
   {
-    e[j] = 1.0;
-    setAccelerations(e);
-
-    // Prepare cache data
-    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
-         it != mBodyNodes.end(); ++it)
-    {
-      (*it)->updateMassMatrix();
-    }
-
-    // Mass matrix
-    //    for (std::vector<BodyNode*>::iterator it = mBodyNodes.begin();
-    //         it != mBodyNodes.end(); ++it)
-    for (int i = mBodyNodes.size() - 1; i > -1 ; --i)
-    {
-      mBodyNodes[i]->aggregateAugMassMatrix(&mAugM, j, mTimeStep);
-      int localDof = mBodyNodes[i]->mParentJoint->getNumDofs();
-      if (localDof > 0)
-      {
-        int iStart =
-            mBodyNodes[i]->mParentJoint->getIndexInSkeleton(0);
-        if (iStart + localDof < j)
-          break;
-      }
-    }
-
-    e[j] = 0.0;
+    (*it)->updateCompositeInertia();
+  }
+  for (std::vector<BodyNode*>::reverse_iterator it = mBodyNodes.rbegin();
+       it != mBodyNodes.rend(); ++it)
+  {
+    (*it)->aggregateCompositeMassMatrix(&mAugM);
   }
-  mAugM.triangularView<Eigen::StrictlyUpper>() = mAugM.transpose();
 
-  // Restore the origianl internal force
-  setAccelerations(originalGenAcceleration);
+  // Add the implicit joint damping and spring terms to the diagonal
+  const size_t dof = getNumDofs();
+  for (size_t i = 0; i < dof; ++i)
+  {
+    const Joint* joint = mDofs[i]->getJoint();
+    const size_t index = mDofs[i]->getIndexInJoint();
+    mAugM(i, i) += mTimeStep * joint->getDampingCoefficient(index)
+                   + mTimeStep * mTimeStep * joint->getSpringStiffness(index);
+  }
 
   mIsAugMassMatrixDirty = false;
 }
@@ -1630,6 +1724,33 @@ void Skeleton::updateInvAugMassMatrix()
   mIsInvAugMassMatrixDirty = false;
 }
 
+//==============================================================================
+void Skeleton::updateMassMatrixLTDL()
+{
+  // LTDL factorization of Featherstone, "Efficient Factorization of the
+  // Joint-Space Inertia Matrix for Branched Kinematic Trees". Only the entries
+  // of the generalized coordinates on the same path to the root are nonzero, so
+  // the factorization visits only the ancestors of each coordinate.
+  mMassMatrixLTDL = getMassMatrix();
+  Eigen::MatrixXd& H = mMassMatrixLTDL;
+
+  const int dof = static_cast<int>(getNumDofs());
+  for (int k = dof - 1; k >= 0; --k)
+  {
+    for (int i = mDofParentIndices[k]; i >= 0; i = mDofParentIndices[i])
+    {
+      const double a = H(k, i) / H(k, k);
+
+      for (int j = i; j >= 0; j = mDofParentIndices[j])
+        H(i, j) -= a * H(k, j);
+
+      H(k, i) = a;
+    }
+  }
+
+  mIsMassMatrixLTDLDirty = false;
+}
+
 //==============================================================================
 void Skeleton::updateCoriolisForceVector()
 {
@@ -535,6 +535,25 @@ public:
   /// Get inverse of augmented mass matrix of the skeleton.
   const Eigen::MatrixXd& getInvAugMassMatrix();
 
+  /// Return the product of the inverse of the mass matrix and _x, which can be
+  /// a vector or a thin matrix. Each column is computed by the articulated body
+  /// algorithm in O(n) without forming the inverse of the mass matrix.
+  Eigen::MatrixXd multiplyInvMassMatrix(const Eigen::MatrixXd& _x);
+
+  /// Return the product of the inverse of the augmented mass matrix and _x.
+  /// See multiplyInvMassMatrix().
+  Eigen::MatrixXd multiplyInvAugMassMatrix(const Eigen::MatrixXd& _x);
+
+  /// Return the solution of M * x = _b where M is the mass matrix. M is
+  /// factorized into L^T * D * L exploiting the sparsity of the tree, and the
+  /// factorization is reused for all the following solves until the mass
+  /// matrix changes.
+  Eigen::MatrixXd solveMassMatrix(const Eigen::MatrixXd& _b);
+
+  /// Overwrite _x, which holds the right hand side b, with the solution of
+  /// M * x = b without allocating memory. See solveMassMatrix().
+  void solveMassMatrixInPlace(Eigen::Map<Eigen::MatrixXd> _x);
+
   /// Get Coriolis force vector of the skeleton.
   /// \remarks Please use getCoriolisForces() instead.
   DEPRECATED(4.2)
@@ -746,6 +765,9 @@ protected:
   /// Update inverse of augmented mass matrix of the skeleton.
   void updateInvAugMassMatrix();
 
+  /// Update LTDL factorization of the mass matrix of the skeleton.
+  void updateMassMatrixLTDL();
+
   /// Update Coriolis force vector of the skeleton.
   /// \remarks Please use updateCoriolisForces() instead.
   DEPRECATED(4.2)
@@ -887,6 +909,17 @@ protected:
   /// Dirty flag for the inverse of augmented mass matrix.
   bool mIsInvAugMassMatrixDirty;
 
+  /// LTDL factorization of the mass matrix. The diagonal holds D and the
+  /// strictly lower triangular part holds L, whose diagonal is all ones.
+  Eigen::MatrixXd mMassMatrixLTDL;
+
+  /// Dirty flag for the LTDL factorization of the mass matrix.
+  bool mIsMassMatrixLTDLDirty;
+
+  /// Index of the parent generalized coordinate of each generalized coordinate
+  /// in the tree, or -1 if there is no parent.
+  std::vector<int> mDofParentIndices;
+
   /// Coriolis vector for the skeleton which is C(q,dq)*dq.
   Eigen::VectorXd mCvec;
 
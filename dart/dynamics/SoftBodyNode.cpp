@@ -36,6 +36,9 @@
 
 #include "dart/dynamics/SoftBodyNode.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
@@ -247,11 +250,160 @@ const Eigen::Vector3i& SoftBodyNode::getFace(size_t _idx) const
 }
 
 //==============================================================================
-size_t SoftBodyNode::getNumFaces()
+size_t SoftBodyNode::getNumFaces() const
 {
   return mFaces.size();
 }
 
+//==============================================================================
+void SoftBodyNode::updatePointMassIndex()
+{
+  const size_t numPointMasses = mPointMasses.size();
+  mPointMassGridOffsets.clear();
+  mPointMassGridIndices.clear();
+  if (numPointMasses == 0)
+    return;
+
+  Eigen::Vector3d min = mPointMasses[0]->getLocalPosition();
+  Eigen::Vector3d max = min;
+  for (size_t i = 1; i < numPointMasses; ++i)
+  {
+    min = min.cwiseMin(mPointMasses[i]->getLocalPosition());
+    max = max.cwiseMax(mPointMasses[i]->getLocalPosition());
+  }
+
+  // About one point mass per cell on a cubic grid. A soft body's point masses
+  // lie on its surface, so most cells are empty but the cells stay small.
+  const int resolution = std::max(
+        1, static_cast<int>(std::ceil(std::cbrt(
+                                        static_cast<double>(numPointMasses)))));
+  const double minCellSize = std::max((max - min).maxCoeff(), 1e-9)
+                             / resolution;
+  mPointMassGridMin = min;
+  for (int i = 0; i < 3; ++i)
+  {
+    mPointMassGridSize[i] = resolution;
+    mPointMassGridCellSize[i]
+        = std::max((max[i] - min[i]) / resolution, minCellSize);
+  }
+
+  // Counting sort of the point masses by their cells
+  const size_t numCells = static_cast<size_t>(resolution)
+                          * resolution * resolution;
+  mPointMassGridCells.resize(numPointMasses);
+  mPointMassGridOffsets.assign(numCells + 1, 0);
+  for (size_t i = 0; i < numPointMasses; ++i)
+  {
+    Eigen::Vector3d cell = (mPointMasses[i]->getLocalPosition() - min).array()
+                           / mPointMassGridCellSize.array();
+    size_t index = 0;
+    for (int j = 2; j >= 0; --j)
+    {
+      const int coordinate = std::min(std::max(static_cast<int>(cell[j]), 0),
+                                      resolution - 1);
+      index = index * resolution + coordinate;
+    }
+    mPointMassGridCells[i] = index;
+    ++mPointMassGridOffsets[index + 1];
+  }
+  for (size_t i = 0; i < numCells; ++i)
+    mPointMassGridOffsets[i + 1] += mPointMassGridOffsets[i];
+
+  mPointMassGridNext.assign(mPointMassGridOffsets.begin(),
+                            mPointMassGridOffsets.end() - 1);
+  mPointMassGridIndices.resize(numPointMasses);
+  for (size_t i = 0; i < numPointMasses; ++i)
+    mPointMassGridIndices[mPointMassGridNext[mPointMassGridCells[i]]++] = i;
+}
+
+//==============================================================================
+size_t SoftBodyNode::findNearestPointMass(const Eigen::Vector3d& _point) const
+{
+  assert(!mPointMasses.empty());
+
+  const Eigen::Vector3d point = getTransform().inverse() * _point;
+  size_t nearest = 0;
+  double minDistance2 = std::numeric_limits<double>::infinity();
+
+  if (mPointMassGridIndices.size() != mPointMasses.size())
+  {
+    for (size_t i = 0; i < mPointMasses.size(); ++i)
+    {
+      const double distance2
+          = (mPointMasses[i]->getLocalPosition() - point).squaredNorm();
+      if (distance2 < minDistance2)
+      {
+        minDistance2 = distance2;
+        nearest = i;
+      }
+    }
+
+    return nearest;
+  }
+
+  Eigen::Vector3i center;
+  for (int i = 0; i < 3; ++i)
+  {
+    const int coordinate = static_cast<int>(std::floor(
+        (point[i] - mPointMassGridMin[i]) / mPointMassGridCellSize[i]));
+    center[i] = std::min(std::max(coordinate, 0), mPointMassGridSize[i] - 1);
+  }
+
+  // Visit the shells of cells around the cell of the point until the shell is
+  // farther than the nearest point mass found so far. The cells of shell r are
+  // at least (r - 1) cell sizes away from the point.
+  const double minCellSize = mPointMassGridCellSize.minCoeff();
+  const int maxRadius = mPointMassGridSize.maxCoeff();
+  for (int radius = 0; radius <= maxRadius; ++radius)
+  {
+    const double shellDistance = (radius - 1) * minCellSize;
+    if (radius > 0 && shellDistance > 0.0
+        && shellDistance * shellDistance > minDistance2)
+    {
+      break;
+    }
+
+    Eigen::Vector3i begin = (center.array() - radius).max(0);
+    Eigen::Vector3i end
+        = (center.array() + radius).min(mPointMassGridSize.array() - 1);
+    for (int z = begin[2]; z <= end[2]; ++z)
+    {
+      for (int y = begin[1]; y <= end[1]; ++y)
+      {
+        for (int x = begin[0]; x <= end[0]; ++x)
+        {
+          // Skip the cells of the inner shells
+          if (std::abs(x - center[0]) != radius
+              && std::abs(y - center[1]) != radius
+              && std::abs(z - center[2]) != radius)
+          {
+            continue;
+          }
+
+          const size_t cell
+              = (static_cast<size_t>(z) * mPointMassGridSize[1] + y)
+                * mPointMassGridSize[0] + x;
+          for (size_t i = mPointMassGridOffsets[cell];
+               i < mPointMassGridOffsets[cell + 1]; ++i)
+          {
+            const size_t index = mPointMassGridIndices[i];
+            const double distance2
+                = (mPointMasses[index]->getLocalPosition()
+                   - point).squaredNorm();
+            if (distance2 < minDistance2)
+            {
+              minDistance2 = distance2;
+              nearest = index;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return nearest;
+}
+
 //==============================================================================
 void SoftBodyNode::clearConstraintImpulse()
 {
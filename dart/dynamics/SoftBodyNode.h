@@ -127,7 +127,17 @@ public:
   const Eigen::Vector3i& getFace(size_t _idx) const;
 
   /// \brief
-  size_t getNumFaces();
+  size_t getNumFaces() const;
+
+  /// \brief Rebuild the uniform grid of the point masses from their current
+  /// positions w.r.t. the body frame. This should be called once per time step
+  /// before findNearestPointMass().
+  void updatePointMassIndex();
+
+  /// \brief Return the index of the point mass nearest to _point, which is
+  /// w.r.t. the world frame, using the grid of updatePointMassIndex(). All the
+  /// point masses are scanned if the grid was not built.
+  size_t findNearestPointMass(const Eigen::Vector3d& _point) const;
 
   // Documentation inherited.
   virtual void clearConstraintImpulse();
@@ -298,6 +308,31 @@ protected:
   /// \brief
   double mDampCoeff;
 
+  /// \brief Minimum corner of the grid of the point masses w.r.t. the body
+  /// frame
+  Eigen::Vector3d mPointMassGridMin;
+
+  /// \brief Size of the cells of the grid of the point masses
+  Eigen::Vector3d mPointMassGridCellSize;
+
+  /// \brief Number of cells of the grid of the point masses along each axis
+  Eigen::Vector3i mPointMassGridSize;
+
+  /// \brief Offset of the first point mass of each cell in
+  /// mPointMassGridIndices, followed by the number of point masses
+  std::vector<size_t> mPointMassGridOffsets;
+
+  /// \brief Indices of the point masses sorted by their cells
+  std::vector<size_t> mPointMassGridIndices;
+
+  /// \brief Cell of each point mass, kept between the calls of
+  /// updatePointMassIndex() so that its storage is reused on every step
+  std::vector<size_t> mPointMassGridCells;
+
+  /// \brief Next free slot of each cell in mPointMassGridIndices while the
+  /// point masses are sorted, kept for the same reason
+  std::vector<size_t> mPointMassGridNext;
+
   /// \brief Soft mesh shape for visualization.
   SoftMeshShape* mSoftVisualShape;
 
@@ -65,6 +65,11 @@ const aiMesh* SoftMeshShape::getAssimpMesh() const
   return mAssimpMesh;
 }
 
+SoftBodyNode* SoftMeshShape::getSoftBodyNode() const
+{
+  return mSoftBodyNode;
+}
+
 Eigen::Matrix3d SoftMeshShape::computeInertia(double _mass) const
 {
   // TODO(JS): Not implemented.
@@ -59,6 +59,11 @@ public:
   /// \brief
   const aiMesh* getAssimpMesh() const;
 
+  /// \brief Return the soft body node whose point masses are the vertices of
+  /// this mesh. Collision detectors can read the vertices from the point
+  /// masses directly instead of calling update().
+  SoftBodyNode* getSoftBodyNode() const;
+
   /// \brief Update positions of the vertices using the parent soft body node.
   void update();
 
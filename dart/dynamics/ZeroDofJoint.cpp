@@ -471,6 +471,13 @@ const math::Jacobian ZeroDofJoint::getLocalJacobian() const
   return Eigen::Matrix<double, 6, 0>();
 }
 
+//==============================================================================
+void ZeroDofJoint::setLocalJacobianTo(math::Jacobian& /*_J*/,
+                                      size_t /*_col*/) const
+{
+  // Do nothing
+}
+
 //==============================================================================
 const math::Jacobian ZeroDofJoint::getLocalJacobianTimeDeriv() const
 {
@@ -636,19 +643,23 @@ void ZeroDofJoint::updateConstrainedTerms(double /*_timeStep*/)
 //==============================================================================
 void ZeroDofJoint::addChildBiasForceForInvMassMatrix(
     Eigen::Vector6d& _parentBiasForce,
-    const Eigen::Matrix6d& _childArtInertia,
+    const Eigen::Matrix6d& /*_childArtInertia*/,
     const Eigen::Vector6d& _childBiasForce)
 {
-  // TODO(JS)
+  // Add child body's bias force to parent body's bias force. Note that mT
+  // should be updated.
+  _parentBiasForce += math::dAdInvT(getLocalTransform(), _childBiasForce);
 }
 
 //==============================================================================
 void ZeroDofJoint::addChildBiasForceForInvAugMassMatrix(
     Eigen::Vector6d& _parentBiasForce,
-    const Eigen::Matrix6d& _childArtInertia,
+    const Eigen::Matrix6d& /*_childArtInertia*/,
     const Eigen::Vector6d& _childBiasForce)
 {
-  // TODO(JS)
+  // Add child body's bias force to parent body's bias force. Note that mT
+  // should be updated.
+  _parentBiasForce += math::dAdInvT(getLocalTransform(), _childBiasForce);
 }
 
 //==============================================================================
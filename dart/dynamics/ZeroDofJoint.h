@@ -309,6 +309,10 @@ protected:
   // Documentation inherited
   virtual const math::Jacobian getLocalJacobian() const override;
 
+  // Documentation inherited
+  virtual void setLocalJacobianTo(math::Jacobian& _J,
+                                  size_t _col) const override;
+
   // Documentation inherited
   virtual const math::Jacobian getLocalJacobianTimeDeriv() const override;
 
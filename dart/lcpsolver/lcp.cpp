@@ -777,8 +777,25 @@ void dLCP::unpermute()
 //***************************************************************************
 // an optimized Dantzig LCP driver routine for the lo-hi LCP problem.
 
+// the scratch memory of dSolveLCP is carved into blocks whose sizes are
+// rounded up to a multiple of dLCP_MEMORY_ALIGNMENT so that each block starts
+// as aligned as the memory itself
+
+#define dLCP_MEMORY_ALIGNMENT 16
+#define dLCP_MEMORY_SIZE(x) \
+  (((x)+(dLCP_MEMORY_ALIGNMENT-1)) & ~((size_t)(dLCP_MEMORY_ALIGNMENT-1)))
+
+template <typename T>
+static T *dLCPTakeMemory (char *&memory, size_t count)
+{
+  T *block = (T *)memory;
+  memory += dLCP_MEMORY_SIZE(count*sizeof(T));
+  return block;
+}
+
 void dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
-                dReal *outer_w/*=NULL*/, int nub, dReal *lo, dReal *hi, int *findex)
+                dReal *outer_w/*=NULL*/, int nub, dReal *lo, dReal *hi, int *findex,
+                void *memory/*=NULL*/)
 {
   dAASSERT (n>0 && A && x && b && lo && hi && nub >= 0 && nub <= n);
 # ifndef dNODEBUG
@@ -791,8 +808,17 @@ void dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
 
   // if all the variables are unbounded then we can just factor, solve,
   // and return
+  // use the scratch memory of the caller if any, otherwise allocate it here
+  char *allocated = NULL;
+  if (!memory) {
+    allocated = new char[dEstimateSolveLCPMemoryReq(n, outer_w != NULL)
+                         + dLCP_MEMORY_ALIGNMENT];
+    memory = (void *)dLCP_MEMORY_SIZE((size_t)allocated);
+  }
+  char *next = (char *)memory;
+
   if (nub >= n) {
-    dReal *d = new dReal[n];
+    dReal *d = dLCPTakeMemory<dReal>(next, n);
     dSetZero (d, n);
 
     int nskip = dPAD(n);
@@ -800,27 +826,31 @@ void dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
     dSolveLDLT (A, d, b, n, nskip);
     memcpy (x, b, n*sizeof(dReal));
 
+    delete[] allocated;
     return;
   }
 
   const int nskip = dPAD(n);
-  dReal *L = new dReal[ (n*nskip)];
-  dReal *d = new dReal[ (n)];
-  dReal *w = outer_w ? outer_w : (new dReal[n]);
-  dReal *delta_w = new dReal[ (n)];
-  dReal *delta_x = new dReal[ (n)];
-  dReal *Dell = new dReal[ (n)];
-  dReal *ell = new dReal[ (n)];
+  dReal *L = dLCPTakeMemory<dReal>(next, n*nskip);
+  dReal *d = dLCPTakeMemory<dReal>(next, n);
+  dReal *w = outer_w ? outer_w : dLCPTakeMemory<dReal>(next, n);
+  dReal *delta_w = dLCPTakeMemory<dReal>(next, n);
+  dReal *delta_x = dLCPTakeMemory<dReal>(next, n);
+  dReal *Dell = dLCPTakeMemory<dReal>(next, n);
+  dReal *ell = dLCPTakeMemory<dReal>(next, n);
 #ifdef ROWPTRS
-  dReal **Arows = new dReal* [n];
+  dReal **Arows = dLCPTakeMemory<dReal *>(next, n);
 #else
   dReal **Arows = NULL;
 #endif
-  int *p = new int[n];
-  int *C = new int[n];
+  int *p = dLCPTakeMemory<int>(next, n);
+  int *C = dLCPTakeMemory<int>(next, n);
 
   // for i in N, state[i] is 0 if x(i)==lo(i) or 1 if x(i)==hi(i)
-  bool *state = new bool[n];
+  bool *state = dLCPTakeMemory<bool>(next, n);
+
+  // scratch memory of dLCP::transfer_i_from_C_to_N
+  void *tmpbuf = next;
 
   // create LCP object. note that tmp is set to delta_w to save space, this
   // optimization relies on knowledge of how tmp is used, so be careful!
@@ -1045,12 +1075,12 @@ void dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
         case 5:		// keep going
           x[si] = lo[si];
           state[si] = false;
-          lcp.transfer_i_from_C_to_N (si, NULL);
+          lcp.transfer_i_from_C_to_N (si, tmpbuf);
           break;
         case 6:		// keep going
           x[si] = hi[si];
           state[si] = true;
-          lcp.transfer_i_from_C_to_N (si, NULL);
+          lcp.transfer_i_from_C_to_N (si, tmpbuf);
           break;
         }
 
@@ -1065,21 +1095,7 @@ void dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
 
   lcp.unpermute();
 
-  if (!outer_w)
-	  delete[] w;
-  delete[] L;
-  delete[] d;
-  delete[] delta_w;
-  delete[] delta_x;
-  delete[] Dell;
-  delete[] ell;
-#ifdef ROWPTRS
-  delete[] Arows;
-#endif
-  delete[] p;
-  delete[] C;
-
-  delete[] state;
+  delete[] allocated;
 }
 
 size_t dEstimateSolveLCPMemoryReq(int n, bool outer_w_avail)
@@ -1088,16 +1104,16 @@ size_t dEstimateSolveLCPMemoryReq(int n, bool outer_w_avail)
 
   size_t res = 0;
 
-  res += (sizeof(dReal) * (n * nskip)); // for L
-  res += 5 * (sizeof(dReal) * n); // for d, delta_w, delta_x, Dell, ell
+  res += dLCP_MEMORY_SIZE(sizeof(dReal) * (n * nskip)); // for L
+  res += 5 * dLCP_MEMORY_SIZE(sizeof(dReal) * n); // for d, delta_w, delta_x, Dell, ell
   if (!outer_w_avail) {
-    res += (sizeof(dReal) * n); // for w
+    res += dLCP_MEMORY_SIZE(sizeof(dReal) * n); // for w
   }
 #ifdef ROWPTRS
-  res += (sizeof(dReal *) * n); // for Arows
+  res += dLCP_MEMORY_SIZE(sizeof(dReal *) * n); // for Arows
 #endif
-  res += 2 * (sizeof(int) * n); // for p, C
-  res += (sizeof(bool) * n); // for state
+  res += 2 * dLCP_MEMORY_SIZE(sizeof(int) * n); // for p, C
+  res += dLCP_MEMORY_SIZE(sizeof(bool) * n); // for state
 
   // Use n instead of nC as nC varies at runtime while n is greater or equal to nC
   size_t lcp_transfer_req = dLCP::estimate_transfer_i_from_C_to_N_mem_req(n, nskip);
@@ -57,8 +57,12 @@ to be implemented. the first `nub' variables are assumed to have findex < 0.
 #include "dart/lcpsolver/odeconfig.h"
 #include "dart/lcpsolver/common.h"
 
+// if `memory' is nonzero, it points to scratch memory of at least
+// dEstimateSolveLCPMemoryReq(n, w != 0) bytes aligned to 16 bytes that is used
+// instead of allocating the working arrays on the heap.
+
 void dSolveLCP (int n, dReal *A, dReal *x, dReal *b, dReal *w,
-	int nub, dReal *lo, dReal *hi, int *findex);
+	int nub, dReal *lo, dReal *hi, int *findex, void *memory = 0);
 
 size_t dEstimateSolveLCPMemoryReq(int n, bool outer_w_avail);
 
@@ -147,7 +147,8 @@ inline bool isNan(double _v) {
 }
 
 /// \brief Returns whether _m is a NaN (Not-A-Number) matrix
-inline bool isNan(const Eigen::MatrixXd& _m) {
+template <typename Derived>
+inline bool isNan(const Eigen::MatrixBase<Derived>& _m) {
   for (int i = 0; i < _m.rows(); ++i)
     for (int j = 0; j < _m.cols(); ++j)
       if (isNan(_m(i, j)))
@@ -168,7 +169,8 @@ inline bool isInf(double _v) {
 
 /// \brief Returns whether _m is an infinity matrix (either positive infinity or
 /// negative infinity).
-inline bool isInf(const Eigen::MatrixXd& _m) {
+template <typename Derived>
+inline bool isInf(const Eigen::MatrixBase<Derived>& _m) {
   for (int i = 0; i < _m.rows(); ++i)
     for (int j = 0; j < _m.cols(); ++j)
       if (isInf(_m(i, j)))
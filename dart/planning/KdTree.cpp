@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/planning/KdTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "dart/math/MathTypes.h"
+
+namespace dart {
+namespace planning {
+
+namespace {
+
+/// Order of configurations by their values along a dimension
+class PointLess
+{
+public:
+  /// Constructor
+  PointLess(const std::vector<double>& _points, size_t _numDimensions,
+            size_t _dimension)
+    : mPoints(_points),
+      mNumDimensions(_numDimensions),
+      mDimension(_dimension)
+  {
+  }
+
+  /// Return true if configuration _index1 precedes configuration _index2
+  bool operator()(size_t _index1, size_t _index2) const
+  {
+    return mPoints[_index1 * mNumDimensions + mDimension]
+        < mPoints[_index2 * mNumDimensions + mDimension];
+  }
+
+private:
+  /// Configurations, stored one after another
+  const std::vector<double>& mPoints;
+
+  /// Number of dimensions
+  size_t mNumDimensions;
+
+  /// Dimension to compare
+  size_t mDimension;
+};
+
+}  // namespace
+
+//==============================================================================
+KdTree::KdTree(size_t _numDimensions, size_t _bucketSize)
+  : mNumDimensions(_numDimensions),
+    mBucketSize(std::max<size_t>(_bucketSize, 1)),
+    mIsCircular(_numDimensions, false),
+    mWeights(_numDimensions, 1.0)
+{
+}
+
+//==============================================================================
+size_t KdTree::getNumDimensions() const
+{
+  return mNumDimensions;
+}
+
+//==============================================================================
+void KdTree::setCircular(size_t _index, bool _isCircular)
+{
+  assert(_index < mNumDimensions);
+  assert(mPoints.empty());
+  mIsCircular[_index] = _isCircular;
+}
+
+//==============================================================================
+bool KdTree::isCircular(size_t _index) const
+{
+  assert(_index < mNumDimensions);
+  return mIsCircular[_index];
+}
+
+//==============================================================================
+void KdTree::setWeight(size_t _index, double _weight)
+{
+  assert(_index < mNumDimensions);
+  assert(_weight >= 0.0);
+  assert(mPoints.empty());
+  mWeights[_index] = _weight;
+}
+
+//==============================================================================
+double KdTree::getWeight(size_t _index) const
+{
+  assert(_index < mNumDimensions);
+  return mWeights[_index];
+}
+
+//==============================================================================
+size_t KdTree::addPoint(const Eigen::VectorXd& _point)
+{
+  assert(static_cast<size_t>(_point.size()) == mNumDimensions);
+
+  const size_t index = getNumPoints();
+  mPoints.insert(mPoints.end(), _point.data(), _point.data() + mNumDimensions);
+  mIsRemoved.push_back(false);
+  const double* point = &mPoints[index * mNumDimensions];
+
+  if (mNodes.empty())
+  {
+    Node root;
+    root.splitDimension = -1;
+    mNodes.push_back(root);
+    mLowerBounds.assign(point, point + mNumDimensions);
+    mUpperBounds.assign(point, point + mNumDimensions);
+  }
+
+  // Descend to the leaf of the configuration while extending the bounding
+  // boxes on the way
+  size_t node = 0;
+  while (true)
+  {
+    extendBox(node, point);
+
+    const Node& current = mNodes[node];
+    if (current.splitDimension < 0)
+      break;
+
+    node = current.children[
+        point[current.splitDimension] < current.splitValue ? 0 : 1];
+  }
+
+  mNodes[node].points.push_back(index);
+  if (mNodes[node].points.size() > mBucketSize)
+    splitLeaf(node);
+
+  return index;
+}
+
+//==============================================================================
+size_t KdTree::getNumPoints() const
+{
+  return mNumDimensions > 0 ? mPoints.size() / mNumDimensions : 0;
+}
+
+//==============================================================================
+Eigen::Map<const Eigen::VectorXd> KdTree::getPoint(size_t _index) const
+{
+  assert(_index < getNumPoints());
+  return Eigen::Map<const Eigen::VectorXd>(&mPoints[_index * mNumDimensions],
+                                           mNumDimensions);
+}
+
+//==============================================================================
+void KdTree::removePoint(size_t _index)
+{
+  assert(_index < getNumPoints());
+  mIsRemoved[_index] = true;
+}
+
+//==============================================================================
+bool KdTree::isRemoved(size_t _index) const
+{
+  assert(_index < getNumPoints());
+  return mIsRemoved[_index];
+}
+
+//==============================================================================
+size_t KdTree::findNearest(const Eigen::VectorXd& _query,
+                           double* _distance) const
+{
+  assert(!mNodes.empty());
+  assert(static_cast<size_t>(_query.size()) == mNumDimensions);
+
+  size_t nearest = 0;
+  double squaredDistance = std::numeric_limits<double>::infinity();
+  findNearest(0, _query.data(), &nearest, &squaredDistance);
+
+  if (_distance)
+    *_distance = std::sqrt(squaredDistance);
+
+  return nearest;
+}
+
+//==============================================================================
+Eigen::VectorXd KdTree::getDifference(const Eigen::VectorXd& _to,
+                                      const Eigen::VectorXd& _from) const
+{
+  assert(static_cast<size_t>(_to.size()) == mNumDimensions);
+  assert(static_cast<size_t>(_from.size()) == mNumDimensions);
+
+  Eigen::VectorXd difference(mNumDimensions);
+  for (size_t i = 0; i < mNumDimensions; ++i)
+    difference[i] = getDifference(i, _to[i], _from[i]);
+
+  return difference;
+}
+
+//==============================================================================
+double KdTree::getDistance(const Eigen::VectorXd& _point1,
+                           const Eigen::VectorXd& _point2) const
+{
+  assert(static_cast<size_t>(_point1.size()) == mNumDimensions);
+  assert(static_cast<size_t>(_point2.size()) == mNumDimensions);
+
+  return std::sqrt(getSquaredDistance(_point1.data(), _point2.data()));
+}
+
+//==============================================================================
+void KdTree::clear()
+{
+  mPoints.clear();
+  mIsRemoved.clear();
+  mNodes.clear();
+  mLowerBounds.clear();
+  mUpperBounds.clear();
+}
+
+//==============================================================================
+double KdTree::getDifference(size_t _index, double _to, double _from) const
+{
+  double difference = _to - _from;
+  if (!mIsCircular[_index])
+    return difference;
+
+  difference = std::fmod(difference, 2.0 * DART_PI);
+  if (difference > DART_PI)
+    difference -= 2.0 * DART_PI;
+  else if (difference < -DART_PI)
+    difference += 2.0 * DART_PI;
+
+  return difference;
+}
+
+//==============================================================================
+double KdTree::getSquaredDistance(const double* _point1,
+                                  const double* _point2) const
+{
+  double squaredDistance = 0.0;
+  for (size_t i = 0; i < mNumDimensions; ++i)
+  {
+    double difference = getDifference(i, _point1[i], _point2[i]);
+    squaredDistance += mWeights[i] * difference * difference;
+  }
+
+  return squaredDistance;
+}
+
+//==============================================================================
+double KdTree::getSquaredBoxDistance(size_t _node, const double* _query) const
+{
+  const double* lower = &mLowerBounds[_node * mNumDimensions];
+  const double* upper = &mUpperBounds[_node * mNumDimensions];
+
+  double squaredDistance = 0.0;
+  for (size_t i = 0; i < mNumDimensions; ++i)
+  {
+    double distance = 0.0;
+    if (!mIsCircular[i])
+    {
+      if (_query[i] < lower[i])
+        distance = lower[i] - _query[i];
+      else if (_query[i] > upper[i])
+        distance = _query[i] - upper[i];
+    }
+    else if (upper[i] - lower[i] < 2.0 * DART_PI)
+    {
+      // Shift the query into [lower, lower + 2*pi), and measure the distance
+      // to the nearer end of the interval around the circle
+      double shifted = lower[i] + std::fmod(_query[i] - lower[i],
+                                            2.0 * DART_PI);
+      if (shifted < lower[i])
+        shifted += 2.0 * DART_PI;
+
+      if (shifted > upper[i])
+      {
+        distance = std::min(shifted - upper[i],
+                            lower[i] + 2.0 * DART_PI - shifted);
+      }
+    }
+
+    squaredDistance += mWeights[i] * distance * distance;
+  }
+
+  return squaredDistance;
+}
+
+//==============================================================================
+void KdTree::extendBox(size_t _node, const double* _point)
+{
+  double* lower = &mLowerBounds[_node * mNumDimensions];
+  double* upper = &mUpperBounds[_node * mNumDimensions];
+  for (size_t i = 0; i < mNumDimensions; ++i)
+  {
+    lower[i] = std::min(lower[i], _point[i]);
+    upper[i] = std::max(upper[i], _point[i]);
+  }
+}
+
+//==============================================================================
+void KdTree::splitLeaf(size_t _node)
+{
+  // Find the widest dimension of the bounding box in the metric
+  const double* lower = &mLowerBounds[_node * mNumDimensions];
+  const double* upper = &mUpperBounds[_node * mNumDimensions];
+  int splitDimension = -1;
+  double maxExtent = 0.0;
+  for (size_t i = 0; i < mNumDimensions; ++i)
+  {
+    double extent = upper[i] - lower[i];
+    if (mIsCircular[i])
+      extent = std::min(extent, 2.0 * DART_PI);
+    extent *= std::sqrt(mWeights[i]);
+
+    if (extent > maxExtent)
+    {
+      maxExtent = extent;
+      splitDimension = static_cast<int>(i);
+    }
+  }
+
+  if (splitDimension < 0)
+    return;
+
+  // Give each child half of the configurations. The children are pruned by
+  // their bounding boxes, so the configurations equal to the split value may
+  // be in either child.
+  std::vector<size_t> points;
+  points.swap(mNodes[_node].points);
+  const size_t middle = points.size() / 2;
+  std::nth_element(points.begin(), points.begin() + middle, points.end(),
+                   PointLess(mPoints, mNumDimensions, splitDimension));
+
+  size_t children[2];
+  for (size_t i = 0; i < 2; ++i)
+  {
+    children[i] = mNodes.size();
+
+    Node child;
+    child.splitDimension = -1;
+    if (i == 0)
+      child.points.assign(points.begin(), points.begin() + middle);
+    else
+      child.points.assign(points.begin() + middle, points.end());
+    mNodes.push_back(child);
+
+    mLowerBounds.resize(mLowerBounds.size() + mNumDimensions,
+                        std::numeric_limits<double>::infinity());
+    mUpperBounds.resize(mUpperBounds.size() + mNumDimensions,
+                        -std::numeric_limits<double>::infinity());
+    for (size_t j = 0; j < mNodes[children[i]].points.size(); ++j)
+    {
+      extendBox(children[i],
+                &mPoints[mNodes[children[i]].points[j] * mNumDimensions]);
+    }
+  }
+
+  Node& node = mNodes[_node];
+  node.splitDimension = splitDimension;
+  node.splitValue = mPoints[points[middle] * mNumDimensions + splitDimension];
+  node.children[0] = children[0];
+  node.children[1] = children[1];
+}
+
+//==============================================================================
+void KdTree::findNearest(size_t _node, const double* _query, size_t* _nearest,
+                         double* _squaredDistance) const
+{
+  const Node& node = mNodes[_node];
+
+  if (node.splitDimension < 0)
+  {
+    for (size_t i = 0; i < node.points.size(); ++i)
+    {
+      size_t index = node.points[i];
+      if (mIsRemoved[index])
+        continue;
+
+      double squaredDistance
+          = getSquaredDistance(&mPoints[index * mNumDimensions], _query);
+      if (squaredDistance < *_squaredDistance)
+      {
+        *_squaredDistance = squaredDistance;
+        *_nearest = index;
+      }
+    }
+    return;
+  }
+
+  // Visit the child that may be nearer first so that the other one is more
+  // likely to be pruned
+  size_t first = node.children[0];
+  size_t second = node.children[1];
+  double firstDistance = getSquaredBoxDistance(first, _query);
+  double secondDistance = getSquaredBoxDistance(second, _query);
+  if (secondDistance < firstDistance)
+  {
+    std::swap(first, second);
+    std::swap(firstDistance, secondDistance);
+  }
+
+  if (firstDistance < *_squaredDistance)
+    findNearest(first, _query, _nearest, _squaredDistance);
+  if (secondDistance < *_squaredDistance)
+    findNearest(second, _query, _nearest, _squaredDistance);
+}
+
+}  // namespace planning
+}  // namespace dart
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_PLANNING_KDTREE_H_
+#define DART_PLANNING_KDTREE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace planning {
+
+/// KdTree is a nearest neighbor index of configurations that are added one at
+/// a time, as the nodes of an RRT are. The configurations are stored
+/// contiguously, and a leaf is split at the median of its widest dimension
+/// once it holds more than a bucket of configurations, so adding a
+/// configuration never rebuilds the tree.
+///
+/// The distance is the weighted Euclidean distance, where a dimension may be
+/// circular with a period of 2*pi as the position of a continuous revolute
+/// joint is. The searches are pruned by the bounding boxes of the subtrees,
+/// which stay valid for the circular dimensions.
+class KdTree
+{
+public:
+  /// Constructor
+  /// \param[in] _numDimensions Number of dimensions of the configurations
+  /// \param[in] _bucketSize Maximum number of configurations of a leaf
+  explicit KdTree(size_t _numDimensions, size_t _bucketSize = 16);
+
+  /// Get the number of dimensions of the configurations
+  size_t getNumDimensions() const;
+
+  /// Set whether dimension _index wraps around with a period of 2*pi. This
+  /// must be set before any configuration is added.
+  void setCircular(size_t _index, bool _isCircular);
+
+  /// Return true if dimension _index wraps around with a period of 2*pi
+  bool isCircular(size_t _index) const;
+
+  /// Set the weight of dimension _index in the distance, which is 1 by
+  /// default. This must be set before any configuration is added.
+  void setWeight(size_t _index, double _weight);
+
+  /// Get the weight of dimension _index in the distance
+  double getWeight(size_t _index) const;
+
+  /// Add a configuration and return its index
+  size_t addPoint(const Eigen::VectorXd& _point);
+
+  /// Get the number of configurations
+  size_t getNumPoints() const;
+
+  /// Get configuration _index, which is invalidated by addPoint()
+  Eigen::Map<const Eigen::VectorXd> getPoint(size_t _index) const;
+
+  /// Exclude configuration _index from the nearest neighbor searches. The
+  /// configuration keeps its index, and the bounding boxes are not shrunk.
+  void removePoint(size_t _index);
+
+  /// Return true if configuration _index has been removed
+  bool isRemoved(size_t _index) const;
+
+  /// Return the index of the configuration nearest to _query, and its
+  /// distance to _query in _distance if it is not NULL. At least one
+  /// configuration must not be removed.
+  size_t findNearest(const Eigen::VectorXd& _query,
+                     double* _distance = NULL) const;
+
+  /// Return the displacement from _from to _to, where the circular dimensions
+  /// take the shorter way around, which is within [-pi, pi]
+  Eigen::VectorXd getDifference(const Eigen::VectorXd& _to,
+                                const Eigen::VectorXd& _from) const;
+
+  /// Return the distance between _point1 and _point2
+  double getDistance(const Eigen::VectorXd& _point1,
+                     const Eigen::VectorXd& _point2) const;
+
+  /// Remove all the configurations
+  void clear();
+
+private:
+  /// Node of the tree, which is a leaf if splitDimension is negative
+  struct Node
+  {
+    /// Dimension that the children are split along, or -1 for a leaf
+    int splitDimension;
+
+    /// Configurations below splitValue are added to the first child, and the
+    /// others to the second child
+    double splitValue;
+
+    /// Indices of the children in mNodes
+    size_t children[2];
+
+    /// Indices of the configurations of a leaf
+    std::vector<size_t> points;
+  };
+
+  /// Return the difference of _to and _from along dimension _index, where a
+  /// circular dimension takes the shorter way around
+  double getDifference(size_t _index, double _to, double _from) const;
+
+  /// Return the squared distance between the configurations at _point1 and
+  /// _point2
+  double getSquaredDistance(const double* _point1,
+                            const double* _point2) const;
+
+  /// Return a lower bound of the squared distance from _query to the
+  /// configurations of node _node, which is computed from its bounding box
+  double getSquaredBoxDistance(size_t _node, const double* _query) const;
+
+  /// Extend the bounding box of node _node to contain _point
+  void extendBox(size_t _node, const double* _point);
+
+  /// Split leaf _node at the median of its widest dimension. The leaf is kept
+  /// if all of its configurations are the same.
+  void splitLeaf(size_t _node);
+
+  /// Find the configuration nearest to _query in the subtree of _node whose
+  /// squared distance is less than _squaredDistance
+  void findNearest(size_t _node, const double* _query, size_t* _nearest,
+                   double* _squaredDistance) const;
+
+  /// Number of dimensions
+  size_t mNumDimensions;
+
+  /// Maximum number of configurations of a leaf
+  size_t mBucketSize;
+
+  /// Whether each dimension wraps around with a period of 2*pi
+  std::vector<bool> mIsCircular;
+
+  /// Weight of each dimension in the distance
+  std::vector<double> mWeights;
+
+  /// Configurations, stored one after another
+  std::vector<double> mPoints;
+
+  /// Whether each configuration is removed from the searches
+  std::vector<bool> mIsRemoved;
+
+  /// Nodes of the tree, where the first node is the root
+  std::vector<Node> mNodes;
+
+  /// Minimum corners of the bounding boxes of the nodes, stored one after
+  /// another
+  std::vector<double> mLowerBounds;
+
+  /// Maximum corners of the bounding boxes of the nodes, stored one after
+  /// another
+  std::vector<double> mUpperBounds;
+};
+
+}  // namespace planning
+}  // namespace dart
+
+#endif  // DART_PLANNING_KDTREE_H_
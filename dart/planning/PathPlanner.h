@@ -11,10 +11,17 @@
 #define DART_PLANNING_PATHPLANNER_H_
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <limits>
 #include <list>
+#include <mutex>
+#include <random>
 #include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "dart/dynamics/Skeleton.h"
 #include "dart/simulation/World.h"
 #include "RRT.h"
@@ -35,6 +42,17 @@ public:
   double goalBias;        ///< Choose btw goal and random value (for goal-biased search)
   size_t maxNodes;        ///< Maximum number of iterations the sampling would continue
   simulation::World* world;  ///< The world that the robot is in (for obstacles and etc.)
+  bool lazy;               ///< Whether the nodes are checked for collisions only on candidate paths
+
+  // Counters of the last planPath() call, for instance to measure the collision checks per solution
+  size_t numCollisionChecks;  ///< Collision checks, including the start and goal configurations
+  size_t numCandidatePaths;   ///< Paths found between the start and the goal, which lazy
+                              ///< planning rejects if they collide
+
+  /// Replicas of the robot, one per planning thread, which must have the same structure as the
+  /// robot and must not be in the world. The trees are extended by several threads at the same
+  /// time if there are more than one.
+  std::vector<dynamics::Skeleton*> replicas;
 
   // NOTE: It is useful to keep the rrts around after planning for reuse, analysis, and etc.
   R* start_rrt;            ///< The rrt for unidirectional search
@@ -43,19 +61,20 @@ public:
 public:
 
   /// The default constructor
-  PathPlanner() : world(NULL) {}
+  PathPlanner() : world(NULL), lazy(false), numCollisionChecks(0), numCandidatePaths(0) {}
 
   /// The desired constructor - you should use this one.
   PathPlanner(simulation::World& world, bool bidirectional_ = true, bool connect_ = true, double stepSize_ = 0.1,
-    size_t maxNodes_ = 1e6, double goalBias_ = 0.3) : world(&world), bidirectional(bidirectional_),
-    connect(connect_), stepSize(stepSize_), maxNodes(maxNodes_), goalBias(goalBias_) {
+    size_t maxNodes_ = 1e6, double goalBias_ = 0.3, bool lazy_ = false) : world(&world),
+    bidirectional(bidirectional_), connect(connect_), stepSize(stepSize_), maxNodes(maxNodes_),
+    goalBias(goalBias_), lazy(lazy_), numCollisionChecks(0), numCandidatePaths(0) {
   }
 
   /// The destructor
   virtual ~PathPlanner() {}
 
   /// Plan a path from a single start configuration to a single goal
-  bool planPath(dynamics::Skeleton* robot, const std::vector<int> &dofs, const Eigen::VectorXd &start,
+  bool planPath(dynamics::Skeleton* robot, const std::vector<size_t> &dofs, const Eigen::VectorXd &start,
       const Eigen::VectorXd &goal, std::list<Eigen::VectorXd> &path) {
     std::vector<Eigen::VectorXd> startVector, goalVector;
     startVector.push_back(start);
@@ -70,7 +89,7 @@ public:
 private:
 
   /// Performs a unidirectional RRT with the given options.
-  bool planSingleTreeRrt(dynamics::Skeleton* robot, const std::vector<int> &dofs,
+  bool planSingleTreeRrt(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
     const std::vector<Eigen::VectorXd> &start, const Eigen::VectorXd &goal,
     std::list<Eigen::VectorXd> &path);
 
@@ -80,9 +99,34 @@ private:
   /// configurations whereas here, first, start rrt extends towards a random node and creates
   /// some node N. Afterwards, the second rrt extends towards _the node N_ and they continue
   /// swapping roles.
-  bool planBidirectionalRrt(dynamics::Skeleton* robot, const std::vector<int> &dofs,
+  bool planBidirectionalRrt(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
     const std::vector<Eigen::VectorXd> &start, const std::vector<Eigen::VectorXd> &goal,
     std::list<Eigen::VectorXd> &path);
+
+  /// Performs a unidirectional RRT with one thread per replica of the robot. The threads extend
+  /// the same tree and stop as soon as one of them reaches the goal.
+  bool planSingleTreeRrtParallel(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
+    const std::vector<Eigen::VectorXd> &start, const Eigen::VectorXd &goal,
+    std::list<Eigen::VectorXd> &path);
+
+  /// Performs bidirectional RRT with one thread per replica of the robot. Each thread swaps the
+  /// roles of the two trees as planBidirectionalRrt() does, and the threads stop as soon as one
+  /// of them connects the trees.
+  bool planBidirectionalRrtParallel(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
+    const std::vector<Eigen::VectorXd> &start, const std::vector<Eigen::VectorXd> &goal,
+    std::list<Eigen::VectorXd> &path);
+
+  /// Traces the path from the root of the start tree to the given node, followed by the path from
+  /// the given node of the goal tree to its root. The trees may meet across pi in the dofs of
+  /// continuous revolute joints, so the goal half is shifted by whole turns to continue the start
+  /// half.
+  void traceBidirectionalPath(int startNode, int goalNode, std::list<Eigen::VectorXd> &path);
+
+  /// Checks the nodes of the path through the given nodes of the two trees that have not been
+  /// checked yet, in bisection order over the whole path. The trees meet in the middle of the path,
+  /// where the candidate paths of lazy planning usually collide, so it is checked first. Returns
+  /// true if none of them collides, and otherwise prunes the tree of the colliding node found first.
+  bool validateBidirectionalPath(int startNode, int goalNode);
 };
 
 /* ********************************************************************************************* */
@@ -92,6 +136,8 @@ bool PathPlanner<R>::planPath(dynamics::Skeleton* robot, const std::vector<size_
     std::list<Eigen::VectorXd> &path) {
 
   Eigen::VectorXd savedConfiguration = robot->getPositionSegment(dofs);
+  numCollisionChecks = start.size() + goal.size();
+  numCandidatePaths = 0;
 
   // ====================================================================
   // Check for collisions in the start and goal configurations
@@ -127,13 +173,23 @@ bool PathPlanner<R>::planPath(dynamics::Skeleton* robot, const std::vector<size_
 
   // Direct the search towards single or bidirectional
   bool result = false;
-  if(bidirectional)
-    result = planBidirectionalRrt(robot, dofs, feasibleStart, feasibleGoal, path);
+  bool parallel = replicas.size() > 1;
+  if(parallel && lazy)
+    fprintf(stderr, "WARNING: PathPlanner: Parallel planning checks the nodes eagerly, not lazily!\n");
+  if(bidirectional) {
+    if(parallel) result = planBidirectionalRrtParallel(robot, dofs, feasibleStart, feasibleGoal, path);
+    else result = planBidirectionalRrt(robot, dofs, feasibleStart, feasibleGoal, path);
+  }
   else {
     if(feasibleGoal.size() > 1) fprintf(stderr, "WARNING: planPath is using ONLY the first goal!\n");
-    result = planSingleTreeRrt(robot, dofs, feasibleStart, feasibleGoal.front(), path);
+    if(parallel) result = planSingleTreeRrtParallel(robot, dofs, feasibleStart, feasibleGoal.front(), path);
+    else result = planSingleTreeRrt(robot, dofs, feasibleStart, feasibleGoal.front(), path);
   }
 
+  // Count the collision checks of the trees
+  numCollisionChecks += start_rrt->getNumCollisionChecks();
+  if(bidirectional) numCollisionChecks += goal_rrt->getNumCollisionChecks();
+
   // Restore previous robot configuration
   robot->setPositionSegment(dofs, savedConfiguration);
 
@@ -142,7 +198,7 @@ bool PathPlanner<R>::planPath(dynamics::Skeleton* robot, const std::vector<size_
 
 /* ********************************************************************************************* */
 template <class R>
-bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vector<int> &dofs,
+bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
     const std::vector<Eigen::VectorXd> &start, const Eigen::VectorXd &goal,
     std::list<Eigen::VectorXd> &path) {
 
@@ -150,6 +206,7 @@ bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vec
 
   // Initialize the RRT
   start_rrt = new R (world, robot, dofs, start, stepSize);
+  start_rrt->setLazy(lazy);
 
   // Expand the tree until the goal is reached or the max # nodes is passed
   typename R::StepResult result = R::STEP_PROGRESS;
@@ -159,7 +216,8 @@ bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vec
 
     // Get the target node based on the bias
     Eigen::VectorXd target;
-    double randomValue = ((double) rand()) / RAND_MAX;
+    double randomValue = std::uniform_real_distribution<double>(0.0, 1.0)(
+        R::getRandomGenerator());
     if(randomValue < goalBias) target = goal;
     else target = start_rrt->getRandomConfig();
 
@@ -167,12 +225,16 @@ bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vec
     if(connect) start_rrt->connect(target);
     else start_rrt->tryStep(target);
 
-    // Check if the goal is reached and create the path, if so
+    // Check if the goal is reached and create the path, if so. In lazy mode, the path is pruned
+    // from the tree instead if it collides.
     double gap = start_rrt->getGap(goal);
     if(gap < stepSize) {
-      if(debug) std::cout << "Returning true, reached the goal" << std::endl;
-      start_rrt->tracePath(start_rrt->activeNode, path);
-      return true;
+      numCandidatePaths++;
+      if(start_rrt->validatePath(start_rrt->activeNode)) {
+        if(debug) std::cout << "Returning true, reached the goal" << std::endl;
+        start_rrt->tracePath(start_rrt->activeNode, path);
+        return true;
+      }
     }
 
     // Update the number of nodes
@@ -187,7 +249,7 @@ bool PathPlanner<R>::planSingleTreeRrt(dynamics::Skeleton* robot, const std::vec
 
 /* ********************************************************************************************* */
 template <class R>
-bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::vector<int> &dofs,
+bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::vector<size_t> &dofs,
     const std::vector<Eigen::VectorXd> &start, const std::vector<Eigen::VectorXd> &goal,
     std::list<Eigen::VectorXd> &path) {
 
@@ -198,6 +260,8 @@ bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::
   // (random or goal) node.
   start_rrt = new R(world, robot, dofs, start, stepSize);
   goal_rrt = new R(world, robot, dofs, goal, stepSize);
+  start_rrt->setLazy(lazy);
+  goal_rrt->setLazy(lazy);
   R* rrt1 = start_rrt;
   R* rrt2 = goal_rrt;
 
@@ -214,7 +278,8 @@ bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::
 
      // Get the target node based on the bias
     Eigen::VectorXd target;
-    double randomValue = ((double) rand()) / RAND_MAX;
+    double randomValue = std::uniform_real_distribution<double>(0.0, 1.0)(
+        R::getRandomGenerator());
     if(randomValue < goalBias) target = goal[0];
     else target = rrt1->getRandomConfig();
 
@@ -227,15 +292,18 @@ bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::
     // NOTE: connect(x) and tryStep(x) functions return true if rrt2 can add the given node
     // in the tree. In this case, this would imply that the two trees meet.
     bool treesMet = false;
-    const Eigen::VectorXd& rrt2target = *(rrt1->configVector[rrt1->activeNode]);
+    const Eigen::VectorXd rrt2target = rrt1->getConfig(rrt1->activeNode);
     if(connect) treesMet = rrt2->connect(rrt2target);
     else treesMet = (rrt2->tryStep(rrt2target) == R::STEP_REACHED);
 
-    // Check if the trees have met and create the path, if so.
+    // Check if the trees have met and create the path, if so. In lazy mode, the path is pruned
+    // from the trees instead if it collides.
     if(treesMet) {
-      start_rrt->tracePath(start_rrt->activeNode, path);
-      goal_rrt->tracePath(goal_rrt->activeNode, path, true);
-      return true;
+      numCandidatePaths++;
+      if(validateBidirectionalPath(start_rrt->activeNode, goal_rrt->activeNode)) {
+        traceBidirectionalPath(start_rrt->activeNode, goal_rrt->activeNode, path);
+        return true;
+      }
     }
 
     // Update the number of nodes in the two trees
@@ -243,11 +311,11 @@ bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::
 
     // Print the gap between the trees in debug mode
     if(debug) {
-      double gap = rrt2->getGap(*(rrt1->configVector[rrt1->activeNode]));
+      double gap = rrt2->getGap(rrt1->getConfig(rrt1->activeNode));
       if(gap < smallestGap) {
         smallestGap = gap;
-        std::cout << "Gap: " << smallestGap << "  Sizes: " << start_rrt->configVector.size()
-          << "/" << goal_rrt->configVector.size() << std::endl;
+        std::cout << "Gap: " << smallestGap << "  Sizes: " << start_rrt->getSize()
+          << "/" << goal_rrt->getSize() << std::endl;
       }
     }
   }
@@ -256,6 +324,180 @@ bool PathPlanner<R>::planBidirectionalRrt(dynamics::Skeleton* robot, const std::
   return false;
 }
 
+/* ********************************************************************************************* */
+template <class R>
+bool PathPlanner<R>::planSingleTreeRrtParallel(dynamics::Skeleton* robot,
+    const std::vector<size_t> &dofs, const std::vector<Eigen::VectorXd> &start,
+    const Eigen::VectorXd &goal, std::list<Eigen::VectorXd> &path) {
+
+  // Initialize the RRT, which the threads extend with their own replicas of the robot
+  start_rrt = new R(world, robot, dofs, start, stepSize);
+  start_rrt->setReplicas(replicas);
+
+  // The node that reached the goal, which is set by the first thread that reaches it
+  std::atomic<bool> done(false);
+  std::mutex resultMutex;
+  int goalNode = -1;
+
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(replicas.size());
+#pragma omp parallel num_threads(numThreads)
+#endif
+  {
+#ifdef _OPENMP
+    dynamics::Skeleton* replica = replicas[omp_get_thread_num()];
+#else
+    dynamics::Skeleton* replica = replicas[0];
+#endif
+
+    // Expand the tree until the goal is reached or the max # nodes is passed
+    int lastNode;
+    Eigen::VectorXd lastConfig;
+    while(!done && start_rrt->getSize() <= maxNodes) {
+
+      // Get the target node based on the bias
+      Eigen::VectorXd target;
+      double randomValue = std::uniform_real_distribution<double>(0.0, 1.0)(
+          R::getRandomGenerator());
+      if(randomValue < goalBias) target = goal;
+      else target = start_rrt->getRandomConfig();
+
+      // Based on the method, either attempt to connect to the target directly or take a small step
+      start_rrt->extend(target, connect, replica, lastNode, lastConfig);
+
+      // Check if the goal is reached
+      if(start_rrt->getDistance(goal, lastConfig) < stepSize) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if(!done) {
+          goalNode = lastNode;
+          numCandidatePaths++;
+          done = true;
+        }
+      }
+    }
+  }
+
+  // Maximum # of iterations are reached and path is not found - failed.
+  if(!done) return false;
+
+  start_rrt->tracePath(goalNode, path);
+  return true;
+}
+
+/* ********************************************************************************************* */
+template <class R>
+bool PathPlanner<R>::planBidirectionalRrtParallel(dynamics::Skeleton* robot,
+    const std::vector<size_t> &dofs, const std::vector<Eigen::VectorXd> &start,
+    const std::vector<Eigen::VectorXd> &goal, std::list<Eigen::VectorXd> &path) {
+
+  // Initialize both the start and goal RRTs, which the threads extend with their own replicas of
+  // the robot
+  start_rrt = new R(world, robot, dofs, start, stepSize);
+  goal_rrt = new R(world, robot, dofs, goal, stepSize);
+  start_rrt->setReplicas(replicas);
+  goal_rrt->setReplicas(replicas);
+
+  // The nodes where the trees met, which are set by the first thread that connects them
+  std::atomic<bool> done(false);
+  std::mutex resultMutex;
+  int startNode = -1;
+  int goalNode = -1;
+
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(replicas.size());
+#pragma omp parallel num_threads(numThreads)
+#endif
+  {
+#ifdef _OPENMP
+    const int thread = omp_get_thread_num();
+#else
+    const int thread = 0;
+#endif
+    dynamics::Skeleton* replica = replicas[thread];
+
+    // Half of the threads start with each tree so that both trees grow from the beginning
+    bool startFirst = (thread % 2 == 0);
+
+    // Expand the trees until they meet or the max # nodes is passed
+    int node1, node2;
+    Eigen::VectorXd config1, config2;
+    while(!done && start_rrt->getSize() + goal_rrt->getSize() < maxNodes) {
+
+      // Swap the roles of the two RRTs. The first rrt reaches out to a target node and the second
+      // rrt reaches to the last node of the first one.
+      R* rrt1 = startFirst ? start_rrt : goal_rrt;
+      R* rrt2 = startFirst ? goal_rrt : start_rrt;
+
+      // Get the target node based on the bias
+      Eigen::VectorXd target;
+      double randomValue = std::uniform_real_distribution<double>(0.0, 1.0)(
+          R::getRandomGenerator());
+      if(randomValue < goalBias) target = goal[0];
+      else target = rrt1->getRandomConfig();
+
+      // rrt1 either attempts to connect to the target directly or takes a step, and rrt2 reaches
+      // out to the last added node of rrt1, or to its nearest neighbor to the target if no node
+      // was added. The trees meet if rrt2 reaches that node.
+      rrt1->extend(target, connect, replica, node1, config1);
+      if(rrt2->extend(config1, connect, replica, node2, config2) == R::STEP_REACHED) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if(!done) {
+          startNode = startFirst ? node1 : node2;
+          goalNode = startFirst ? node2 : node1;
+          numCandidatePaths++;
+          done = true;
+        }
+      }
+
+      startFirst = !startFirst;
+    }
+  }
+
+  // Maximum # of iterations are reached and path is not found - failed.
+  if(!done) return false;
+
+  traceBidirectionalPath(startNode, goalNode, path);
+  return true;
+}
+
+/* ********************************************************************************************* */
+template <class R>
+bool PathPlanner<R>::validateBidirectionalPath(int startNode, int goalNode) {
+
+  // The unchecked nodes of the start tree are collected towards its root, so they are reversed to
+  // follow the path from the start to the goal
+  std::vector<int> startNodes, goalNodes;
+  start_rrt->getUncheckedNodes(startNode, startNodes);
+  goal_rrt->getUncheckedNodes(goalNode, goalNodes);
+  std::reverse(startNodes.begin(), startNodes.end());
+
+  std::vector<size_t> order;
+  computeBisectionOrder(startNodes.size() + goalNodes.size() + 1, order);
+  for(size_t i = 0; i < order.size(); i++) {
+    size_t x = order[i] - 1;
+    bool isFree = x < startNodes.size() ? start_rrt->validateNode(startNodes[x])
+        : goal_rrt->validateNode(goalNodes[x - startNodes.size()]);
+    if(!isFree) return false;
+  }
+  return true;
+}
+
+/* ********************************************************************************************* */
+template <class R>
+void PathPlanner<R>::traceBidirectionalPath(int startNode, int goalNode,
+    std::list<Eigen::VectorXd> &path) {
+
+  start_rrt->tracePath(startNode, path);
+  std::list<Eigen::VectorXd> goalPath;
+  goal_rrt->tracePath(goalNode, goalPath, true);
+
+  const Eigen::VectorXd offset
+      = start_rrt->getNearestEquivalent(goalPath.front(), path.back()) - goalPath.front();
+  for(std::list<Eigen::VectorXd>::iterator it = goalPath.begin(); it != goalPath.end(); it++)
+    *it += offset;
+  path.splice(path.end(), goalPath);
+}
+
 } // namespace planning
 } // namespace dart
 
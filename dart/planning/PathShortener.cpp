@@ -2,6 +2,7 @@
 #include "dart/simulation/World.h"
 #include "RRT.h"
 #include "dart/collision/CollisionDetector.h"
+#include "dart/constraint/ConstraintSolver.h"
 #include "dart/dynamics/Skeleton.h"
 #include <ctime>
 #include <cstdio>
@@ -16,14 +17,19 @@ using namespace simulation;
 namespace dart {
 namespace planning {
 
-PathShortener::PathShortener() {}
+PathShortener::PathShortener() : numCollisionChecks(0) {}
 
 PathShortener::PathShortener(World* world, dynamics::Skeleton* robot, const vector<size_t> &dofs, double stepSize) :
    world(world),
    robot(robot),
    dofs(dofs),
-   stepSize(stepSize)
-{}
+   stepSize(stepSize),
+   numCollisionChecks(0)
+{
+	// Only the bodies of the robot are checked against the rest of the world
+	for(size_t i = 0; i < robot->getNumBodyNodes(); i++)
+		robotBodyNodes.push_back(robot->getBodyNode(i));
+}
 
 PathShortener::~PathShortener()
 {}
@@ -32,6 +38,7 @@ void PathShortener::shortenPath(list<VectorXd> &path)
 {
 	printf("--> Start Brute Force Shortener \n"); 
 	srand(time(NULL));
+	numCollisionChecks = 0;
 
   VectorXd savedDofs = robot->getPositionSegment(dofs);
 
@@ -84,29 +91,32 @@ bool PathShortener::segmentCollisionFree(list<VectorXd> &intermediatePoints, con
 	}
 
 	const int n = (int)(length / stepSize) + 1; // number of intermediate segments
-	int n1 = n / 2;
-	int n2 = n / 2;
-	if(n % 2 == 1) {
-		n2 += 1;
-	}
 
-	VectorXd midpoint = (double)n2 / (double)n * config1 + (double)n1 / (double)n * config2;
-	list<VectorXd> intermediatePoints1, intermediatePoints2;
-  // TODO(JS): What kinematic values should be updated here?
-  robot->setPositionSegment(dofs, midpoint);
-  robot->computeForwardKinematics(true, true, true);
-	if(!world->checkCollision() && segmentCollisionFree(intermediatePoints1, config1, midpoint)
-			&& segmentCollisionFree(intermediatePoints2, midpoint, config2))
-	{
-		intermediatePoints.clear();
-		intermediatePoints.splice(intermediatePoints.end(), intermediatePoints1);
-		intermediatePoints.push_back(midpoint);
-		intermediatePoints.splice(intermediatePoints.end(), intermediatePoints2);
-		return true;
+	// Check the intermediate points in bisection order, so that a colliding segment is likely
+	// rejected after a few checks
+	vector<size_t> order;
+	computeBisectionOrder(n, order);
+	for(size_t i = 0; i < order.size(); i++) {
+		const double t = (double)order[i] / (double)n;
+    // TODO(JS): What kinematic values should be updated here?
+    robot->setPositionSegment(dofs, (1.0 - t) * config1 + t * config2);
+    robot->computeForwardKinematics(true, true, true);
+		numCollisionChecks++;
+		if(world->getConstraintSolver()->getCollisionDetector()->checkCollision(robotBodyNodes)) {
+			return false;
+		}
 	}
-	else {
-		return false;
+
+	intermediatePoints.clear();
+	for(int i = 1; i < n; i++) {
+		const double t = (double)i / (double)n;
+		intermediatePoints.push_back((1.0 - t) * config1 + t * config2);
 	}
+	return true;
+}
+
+size_t PathShortener::getNumCollisionChecks() const {
+	return numCollisionChecks;
 }
 
 } // namespace planning
@@ -7,7 +7,7 @@
 namespace dart {
 
 namespace simulation { class World; }
-namespace dynamics { class Skeleton; }
+namespace dynamics { class BodyNode; class Skeleton; }
 
 namespace planning {
 
@@ -19,11 +19,15 @@ public:
 	~PathShortener();
 	virtual void shortenPath(std::list<Eigen::VectorXd> &rawPath);
 	bool segmentCollisionFree(std::list<Eigen::VectorXd> &waypoints, const Eigen::VectorXd &config1, const Eigen::VectorXd &config2);
+	/// Returns the number of collision checks of the last shortenPath() call
+	size_t getNumCollisionChecks() const;
 protected:
 	simulation::World* world;
 	dynamics::Skeleton* robot;
 	std::vector<size_t> dofs;
+	std::vector<dynamics::BodyNode*> robotBodyNodes;
 	double stepSize;
+	size_t numCollisionChecks;
 	virtual bool localPlanner(std::list<Eigen::VectorXd> &waypoints, std::list<Eigen::VectorXd>::const_iterator it1, std::list<Eigen::VectorXd>::const_iterator it2);
 };
 
@@ -42,9 +42,14 @@
  */
 
 #include "RRT.h"
+#include <cmath>
 #include "dart/simulation/World.h"
 #include "dart/dynamics/Skeleton.h"
-#include <flann/flann.hpp>
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/collision/CollisionDetector.h"
+#include "dart/dynamics/DegreeOfFreedom.h"
+#include "dart/dynamics/RevoluteJoint.h"
+#include "dart/math/MathTypes.h"
 
 using namespace std;
 using namespace Eigen;
@@ -63,11 +68,17 @@ RRT::RRT(World* world, Skeleton* robot, const std::vector<size_t> &dofs,
 	world(world),
 	robot(robot),
 	dofs(dofs),
-  index(new flann::Index<flann::L2<double> >(flann::KDTreeSingleIndexParams()))
+	index(dofs.size()),
+	lazy(false),
+	numCollisionChecks(0)
 {
-	// Reset the random number generator and add the given start configuration to the flann structure
-	srand(time(NULL));
+	// Add the given start configuration to the kd-tree
+	initializeMetric();
 	addNode(root, -1);
+
+	// Only the bodies of the robot are checked against the rest of the world
+	for(size_t i = 0; i < robot->getNumBodyNodes(); i++)
+		robotBodyNodes.push_back(robot->getBodyNode(i));
 }
 
 /* ********************************************************************************************* */
@@ -77,13 +88,19 @@ RRT::RRT(World* world, Skeleton* robot, const std::vector<size_t> &dofs, const v
 	world(world),
 	robot(robot),
 	dofs(dofs),
-	index(new flann::Index<flann::L2<double> >(flann::KDTreeSingleIndexParams()))
+	index(dofs.size()),
+	lazy(false),
+	numCollisionChecks(0)
 {
-	// Reset the random number generator and add the given start configurations to the flann structure
-	srand(time(NULL));
+	// Add the given start configurations to the kd-tree
+	initializeMetric();
   for(size_t i = 0; i < roots.size(); i++) {
 		addNode(roots[i], -1);
 	}
+
+	// Only the bodies of the robot are checked against the rest of the world
+	for(size_t i = 0; i < robot->getNumBodyNodes(); i++)
+		robotBodyNodes.push_back(robot->getBodyNode(i));
 }
 
 /* ********************************************************************************************* */
@@ -102,7 +119,7 @@ bool RRT::connect(const VectorXd &target) {
 	StepResult result = STEP_PROGRESS;
 	while(result == STEP_PROGRESS) {
 		result = tryStepFromNode(target, NNidx);
-		NNidx = configVector.size() - 1;
+		NNidx = index.getNumPoints() - 1;
 	}
 	return (result == STEP_REACHED);
 }
@@ -122,14 +139,16 @@ RRT::StepResult RRT::tryStep(const VectorXd &qtry) {
 /* ********************************************************************************************* */
 RRT::StepResult RRT::tryStepFromNode(const VectorXd &qtry, int NNidx) {
 
-	// Get the configuration of the nearest neighbor and check if already reached
-	const VectorXd& qnear = *(configVector[NNidx]);
-	if((qtry - qnear).norm() < stepSize) {
+	// Get the configuration of the nearest neighbor and check if already reached. It is copied
+	// since adding nodes moves the configurations.
+	const VectorXd qnear = getConfig(NNidx);
+	const VectorXd direction = index.getDifference(qtry, qnear);
+	if(direction.norm() < stepSize) {
 		return STEP_REACHED;
 	}
 
 	// Create the new node: scale the direction vector to stepSize and add to qnear
-	VectorXd qnew = qnear + stepSize * (qtry - qnear).normalized();
+	VectorXd qnew = qnear + stepSize * direction.normalized();
 
 	// Check for collision, make changes to the qNew and create intermediate points if necessary
 	// NOTE: This is largely implementation dependent and in default, no points are created.
@@ -147,37 +166,32 @@ RRT::StepResult RRT::tryStepFromNode(const VectorXd &qtry, int NNidx) {
 
 /* ********************************************************************************************* */
 bool RRT::newConfig(list<VectorXd> &intermediatePoints, VectorXd &qnew, const VectorXd &qnear, const VectorXd &qtarget) {
+	if(lazy) return true;
+	numCollisionChecks++;
 	return !checkCollisions(qnew);
 }
 
+/* ********************************************************************************************* */
+bool RRT::newReplicaConfig(list<VectorXd> &intermediatePoints, VectorXd &qnew,
+		const VectorXd &qnear, const VectorXd &qtarget, Skeleton* replica) {
+	numCollisionChecks++;
+	return !checkReplicaCollisions(qnew, replica);
+}
+
 /* ********************************************************************************************* */
 int RRT::addNode(const VectorXd &qnew, int parentId) {
 	
-	// Update the graph vector
-	VectorXd* temp = new VectorXd(qnew);
-	configVector.push_back(temp);
+	// Update the graph vector and the kd-tree, which stores the configuration
 	parentVector.push_back(parentId);
-
-	// Update the underlying flann structure (the kdtree)
-	unsigned int id = configVector.size() - 1;
-	if(id == 0) 
-		index->buildIndex(flann::Matrix<double>((double*)temp->data(), 1, temp->size()));
-	else 
-		index->addPoints(flann::Matrix<double>((double*)temp->data(), 1, temp->size()));
-	
+	validated.push_back(!lazy);
+	int id = index.addPoint(qnew);
 	activeNode = id;
 	return id;
 }
 
 /* ********************************************************************************************* */
-inline int RRT::getNearestNeighbor(const VectorXd &qsamp) {
-	int nearest;
-	double distance;
-	const flann::Matrix<double> queryMatrix((double*)qsamp.data(), 1, qsamp.size());
-	flann::Matrix<int> nearestMatrix(&nearest, 1, 1);
-	flann::Matrix<double> distanceMatrix(flann::Matrix<double>(&distance, 1, 1));
-	index->knnSearch(queryMatrix, nearestMatrix, distanceMatrix, 1, 
-		flann::SearchParams(flann::FLANN_CHECKS_UNLIMITED));
+int RRT::getNearestNeighbor(const VectorXd &qsamp) {
+	int nearest = index.findNearest(qsamp);
 	activeNode = nearest;
 	return nearest;
 }
@@ -189,23 +203,36 @@ inline double RRT::randomInRange(double min, double max) {
 	assert(max - min < numeric_limits<double>::infinity());
 
 	if(min == max) return min;
-	return min + ((max-min) * ((double)rand() / ((double)RAND_MAX + 1)));
+	return std::uniform_real_distribution<double>(min, max)(getRandomGenerator());
+}
+
+/* ********************************************************************************************* */
+std::mt19937& RRT::getRandomGenerator() {
+	static thread_local std::mt19937 generator(std::random_device{}());
+	return generator;
 }
 
 /* ********************************************************************************************* */
 VectorXd RRT::getRandomConfig() {
 	// Samples a random point for qtmp in the configuration space, bounded by the provided 
-	// configuration vectors (and returns ref to it)
+	// configuration vectors (and returns ref to it). Continuous dofs without limits are sampled
+	// over a single turn.
 	VectorXd config(ndim);
 	for (int i = 0; i < ndim; ++i) {
-    config[i] = randomInRange(robot->getPositionLowerLimit(dofs[i]), robot->getPositionUpperLimit(dofs[i]));
+		double lower = robot->getPositionLowerLimit(dofs[i]);
+		double upper = robot->getPositionUpperLimit(dofs[i]);
+		if(index.isCircular(i) && upper - lower == numeric_limits<double>::infinity()) {
+			lower = -DART_PI;
+			upper = DART_PI;
+		}
+		config[i] = randomInRange(lower, upper);
 	}
 	return config;
 }
 
 /* ********************************************************************************************* */
 double RRT::getGap(const VectorXd &target) {
-	return (target - *(configVector[activeNode])).norm();
+	return getDistance(target, getConfig(activeNode));
 }
 
 /* ********************************************************************************************* */
@@ -214,8 +241,8 @@ void RRT::tracePath(int node, std::list<VectorXd> &path, bool reverse) {
 	// Keep following the "linked list" in the given direction
 	int x = node;
 	while(x != -1) {
-		if(!reverse) path.push_front(*(configVector[x]));	
-		else path.push_back(*(configVector[x]));
+		if(!reverse) path.push_front(getConfig(x));
+		else path.push_back(getConfig(x));
 		x = parentVector[x];
 	}
 }
@@ -224,12 +251,195 @@ void RRT::tracePath(int node, std::list<VectorXd> &path, bool reverse) {
 bool RRT::checkCollisions(const VectorXd &c) {
   robot->setPositionSegment(dofs, c);
   robot->computeForwardKinematics(true, false, false);
-	return world->checkCollision();
+	return world->getConstraintSolver()->getCollisionDetector()->checkCollision(robotBodyNodes);
+}
+
+/* ********************************************************************************************* */
+void RRT::setLazy(bool lazy) {
+	this->lazy = lazy;
+}
+
+/* ********************************************************************************************* */
+bool RRT::isLazy() const {
+	return lazy;
+}
+
+/* ********************************************************************************************* */
+bool RRT::validatePath(int node) {
+
+	// Check the nodes that have not been checked yet in bisection order, and prune the tree at the
+	// first colliding node found
+	vector<int> unchecked;
+	getUncheckedNodes(node, unchecked);
+	vector<size_t> order;
+	computeBisectionOrder(unchecked.size() + 1, order);
+	for(size_t i = 0; i < order.size(); i++)
+		if(!validateNode(unchecked[order[i] - 1])) return false;
+	return true;
+}
+
+/* ********************************************************************************************* */
+void RRT::getUncheckedNodes(int node, std::vector<int> &nodes) const {
+	nodes.clear();
+	for(int x = node; x != -1; x = parentVector[x])
+		if(!validated[x]) nodes.push_back(x);
+}
+
+/* ********************************************************************************************* */
+bool RRT::validateNode(int node) {
+	numCollisionChecks++;
+	if(checkCollisions(getConfig(node))) {
+		removeSubtree(node);
+		return false;
+	}
+	validated[node] = true;
+	return true;
+}
+
+/* ********************************************************************************************* */
+void RRT::removeSubtree(int node) {
+
+	// The children are added after their parents, so a single pass finds all the descendants
+	index.removePoint(node);
+	for(size_t i = node + 1; i < parentVector.size(); i++)
+		if(parentVector[i] != -1 && index.isRemoved(parentVector[i])) index.removePoint(i);
+}
+
+/* ********************************************************************************************* */
+size_t RRT::getNumCollisionChecks() const {
+	return numCollisionChecks;
 }
 
 /* ********************************************************************************************* */
 size_t RRT::getSize() {
-	return configVector.size();
+	std::lock_guard<std::mutex> lock(treeMutex);
+	return index.getNumPoints();
+}
+
+/* ********************************************************************************************* */
+Eigen::Map<const VectorXd> RRT::getConfig(int node) const {
+	return index.getPoint(node);
+}
+
+/* ********************************************************************************************* */
+double RRT::getDistance(const VectorXd &config1, const VectorXd &config2) const {
+	return index.getDistance(config1, config2);
+}
+
+/* ********************************************************************************************* */
+VectorXd RRT::getNearestEquivalent(const VectorXd &config, const VectorXd &reference) const {
+	VectorXd equivalent = config;
+	for(int i = 0; i < ndim; i++) {
+		if(index.isCircular(i)) {
+			double turns = std::floor((reference[i] - config[i]) / (2.0 * DART_PI) + 0.5);
+			equivalent[i] += 2.0 * DART_PI * turns;
+		}
+	}
+	return equivalent;
+}
+
+/* ********************************************************************************************* */
+void RRT::initializeMetric() {
+	// A revolute joint with finite limits, even if they span more than a turn, cannot move across
+	// them, so its positions do not wrap around
+	for(int i = 0; i < ndim; i++) {
+		const DegreeOfFreedom* dof = robot->getDof(dofs[i]);
+		double range = dof->getPositionUpperLimit() - dof->getPositionLowerLimit();
+		if(dynamic_cast<const RevoluteJoint*>(dof->getJoint())
+				&& range == numeric_limits<double>::infinity())
+			index.setCircular(i, true);
+	}
+}
+
+/* ********************************************************************************************* */
+void RRT::setReplicas(const std::vector<Skeleton*> &replicas) {
+	this->replicas = replicas;
+
+	// The replicas start from the configuration of the robot so that the dofs the planner does not
+	// manipulate match
+	Eigen::VectorXd positions = robot->getPositions();
+	for(size_t i = 0; i < replicas.size(); i++) {
+		assert(replicas[i]->getNumDofs() == robot->getNumDofs());
+		replicas[i]->setPositions(positions);
+		replicas[i]->computeForwardKinematics(true, false, false);
+	}
+
+	// The collision pairs are built once so that the threads only read the collision detector
+	world->getConstraintSolver()->getCollisionDetector()->buildReplicaQuery(robotBodyNodes, robot,
+		&replicaQuery);
+}
+
+/* ********************************************************************************************* */
+const std::vector<Skeleton*>& RRT::getReplicas() const {
+	return replicas;
+}
+
+/* ********************************************************************************************* */
+RRT::StepResult RRT::extend(const VectorXd &target, bool connect, Skeleton* replica,
+		int &lastNode, VectorXd &lastConfig) {
+
+	// Copy the configuration of the nearest neighbor since other threads may add nodes meanwhile
+	int NNidx;
+	VectorXd qnear;
+	{
+		std::lock_guard<std::mutex> lock(treeMutex);
+		NNidx = getNearestNeighbor(target);
+		qnear = getConfig(NNidx);
+	}
+	lastNode = NNidx;
+	lastConfig = qnear;
+
+	// Keep taking steps towards the target until it is reached or a collision happens. Only one
+	// step is taken if not connecting.
+	while(true) {
+		VectorXd direction = index.getDifference(target, qnear);
+		if(direction.norm() < stepSize)
+			return STEP_REACHED;
+
+		VectorXd qnew = qnear + stepSize * direction.normalized();
+		list<VectorXd> intermediatePoints;
+		if(!newReplicaConfig(intermediatePoints, qnew, qnear, target, replica))
+			return STEP_COLLISION;
+
+		{
+			std::lock_guard<std::mutex> lock(treeMutex);
+			list<VectorXd>::iterator it = intermediatePoints.begin();
+			for(; it != intermediatePoints.end(); it++)
+				NNidx = addNode(*it, NNidx);
+			NNidx = addNode(qnew, NNidx);
+		}
+		lastNode = NNidx;
+		lastConfig = qnew;
+		if(!connect)
+			return STEP_PROGRESS;
+		qnear = qnew;
+	}
+}
+
+/* ********************************************************************************************* */
+bool RRT::checkReplicaCollisions(const VectorXd &c, Skeleton* replica) {
+	replica->setPositionSegment(dofs, c);
+	replica->computeForwardKinematics(true, false, false);
+	return world->getConstraintSolver()->getCollisionDetector()->checkCollision(replicaQuery,
+		replica);
+}
+
+/* ********************************************************************************************* */
+void computeBisectionOrder(size_t numSegments, std::vector<size_t> &order) {
+
+	// Split the intervals breadth first, so that each level of midpoints is checked before the next
+	order.clear();
+	vector<pair<size_t, size_t> > intervals(1, make_pair(0, numSegments));
+	for(size_t i = 0; i < intervals.size(); i++) {
+		size_t lower = intervals[i].first;
+		size_t upper = intervals[i].second;
+		if(upper - lower < 2) continue;
+
+		size_t middle = (lower + upper) / 2;
+		order.push_back(middle);
+		intervals.push_back(make_pair(lower, middle));
+		intervals.push_back(make_pair(middle, upper));
+	}
 }
 
 } // namespace planning
@@ -43,19 +43,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <list>
+#include <mutex>
+#include <random>
 #include <Eigen/Core>
-
-namespace flann {
-	template <class A> class L2;
-	template <class A> class Index;
-}
+#include "dart/collision/CollisionDetector.h"
+#include "dart/planning/KdTree.h"
 
 namespace dart {
 
 namespace simulation { class World; }
-namespace dynamics { class Skeleton; }
+namespace dynamics { class BodyNode; class Skeleton; }
 
 namespace planning {
 
@@ -80,12 +80,7 @@ public:
 	const double stepSize;	///< Step size at each node creation
 
 	int activeNode;	 								///< Last added node or the nearest node found after a search
-	std::vector<int> parentVector;		///< The ith node in configVector has parent with index pV[i]
-
-	/// All visited configs
-	// NOTE We are using pointers for the VectorXd's because flann copies the pointers for the
-	// data points and we give it the copies made in the heap
-	std::vector<const Eigen::VectorXd*> configVector; 	
+	std::vector<int> parentVector;		///< The ith node has parent with index pV[i]
 
 public:
 
@@ -119,10 +114,19 @@ public:
 	/// Checks if the given new configuration is in collision with an obstacle. Moreover, it is a
 	/// an opportunity for child classes to change the new configuration if there is a need. For 
 	/// instance, task constrained planners might want to sample around this point and replace it with
-	/// a better (less erroroneous due to constraint) node.
+	/// a better (less erroroneous due to constraint) node. In lazy mode, the default implementation
+	/// leaves the check to validatePath(). Parallel planning calls newReplicaConfig() instead, so
+	/// child classes that override this should override both.
 	virtual bool newConfig(std::list<Eigen::VectorXd> &intermediatePoints, Eigen::VectorXd &qnew, 
 			const Eigen::VectorXd &qnear, const Eigen::VectorXd &qtarget);
 
+	/// The counterpart of newConfig() that extend() calls, which several threads call at the same
+	/// time with their own replicas of the robot. The default implementation checks the new
+	/// configuration with checkReplicaCollisions().
+	virtual bool newReplicaConfig(std::list<Eigen::VectorXd> &intermediatePoints,
+			Eigen::VectorXd &qnew, const Eigen::VectorXd &qnear, const Eigen::VectorXd &qtarget,
+			dynamics::Skeleton* replica);
+
 	/// Returns the distance between the current active node and the given node.
 	/// TODO This might mislead the users to thinking returning the distance between the given target
 	/// and the nearest neighbor.
@@ -135,20 +139,97 @@ public:
 	/// Returns the number of nodes in the tree.
 	size_t getSize();
 
+	/// Returns the configuration of the given node, which is invalidated when a node is added
+	Eigen::Map<const Eigen::VectorXd> getConfig(int node) const;
+
+	/// Returns the distance between two configurations, where the dofs of continuous revolute
+	/// joints take the shorter way around
+	double getDistance(const Eigen::VectorXd &config1, const Eigen::VectorXd &config2) const;
+
+	/// Returns the given configuration shifted by whole turns in the dofs of continuous revolute
+	/// joints so that it is nearest to the reference configuration. The paths of two trees that
+	/// meet across pi are joined with this.
+	Eigen::VectorXd getNearestEquivalent(const Eigen::VectorXd &config,
+			const Eigen::VectorXd &reference) const;
+
 	/// Implementation-specific function for checking collisions 
 	virtual bool checkCollisions(const Eigen::VectorXd &c);
 
+	/// Sets whether the collisions of new nodes are checked only once the nodes are on a candidate
+	/// path, by validatePath(). The nodes that already are in the tree are not affected.
+	void setLazy(bool lazy);
+
+	/// Returns true if the collisions of new nodes are checked only on candidate paths
+	bool isLazy() const;
+
+	/// Checks the nodes on the path from the given node to the root that have not been checked yet,
+	/// in bisection order so that a colliding path is likely rejected after a few checks. Returns
+	/// true if none of them collides. Otherwise, the colliding node found first is removed from the
+	/// tree with its descendants.
+	bool validatePath(int node);
+
+	/// Collects the nodes on the path from the given node to the root that have not been checked
+	/// yet, starting from the given node
+	void getUncheckedNodes(int node, std::vector<int> &nodes) const;
+
+	/// Checks the given node, which has not been checked yet. Returns true if it does not collide.
+	/// Otherwise, the node is removed from the tree with its descendants.
+	bool validateNode(int node);
+
+	/// Returns the number of collision checks made for the tree
+	size_t getNumCollisionChecks() const;
+
 	/// Returns a random configuration with the specified node IDs 
 	virtual Eigen::VectorXd getRandomConfig();
 
+	/// Returns the random number generator of the calling thread, which getRandomConfig() and the
+	/// planners draw from, so that the threads of parallel planning do not share a generator
+	static std::mt19937& getRandomGenerator();
+
+	/// Sets the replicas of the robot that the threads of parallel planning move to check collisions,
+	/// one per thread. Each replica must have the same structure as the robot, for instance loaded
+	/// from the same file, and must not be in the world.
+	void setReplicas(const std::vector<dynamics::Skeleton*> &replicas);
+
+	/// Returns the replicas of the robot for parallel planning
+	const std::vector<dynamics::Skeleton*>& getReplicas() const;
+
+	/// Reach for (or take a single step towards) the target from the nearest neighbor in the tree.
+	/// This is the counterpart of connect() and tryStep() that several threads can call at the same
+	/// time: the tree is locked only to find the nearest neighbor and to add nodes, and the new
+	/// configurations are checked by newReplicaConfig() with the given replica. Sets lastNode and
+	/// lastConfig to the last added node, or to the nearest neighbor if no node was added.
+	StepResult extend(const Eigen::VectorXd &target, bool connect, dynamics::Skeleton* replica,
+			int &lastNode, Eigen::VectorXd &lastConfig);
+
+	/// Implementation-specific function for checking collisions of a replica of the robot, which
+	/// several threads call at the same time with their own replicas
+	virtual bool checkReplicaCollisions(const Eigen::VectorXd &c, dynamics::Skeleton* replica);
+
 protected:
 
 	simulation::World* world;                 ///< The world that the robot is in
 	dynamics::Skeleton* robot;        ///< The ID of the robot for which a plan is generated
 	std::vector<size_t> dofs;                    ///< The dofs of the robot the planner can manipulate
+	std::vector<dynamics::BodyNode*> robotBodyNodes; ///< The bodies of the robot checked for collisions
+	std::vector<dynamics::Skeleton*> replicas;  ///< The replicas of the robot for parallel planning
+	collision::ReplicaQuery replicaQuery;        ///< The pairs checked for collisions of the replicas
+	std::mutex treeMutex;                        ///< Guards the tree while several threads extend it
+
+	/// The configurations of the nodes, stored contiguously in a kd-tree for fast nearest neighbor
+	/// searches. The dofs of continuous revolute joints wrap around.
+	KdTree index;
+
+	bool lazy;                                   ///< Whether new nodes are checked on candidate paths
+	std::vector<bool> validated;                 ///< Whether each node is known to be collision free
+	std::atomic<size_t> numCollisionChecks;      ///< The number of collision checks for the tree
 
-	/// The underlying flann data structure for fast nearest neighbor searches 
-	flann::Index<flann::L2<double> >* index;
+	/// Removes the given node and its descendants from the nearest neighbor searches
+	void removeSubtree(int node);
+
+	/// Marks the dofs of continuous revolute joints, which have no position limits, as circular in
+	/// the metric of the index
+	void initializeMetric();
 
 	/// Returns a random value between the given minimum and maximum value
 	double randomInRange(double min, double max);
@@ -160,5 +241,11 @@ protected:
 	virtual int addNode(const Eigen::VectorXd &qnew, int parentId);
 };
 
+/// Returns the samples 1, ..., numSegments - 1 of a segment divided into numSegments pieces in
+/// bisection order: the midpoint first, then the midpoints of the two halves and so on. This is the
+/// van der Corput order if numSegments is a power of two, and checking the samples in this order
+/// finds a colliding part of the segment after a few checks.
+void computeBisectionOrder(size_t numSegments, std::vector<size_t> &order);
+
 } // namespace planning
 } // namespace dart
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/simulation/RangeSensor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "dart/common/Console.h"
+#include "dart/math/Helpers.h"
+#include "dart/dynamics/Frame.h"
+
+namespace dart {
+namespace simulation {
+
+//==============================================================================
+RangeSensor::RangeSensor(dynamics::Frame* _frame)
+  : mFrame(_frame),
+    mNumRows(1),
+    mNumColumns(360),
+    mMinAzimuth(-DART_PI),
+    mMaxAzimuth(DART_PI * 179.0 / 180.0),
+    mMinElevation(0.0),
+    mMaxElevation(0.0),
+    mMaxRange(10.0)
+{
+  updateDirections();
+}
+
+//==============================================================================
+RangeSensor::~RangeSensor()
+{
+}
+
+//==============================================================================
+void RangeSensor::setFrame(dynamics::Frame* _frame)
+{
+  mFrame = _frame;
+}
+
+//==============================================================================
+dynamics::Frame* RangeSensor::getFrame() const
+{
+  return mFrame;
+}
+
+//==============================================================================
+void RangeSensor::setResolution(size_t _numRows, size_t _numColumns)
+{
+  if (_numRows == 0 || _numColumns == 0)
+  {
+    dtwarn << "Attempting to set an empty grid of rays. Using a single ray "
+           << "instead.\n";
+    _numRows = std::max(_numRows, static_cast<size_t>(1));
+    _numColumns = std::max(_numColumns, static_cast<size_t>(1));
+  }
+
+  mNumRows = _numRows;
+  mNumColumns = _numColumns;
+  updateDirections();
+}
+
+//==============================================================================
+size_t RangeSensor::getNumRows() const
+{
+  return mNumRows;
+}
+
+//==============================================================================
+size_t RangeSensor::getNumColumns() const
+{
+  return mNumColumns;
+}
+
+//==============================================================================
+void RangeSensor::setAzimuthRange(double _minAzimuth, double _maxAzimuth)
+{
+  mMinAzimuth = _minAzimuth;
+  mMaxAzimuth = _maxAzimuth;
+  updateDirections();
+}
+
+//==============================================================================
+void RangeSensor::setElevationRange(double _minElevation, double _maxElevation)
+{
+  mMinElevation = _minElevation;
+  mMaxElevation = _maxElevation;
+  updateDirections();
+}
+
+//==============================================================================
+void RangeSensor::setMaxRange(double _maxRange)
+{
+  assert(_maxRange > 0.0 && "Invalid maximum range.");
+
+  mMaxRange = _maxRange;
+}
+
+//==============================================================================
+double RangeSensor::getMaxRange() const
+{
+  return mMaxRange;
+}
+
+//==============================================================================
+const std::vector<Eigen::Vector3d>& RangeSensor::getDirections() const
+{
+  return mDirections;
+}
+
+//==============================================================================
+void RangeSensor::scan(collision::RayCaster* _rayCaster)
+{
+  assert(_rayCaster != NULL);
+  assert(mFrame != NULL);
+
+  const Eigen::Isometry3d& transform = mFrame->getWorldTransform();
+
+  mWorldDirections.resize(mDirections.size());
+  for (size_t i = 0; i < mDirections.size(); ++i)
+    mWorldDirections[i] = transform.linear() * mDirections[i];
+
+  _rayCaster->castRays(transform.translation(), mWorldDirections, mMaxRange,
+                       &mHits);
+}
+
+//==============================================================================
+const std::vector<collision::RayHit>& RangeSensor::getHits() const
+{
+  return mHits;
+}
+
+//==============================================================================
+const collision::RayHit& RangeSensor::getHit(size_t _row,
+                                             size_t _column) const
+{
+  assert(_row < mNumRows && _column < mNumColumns);
+  assert(mHits.size() == mNumRows * mNumColumns && "Not scanned yet.");
+
+  return mHits[_row * mNumColumns + _column];
+}
+
+//==============================================================================
+Eigen::MatrixXd RangeSensor::getRanges() const
+{
+  Eigen::MatrixXd ranges
+      = Eigen::MatrixXd::Constant(mNumRows, mNumColumns, mMaxRange);
+  for (size_t i = 0; i < mHits.size(); ++i)
+    ranges(i / mNumColumns, i % mNumColumns) = mHits[i].distance;
+
+  return ranges;
+}
+
+//==============================================================================
+void RangeSensor::updateDirections()
+{
+  mDirections.resize(mNumRows * mNumColumns);
+  mHits.clear();
+
+  for (size_t i = 0; i < mNumRows; ++i)
+  {
+    const double elevation = mNumRows > 1
+        ? mMinElevation + (mMaxElevation - mMinElevation) * i / (mNumRows - 1)
+        : 0.5 * (mMinElevation + mMaxElevation);
+
+    for (size_t j = 0; j < mNumColumns; ++j)
+    {
+      const double azimuth = mNumColumns > 1
+          ? mMinAzimuth + (mMaxAzimuth - mMinAzimuth) * j / (mNumColumns - 1)
+          : 0.5 * (mMinAzimuth + mMaxAzimuth);
+
+      mDirections[i * mNumColumns + j]
+          = Eigen::Vector3d(std::cos(elevation) * std::cos(azimuth),
+                            std::cos(elevation) * std::sin(azimuth),
+                            std::sin(elevation));
+    }
+  }
+}
+
+}  // namespace simulation
+}  // namespace dart
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_SIMULATION_RANGESENSOR_H_
+#define DART_SIMULATION_RANGESENSOR_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/collision/RayCaster.h"
+
+namespace dart {
+namespace dynamics {
+class Frame;
+}  // namespace dynamics
+}  // namespace dart
+
+namespace dart {
+namespace simulation {
+
+/// RangeSensor casts a grid of rays from a Frame, such as a BodyNode or a
+/// SimpleFrame, and stores the hits of the last scan. The ray of row i and
+/// column j points at the i-th elevation and the j-th azimuth of the grid
+/// w.r.t. the frame, where the azimuth is measured from the x-axis about the
+/// z-axis and the elevation from the xy-plane. The frame must outlive the
+/// sensor.
+class RangeSensor
+{
+public:
+  /// Constructor. The default sensor is a planar scanner of 360 rays over the
+  /// full circle with a maximum range of 10.
+  explicit RangeSensor(dynamics::Frame* _frame);
+
+  /// Destructor
+  virtual ~RangeSensor();
+
+  /// Set the frame that carries the sensor
+  void setFrame(dynamics::Frame* _frame);
+
+  /// Get the frame that carries the sensor
+  dynamics::Frame* getFrame() const;
+
+  /// Set the number of rows and columns of the grid of rays
+  void setResolution(size_t _numRows, size_t _numColumns);
+
+  /// Get the number of rows of the grid of rays
+  size_t getNumRows() const;
+
+  /// Get the number of columns of the grid of rays
+  size_t getNumColumns() const;
+
+  /// Set the azimuths of the first and the last columns
+  void setAzimuthRange(double _minAzimuth, double _maxAzimuth);
+
+  /// Set the elevations of the first and the last rows
+  void setElevationRange(double _minElevation, double _maxElevation);
+
+  /// Set the maximum range of the rays
+  void setMaxRange(double _maxRange);
+
+  /// Get the maximum range of the rays
+  double getMaxRange() const;
+
+  /// Get the directions of the rays w.r.t. the frame in row-major order
+  const std::vector<Eigen::Vector3d>& getDirections() const;
+
+  /// Cast the rays from the current transform of the frame
+  void scan(collision::RayCaster* _rayCaster);
+
+  /// Get the hits of the last scan in row-major order
+  const std::vector<collision::RayHit>& getHits() const;
+
+  /// Get the hit of the ray of row _row and column _column in the last scan
+  const collision::RayHit& getHit(size_t _row, size_t _column) const;
+
+  /// Get the distances of the last scan, which are the maximum range where the
+  /// rays did not hit anything
+  Eigen::MatrixXd getRanges() const;
+
+protected:
+  /// Compute the directions of the rays from the grid
+  void updateDirections();
+
+  /// Frame that carries the sensor
+  dynamics::Frame* mFrame;
+
+  /// Number of rows of the grid
+  size_t mNumRows;
+
+  /// Number of columns of the grid
+  size_t mNumColumns;
+
+  /// Azimuth of the first column
+  double mMinAzimuth;
+
+  /// Azimuth of the last column
+  double mMaxAzimuth;
+
+  /// Elevation of the first row
+  double mMinElevation;
+
+  /// Elevation of the last row
+  double mMaxElevation;
+
+  /// Maximum range of the rays
+  double mMaxRange;
+
+  /// Directions of the rays w.r.t. the frame
+  std::vector<Eigen::Vector3d> mDirections;
+
+  /// Directions of the rays w.r.t. the world frame
+  std::vector<Eigen::Vector3d> mWorldDirections;
+
+  /// Hits of the last scan
+  std::vector<collision::RayHit> mHits;
+};
+
+}  // namespace simulation
+}  // namespace dart
+
+#endif  // DART_SIMULATION_RANGESENSOR_H_
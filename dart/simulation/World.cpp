@@ -42,6 +42,7 @@
 
 #include "dart/simulation/World.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -50,6 +51,8 @@
 #include "dart/integration/SemiImplicitEulerIntegrator.h"
 #include "dart/dynamics/Skeleton.h"
 #include "dart/constraint/ConstraintSolver.h"
+#include "dart/collision/RayCaster.h"
+#include "dart/simulation/RangeSensor.h"
 
 namespace dart {
 namespace simulation {
@@ -59,11 +62,13 @@ World::World()
   : mNameMgrForSkeletons("skeleton"),
     mGravity(0.0, 0.0, -9.81),
     mTimeStep(0.001),
+    mNumThreads(1),
     mTime(0.0),
     mFrame(0),
     mIntegrator(NULL),
     mConstraintSolver(new constraint::ConstraintSolver(mTimeStep)),
-    mRecording(new Recording(mSkeletons))
+    mRecording(new Recording(mSkeletons)),
+    mRayCaster(new collision::RayCaster())
 {
   mIndices.push_back(0);
 }
@@ -73,6 +78,7 @@ World::~World()
 {
   delete mConstraintSolver;
   delete mRecording;
+  delete mRayCaster;
 
   for (std::vector<dynamics::Skeleton*>::const_iterator it = mSkeletons.begin();
        it != mSkeletons.end(); ++it)
@@ -102,6 +108,27 @@ double World::getTimeStep() const
   return mTimeStep;
 }
 
+//==============================================================================
+void World::setNumThreads(size_t _numThreads)
+{
+  if (_numThreads == 0)
+  {
+    dtwarn << "Attempting to set the number of threads to zero. Using a single "
+           << "thread instead.\n";
+    _numThreads = 1;
+  }
+
+  mNumThreads = _numThreads;
+  mConstraintSolver->setNumThreads(mNumThreads);
+  mRayCaster->setNumThreads(mNumThreads);
+}
+
+//==============================================================================
+size_t World::getNumThreads() const
+{
+  return mNumThreads;
+}
+
 //==============================================================================
 void World::reset()
 {
@@ -113,9 +140,22 @@ void World::reset()
 //==============================================================================
 void World::step(bool _resetCommand)
 {
+  // The skeletons don't share any state in the per-skeleton phases below, so
+  // they can be processed by several threads in any order.
+  const int numSkeletons = static_cast<int>(mSkeletons.size());
+#ifdef _OPENMP
+  const int numThreads = static_cast<int>(mNumThreads);
+#endif
+
   // Integrate velocity for unconstrained skeletons
-  for (auto& skel : mSkeletons)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numSkeletons; ++i)
   {
+    dynamics::Skeleton* skel = mSkeletons[i];
+
     if (!skel->isMobile())
       continue;
 
@@ -127,8 +167,14 @@ void World::step(bool _resetCommand)
   mConstraintSolver->solve();
 
   // Compute velocity changes given constraint impulses
-  for (auto& skel : mSkeletons)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) if(numThreads > 1) \
+  schedule(dynamic)
+#endif
+  for (int i = 0; i < numSkeletons; ++i)
   {
+    dynamics::Skeleton* skel = mSkeletons[i];
+
     if (!skel->isMobile())
       continue;
 
@@ -151,6 +197,9 @@ void World::step(bool _resetCommand)
 
   mTime += mTimeStep;
   mFrame++;
+
+  for (size_t i = 0; i < mSensors.size(); ++i)
+    mSensors[i]->scan(mRayCaster);
 }
 
 //==============================================================================
@@ -234,6 +283,7 @@ std::string World::addSkeleton(dynamics::Skeleton* _skeleton)
   _skeleton->init(mTimeStep, mGravity);
   mIndices.push_back(mIndices.back() + _skeleton->getNumDofs());
   mConstraintSolver->addSkeleton(_skeleton);
+  mRayCaster->addSkeleton(_skeleton);
 
   // Update recording
   mRecording->updateNumGenCoords(mSkeletons);
@@ -270,6 +320,7 @@ void World::withdrawSkeleton(dynamics::Skeleton *_skeleton)
 
   // Remove _skeleton from constraint handler.
   mConstraintSolver->removeSkeleton(_skeleton);
+  mRayCaster->removeSkeleton(_skeleton);
 
   // Remove _skeleton in mSkeletons and delete it.
   mSkeletons.erase(remove(mSkeletons.begin(), mSkeletons.end(), _skeleton),
@@ -458,5 +509,49 @@ Recording* World::getRecording()
   return mRecording;
 }
 
+//==============================================================================
+collision::RayCaster* World::getRayCaster() const
+{
+  return mRayCaster;
+}
+
+//==============================================================================
+void World::addSensor(RangeSensor* _sensor)
+{
+  assert(_sensor != NULL && "Attempted to add NULL sensor to world.");
+
+  if (std::find(mSensors.begin(), mSensors.end(), _sensor) != mSensors.end())
+  {
+    dtwarn << "Sensor is already in the world.\n";
+    return;
+  }
+
+  mSensors.push_back(_sensor);
+}
+
+//==============================================================================
+void World::removeSensor(RangeSensor* _sensor)
+{
+  std::vector<RangeSensor*>::iterator it
+      = std::find(mSensors.begin(), mSensors.end(), _sensor);
+  if (it != mSensors.end())
+    mSensors.erase(it);
+}
+
+//==============================================================================
+RangeSensor* World::getSensor(size_t _index) const
+{
+  if (_index < mSensors.size())
+    return mSensors[_index];
+
+  return NULL;
+}
+
+//==============================================================================
+size_t World::getNumSensors() const
+{
+  return mSensors.size();
+}
+
 }  // namespace simulation
 }  // namespace dart
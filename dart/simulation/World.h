@@ -69,8 +69,14 @@ namespace constraint {
 class ConstraintSolver;
 }  // namespace constraint
 
+namespace collision {
+class RayCaster;
+}  // namespace collision
+
 namespace simulation {
 
+class RangeSensor;
+
 /// class World
 class World
 {
@@ -101,6 +107,17 @@ public:
   /// Get time step
   double getTimeStep() const;
 
+  /// Set the number of threads used to step the skeletons, to solve the
+  /// constrained groups and to cast the rays of the sensors in parallel. All
+  /// of them are independent per skeleton, per group and per ray respectively,
+  /// so the result does not depend on the number of threads. The default is 1
+  /// (serial stepping). Values larger than 1 have no effect unless DART is
+  /// built with OpenMP.
+  void setNumThreads(size_t _numThreads);
+
+  /// Get the number of threads used to step the world
+  size_t getNumThreads() const;
+
   //--------------------------------------------------------------------------
   // Structural Properties
   //--------------------------------------------------------------------------
@@ -199,6 +216,26 @@ public:
   /// Get recording
   Recording* getRecording();
 
+  //--------------------------------------------------------------------------
+  // Sensors
+  //--------------------------------------------------------------------------
+
+  /// Get the ray caster over the collision shapes of the skeletons
+  collision::RayCaster* getRayCaster() const;
+
+  /// Add a sensor that scans at the end of every step. The world does not
+  /// take the ownership of the sensor.
+  void addSensor(RangeSensor* _sensor);
+
+  /// Remove a sensor from this world without deleting it
+  void removeSensor(RangeSensor* _sensor);
+
+  /// Get the indexed sensor
+  RangeSensor* getSensor(size_t _index) const;
+
+  /// Get the number of sensors
+  size_t getNumSensors() const;
+
 protected:
   /// Skeletones in this world
   std::vector<dynamics::Skeleton*> mSkeletons;
@@ -224,6 +261,9 @@ protected:
   /// Simulation time step
   double mTimeStep;
 
+  /// Number of threads used to step the skeletons
+  size_t mNumThreads;
+
   /// Current simulation time
   double mTime;
 
@@ -239,6 +279,12 @@ protected:
 
   ///
   Recording* mRecording;
+
+  /// Ray caster over the collision shapes of mSkeletons
+  collision::RayCaster* mRayCaster;
+
+  /// Sensors that scan at the end of every step
+  std::vector<RangeSensor*> mSensors;
 };
 
 }  // namespace simulation
@@ -34,7 +34,9 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdio>
 #include <iostream>
+#include <set>
 #include <gtest/gtest.h>
 
 #include <fcl/collision.h>
@@ -45,10 +47,21 @@
 #include "dart/common/common.h"
 #include "dart/math/math.h"
 #include "dart/dynamics/dynamics.h"
+#include "dart/collision/ContactReducer.h"
+#include "dart/collision/ConvexDecomposition.h"
+#include "dart/collision/RayCaster.h"
+#include "dart/collision/dart/DARTCollide.h"
+#include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/collision/fcl/FCLCollisionDetector.h"
+#include "dart/collision/fcl/FCLMeshCache.h"
+#include "dart/collision/fcl_mesh/FCLMeshCollisionDetector.h"
+#include "dart/collision/fcl_mesh/FCLMeshCollisionNode.h"
 //#include "dart/collision/unc/UNCCollisionDetector.h"
 #include "dart/simulation/simulation.h"
 #include "dart/utils/utils.h"
 
+#include "TestHelpers.h"
+
 using namespace dart;
 using namespace math;
 //using namespace collision;
@@ -586,6 +599,1272 @@ TEST_F(COLLISION, CollisionOfPrescribedJoints)
   }
 }
 
+//==============================================================================
+TEST_F(COLLISION, DARTBroadphase)
+{
+  typedef std::set<std::pair<BodyNode*, BodyNode*> > BodyNodePairs;
+
+  // Scatter boxes and spheres so that only some of them overlap
+  std::vector<Skeleton*> skeletons;
+  collision::DARTCollisionDetector* detector
+      = new collision::DARTCollisionDetector();
+  for (size_t i = 0; i < 40; ++i)
+  {
+    Eigen::Vector3d position(random(-1.5, 1.5), random(-1.5, 1.5),
+                             random(-1.5, 1.5));
+    Eigen::Vector3d orientation(random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI));
+
+    if (i % 2 == 0)
+      skeletons.push_back(createBox(Eigen::Vector3d::Constant(0.5), position,
+                                    orientation));
+    else
+      skeletons.push_back(createSphere(0.3, position));
+
+    detector->addSkeleton(skeletons.back());
+  }
+
+  for (size_t frame = 0; frame < 10; ++frame)
+  {
+    detector->detectCollision(true, true);
+
+    BodyNodePairs detected;
+    for (size_t i = 0; i < detector->getNumContacts(); ++i)
+    {
+      const collision::Contact& contact = detector->getContact(i);
+      detected.insert(std::make_pair(contact.bodyNode1, contact.bodyNode2));
+    }
+
+    // The broadphase must not miss any pair that the narrowphase reports
+    BodyNodePairs expected;
+    std::vector<collision::Contact> contacts;
+    for (size_t i = 0; i < skeletons.size(); ++i)
+    {
+      BodyNode* bodyNode1 = skeletons[i]->getBodyNode(0);
+      for (size_t j = i + 1; j < skeletons.size(); ++j)
+      {
+        BodyNode* bodyNode2 = skeletons[j]->getBodyNode(0);
+
+        contacts.clear();
+        collision::collide(bodyNode1->getCollisionShape(0),
+                           bodyNode1->getTransform(),
+                           bodyNode2->getCollisionShape(0),
+                           bodyNode2->getTransform(),
+                           &contacts);
+        if (!contacts.empty())
+          expected.insert(std::make_pair(bodyNode1, bodyNode2));
+      }
+    }
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_TRUE(detected == expected);
+
+    // Move the bodies a little to exercise the incremental sorting
+    for (size_t i = 0; i < skeletons.size(); ++i)
+    {
+      Eigen::VectorXd positions = skeletons[i]->getPositions();
+      positions.tail<3>() += Eigen::Vector3d(random(-0.2, 0.2),
+                                             random(-0.2, 0.2),
+                                             random(-0.2, 0.2));
+      skeletons[i]->setPositions(positions);
+      skeletons[i]->computeForwardKinematics(true, false, false);
+    }
+  }
+
+  delete detector;
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+void testParallelNarrowphase(collision::CollisionDetector* _detector)
+{
+  // Scatter boxes and spheres so that many of them overlap
+  std::vector<Skeleton*> skeletons;
+  for (size_t i = 0; i < 60; ++i)
+  {
+    Eigen::Vector3d position(random(-1.0, 1.0), random(-1.0, 1.0),
+                             random(-1.0, 1.0));
+    Eigen::Vector3d orientation(random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI));
+
+    if (i % 2 == 0)
+      skeletons.push_back(createBox(Eigen::Vector3d::Constant(0.5), position,
+                                    orientation));
+    else
+      skeletons.push_back(createSphere(0.3, position));
+
+    _detector->addSkeleton(skeletons.back());
+  }
+
+  _detector->setNumThreads(1);
+  _detector->detectCollision(true, true);
+  std::vector<collision::Contact> serialContacts;
+  for (size_t i = 0; i < _detector->getNumContacts(); ++i)
+    serialContacts.push_back(_detector->getContact(i));
+  EXPECT_FALSE(serialContacts.empty());
+
+  // The contacts are the same and in the same order for any number of threads
+  for (size_t numThreads = 2; numThreads <= 4; ++numThreads)
+  {
+    // Mark the transforms stale so that the detector evaluates them again
+    for (size_t i = 0; i < skeletons.size(); ++i)
+      skeletons[i]->setPositions(skeletons[i]->getPositions());
+
+    _detector->setNumThreads(numThreads);
+    _detector->detectCollision(true, true);
+
+    ASSERT_EQ(_detector->getNumContacts(), serialContacts.size());
+    for (size_t i = 0; i < serialContacts.size(); ++i)
+    {
+      const collision::Contact& contact = _detector->getContact(i);
+      EXPECT_EQ(contact.bodyNode1, serialContacts[i].bodyNode1);
+      EXPECT_EQ(contact.bodyNode2, serialContacts[i].bodyNode2);
+      EXPECT_TRUE(contact.point == serialContacts[i].point);
+      EXPECT_TRUE(contact.normal == serialContacts[i].normal);
+      EXPECT_EQ(contact.penetrationDepth,
+                serialContacts[i].penetrationDepth);
+    }
+  }
+
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, PairCache)
+{
+  typedef std::set<std::pair<BodyNode*, BodyNode*> > BodyNodePairs;
+
+  // Scatter boxes, spheres and cylinders so that many bounding boxes overlap
+  std::vector<Skeleton*> skeletons;
+  collision::DARTCollisionDetector* detector
+      = new collision::DARTCollisionDetector();
+  for (size_t i = 0; i < 60; ++i)
+  {
+    Eigen::Vector3d position(random(-1.5, 1.5), random(-1.5, 1.5),
+                             random(-1.5, 1.5));
+    Eigen::Vector3d orientation(random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI),
+                                random(-DART_PI, DART_PI));
+
+    if (i % 3 == 0)
+    {
+      skeletons.push_back(createBox(Eigen::Vector3d(0.6, 0.4, 0.2), position,
+                                    orientation));
+    }
+    else if (i % 3 == 1)
+    {
+      skeletons.push_back(createSphere(0.3, position));
+    }
+    else
+    {
+      Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+      T.translation() = position;
+      T.linear() = eulerXYZToMatrix(orientation);
+      FreeJoint* joint = new FreeJoint("joint1");
+      joint->setPositions(logMap(T));
+
+      BodyNode* bodyNode = new BodyNode("link1");
+      bodyNode->addCollisionShape(new CylinderShape(0.2, 0.5));
+      bodyNode->setParentJoint(joint);
+
+      Skeleton* skeleton = new Skeleton();
+      skeleton->addBodyNode(bodyNode);
+      skeleton->init();
+      skeletons.push_back(skeleton);
+    }
+
+    detector->addSkeleton(skeletons.back());
+  }
+
+  // Nothing is skipped without a previous narrowphase
+  detector->detectCollision(true, true);
+  EXPECT_EQ(detector->getNumSkippedPairs(), 0u);
+
+  // Pairs that were separated are skipped while nothing moves
+  detector->detectCollision(true, true);
+  EXPECT_GT(detector->getNumSkippedPairs(), 0u);
+
+  size_t numSkippedPairs = 0;
+  for (size_t frame = 0; frame < 20; ++frame)
+  {
+    // Move the bodies slowly
+    for (size_t i = 0; i < skeletons.size(); ++i)
+    {
+      Eigen::VectorXd positions = skeletons[i]->getPositions();
+      for (int j = 0; j < 6; ++j)
+        positions[j] += random(-0.01, 0.01);
+      skeletons[i]->setPositions(positions);
+      skeletons[i]->computeForwardKinematics(true, false, false);
+    }
+
+    detector->detectCollision(true, true);
+    numSkippedPairs += detector->getNumSkippedPairs();
+
+    BodyNodePairs detected;
+    for (size_t i = 0; i < detector->getNumContacts(); ++i)
+    {
+      const collision::Contact& contact = detector->getContact(i);
+      detected.insert(std::make_pair(contact.bodyNode1, contact.bodyNode2));
+    }
+
+    // Skipping never misses a colliding pair
+    BodyNodePairs expected;
+    std::vector<collision::Contact> contacts;
+    for (size_t i = 0; i < skeletons.size(); ++i)
+    {
+      BodyNode* bodyNode1 = skeletons[i]->getBodyNode(0);
+      for (size_t j = i + 1; j < skeletons.size(); ++j)
+      {
+        BodyNode* bodyNode2 = skeletons[j]->getBodyNode(0);
+
+        contacts.clear();
+        collision::collide(bodyNode1->getCollisionShape(0),
+                           bodyNode1->getTransform(),
+                           bodyNode2->getCollisionShape(0),
+                           bodyNode2->getTransform(),
+                           &contacts);
+        if (!contacts.empty())
+          expected.insert(std::make_pair(bodyNode1, bodyNode2));
+      }
+    }
+
+    EXPECT_TRUE(detected == expected);
+  }
+  EXPECT_GT(numSkippedPairs, 0u);
+
+  delete detector;
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, ParallelNarrowphase)
+{
+  collision::DARTCollisionDetector* dartDetector
+      = new collision::DARTCollisionDetector();
+  testParallelNarrowphase(dartDetector);
+  delete dartDetector;
+
+  collision::FCLCollisionDetector* fclDetector
+      = new collision::FCLCollisionDetector();
+  testParallelNarrowphase(fclDetector);
+  delete fclDetector;
+
+  collision::FCLMeshCollisionDetector* fclMeshDetector
+      = new collision::FCLMeshCollisionDetector();
+  testParallelNarrowphase(fclMeshDetector);
+  delete fclMeshDetector;
+}
+
+//==============================================================================
+void testFCLBroadphase(collision::CollisionDetector* _detector)
+{
+  // Boxes on a grid far apart from each other, except for the first two
+  std::vector<Skeleton*> skeletons;
+  for (size_t i = 0; i < 16; ++i)
+  {
+    Eigen::Vector3d position(2.0 * (i % 4), 2.0 * (i / 4), 0.0);
+    if (i == 1)
+      position = Eigen::Vector3d(0.3, 0.0, 0.0);
+
+    skeletons.push_back(createBox(Eigen::Vector3d::Constant(0.5), position));
+    _detector->addSkeleton(skeletons.back());
+  }
+
+  BodyNode* bodyNode0 = skeletons[0]->getBodyNode(0);
+  BodyNode* bodyNode1 = skeletons[1]->getBodyNode(0);
+  BodyNode* bodyNode2 = skeletons[2]->getBodyNode(0);
+
+  EXPECT_TRUE(_detector->detectCollision(true, true));
+  EXPECT_GT(_detector->getNumContacts(), 0u);
+  for (size_t i = 0; i < _detector->getNumContacts(); ++i)
+  {
+    const collision::Contact& contact = _detector->getContact(i);
+    EXPECT_TRUE(contact.bodyNode1 == bodyNode0
+                || contact.bodyNode1 == bodyNode1);
+    EXPECT_TRUE(contact.bodyNode2 == bodyNode0
+                || contact.bodyNode2 == bodyNode1);
+  }
+
+  // Excluded pairs are filtered out by the broadphase
+  _detector->disablePair(bodyNode0, bodyNode1);
+  EXPECT_FALSE(_detector->detectCollision(true, true));
+  _detector->enablePair(bodyNode0, bodyNode1);
+
+  // The broadphase follows the bodies as they move
+  Eigen::VectorXd positions = skeletons[2]->getPositions();
+  positions.tail<3>() = Eigen::Vector3d(0.0, 0.3, 0.0);
+  skeletons[2]->setPositions(positions);
+  skeletons[2]->computeForwardKinematics(true, false, false);
+  EXPECT_TRUE(_detector->detectCollision(true, true));
+  EXPECT_TRUE(bodyNode2->isColliding());
+
+  // Removed bodies leave the broadphase
+  _detector->removeSkeleton(skeletons[1]);
+  _detector->removeSkeleton(skeletons[2]);
+  EXPECT_FALSE(_detector->detectCollision(true, true));
+
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, FCLBroadphase)
+{
+  collision::FCLCollisionDetector* fclDetector
+      = new collision::FCLCollisionDetector();
+  testFCLBroadphase(fclDetector);
+  delete fclDetector;
+
+  collision::FCLMeshCollisionDetector* fclMeshDetector
+      = new collision::FCLMeshCollisionDetector();
+  testFCLBroadphase(fclMeshDetector);
+  delete fclMeshDetector;
+}
+
+//==============================================================================
+TEST_F(COLLISION, FCLMeshCache)
+{
+  const aiScene* mesh
+      = MeshShape::loadMesh(DART_DATA_PATH"obj/BoxSmall.obj");
+  ASSERT_TRUE(mesh != NULL);
+  size_t numMeshes = collision::FCLMeshCache::getNumMeshes();
+
+  // Copies of a body share the BVH model of the mesh
+  std::vector<Skeleton*> skeletons;
+  collision::FCLCollisionDetector* detector
+      = new collision::FCLCollisionDetector();
+  for (size_t i = 0; i < 10; ++i)
+  {
+    BodyNode* node = new BodyNode("link1");
+    node->addCollisionShape(new MeshShape(Eigen::Vector3d::Ones(), mesh));
+    node->setParentJoint(new FreeJoint("joint1"));
+
+    Skeleton* skeleton = new Skeleton();
+    skeleton->addBodyNode(node);
+    skeleton->init();
+
+    skeletons.push_back(skeleton);
+    detector->addSkeleton(skeleton);
+  }
+  EXPECT_EQ(collision::FCLMeshCache::getNumMeshes(), numMeshes + 1);
+
+  // A different scale needs its own BVH model
+  boost::shared_ptr<collision::FCLMeshCache::Model> scaledModel
+      = collision::FCLMeshCache::getMesh(mesh, Eigen::Vector3d::Constant(2.0));
+  EXPECT_EQ(collision::FCLMeshCache::getNumMeshes(), numMeshes + 2);
+  EXPECT_TRUE(scaledModel == collision::FCLMeshCache::getMesh(
+                mesh, Eigen::Vector3d::Constant(2.0)));
+  scaledModel.reset();
+
+  // The models are freed with the last collision nodes that use them
+  delete detector;
+  EXPECT_EQ(collision::FCLMeshCache::getNumMeshes(), numMeshes);
+
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, FCLSoftMeshUpdate)
+{
+  World* world = SkelParser::readWorld(DART_DATA_PATH"skel/soft_cubes.skel");
+  ASSERT_TRUE(world != NULL);
+
+  SoftBodyNode* softBodyNode = NULL;
+  for (size_t i = 0; i < world->getNumSkeletons() && !softBodyNode; ++i)
+  {
+    if (world->getSkeleton(i)->getNumSoftBodyNodes() > 0)
+      softBodyNode = world->getSkeleton(i)->getSoftBodyNode(0);
+  }
+  ASSERT_TRUE(softBodyNode != NULL);
+
+  size_t shapeIndex = softBodyNode->getNumCollisionShapes();
+  for (size_t i = 0; i < softBodyNode->getNumCollisionShapes(); ++i)
+  {
+    if (softBodyNode->getCollisionShape(i)->getShapeType()
+        == Shape::SOFT_MESH)
+      shapeIndex = i;
+  }
+  ASSERT_LT(shapeIndex, softBodyNode->getNumCollisionShapes());
+  const Eigen::Isometry3d& shapeTransform
+      = softBodyNode->getCollisionShape(shapeIndex)->getLocalTransform();
+
+  // The vertices of the soft mesh model follow the deformed point masses,
+  // which are shared by the triangles
+  collision::FCLMeshCollisionNode node(softBodyNode);
+  fcl::BVHModel<fcl::OBBRSS>* model = node.mMeshes[shapeIndex];
+  EXPECT_EQ(static_cast<size_t>(model->num_vertices),
+            softBodyNode->getNumPointMasses());
+  EXPECT_EQ(static_cast<size_t>(model->num_tris),
+            softBodyNode->getNumFaces());
+
+  for (size_t i = 0; i < softBodyNode->getNumPointMasses(); ++i)
+  {
+    softBodyNode->getPointMass(i)->setPositions(
+          Eigen::Vector3d(random(-0.01, 0.01), random(-0.01, 0.01),
+                          random(-0.01, 0.01)));
+  }
+  softBodyNode->getSkeleton()->computeForwardKinematics(true, false, false);
+  node.updateShape();
+
+  for (size_t i = 0; i < softBodyNode->getNumPointMasses(); ++i)
+  {
+    Eigen::Vector3d expected
+        = shapeTransform * softBodyNode->getPointMass(i)->getLocalPosition();
+    for (int j = 0; j < 3; ++j)
+      EXPECT_NEAR(model->vertices[i][j], expected[j], 1e-12);
+  }
+
+  delete world;
+}
+
+//==============================================================================
+TEST_F(COLLISION, ContactReducer)
+{
+  collision::ContactReducer reducer;
+
+  // Removing duplicates gives the same contacts as comparing all the pairs
+  std::vector<collision::Contact> contacts(300);
+  for (size_t i = 0; i < contacts.size(); ++i)
+  {
+    contacts[i].point = Eigen::Vector3d(random(-0.05, 0.05),
+                                        random(-0.05, 0.05),
+                                        random(-0.05, 0.05));
+    contacts[i].penetrationDepth = static_cast<double>(i);
+  }
+  std::vector<collision::Contact> expected;
+  for (size_t i = 0; i < contacts.size(); ++i)
+  {
+    bool isDuplicate = false;
+    for (size_t j = i + 1; j < contacts.size(); ++j)
+    {
+      Eigen::Vector3d diff = contacts[i].point - contacts[j].point;
+      if (diff.dot(diff) < 1e-4)
+      {
+        isDuplicate = true;
+        break;
+      }
+    }
+    if (!isDuplicate)
+      expected.push_back(contacts[i]);
+  }
+  reducer.removeDuplicateContacts(&contacts, 0, 1e-2);
+  ASSERT_EQ(contacts.size(), expected.size());
+  EXPECT_LT(contacts.size(), 300u);
+  for (size_t i = 0; i < contacts.size(); ++i)
+    EXPECT_EQ(contacts[i].penetrationDepth, expected[i].penetrationDepth);
+
+  // Limiting a grid of contacts keeps the deepest contact and the corners
+  contacts.resize(1);
+  contacts[0].penetrationDepth = -1.0;
+  for (int i = 0; i < 5; ++i)
+  {
+    for (int j = 0; j < 5; ++j)
+    {
+      collision::Contact contact;
+      contact.point = Eigen::Vector3d(i, j, 0.0);
+      contact.normal = Eigen::Vector3d::UnitZ();
+      contact.penetrationDepth = (i == 2 && j == 2) ? 0.1 : 0.01;
+      contacts.push_back(contact);
+    }
+  }
+  reducer.limitContacts(&contacts, 1, 5);
+  ASSERT_EQ(contacts.size(), 6u);
+  EXPECT_EQ(contacts[0].penetrationDepth, -1.0);
+  std::set<std::pair<int, int> > corners;
+  bool hasDeepest = false;
+  for (size_t i = 1; i < contacts.size(); ++i)
+  {
+    if (contacts[i].penetrationDepth == 0.1)
+    {
+      hasDeepest = true;
+      continue;
+    }
+    corners.insert(std::make_pair(static_cast<int>(contacts[i].point[0]),
+                                  static_cast<int>(contacts[i].point[1])));
+  }
+  EXPECT_TRUE(hasDeepest);
+  EXPECT_EQ(corners.size(), 4u);
+  EXPECT_TRUE(corners.count(std::make_pair(0, 0)) == 1);
+  EXPECT_TRUE(corners.count(std::make_pair(0, 4)) == 1);
+  EXPECT_TRUE(corners.count(std::make_pair(4, 0)) == 1);
+  EXPECT_TRUE(corners.count(std::make_pair(4, 4)) == 1);
+
+  // The detector limits the contacts of each body pair
+  collision::DARTCollisionDetector* detector
+      = new collision::DARTCollisionDetector();
+  Skeleton* box1 = createBox(Eigen::Vector3d(1.0, 1.0, 0.1),
+                             Eigen::Vector3d::Zero());
+  Skeleton* box2 = createBox(Eigen::Vector3d(0.5, 0.5, 0.1),
+                             Eigen::Vector3d(0.0, 0.0, 0.09),
+                             Eigen::Vector3d(0.0, 0.0, 0.3));
+  detector->addSkeleton(box1);
+  detector->addSkeleton(box2);
+
+  detector->detectCollision(true, true);
+  size_t numContacts = detector->getNumContacts();
+  EXPECT_GT(numContacts, 2u);
+
+  detector->setNumMaxContactsPerPair(2);
+  detector->detectCollision(true, true);
+  EXPECT_EQ(detector->getNumContacts(), 2u);
+
+  delete detector;
+  delete box1;
+  delete box2;
+}
+
+//==============================================================================
+typedef std::set<std::pair<BodyNode*, BodyNode*> > BodyNodePairs;
+
+BodyNodePairs getCollidingPairs(collision::CollisionDetector* _detector)
+{
+  BodyNodePairs pairs;
+  for (size_t i = 0; i < _detector->getNumContacts(); ++i)
+  {
+    const collision::Contact& contact = _detector->getContact(i);
+    pairs.insert(std::make_pair(contact.bodyNode1, contact.bodyNode2));
+  }
+  return pairs;
+}
+
+//==============================================================================
+TEST_F(COLLISION, CollisionFilter)
+{
+  // Three overlapping spheres
+  std::vector<Skeleton*> skeletons;
+  std::vector<BodyNode*> bodyNodes;
+  collision::DARTCollisionDetector* detector
+      = new collision::DARTCollisionDetector();
+  for (size_t i = 0; i < 3; ++i)
+  {
+    skeletons.push_back(createSphere(0.3, Eigen::Vector3d(0.1 * i, 0.0, 0.0)));
+    bodyNodes.push_back(skeletons.back()->getBodyNode(0));
+    detector->addSkeleton(skeletons.back());
+  }
+
+  detector->detectCollision(true, true);
+  BodyNodePairs pairs = getCollidingPairs(detector);
+  EXPECT_EQ(pairs.size(), 3u);
+
+  // The second sphere only collides with the third one
+  detector->setCollisionFilter(bodyNodes[0], 0x1, ~0u);
+  detector->setCollisionFilter(bodyNodes[1], 0x2, 0x4);
+  detector->setCollisionFilter(bodyNodes[2], 0x4, ~0u);
+  detector->detectCollision(true, true);
+  pairs = getCollidingPairs(detector);
+  EXPECT_EQ(pairs.size(), 2u);
+  EXPECT_TRUE(pairs.count(std::make_pair(bodyNodes[0], bodyNodes[1])) == 0);
+
+  // Pair exceptions override the categories and masks
+  detector->enablePair(bodyNodes[0], bodyNodes[1]);
+  detector->disablePair(bodyNodes[2], bodyNodes[0]);
+  detector->detectCollision(true, true);
+  pairs = getCollidingPairs(detector);
+  EXPECT_EQ(pairs.size(), 2u);
+  EXPECT_TRUE(pairs.count(std::make_pair(bodyNodes[0], bodyNodes[1])) == 1);
+  EXPECT_TRUE(pairs.count(std::make_pair(bodyNodes[0], bodyNodes[2])) == 0);
+
+  detector->resetPair(bodyNodes[0], bodyNodes[1]);
+  detector->resetPair(bodyNodes[0], bodyNodes[2]);
+  detector->detectCollision(true, true);
+  pairs = getCollidingPairs(detector);
+  EXPECT_EQ(pairs.size(), 2u);
+  EXPECT_TRUE(pairs.count(std::make_pair(bodyNodes[0], bodyNodes[2])) == 1);
+
+  // Removing a body node removes its pair exceptions
+  detector->disablePair(bodyNodes[1], bodyNodes[2]);
+  detector->removeSkeleton(skeletons[1]);
+  detector->addSkeleton(skeletons[1]);
+  EXPECT_TRUE(detector->detectCollision(true, true));
+  pairs = getCollidingPairs(detector);
+  EXPECT_EQ(pairs.size(), 3u);
+
+  delete detector;
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+void testCheckCollision(collision::CollisionDetector* _detector)
+{
+  // The first sphere is queried, and the other two overlap each other
+  std::vector<Skeleton*> skeletons;
+  skeletons.push_back(createSphere(0.3, Eigen::Vector3d(-2.0, 0.0, 0.0)));
+  skeletons.push_back(createSphere(0.3, Eigen::Vector3d(0.0, 0.0, 0.0)));
+  skeletons.push_back(createSphere(0.3, Eigen::Vector3d(0.4, 0.0, 0.0)));
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    _detector->addSkeleton(skeletons[i]);
+
+  std::vector<BodyNode*> bodyNodes(1, skeletons[0]->getBodyNode(0));
+  EXPECT_TRUE(_detector->detectCollision(false, false));
+  EXPECT_FALSE(_detector->checkCollision(bodyNodes));
+
+  // Moving the queried sphere into the second one
+  Eigen::VectorXd positions = skeletons[0]->getPositions();
+  positions.tail<3>() = Eigen::Vector3d(-0.4, 0.0, 0.0);
+  skeletons[0]->setPositions(positions);
+  skeletons[0]->computeForwardKinematics(true, false, false);
+  EXPECT_TRUE(_detector->checkCollision(bodyNodes));
+  EXPECT_TRUE(_detector->checkCollision(bodyNodes));
+
+  // The cached results of the second sphere are discarded when it moves
+  positions = skeletons[1]->getPositions();
+  positions.tail<3>() = Eigen::Vector3d(0.0, 2.0, 0.0);
+  skeletons[1]->setPositions(positions);
+  skeletons[1]->computeForwardKinematics(true, false, false);
+  EXPECT_FALSE(_detector->checkCollision(bodyNodes));
+
+  // Queried body nodes are checked against each other too
+  bodyNodes.push_back(skeletons[1]->getBodyNode(0));
+  EXPECT_FALSE(_detector->checkCollision(bodyNodes));
+  positions.tail<3>() = Eigen::Vector3d(-0.6, 0.0, 0.0);
+  skeletons[1]->setPositions(positions);
+  skeletons[1]->computeForwardKinematics(true, false, false);
+  EXPECT_TRUE(_detector->checkCollision(bodyNodes));
+
+  // Removed body nodes are no longer checked
+  _detector->removeSkeleton(skeletons[1]);
+  EXPECT_FALSE(_detector->checkCollision(bodyNodes));
+
+  for (size_t i = 0; i < skeletons.size(); ++i)
+    delete skeletons[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, CheckCollision)
+{
+  collision::DARTCollisionDetector* dartDetector
+      = new collision::DARTCollisionDetector();
+  testCheckCollision(dartDetector);
+  delete dartDetector;
+
+  collision::FCLCollisionDetector* fclDetector
+      = new collision::FCLCollisionDetector();
+  testCheckCollision(fclDetector);
+  delete fclDetector;
+}
+
+//==============================================================================
+void testComputeDistances(collision::CollisionDetector* _detector)
+{
+  // Batched distances between a moving box and a fixed box
+  Skeleton* movingBox = createBox(Eigen::Vector3d::Ones());
+  Skeleton* fixedBox = createBox(Eigen::Vector3d::Ones(),
+                                 Eigen::Vector3d(3.0, 0.0, 0.0));
+  _detector->addSkeleton(movingBox);
+  _detector->addSkeleton(fixedBox);
+
+  collision::DistanceResult result;
+  EXPECT_TRUE(_detector->computeDistance(movingBox->getBodyNode(0),
+                                         fixedBox->getBodyNode(0), &result));
+  EXPECT_NEAR(result.distance, 2.0, 1e-6);
+  EXPECT_NEAR((result.point2 - result.point1).norm(), 2.0, 1e-6);
+
+  std::vector<Skeleton*> replicas;
+  for (size_t i = 0; i < 3; ++i)
+    replicas.push_back(createBox(Eigen::Vector3d::Ones()));
+
+  std::vector<Eigen::VectorXd> configurations;
+  for (size_t i = 0; i < 50; ++i)
+  {
+    Eigen::VectorXd configuration = Eigen::VectorXd::Zero(6);
+    configuration[3] = -2.0 + 0.1 * i;
+    configurations.push_back(configuration);
+  }
+
+  std::vector<std::pair<BodyNode*, BodyNode*> > pairs;
+  pairs.push_back(std::make_pair(movingBox->getBodyNode(0),
+                                 fixedBox->getBodyNode(0)));
+
+  // Evaluated with a replica of the moving box per thread, and with the moving
+  // box itself
+  _detector->setNumThreads(3);
+  for (size_t k = 0; k < 2; ++k)
+  {
+    std::vector<collision::DistanceResult> results;
+    _detector->computeDistances(
+        movingBox, k == 0 ? replicas : std::vector<Skeleton*>(),
+        configurations, pairs, &results);
+    ASSERT_EQ(results.size(), configurations.size());
+    for (size_t i = 0; i < configurations.size(); ++i)
+    {
+      EXPECT_EQ(results[i].bodyNode1, movingBox->getBodyNode(0));
+      EXPECT_EQ(results[i].bodyNode2, fixedBox->getBodyNode(0));
+
+      double gap = 2.0 - configurations[i][3];
+      if (gap > 1e-6)
+        EXPECT_NEAR(results[i].distance, gap, 1e-6);
+      else
+        EXPECT_LE(results[i].distance, 1e-6);
+    }
+
+    // The moving box is left at its own configuration
+    EXPECT_TRUE(movingBox->getPositions().isZero());
+    EXPECT_TRUE(_detector->computeDistance(movingBox->getBodyNode(0),
+                                           fixedBox->getBodyNode(0), &result));
+    EXPECT_NEAR(result.distance, 2.0, 1e-6);
+  }
+
+  _detector->removeSkeleton(movingBox);
+  _detector->removeSkeleton(fixedBox);
+  delete movingBox;
+  delete fixedBox;
+  for (size_t i = 0; i < replicas.size(); ++i)
+    delete replicas[i];
+}
+
+//==============================================================================
+TEST_F(COLLISION, Distance)
+{
+  BoxShape box(Eigen::Vector3d::Ones());
+  EllipsoidShape sphere(Eigen::Vector3d::Constant(0.6));
+  CylinderShape cylinder(0.5, 1.0);
+  Eigen::Isometry3d T0 = Eigen::Isometry3d::Identity();
+  Eigen::Isometry3d T1 = Eigen::Isometry3d::Identity();
+  double distance;
+  Eigen::Vector3d point0;
+  Eigen::Vector3d point1;
+
+  // Box-box
+  T1.translation() = Eigen::Vector3d(3.0, 0.2, -0.1);
+  EXPECT_TRUE(collision::distance(&box, T0, &box, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_NEAR(distance, 2.0, 1e-6);
+  EXPECT_NEAR(point0[0], 0.5, 1e-6);
+  EXPECT_NEAR(point1[0], 2.5, 1e-6);
+  EXPECT_NEAR((point1 - point0).norm(), distance, 1e-6);
+
+  // Box-box rotated about the z-axis so that an edge faces the other box
+  T1.linear() = Eigen::AngleAxisd(0.25 * DART_PI,
+                                  Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  T1.translation() = Eigen::Vector3d(3.0, 0.0, 0.0);
+  EXPECT_TRUE(collision::distance(&box, T0, &box, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_NEAR(distance, 2.5 - 0.5 * std::sqrt(2.0), 1e-6);
+
+  // Sphere-sphere in arbitrary directions
+  for (size_t i = 0; i < 20; ++i)
+  {
+    T0 = Eigen::Isometry3d::Identity();
+    T1 = Eigen::Isometry3d::Identity();
+    T0.translation() = Eigen::Vector3d(random(-2.0, 2.0), random(-2.0, 2.0),
+                                       random(-2.0, 2.0));
+    T1.translation() = Eigen::Vector3d(random(-2.0, 2.0), random(-2.0, 2.0),
+                                       random(-2.0, 2.0));
+    double expected = (T1.translation() - T0.translation()).norm() - 0.6;
+    if (expected < 0.01)
+      continue;
+
+    EXPECT_TRUE(collision::distance(&sphere, T0, &sphere, T1,
+                                    &distance, &point0, &point1));
+    EXPECT_NEAR(distance, expected, 1e-6);
+  }
+
+  // Cylinder-sphere above the cap and beside the side
+  T0 = Eigen::Isometry3d::Identity();
+  T1 = Eigen::Isometry3d::Identity();
+  T1.translation() = Eigen::Vector3d(0.1, 0.0, 2.0);
+  EXPECT_TRUE(collision::distance(&cylinder, T0, &sphere, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_NEAR(distance, 2.0 - 0.5 - 0.3, 1e-6);
+  T1.translation() = Eigen::Vector3d(0.0, 2.0, 0.1);
+  EXPECT_TRUE(collision::distance(&cylinder, T0, &sphere, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_NEAR(distance, 2.0 - 0.5 - 0.3, 1e-6);
+
+  // Intersecting shapes
+  T1.translation() = Eigen::Vector3d(0.0, 0.5, 0.0);
+  EXPECT_TRUE(collision::distance(&cylinder, T0, &sphere, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_EQ(distance, 0.0);
+
+  // Batched distances with every detector
+  collision::DARTCollisionDetector* dartDetector
+      = new collision::DARTCollisionDetector();
+  testComputeDistances(dartDetector);
+  delete dartDetector;
+
+  collision::FCLCollisionDetector* fclDetector
+      = new collision::FCLCollisionDetector();
+  testComputeDistances(fclDetector);
+  delete fclDetector;
+
+  collision::FCLMeshCollisionDetector* fclMeshDetector
+      = new collision::FCLMeshCollisionDetector();
+  testComputeDistances(fclMeshDetector);
+  delete fclMeshDetector;
+}
+
+//==============================================================================
+TEST_F(COLLISION, RayCaster)
+{
+  // A box, a sphere, a cylinder and a ground plane around the origin
+  Skeleton* box = createBox(Eigen::Vector3d::Ones(),
+                            Eigen::Vector3d(2.0, 0.0, 0.0));
+  Skeleton* sphere = createSphere(0.5, Eigen::Vector3d(0.0, 3.0, 0.0));
+
+  BodyNode* cylinderNode = new BodyNode("cylinder");
+  cylinderNode->addCollisionShape(new CylinderShape(0.5, 1.0));
+  cylinderNode->setParentJoint(new WeldJoint("joint1"));
+  cylinderNode->getParentJoint()->setTransformFromParentBodyNode(
+        Eigen::Isometry3d(Eigen::Translation3d(-4.0, 0.0, 0.0)));
+  Skeleton* cylinder = new Skeleton();
+  cylinder->addBodyNode(cylinderNode);
+  cylinder->init();
+
+  BodyNode* groundNode = new BodyNode("ground");
+  groundNode->addCollisionShape(
+        new PlaneShape(Eigen::Vector3d::UnitZ(), Eigen::Vector3d(0, 0, -1)));
+  groundNode->setParentJoint(new WeldJoint("joint1"));
+  Skeleton* ground = new Skeleton();
+  ground->addBodyNode(groundNode);
+  ground->init();
+
+  collision::RayCaster rayCaster;
+  rayCaster.addSkeleton(box);
+  rayCaster.addSkeleton(sphere);
+  rayCaster.addSkeleton(cylinder);
+  rayCaster.addSkeleton(ground);
+
+  collision::RayHit hit;
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                Eigen::Vector3d::UnitX(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 1.5, 1e-9);
+  EXPECT_TRUE(equals(hit.point, Eigen::Vector3d(1.5, 0.0, 0.0)));
+  EXPECT_TRUE(equals(hit.normal, Eigen::Vector3d(-1.0, 0.0, 0.0)));
+  EXPECT_EQ(hit.bodyNode, box->getBodyNode(0));
+
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                Eigen::Vector3d::UnitY(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.5, 1e-9);
+  EXPECT_TRUE(equals(hit.normal, Eigen::Vector3d(0.0, -1.0, 0.0)));
+  EXPECT_EQ(hit.bodyNode, sphere->getBodyNode(0));
+
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                -Eigen::Vector3d::UnitX(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 3.5, 1e-9);
+  EXPECT_EQ(hit.bodyNode, cylinderNode);
+
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                -Eigen::Vector3d::UnitZ(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 1.0, 1e-9);
+  EXPECT_TRUE(equals(hit.normal, Eigen::Vector3d(0.0, 0.0, 1.0)));
+  EXPECT_EQ(hit.bodyNode, groundNode);
+
+  // Nothing within the maximum distance
+  EXPECT_FALSE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                 Eigen::Vector3d::UnitZ(), 10.0, &hit));
+  EXPECT_EQ(hit.distance, 10.0);
+  EXPECT_TRUE(hit.bodyNode == NULL);
+  EXPECT_FALSE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                 Eigen::Vector3d::UnitX(), 1.0, &hit));
+
+  // The box that contains the origin of the ray is ignored
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d(2.0, 0.0, 0.0),
+                                -Eigen::Vector3d::UnitX(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 5.5, 1e-9);
+  EXPECT_EQ(hit.bodyNode, cylinderNode);
+
+  // The caster follows the skeletons
+  Eigen::VectorXd positions = box->getPositions();
+  positions[3] = 3.0;
+  box->setPositions(positions);
+  box->computeForwardKinematics(true, false, false);
+  EXPECT_TRUE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                Eigen::Vector3d::UnitX(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.5, 1e-9);
+
+  rayCaster.removeSkeleton(box);
+  EXPECT_FALSE(rayCaster.castRay(Eigen::Vector3d::Zero(),
+                                 Eigen::Vector3d::UnitX(), 10.0, &hit));
+
+  // A mesh of a box agrees with the box shape
+  const aiScene* mesh
+      = MeshShape::loadMesh(DART_DATA_PATH"obj/BoxSmall.obj");
+  ASSERT_TRUE(mesh != NULL);
+  BodyNode* meshNode = new BodyNode("mesh");
+  meshNode->addCollisionShape(
+        new MeshShape(Eigen::Vector3d::Constant(25.0), mesh));
+  meshNode->setParentJoint(new WeldJoint("joint1"));
+  Skeleton* meshBox = new Skeleton();
+  meshBox->addBodyNode(meshNode);
+  meshBox->init();
+
+  collision::RayCaster boxCaster;
+  boxCaster.addSkeleton(box);
+  positions.setZero();
+  box->setPositions(positions);
+  box->computeForwardKinematics(true, false, false);
+  collision::RayCaster meshCaster;
+  meshCaster.addSkeleton(meshBox);
+
+  std::vector<Eigen::Vector3d> origins;
+  std::vector<Eigen::Vector3d> directions;
+  for (size_t i = 0; i < 500; ++i)
+  {
+    origins.push_back(Eigen::Vector3d(random(-3.0, 3.0), random(-3.0, 3.0),
+                                      random(-3.0, 3.0)));
+    Eigen::Vector3d target(random(-0.6, 0.6), random(-0.6, 0.6),
+                           random(-0.6, 0.6));
+    directions.push_back((target - origins.back()).normalized());
+  }
+
+  std::vector<collision::RayHit> boxHits;
+  std::vector<collision::RayHit> meshHits;
+  boxCaster.castRays(origins, directions, 10.0, &boxHits);
+  meshCaster.castRays(origins, directions, 10.0, &meshHits);
+  ASSERT_EQ(boxHits.size(), origins.size());
+  ASSERT_EQ(meshHits.size(), origins.size());
+  size_t numHits = 0;
+  for (size_t i = 0; i < origins.size(); ++i)
+  {
+    if (std::abs(origins[i].maxCoeff()) <= 0.5
+        && std::abs(origins[i].minCoeff()) <= 0.5)
+      continue;
+
+    EXPECT_EQ(boxHits[i].isHit, meshHits[i].isHit);
+    if (boxHits[i].isHit && meshHits[i].isHit)
+    {
+      EXPECT_NEAR(boxHits[i].distance, meshHits[i].distance, 1e-6);
+      EXPECT_NEAR(boxHits[i].normal.dot(meshHits[i].normal), 1.0, 1e-6);
+      EXPECT_EQ(meshHits[i].bodyNode, meshNode);
+      ++numHits;
+    }
+  }
+  EXPECT_GT(numHits, 0u);
+
+  // Batches of rays give the same hits for any number of threads
+  rayCaster.addSkeleton(box);
+  rayCaster.addSkeleton(meshBox);
+  std::vector<collision::RayHit> serialHits;
+  rayCaster.castRays(origins, directions, 10.0, &serialHits);
+  for (size_t numThreads = 2; numThreads <= 4; ++numThreads)
+  {
+    std::vector<collision::RayHit> hits;
+    rayCaster.setNumThreads(numThreads);
+    rayCaster.castRays(origins, directions, 10.0, &hits);
+    ASSERT_EQ(hits.size(), serialHits.size());
+    for (size_t i = 0; i < hits.size(); ++i)
+    {
+      EXPECT_EQ(hits[i].isHit, serialHits[i].isHit);
+      EXPECT_EQ(hits[i].distance, serialHits[i].distance);
+      EXPECT_EQ(hits[i].bodyNode, serialHits[i].bodyNode);
+    }
+  }
+
+  // A soft box follows the deformation of its point masses
+  SoftBodyNode* softNode = new SoftBodyNode("soft");
+  SoftBodyNodeHelper::setBox(softNode, Eigen::Vector3d::Ones(),
+                             Eigen::Isometry3d::Identity(),
+                             Eigen::Vector3i(3, 3, 3), 1.0);
+  softNode->addCollisionShape(new SoftMeshShape(softNode));
+  softNode->setParentJoint(new WeldJoint("joint1"));
+  softNode->getParentJoint()->setTransformFromParentBodyNode(
+        Eigen::Isometry3d(Eigen::Translation3d(0.0, -3.0, 0.0)));
+  Skeleton* softBox = new Skeleton();
+  softBox->addBodyNode(softNode);
+  softBox->init();
+
+  collision::RayCaster softCaster;
+  softCaster.addSkeleton(softBox);
+  EXPECT_TRUE(softCaster.castRay(Eigen::Vector3d::Zero(),
+                                 -Eigen::Vector3d::UnitY(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.5, 1e-9);
+  EXPECT_EQ(hit.bodyNode, softNode);
+  EXPECT_FALSE(softCaster.castRay(Eigen::Vector3d(0.8, 0.0, 0.0),
+                                  -Eigen::Vector3d::UnitY(), 10.0, &hit));
+
+  // Inflating the box to twice its size moves the faces out of the bounding
+  // boxes of the hierarchy that was built for the resting box
+  for (size_t i = 0; i < softNode->getNumPointMasses(); ++i)
+  {
+    PointMass* pointMass = softNode->getPointMass(i);
+    pointMass->setPositions(pointMass->getRestingPosition());
+  }
+  softBox->computeForwardKinematics(true, false, false);
+  EXPECT_TRUE(softCaster.castRay(Eigen::Vector3d::Zero(),
+                                 -Eigen::Vector3d::UnitY(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.0, 1e-9);
+  EXPECT_TRUE(softCaster.castRay(Eigen::Vector3d(0.8, 0.0, 0.0),
+                                 -Eigen::Vector3d::UnitY(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.0, 1e-9);
+  EXPECT_EQ(hit.bodyNode, softNode);
+
+  // The point masses are w.r.t. the body frame, so the local transform of the
+  // soft mesh shape doesn't move the soft box
+  SoftBodyNode* offsetNode = new SoftBodyNode("offset soft");
+  SoftBodyNodeHelper::setBox(offsetNode, Eigen::Vector3d::Ones(),
+                             Eigen::Isometry3d::Identity(),
+                             Eigen::Vector3i(3, 3, 3), 1.0);
+  SoftMeshShape* offsetShape = new SoftMeshShape(offsetNode);
+  offsetShape->setLocalTransform(
+        Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, 2.0)));
+  offsetNode->addCollisionShape(offsetShape);
+  offsetNode->setParentJoint(new WeldJoint("joint1"));
+  offsetNode->getParentJoint()->setTransformFromParentBodyNode(
+        Eigen::Isometry3d(Eigen::Translation3d(0.0, -3.0, 0.0)));
+  Skeleton* offsetSoftBox = new Skeleton();
+  offsetSoftBox->addBodyNode(offsetNode);
+  offsetSoftBox->init();
+
+  collision::RayCaster offsetCaster;
+  offsetCaster.addSkeleton(offsetSoftBox);
+  EXPECT_TRUE(offsetCaster.castRay(Eigen::Vector3d::Zero(),
+                                   -Eigen::Vector3d::UnitY(), 10.0, &hit));
+  EXPECT_NEAR(hit.distance, 2.5, 1e-9);
+  EXPECT_EQ(hit.bodyNode, offsetNode);
+  EXPECT_FALSE(offsetCaster.castRay(Eigen::Vector3d(0.0, 0.0, 2.0),
+                                    -Eigen::Vector3d::UnitY(), 10.0, &hit));
+
+  delete box;
+  delete sphere;
+  delete cylinder;
+  delete ground;
+  delete meshBox;
+  delete softBox;
+  delete offsetSoftBox;
+}
+
+//==============================================================================
+TEST_F(COLLISION, ConvexDecomposition)
+{
+  // Random points lie inside their convex hull, which is a closed surface
+  std::vector<Eigen::Vector3d> points;
+  for (size_t i = 0; i < 200; ++i)
+  {
+    points.push_back(Eigen::Vector3d(random(-1.0, 1.0), random(-1.0, 1.0),
+                                     random(-1.0, 1.0)));
+  }
+
+  collision::ConvexHull hull;
+  std::vector<Eigen::Vector3i> triangles;
+  collision::ConvexDecomposition::computeConvexHull(points, &hull,
+                                                    &triangles);
+  ASSERT_FALSE(triangles.empty());
+  EXPECT_EQ(hull.size() + triangles.size(), 3 * triangles.size() / 2 + 2);
+  for (size_t i = 0; i < triangles.size(); ++i)
+  {
+    const Eigen::Vector3d& a = hull[triangles[i][0]];
+    const Eigen::Vector3d& b = hull[triangles[i][1]];
+    const Eigen::Vector3d& c = hull[triangles[i][2]];
+    Eigen::Vector3d normal = (b - a).cross(c - a).normalized();
+    for (size_t j = 0; j < points.size(); ++j)
+      EXPECT_LE(normal.dot(points[j] - a), 1e-9);
+  }
+
+  // An L-shaped prism is split into the two boxes of its legs, neither of
+  // which covers the notch of the L
+  std::vector<Eigen::Vector3d> vertices;
+  const double outline[6][2] = {{0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0},
+                                {1.0, 1.0}, {1.0, 3.0}, {0.0, 3.0}};
+  for (int i = 0; i < 2; ++i)
+  {
+    for (int j = 0; j < 6; ++j)
+    {
+      vertices.push_back(Eigen::Vector3d(outline[j][0], i,
+                                         outline[j][1]));
+    }
+  }
+  const int faces[20][3] = {{0, 1, 2}, {0, 2, 3}, {0, 3, 4}, {0, 4, 5},
+                            {6, 8, 7}, {6, 9, 8}, {6, 10, 9}, {6, 11, 10},
+                            {0, 7, 1}, {0, 6, 7}, {1, 8, 2}, {1, 7, 8},
+                            {2, 9, 3}, {2, 8, 9}, {3, 10, 4}, {3, 9, 10},
+                            {4, 11, 5}, {4, 10, 11}, {5, 6, 0}, {5, 11, 6}};
+  triangles.clear();
+  for (int i = 0; i < 20; ++i)
+    triangles.push_back(Eigen::Vector3i(faces[i][0], faces[i][1], faces[i][2]));
+
+  collision::ConvexHulls hulls;
+  collision::ConvexDecomposition::decompose(vertices, triangles, 0.03, 16,
+                                            &hulls);
+  ASSERT_EQ(hulls.size(), 2u);
+  const Eigen::Vector3d notch(2.0, 0.5, 2.0);
+  for (size_t i = 0; i < hulls.size(); ++i)
+  {
+    Eigen::Vector3d min = hulls[i][0];
+    Eigen::Vector3d max = hulls[i][0];
+    for (size_t j = 1; j < hulls[i].size(); ++j)
+    {
+      min = min.cwiseMin(hulls[i][j]);
+      max = max.cwiseMax(hulls[i][j]);
+    }
+    EXPECT_FALSE((notch.array() >= min.array()).all()
+                 && (notch.array() <= max.array()).all());
+  }
+
+  // The disk cache gives back the same hulls only for the same modification
+  // time of the mesh
+  const std::string fileName = "testConvexDecomposition.convex";
+  EXPECT_TRUE(collision::ConvexDecomposition::saveConvexHulls(fileName, 42,
+                                                              hulls));
+  collision::ConvexHulls loadedHulls;
+  EXPECT_FALSE(collision::ConvexDecomposition::loadConvexHulls(
+                 fileName, 43, &loadedHulls));
+  EXPECT_TRUE(collision::ConvexDecomposition::loadConvexHulls(
+                fileName, 42, &loadedHulls));
+  ASSERT_EQ(loadedHulls.size(), hulls.size());
+  for (size_t i = 0; i < hulls.size(); ++i)
+  {
+    ASSERT_EQ(loadedHulls[i].size(), hulls[i].size());
+    for (size_t j = 0; j < hulls[i].size(); ++j)
+      EXPECT_TRUE(loadedHulls[i][j] == hulls[i][j]);
+  }
+  std::remove(fileName.c_str());
+}
+
+//==============================================================================
+TEST_F(COLLISION, ConvexCollision)
+{
+  // EPA agrees with the box-box collider on the penetration of boxes, and the
+  // overlapping faces give the four corners of their intersection
+  BoxShape box(Eigen::Vector3d::Ones());
+  Eigen::Isometry3d T0 = Eigen::Isometry3d::Identity();
+  Eigen::Isometry3d T1 = Eigen::Isometry3d::Identity();
+  std::vector<collision::Contact> contacts;
+  for (size_t i = 0; i < 20; ++i)
+  {
+    T1.translation() = Eigen::Vector3d(random(-0.9, 0.9), random(-0.9, 0.9),
+                                       random(-0.9, 0.9));
+
+    contacts.clear();
+    ASSERT_GT(collision::collideBoxBox(box.getSize(), T0, box.getSize(), T1,
+                                       &contacts), 0);
+    double depth = contacts[0].penetrationDepth;
+    for (size_t j = 1; j < contacts.size(); ++j)
+      depth = std::max(depth, contacts[j].penetrationDepth);
+    Eigen::Vector3d normal = contacts[0].normal;
+
+    contacts.clear();
+    ASSERT_EQ(collision::collideConvex(collision::ConvexGeometry(&box, T0),
+                                       collision::ConvexGeometry(&box, T1),
+                                       &contacts), 4);
+    for (size_t j = 0; j < contacts.size(); ++j)
+    {
+      EXPECT_NEAR(contacts[j].penetrationDepth, depth, 1e-6);
+      EXPECT_NEAR(contacts[j].normal.dot(normal), 1.0, 1e-6);
+    }
+  }
+
+  // A sphere has no face, so it touches at the deepest point only
+  EllipsoidShape sphere(Eigen::Vector3d::Constant(1.0));
+  T1.translation() = Eigen::Vector3d(0.0, 0.0, 0.9);
+  contacts.clear();
+  ASSERT_EQ(collision::collideConvex(collision::ConvexGeometry(&box, T0),
+                                     collision::ConvexGeometry(&sphere, T1),
+                                     &contacts), 1);
+  EXPECT_NEAR(contacts[0].penetrationDepth, 0.1, 1e-6);
+
+  // A mesh of a unit box collides with a box in the DART detector like the
+  // box itself
+  const aiScene* mesh
+      = MeshShape::loadMesh(DART_DATA_PATH"obj/BoxSmall.obj");
+  ASSERT_TRUE(mesh != NULL);
+  BodyNode* meshNode = new BodyNode("mesh");
+  MeshShape* meshShape = new MeshShape(Eigen::Vector3d::Constant(25.0), mesh);
+  meshNode->addCollisionShape(meshShape);
+  meshNode->setParentJoint(new WeldJoint("joint1"));
+  Skeleton* meshBox = new Skeleton();
+  meshBox->addBodyNode(meshNode);
+  meshBox->init();
+  EXPECT_EQ(collision::ConvexDecomposition::getConvexHulls(mesh)->size(), 1u);
+
+  Skeleton* boxSkeleton = createBox(Eigen::Vector3d::Ones(),
+                                    Eigen::Vector3d(0.9, 0.2, -0.1));
+  collision::DARTCollisionDetector detector;
+  detector.addSkeleton(meshBox);
+  detector.addSkeleton(boxSkeleton);
+  EXPECT_TRUE(detector.detectCollision(true, true));
+  ASSERT_EQ(detector.getNumContacts(), 4u);
+  for (size_t i = 0; i < detector.getNumContacts(); ++i)
+  {
+    EXPECT_NEAR(detector.getContact(i).penetrationDepth, 0.1, 1e-6);
+    EXPECT_NEAR(std::abs(detector.getContact(i).normal[0]), 1.0, 1e-6);
+  }
+
+  double distance;
+  Eigen::Vector3d point0;
+  Eigen::Vector3d point1;
+  T1.translation() = Eigen::Vector3d(1.5, 0.2, -0.1);
+  EXPECT_TRUE(collision::distance(meshShape, T0, &box, T1,
+                                  &distance, &point0, &point1));
+  EXPECT_NEAR(distance, 0.5, 1e-6);
+
+  Eigen::VectorXd positions = boxSkeleton->getPositions();
+  positions.tail<3>() = T1.translation();
+  boxSkeleton->setPositions(positions);
+  boxSkeleton->computeForwardKinematics(true, false, false);
+  EXPECT_FALSE(detector.detectCollision(true, true));
+
+  // The hulls are cached by the path of the mesh file rather than by the
+  // scene, which is released once no shape uses it
+  std::shared_ptr<const collision::ConvexHulls> hulls
+      = collision::ConvexDecomposition::getConvexHulls(mesh);
+  delete meshBox;
+  delete boxSkeleton;
+  MeshShape::releaseUnusedMeshes();
+  mesh = MeshShape::loadMesh(DART_DATA_PATH"obj/BoxSmall.obj");
+  ASSERT_TRUE(mesh != NULL);
+  EXPECT_EQ(collision::ConvexDecomposition::getConvexHulls(mesh), hulls);
+
+  // The hulls are not written next to the mesh file by default
+  EXPECT_FALSE(collision::ConvexDecomposition::isDiskCacheEnabled());
+}
+
+//==============================================================================
+TEST_F(COLLISION, BoxRestingOnMesh)
+{
+  // A slab made of the mesh of a box, whose top face is at z = 0
+  const aiScene* mesh
+      = MeshShape::loadMesh(DART_DATA_PATH"obj/BoxSmall.obj");
+  ASSERT_TRUE(mesh != NULL);
+  BodyNode* slabNode = new BodyNode("slab");
+  slabNode->addCollisionShape(
+        new MeshShape(Eigen::Vector3d(100.0, 100.0, 25.0), mesh));
+  slabNode->setParentJoint(new WeldJoint("joint1"));
+  slabNode->getParentJoint()->setTransformFromParentBodyNode(
+        Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, -0.5)));
+  Skeleton* slab = new Skeleton();
+  slab->addBodyNode(slabNode);
+  slab->init();
+
+  // A tilted box dropped onto the slab settles on its bottom corners instead
+  // of rocking about a single contact
+  Skeleton* box = createBox(Eigen::Vector3d::Constant(0.5),
+                            Eigen::Vector3d(0.3, -0.2, 0.3),
+                            Eigen::Vector3d(0.1, 0.05, 0.0));
+
+  World* world = new World();
+  world->getConstraintSolver()->setCollisionDetector(
+        new collision::DARTCollisionDetector());
+  world->addSkeleton(slab);
+  world->addSkeleton(box);
+
+  for (size_t i = 0; i < 1500; ++i)
+    world->step();
+
+  double maxSpeed = 0.0;
+  for (size_t i = 0; i < 500; ++i)
+  {
+    world->step();
+    maxSpeed = std::max(maxSpeed, box->getVelocities().norm());
+  }
+  EXPECT_LT(maxSpeed, 1e-3);
+
+  const Eigen::Isometry3d& transform = box->getBodyNode(0)->getTransform();
+  EXPECT_NEAR(transform.translation()[2], 0.25, 1e-2);
+  EXPECT_GT(transform.linear()(2, 2), 1.0 - 1e-3);
+  EXPECT_EQ(world->getConstraintSolver()->getCollisionDetector()
+              ->getNumContacts(), 4u);
+
+  delete world;
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
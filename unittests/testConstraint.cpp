@@ -35,7 +35,9 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdlib>
 #include <iostream>
+#include <new>
 
 #include <Eigen/Dense>
 #include <gtest/gtest.h>
@@ -46,12 +48,93 @@
 #include "dart/math/Geometry.h"
 #include "dart/math/Helpers.h"
 #include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/constraint/ConstrainedGroup.h"
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/constraint/ContactConstraint.h"
+#include "dart/constraint/DantzigLCPSolver.h"
+#include "dart/constraint/JointLimitConstraint.h"
+#include "dart/lcpsolver/lcp.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/Skeleton.h"
+#include "dart/dynamics/SoftBodyNode.h"
 #include "dart/simulation/World.h"
 #include "dart/utils/SkelParser.h"
 #include "dart/utils/Paths.h"
 
+//==============================================================================
+// Heap allocations are counted while gIsCountingAllocations is true
+static bool gIsCountingAllocations = false;
+static size_t gNumAllocations = 0;
+
+#if defined(__GLIBC__)
+// Eigen allocates its dynamic matrices with malloc rather than operator new, so
+// malloc itself is replaced to count them as well. The replacements forward to
+// the allocator of glibc, and operator new is counted through them.
+extern "C" void* __libc_malloc(size_t _size);
+extern "C" void* __libc_calloc(size_t _num, size_t _size);
+extern "C" void* __libc_realloc(void* _memory, size_t _size);
+
+//==============================================================================
+extern "C" void* malloc(size_t _size)
+{
+  if (gIsCountingAllocations)
+    ++gNumAllocations;
+
+  return __libc_malloc(_size);
+}
+
+//==============================================================================
+extern "C" void* calloc(size_t _num, size_t _size)
+{
+  if (gIsCountingAllocations)
+    ++gNumAllocations;
+
+  return __libc_calloc(_num, _size);
+}
+
+//==============================================================================
+extern "C" void* realloc(void* _memory, size_t _size)
+{
+  if (gIsCountingAllocations)
+    ++gNumAllocations;
+
+  return __libc_realloc(_memory, _size);
+}
+#endif
+
+//==============================================================================
+void* operator new(size_t _size)
+{
+#if !defined(__GLIBC__)
+  if (gIsCountingAllocations)
+    ++gNumAllocations;
+#endif
+
+  void* memory = std::malloc(_size > 0 ? _size : 1);
+  if (memory == NULL)
+    throw std::bad_alloc();
+
+  return memory;
+}
+
+//==============================================================================
+void* operator new[](size_t _size)
+{
+  return operator new(_size);
+}
+
+//==============================================================================
+void operator delete(void* _memory) throw()
+{
+  std::free(_memory);
+}
+
+//==============================================================================
+void operator delete[](void* _memory) throw()
+{
+  operator delete(_memory);
+}
+
 //==============================================================================
 class ConstraintTest : public ::testing::Test
 {
@@ -242,6 +325,480 @@ TEST_F(ConstraintTest, SingleContactTest)
   SingleContactTest(getList()[0]);
 }
 
+//==============================================================================
+TEST(ConstraintSolver, ParallelConstrainedGroups)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  const size_t numStacks = 6;
+  const size_t numBoxesPerStack = 2;
+  const int numSteps = 300;
+
+  World* worlds[2];
+  for (size_t i = 0; i < 2; ++i)
+  {
+    worlds[i] = new World;
+    worlds[i]->setGravity(Vector3d(0.0, -10.0, 0.0));
+    worlds[i]->getConstraintSolver()->setCollisionDetector(
+          new DARTCollisionDetector());
+
+    Skeleton* groundSkel = createGround(Vector3d(100.0, 0.1, 100.0),
+                                        Vector3d(0.0, -0.05, 0.0));
+    groundSkel->setMobile(false);
+    worlds[i]->addSkeleton(groundSkel);
+
+    // Every stack touches only the immobile ground and the boxes of the same
+    // stack, so each stack becomes a separate constrained group.
+    for (size_t j = 0; j < numStacks; ++j)
+    {
+      for (size_t k = 0; k < numBoxesPerStack; ++k)
+      {
+        Vector3d pos(1.0 * j, 0.12 + 0.22 * k, 0.01 * k);
+        worlds[i]->addSkeleton(createBox(Vector3d(0.2, 0.2, 0.2), pos));
+      }
+    }
+  }
+  worlds[1]->setNumThreads(4);
+  EXPECT_EQ(worlds[1]->getConstraintSolver()->getNumThreads(), 4u);
+
+  for (int i = 0; i < numSteps; ++i)
+  {
+    worlds[0]->step();
+    worlds[1]->step();
+  }
+
+  // Solving the groups in parallel must not change the result
+  EXPECT_GT(worlds[1]->getConstraintSolver()->getCollisionDetector()
+            ->getNumContacts(), 0u);
+  for (size_t i = 0; i < worlds[0]->getNumSkeletons(); ++i)
+  {
+    Skeleton* skel1 = worlds[0]->getSkeleton(i);
+    Skeleton* skel2 = worlds[1]->getSkeleton(i);
+    for (size_t j = 0; j < skel1->getNumDofs(); ++j)
+    {
+      EXPECT_EQ(skel1->getPosition(j), skel2->getPosition(j));
+      EXPECT_EQ(skel1->getVelocity(j), skel2->getVelocity(j));
+    }
+  }
+
+  delete worlds[0];
+  delete worlds[1];
+}
+
+//==============================================================================
+// Exposes the LCP matrix assembly of the solvers
+class LCPMatrixBuilder : public dart::constraint::DantzigLCPSolver
+{
+public:
+  LCPMatrixBuilder() : DantzigLCPSolver(0.001) {}
+
+  using DantzigLCPSolver::buildLCPMatrix;
+};
+
+//==============================================================================
+// Hides the Jacobian of a constraint so that its rows of the LCP matrix are
+// filled by unit impulse tests
+class UnitImpulseConstraint : public dart::constraint::ConstraintBase
+{
+public:
+  explicit UnitImpulseConstraint(ConstraintBase* _constraint)
+    : mConstraint(_constraint)
+  {
+    mDim = mConstraint->getDimension();
+  }
+
+  virtual ~UnitImpulseConstraint() {}
+
+  virtual void update() { mConstraint->update(); }
+  virtual void getInformation(dart::constraint::ConstraintInfo* _info)
+  { mConstraint->getInformation(_info); }
+  virtual void applyUnitImpulse(size_t _index)
+  { mConstraint->applyUnitImpulse(_index); }
+  virtual void getVelocityChange(double* _vel, bool _withCfm)
+  { mConstraint->getVelocityChange(_vel, _withCfm); }
+  virtual void excite() { mConstraint->excite(); }
+  virtual void unexcite() { mConstraint->unexcite(); }
+  virtual void applyImpulse(double* _lambda)
+  { mConstraint->applyImpulse(_lambda); }
+  virtual bool isActive() const { return mConstraint->isActive(); }
+  virtual dart::dynamics::Skeleton* getRootSkeleton() const
+  { return mConstraint->getRootSkeleton(); }
+
+private:
+  ConstraintBase* mConstraint;
+};
+
+//==============================================================================
+// Expects the LCP matrix of _constraints assembled from their Jacobians to be
+// the one filled by unit impulse tests
+void expectJacobianLCPMatrix(
+    const std::vector<dart::constraint::ConstraintBase*>& _constraints)
+{
+  using namespace Eigen;
+  using namespace dart::constraint;
+
+  ASSERT_FALSE(_constraints.empty());
+  for (size_t i = 0; i < _constraints.size(); ++i)
+    _constraints[i]->update();
+
+  // All the constraints are assembled from Jacobians in the first group, none
+  // in the second group and every other one in the third group
+  ConstrainedGroup groups[3];
+  std::vector<UnitImpulseConstraint*> wrappers;
+  for (size_t i = 0; i < _constraints.size(); ++i)
+  {
+    ASSERT_TRUE(_constraints[i]->isActive());
+    wrappers.push_back(new UnitImpulseConstraint(_constraints[i]));
+    groups[0].addConstraint(_constraints[i]);
+    groups[1].addConstraint(wrappers.back());
+    if (i % 2 == 0)
+      groups[2].addConstraint(_constraints[i]);
+    else
+      groups[2].addConstraint(wrappers.back());
+  }
+
+  size_t n = groups[0].getTotalDimension();
+  size_t nSkip = dPAD(n);
+  std::vector<size_t> offset(_constraints.size(), 0);
+  for (size_t i = 1; i < _constraints.size(); ++i)
+    offset[i] = offset[i - 1] + _constraints[i - 1]->getDimension();
+
+  LCPMatrixBuilder builder;
+  MatrixXd A[3];
+  for (size_t i = 0; i < 3; ++i)
+  {
+    std::vector<double> buffer(n * nSkip, 0.0);
+    builder.buildLCPMatrix(&groups[i], &buffer[0], nSkip, &offset[0]);
+
+    A[i].resize(n, n);
+    for (size_t j = 0; j < n; ++j)
+      for (size_t k = 0; k < n; ++k)
+        A[i](j, k) = buffer[j * nSkip + k];
+  }
+
+  EXPECT_TRUE(equals(A[0], A[1], 1e-9));
+  EXPECT_TRUE(equals(A[2], A[1], 1e-9));
+
+  for (size_t i = 0; i < wrappers.size(); ++i)
+    delete wrappers[i];
+}
+
+//==============================================================================
+TEST(ConstraintSolver, JacobianLCPMatrix)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  World* world = new World;
+  world->setGravity(Vector3d(0.0, -10.0, 0.0));
+  world->getConstraintSolver()->setCollisionDetector(
+        new DARTCollisionDetector());
+
+  Skeleton* groundSkel = createGround(Vector3d(100.0, 0.1, 100.0),
+                                      Vector3d(0.0, -0.05, 0.0));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Vector3d pos(0.02 * i, 0.12 + 0.22 * i, 0.01 * i);
+    world->addSkeleton(createBox(Vector3d(0.2, 0.2, 0.2), pos));
+  }
+
+  // An articulated chain beyond the limits of its joints, away from the boxes
+  Skeleton* chain = createNLinkRobot(3, Vector3d(0.1, 0.1, 0.3), DOF_PITCH);
+  chain->getJoint(0)->setTransformFromParentBodyNode(
+        Isometry3d(Translation3d(5.0, 1.0, 0.0)));
+  world->addSkeleton(chain);
+
+  // A soft box on a revolute joint beyond its limit
+  Skeleton* softSkel = new Skeleton("soft");
+  SoftBodyNode* softBodyNode = new SoftBodyNode("soft box");
+  SoftBodyNodeHelper::setBox(softBodyNode, Vector3d(0.2, 0.2, 0.2),
+                             Isometry3d::Identity(), Vector3i(3, 3, 3), 1.0);
+  softBodyNode->setMass(1.0);
+  Joint* softJoint = create1DOFJoint(0.0, -0.1, 0.1, DOF_ROLL);
+  softJoint->setTransformFromParentBodyNode(
+        Isometry3d(Translation3d(-5.0, 1.0, 0.0)));
+  softBodyNode->setParentJoint(softJoint);
+  softSkel->addBodyNode(softBodyNode);
+  world->addSkeleton(softSkel);
+
+  for (int i = 0; i < 20; ++i)
+    world->step();
+
+  // Move the joints beyond their limits, and update the articulated inertias
+  // used by the unit impulse tests
+  for (size_t i = 0; i < chain->getNumDofs(); ++i)
+  {
+    chain->getJoint(i)->setPositionLowerLimit(0, -0.1);
+    chain->getJoint(i)->setPositionUpperLimit(0, 0.1);
+    chain->setPosition(i, i % 2 == 0 ? 0.3 : -0.3);
+  }
+  softSkel->setPosition(0, 0.3);
+  for (size_t i = 0; i < world->getNumSkeletons(); ++i)
+  {
+    world->getSkeleton(i)->computeForwardKinematics(true, true, false);
+    world->getSkeleton(i)->computeForwardDynamics();
+  }
+
+  // Contacts between free bodies
+  CollisionDetector* detector
+      = world->getConstraintSolver()->getCollisionDetector();
+  detector->detectCollision(true, true);
+  ASSERT_GT(detector->getNumContacts(), 0u);
+
+  std::vector<ContactConstraint*> contacts;
+  std::vector<ConstraintBase*> constraints;
+  for (size_t i = 0; i < detector->getNumContacts(); ++i)
+  {
+    contacts.push_back(new ContactConstraint(detector->getContact(i),
+                                             world->getTimeStep()));
+    constraints.push_back(contacts.back());
+  }
+  expectJacobianLCPMatrix(constraints);
+
+  // Joint limits of an articulated chain, which are coupled through its mass
+  // matrix
+  std::vector<JointLimitConstraint*> limits;
+  constraints.clear();
+  for (size_t i = 0; i < chain->getNumDofs(); ++i)
+  {
+    limits.push_back(new JointLimitConstraint(chain->getJoint(i)));
+    constraints.push_back(limits.back());
+  }
+  expectJacobianLCPMatrix(constraints);
+
+  // The joint limit of a soft body, whose rows are filled by unit impulse
+  // tests since its point masses are not in the mass matrix
+  limits.push_back(new JointLimitConstraint(softJoint));
+  constraints.assign(1, limits.back());
+  expectJacobianLCPMatrix(constraints);
+
+  for (size_t i = 0; i < contacts.size(); ++i)
+    delete contacts[i];
+  for (size_t i = 0; i < limits.size(); ++i)
+    delete limits[i];
+  delete world;
+}
+
+//==============================================================================
+TEST(ConstraintSolver, WarmStartedContactConstraint)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  World* world = new World;
+  world->setGravity(Vector3d(0.0, -10.0, 0.0));
+  world->getConstraintSolver()->setCollisionDetector(
+        new DARTCollisionDetector());
+  EXPECT_FALSE(world->getConstraintSolver()->isWarmStarting());
+
+  Skeleton* groundSkel = createGround(Vector3d(100.0, 0.1, 100.0),
+                                      Vector3d(0.0, -0.05, 0.0));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+  world->addSkeleton(createBox(Vector3d(0.2, 0.2, 0.2),
+                               Vector3d(0.0, 0.1, 0.0)));
+
+  for (int i = 0; i < 100; ++i)
+    world->step();
+
+  // The contact forces of the last step become the initial guesses of new
+  // constraints between the same bodies
+  CollisionDetector* detector
+      = world->getConstraintSolver()->getCollisionDetector();
+  ASSERT_GT(detector->getNumContacts(), 0u);
+
+  double timeStep = world->getTimeStep();
+  for (size_t i = 0; i < detector->getNumContacts(); ++i)
+  {
+    Contact& contact = detector->getContact(i);
+    Vector3d force = contact.force;
+
+    ContactConstraint* constraint = new ContactConstraint(contact, timeStep);
+    constraint->setInitialContactForce(0, force);
+    EXPECT_TRUE(equals(constraint->getInitialContactForce(0), force));
+
+    ConstraintBase* base = constraint;
+    base->update();
+    ASSERT_EQ(base->getDimension(), 3u);
+
+    double x[3], lo[3], hi[3], b[3], w[3] = {0.0, 0.0, 0.0};
+    int findex[3] = {-1, -1, -1};
+    ConstraintInfo info;
+    info.x = x;
+    info.lo = lo;
+    info.hi = hi;
+    info.b = b;
+    info.w = w;
+    info.findex = findex;
+    info.invTimeStep = 1.0 / timeStep;
+    base->getInformation(&info);
+
+    Vector3d tangent = force - force.dot(contact.normal) * contact.normal;
+    EXPECT_NEAR(x[0], force.dot(contact.normal) * timeStep, 1e-12);
+    EXPECT_NEAR(std::sqrt(x[1] * x[1] + x[2] * x[2]),
+                tangent.norm() * timeStep, 1e-12);
+
+    delete constraint;
+  }
+
+  delete world;
+}
+
+//==============================================================================
+TEST(ConstraintSolver, WarmStartedPGS)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::constraint;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  // Stacks of boxes solved by PGS with and without warm starting
+  const size_t numBoxes = 5;
+  World* worlds[2];
+  for (size_t i = 0; i < 2; ++i)
+  {
+    worlds[i] = new World;
+    worlds[i]->setGravity(Vector3d(0.0, -10.0, 0.0));
+    ConstraintSolver* solver = worlds[i]->getConstraintSolver();
+    solver->setCollisionDetector(new DARTCollisionDetector());
+    solver->setLCPSolverType(ConstraintSolver::PGS);
+    EXPECT_EQ(solver->getLCPSolverType(), ConstraintSolver::PGS);
+    solver->setWarmStarting(i == 1);
+
+    Skeleton* groundSkel = createGround(Vector3d(100.0, 0.1, 100.0),
+                                        Vector3d(0.0, -0.05, 0.0));
+    groundSkel->setMobile(false);
+    worlds[i]->addSkeleton(groundSkel);
+    for (size_t j = 0; j < numBoxes; ++j)
+    {
+      worlds[i]->addSkeleton(createBox(Vector3d(0.2, 0.2, 0.2),
+                                       Vector3d(0.0, 0.1 + 0.2 * j, 0.0)));
+    }
+  }
+
+  // Accumulate the speeds of the boxes, which should be at rest
+  double speeds[2] = {0.0, 0.0};
+  for (int i = 0; i < 500; ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      worlds[j]->step();
+      for (size_t k = 1; k < worlds[j]->getNumSkeletons(); ++k)
+        speeds[j] += worlds[j]->getSkeleton(k)->getVelocities().norm();
+    }
+  }
+
+  // The contact impulses of the previous step let the few PGS iterations
+  // settle the stack
+  EXPECT_LT(speeds[1], speeds[0]);
+
+  delete worlds[0];
+  delete worlds[1];
+}
+
+//==============================================================================
+size_t countAllocationsPerStep(dart::simulation::World* _world)
+{
+  gNumAllocations = 0;
+  gIsCountingAllocations = true;
+  _world->step();
+  gIsCountingAllocations = false;
+
+  return gNumAllocations;
+}
+
+//==============================================================================
+TEST(ConstraintSolver, NoAllocationInSteadyStateStep)
+{
+  using namespace Eigen;
+  using namespace dart::collision;
+  using namespace dart::dynamics;
+  using namespace dart::simulation;
+
+  // Box resting on the ground, which is solved with contact constraints
+  World* world = new World;
+  world->getConstraintSolver()->setCollisionDetector(
+        new DARTCollisionDetector());
+
+  Skeleton* groundSkel = createGround(Vector3d(10.0, 10.0, 0.1));
+  groundSkel->setMobile(false);
+  world->addSkeleton(groundSkel);
+  world->addSkeleton(createBox(Vector3d(0.5, 0.5, 0.5),
+                               Vector3d(0.0, 0.0, 0.3)));
+
+  // Let the box settle so that the number of contacts stays the same
+  for (int i = 0; i < 500; ++i)
+    world->step();
+  ASSERT_GT(world->getConstraintSolver()->getCollisionDetector()
+            ->getNumContacts(), 0u);
+
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(countAllocationsPerStep(world), 0u);
+
+  delete world;
+
+  // Pendulum pushed against its joint limit, which is solved with a joint
+  // limit constraint
+  world = new World;
+  world->setGravity(Vector3d::Zero());
+  world->getConstraintSolver()->setCollisionDetector(
+        new DARTCollisionDetector());
+
+  Skeleton* pendulum = createNLinkRobot(1, Vector3d(0.3, 0.3, 1.0), DOF_ROLL,
+                                        true);
+  world->addSkeleton(pendulum);
+
+  Joint* joint = pendulum->getJoint(0);
+  joint->setPositionLimited(true);
+  joint->setPositionLowerLimit(0, -0.1);
+  joint->setPositionUpperLimit(0, 0.1);
+
+  for (int i = 0; i < 200; ++i)
+  {
+    joint->setForce(0, 500.0);
+    world->step();
+  }
+  ASSERT_NEAR(joint->getPosition(0), 0.1, 1e-2);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    joint->setForce(0, 500.0);
+    EXPECT_EQ(countAllocationsPerStep(world), 0u);
+  }
+
+  delete world;
+
+  // Box resting on the ground with the default collision detector, which
+  // collides the shapes as FCL meshes
+  world = new World;
+  world->addSkeleton(createGround(Vector3d(10.0, 10.0, 0.1)));
+  world->getSkeleton(0)->setMobile(false);
+  world->addSkeleton(createBox(Vector3d(0.5, 0.5, 0.5),
+                               Vector3d(0.0, 0.0, 0.3)));
+
+  for (int i = 0; i < 500; ++i)
+    world->step();
+  ASSERT_GT(world->getConstraintSolver()->getCollisionDetector()
+            ->getNumContacts(), 0u);
+
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(countAllocationsPerStep(world), 0u);
+
+  delete world;
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -825,6 +825,36 @@ void DynamicsTest::compareEquationsOfMotion(const std::string& _fileName)
         cout << "InvAugM_AugM:" << endl << InvAugM_AugM << endl << endl;
       }
 
+      //----------------- Inverse Mass Matrix Product Test -------------------
+      // Products with the inverse mass matrices computed without forming them
+      MatrixXd B = MatrixXd::Random(dof, 3);
+      MatrixXd InvM_B    = skel->multiplyInvMassMatrix(B);
+      MatrixXd InvAugM_B = skel->multiplyInvAugMassMatrix(B);
+      MatrixXd LTDL_B    = skel->solveMassMatrix(B);
+      MatrixXd InvMB     = InvM * B;
+      MatrixXd InvAugMB  = InvAugM * B;
+
+      EXPECT_TRUE(equals(InvM_B, InvMB, 1e-6));
+      if (!equals(InvM_B, InvMB, 1e-6))
+      {
+        cout << "InvM_B:" << endl << InvM_B << endl << endl;
+        cout << "InvM * B:" << endl << InvMB << endl << endl;
+      }
+
+      EXPECT_TRUE(equals(InvAugM_B, InvAugMB, 1e-6));
+      if (!equals(InvAugM_B, InvAugMB, 1e-6))
+      {
+        cout << "InvAugM_B:" << endl << InvAugM_B << endl << endl;
+        cout << "InvAugM * B:" << endl << InvAugMB << endl << endl;
+      }
+
+      EXPECT_TRUE(equals(LTDL_B, InvMB, 1e-6));
+      if (!equals(LTDL_B, InvMB, 1e-6))
+      {
+        cout << "LTDL_B:" << endl << LTDL_B << endl << endl;
+        cout << "InvM * B:" << endl << InvMB << endl << endl;
+      }
+
       //------- Coriolis Force Vector and Combined Force Vector Tests --------
       // Get C1, Coriolis force vector using recursive method
       VectorXd C = skel->getCoriolisForces();
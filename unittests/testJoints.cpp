@@ -383,6 +383,51 @@ TEST_F(JOINTS, POSITION_LIMIT)
   }
 }
 
+//==============================================================================
+TEST_F(JOINTS, POSITION_LIMIT_CHANGED_DURING_SIMULATION)
+{
+  double tol = 1e-3;
+
+  World* myWorld = new World;
+  myWorld->setGravity(Eigen::Vector3d(0.0, 0.0, 0.0));
+
+  Skeleton* pendulum = createNLinkRobot(1, Eigen::Vector3d(0.3, 0.3, 1.0),
+                                        DOF_ROLL, true);
+  myWorld->addSkeleton(pendulum);
+
+  Joint* joint = pendulum->getJoint(0);
+
+  double limit = DART_PI / 6.0;
+  joint->setPositionLowerLimit(0, -limit);
+  joint->setPositionUpperLimit(0, limit);
+
+  // Joint constraints are kept over time steps, so limits enabled after the
+  // simulation has started must still be enforced
+  myWorld->step();
+  joint->setPositionLimited(true);
+
+  int nSteps = 2.0 / myWorld->getTimeStep();
+  for (int i = 0; i < nSteps; i++)
+  {
+    joint->setForce(0, 2.0);
+    myWorld->step();
+
+    EXPECT_LE(joint->getPosition(0), limit + tol);
+  }
+
+  // ...and limits disabled later must stop being enforced
+  joint->setPositionLimited(false);
+  for (int i = 0; i < nSteps; i++)
+  {
+    joint->setForce(0, 2.0);
+    myWorld->step();
+  }
+
+  EXPECT_GT(joint->getPosition(0), limit + tol);
+
+  delete myWorld;
+}
+
 //==============================================================================
 void testJointCoulombFrictionForce(double _timeStep)
 {
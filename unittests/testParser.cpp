@@ -38,6 +38,7 @@
 #include <gtest/gtest.h>
 #include "TestHelpers.h"
 
+#include "dart/dynamics/MeshShape.h"
 #include "dart/dynamics/SoftBodyNode.h"
 #include "dart/dynamics/RevoluteJoint.h"
 #include "dart/dynamics/PlanarJoint.h"
@@ -129,6 +130,54 @@ TEST(Parser, EmptyWorld)
   delete world;
 }
 
+//==============================================================================
+TEST(Parser, MeshCache)
+{
+  size_t numHits = MeshShape::getNumMeshCacheHits();
+  size_t numMisses = MeshShape::getNumMeshCacheMisses();
+
+  World* world = SkelParser::readWorld(
+                   DART_DATA_PATH"skel/bullet_collision.skel");
+  EXPECT_TRUE(world != NULL);
+
+  // All the shapes that refer to the same mesh file share the scene
+  std::vector<MeshShape*> meshShapes;
+  for (size_t i = 0; i < world->getNumSkeletons(); ++i)
+  {
+    Skeleton* skeleton = world->getSkeleton(i);
+    for (size_t j = 0; j < skeleton->getNumBodyNodes(); ++j)
+    {
+      BodyNode* bodyNode = skeleton->getBodyNode(j);
+      for (size_t k = 0; k < bodyNode->getNumVisualizationShapes(); ++k)
+      {
+        Shape* shape = bodyNode->getVisualizationShape(k);
+        if (shape->getShapeType() == Shape::MESH)
+          meshShapes.push_back(static_cast<MeshShape*>(shape));
+      }
+      for (size_t k = 0; k < bodyNode->getNumCollisionShapes(); ++k)
+      {
+        Shape* shape = bodyNode->getCollisionShape(k);
+        if (shape->getShapeType() == Shape::MESH)
+          meshShapes.push_back(static_cast<MeshShape*>(shape));
+      }
+    }
+  }
+  ASSERT_GE(meshShapes.size(), 2u);
+  for (size_t i = 1; i < meshShapes.size(); ++i)
+    EXPECT_EQ(meshShapes[i]->getMesh(), meshShapes[0]->getMesh());
+
+  EXPECT_LE(MeshShape::getNumMeshCacheMisses(), numMisses + 1);
+  EXPECT_GE(MeshShape::getNumMeshCacheHits(), numHits + meshShapes.size() - 1);
+
+  // Equivalent paths to the same file hit the cache
+  numHits = MeshShape::getNumMeshCacheHits();
+  EXPECT_EQ(MeshShape::loadMesh(DART_DATA_PATH"skel/../obj/foot.obj"),
+            meshShapes[0]->getMesh());
+  EXPECT_EQ(MeshShape::getNumMeshCacheHits(), numHits + 1);
+
+  delete world;
+}
+
 //==============================================================================
 TEST(Parser, SinglePendulum)
 {
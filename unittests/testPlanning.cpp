@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2015, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author(s): Jeongseok Lee <jslee02@gmail.com>
+ *
+ * Georgia Tech Graphics Lab and Humanoid Robotics Lab
+ *
+ * Directed by Prof. C. Karen Liu and Prof. Mike Stilman
+ * <karenliu@cc.gatech.edu> <mstilman@cc.gatech.edu>
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "TestHelpers.h"
+
+#include "dart/dynamics/BodyNode.h"
+#include "dart/dynamics/Joint.h"
+#include "dart/dynamics/Skeleton.h"
+#include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/constraint/ConstraintSolver.h"
+#include "dart/simulation/World.h"
+#include "dart/planning/KdTree.h"
+#include "dart/planning/PathPlanner.h"
+#include "dart/planning/PathShortener.h"
+#include "dart/planning/RRT.h"
+
+using namespace dart;
+using namespace math;
+using namespace dynamics;
+using namespace simulation;
+using namespace planning;
+
+//==============================================================================
+/// Create a small box whose translation is limited to [-1.5, 1.5]^3
+Skeleton* createTranslatingBox()
+{
+  Skeleton* robot = createBox(Eigen::Vector3d::Constant(0.1));
+  Joint* joint = robot->getJoint(0);
+  for (size_t i = 3; i < 6; ++i)
+  {
+    joint->setPositionLowerLimit(i, -1.5);
+    joint->setPositionUpperLimit(i, 1.5);
+  }
+  return robot;
+}
+
+//==============================================================================
+/// Return true if the path is collision free, which is checked at the nodes
+/// and at the points in between them with the given resolution, or only at the
+/// nodes if the resolution is infinity
+bool isPathCollisionFree(World* _world, Skeleton* _robot,
+                         const std::vector<size_t>& _dofs,
+                         const std::list<Eigen::VectorXd>& _path,
+                         double _resolution)
+{
+  collision::CollisionDetector* detector
+      = _world->getConstraintSolver()->getCollisionDetector();
+  std::vector<BodyNode*> bodyNodes(1, _robot->getBodyNode(0));
+
+  std::list<Eigen::VectorXd>::const_iterator it = _path.begin();
+  Eigen::VectorXd prev = *it;
+  for (++it; it != _path.end(); ++it)
+  {
+    const Eigen::VectorXd& next = *it;
+    int numSteps = static_cast<int>((next - prev).norm() / _resolution) + 1;
+    for (int i = 0; i <= numSteps; ++i)
+    {
+      double t = static_cast<double>(i) / numSteps;
+      _robot->setPositionSegment(_dofs, (1.0 - t) * prev + t * next);
+      _robot->computeForwardKinematics(true, false, false);
+      if (detector->checkCollision(bodyNodes))
+        return false;
+    }
+    prev = next;
+  }
+
+  return true;
+}
+
+//==============================================================================
+TEST(Planning, ParallelRRT)
+{
+  // A wall between the start and the goal that the robot has to go around
+  World* world = new World();
+  world->getConstraintSolver()->setCollisionDetector(
+        new collision::DARTCollisionDetector());
+  Skeleton* robot = createTranslatingBox();
+  Skeleton* wall = createBox(Eigen::Vector3d(0.2, 1.6, 1.6));
+  world->addSkeleton(robot);
+  world->addSkeleton(wall);
+
+  std::vector<size_t> dofs;
+  for (size_t i = 3; i < 6; ++i)
+    dofs.push_back(i);
+  Eigen::VectorXd start = Eigen::Vector3d(-1.0, 0.0, 0.0);
+  Eigen::VectorXd goal = Eigen::Vector3d(1.0, 0.0, 0.0);
+
+  // Replicas of the robot for the planning threads, which are not in the world
+  std::vector<Skeleton*> replicas;
+  for (size_t i = 0; i < 4; ++i)
+    replicas.push_back(createTranslatingBox());
+
+  const double inf = std::numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    bool bidirectional = i == 0;
+    for (size_t j = 0; j < 2; ++j)
+    {
+      PathPlanner<> planner(*world, bidirectional, true, 0.05, 1e5);
+      if (j == 1)
+        planner.replicas = replicas;
+
+      std::list<Eigen::VectorXd> path;
+      ASSERT_TRUE(planner.planPath(robot, dofs, start, goal, path));
+      ASSERT_GE(path.size(), 2u);
+      EXPECT_TRUE(equals(path.front(), start));
+      if (bidirectional)
+        EXPECT_TRUE(equals(path.back(), goal));
+      else
+        EXPECT_LT((path.back() - goal).norm(), 0.05);
+      // The planner checks the nodes, which are a step apart, so the straight
+      // lines between them may graze the corners of the wall
+      EXPECT_TRUE(isPathCollisionFree(world, robot, dofs, path, inf));
+
+      delete planner.start_rrt;
+      if (bidirectional)
+        delete planner.goal_rrt;
+    }
+  }
+
+  for (size_t i = 0; i < replicas.size(); ++i)
+    delete replicas[i];
+  delete world;
+}
+
+//==============================================================================
+TEST(Planning, KdTree)
+{
+  // Linear and circular dimensions with different weights
+  KdTree tree(4, 8);
+  tree.setCircular(1, true);
+  tree.setCircular(3, true);
+  tree.setWeight(2, 4.0);
+  tree.setWeight(3, 0.25);
+
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    Eigen::VectorXd point(4);
+    point << random(-2.0, 2.0), random(-DART_PI, DART_PI),
+             random(-1.0, 1.0), random(-3.0 * DART_PI, 3.0 * DART_PI);
+    EXPECT_EQ(tree.addPoint(point), i);
+  }
+  EXPECT_EQ(tree.getNumPoints(), 2000u);
+
+  // The nearest configuration is as near as the nearest one found by brute
+  // force
+  for (size_t i = 0; i < 200; ++i)
+  {
+    Eigen::VectorXd query(4);
+    query << random(-2.5, 2.5), random(-2.0 * DART_PI, 2.0 * DART_PI),
+             random(-1.5, 1.5), random(-DART_PI, DART_PI);
+
+    double minDistance = std::numeric_limits<double>::infinity();
+    for (size_t j = 0; j < tree.getNumPoints(); ++j)
+    {
+      minDistance = std::min(minDistance,
+                             tree.getDistance(query, tree.getPoint(j)));
+    }
+
+    double distance;
+    size_t nearest = tree.findNearest(query, &distance);
+    EXPECT_NEAR(distance, minDistance, 1e-12);
+    EXPECT_NEAR(tree.getDistance(query, tree.getPoint(nearest)), minDistance,
+                1e-12);
+  }
+
+  // Removed configurations are not found anymore
+  Eigen::VectorXd query = tree.getPoint(100);
+  EXPECT_EQ(tree.findNearest(query), 100u);
+  tree.removePoint(100);
+  EXPECT_TRUE(tree.isRemoved(100));
+  EXPECT_NE(tree.findNearest(query), 100u);
+
+  // Circular dimensions take the shorter way around
+  Eigen::VectorXd from = Eigen::Vector4d(0.0, 3.0, 0.0, 0.0);
+  Eigen::VectorXd to = Eigen::Vector4d(0.5, -3.0, 0.0, 4.0 * DART_PI);
+  Eigen::VectorXd difference = tree.getDifference(to, from);
+  EXPECT_NEAR(difference[0], 0.5, 1e-12);
+  EXPECT_NEAR(difference[1], 2.0 * DART_PI - 6.0, 1e-12);
+  EXPECT_NEAR(difference[3], 0.0, 1e-12);
+}
+
+//==============================================================================
+TEST(Planning, ContinuousJoint)
+{
+  // A link on a revolute joint without limits
+  World* world = new World();
+  world->getConstraintSolver()->setCollisionDetector(
+        new collision::DARTCollisionDetector());
+  Skeleton* robot = createTwoLinkRobot(Eigen::Vector3d(0.1, 0.1, 0.5),
+                                       DOF_YAW,
+                                       Eigen::Vector3d(0.1, 0.1, 0.5),
+                                       DOF_ROLL);
+  Joint* joint = robot->getJoint(0);
+  joint->setPositionLowerLimit(0, -std::numeric_limits<double>::infinity());
+  joint->setPositionUpperLimit(0, std::numeric_limits<double>::infinity());
+  world->addSkeleton(robot);
+
+  // The tree steps across pi instead of going around the other way
+  std::vector<size_t> dofs(1, 0);
+  Eigen::VectorXd root = Eigen::VectorXd::Constant(1, 3.0);
+  Eigen::VectorXd target = Eigen::VectorXd::Constant(1, -3.0);
+  RRT rrt(world, robot, dofs, root, 0.1);
+  EXPECT_NEAR(rrt.getDistance(root, target), 2.0 * DART_PI - 6.0, 1e-12);
+  EXPECT_EQ(rrt.tryStep(target), RRT::STEP_PROGRESS);
+  ASSERT_EQ(rrt.getSize(), 2u);
+  EXPECT_NEAR(rrt.getConfig(1)[0], 3.1, 1e-12);
+
+  // Random configurations of the joint are sampled over a turn
+  for (size_t i = 0; i < 100; ++i)
+  {
+    double position = rrt.getRandomConfig()[0];
+    EXPECT_GE(position, -DART_PI);
+    EXPECT_LE(position, DART_PI);
+  }
+
+  // The trees of bidirectional planning meet across pi, and the half of the
+  // path from the goal tree is shifted by a turn to continue the other half
+  std::vector<Skeleton*> replicas;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    replicas.push_back(createTwoLinkRobot(Eigen::Vector3d(0.1, 0.1, 0.5),
+                                          DOF_YAW,
+                                          Eigen::Vector3d(0.1, 0.1, 0.5),
+                                          DOF_ROLL));
+    replicas.back()->getJoint(0)->setPositionLowerLimit(
+          0, -std::numeric_limits<double>::infinity());
+    replicas.back()->getJoint(0)->setPositionUpperLimit(
+          0, std::numeric_limits<double>::infinity());
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    PathPlanner<> planner(*world, true, true, 0.1, 1e4);
+    if (i == 1)
+      planner.replicas = replicas;
+
+    std::list<Eigen::VectorXd> path;
+    ASSERT_TRUE(planner.planPath(robot, dofs, root, target, path));
+    EXPECT_TRUE(equals(path.front(), root));
+    EXPECT_NEAR(std::remainder(path.back()[0] - target[0], 2.0 * DART_PI),
+                0.0, 1e-9);
+
+    std::list<Eigen::VectorXd>::const_iterator it = path.begin();
+    for (++it; it != path.end(); ++it)
+    {
+      std::list<Eigen::VectorXd>::const_iterator prev = it;
+      --prev;
+      EXPECT_LE(std::abs((*it)[0] - (*prev)[0]), 0.1 + 1e-9);
+    }
+
+    delete planner.start_rrt;
+    delete planner.goal_rrt;
+  }
+  for (size_t i = 0; i < replicas.size(); ++i)
+    delete replicas[i];
+
+  // A joint whose limits span more than a turn does not wrap around
+  joint->setPositionLowerLimit(0, -4.0);
+  joint->setPositionUpperLimit(0, 4.0);
+  RRT limitedRrt(world, robot, dofs, root, 0.1);
+  EXPECT_NEAR(limitedRrt.getDistance(root, target), 6.0, 1e-12);
+  EXPECT_EQ(limitedRrt.tryStep(target), RRT::STEP_PROGRESS);
+  ASSERT_EQ(limitedRrt.getSize(), 2u);
+  EXPECT_NEAR(limitedRrt.getConfig(1)[0], 2.9, 1e-12);
+
+  delete world;
+}
+
+//==============================================================================
+TEST(Planning, BisectionOrder)
+{
+  // The samples of eight segments are in van der Corput order
+  std::vector<size_t> order;
+  computeBisectionOrder(8, order);
+  const size_t expected[] = {4, 2, 6, 1, 3, 5, 7};
+  ASSERT_EQ(order.size(), 7u);
+  for (size_t i = 0; i < order.size(); ++i)
+    EXPECT_EQ(order[i], expected[i]);
+
+  // Every sample of any number of segments is checked once
+  for (size_t numSegments = 0; numSegments < 40; ++numSegments)
+  {
+    computeBisectionOrder(numSegments, order);
+    std::sort(order.begin(), order.end());
+    ASSERT_EQ(order.size(), numSegments > 1 ? numSegments - 1 : 0);
+    for (size_t i = 0; i < order.size(); ++i)
+      EXPECT_EQ(order[i], i + 1);
+  }
+}
+
+//==============================================================================
+TEST(Planning, LazyRRT)
+{
+  // A wall between the start and the goal that the robot has to go around
+  World* world = new World();
+  world->getConstraintSolver()->setCollisionDetector(
+        new collision::DARTCollisionDetector());
+  Skeleton* robot = createTranslatingBox();
+  Skeleton* wall = createBox(Eigen::Vector3d(0.2, 1.6, 1.6));
+  world->addSkeleton(robot);
+  world->addSkeleton(wall);
+
+  std::vector<size_t> dofs;
+  for (size_t i = 3; i < 6; ++i)
+    dofs.push_back(i);
+  Eigen::VectorXd start = Eigen::Vector3d(-1.0, 0.0, 0.0);
+  Eigen::VectorXd goal = Eigen::Vector3d(1.0, 0.0, 0.0);
+  const double inf = std::numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    bool bidirectional = i == 0;
+
+    // The same problem is planned eagerly and lazily from the same seed
+    size_t numCollisionChecks[2];
+    for (size_t j = 0; j < 2; ++j)
+    {
+      bool lazy = j == 1;
+      RRT::getRandomGenerator().seed(2);
+      PathPlanner<> planner(*world, bidirectional, true, 0.05, 1e5, 0.3, lazy);
+
+      // The nodes of the path, which are checked lazily, are collision free
+      std::list<Eigen::VectorXd> path;
+      ASSERT_TRUE(planner.planPath(robot, dofs, start, goal, path));
+      EXPECT_TRUE(equals(path.front(), start));
+      EXPECT_TRUE(isPathCollisionFree(world, robot, dofs, path, inf));
+      numCollisionChecks[j] = planner.numCollisionChecks;
+
+      // The straight line through the wall is the first candidate, which
+      // lazy planning rejects
+      if (lazy)
+        EXPECT_GT(planner.numCandidatePaths, 1u);
+
+      // The shortcuts are checked in bisection order at the step size, and
+      // the nodes of the shortened path stay collision free
+      PathShortener shortener(world, robot, dofs, 0.05);
+      shortener.shortenPath(path);
+      EXPECT_GT(shortener.getNumCollisionChecks(), 0u);
+      EXPECT_TRUE(isPathCollisionFree(world, robot, dofs, path, inf));
+
+      delete planner.start_rrt;
+      if (bidirectional)
+        delete planner.goal_rrt;
+    }
+
+    // Lazy planning checks only the nodes of the candidate paths
+    EXPECT_LT(numCollisionChecks[1], numCollisionChecks[0]);
+  }
+
+  delete world;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
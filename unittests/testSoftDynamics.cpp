@@ -34,6 +34,8 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <string>
 
@@ -46,8 +48,14 @@
 #include "dart/dynamics/Joint.h"
 
 #include "dart/dynamics/Skeleton.h"
+#include "dart/dynamics/BoxShape.h"
+#include "dart/dynamics/SoftMeshShape.h"
 #include "dart/dynamics/SoftBodyNode.h"
 #include "dart/dynamics/PointMass.h"
+#include "dart/dynamics/FreeJoint.h"
+#include "dart/dynamics/WeldJoint.h"
+#include "dart/collision/dart/DARTCollisionDetector.h"
+#include "dart/constraint/ConstraintSolver.h"
 #include "dart/simulation/World.h"
 #include "dart/utils/Paths.h"
 #include "dart/utils/SkelParser.h"
@@ -507,6 +515,148 @@ TEST_F(SoftDynamicsTest, compareEquationsOfMotion)
 //  }
 }
 
+//==============================================================================
+TEST_F(SoftDynamicsTest, findNearestPointMass)
+{
+  simulation::World* myWorld
+      = utils::SkelParser::readWorld(DART_DATA_PATH"skel/soft_cubes.skel");
+  EXPECT_TRUE(myWorld != NULL);
+
+  for (size_t i = 0; i < myWorld->getNumSkeletons(); ++i)
+  {
+    dynamics::Skeleton* skel = myWorld->getSkeleton(i);
+
+    for (size_t j = 0; j < skel->getNumSoftBodyNodes(); ++j)
+    {
+      dynamics::SoftBodyNode* softBodyNode = skel->getSoftBodyNode(j);
+      size_t numPointMasses = softBodyNode->getNumPointMasses();
+      ASSERT_TRUE(numPointMasses > 0);
+
+      // Deform the soft body randomly
+      for (size_t k = 0; k < numPointMasses; ++k)
+      {
+        Vector3d positions(math::random(-0.01, 0.01),
+                           math::random(-0.01, 0.01),
+                           math::random(-0.01, 0.01));
+        softBodyNode->getPointMass(k)->setPositions(positions);
+      }
+      skel->computeForwardKinematics(true, false, false);
+      softBodyNode->updatePointMassIndex();
+
+      // The grid search finds a point mass as near as the nearest one
+      for (size_t k = 0; k < 100; ++k)
+      {
+        Vector3d point = softBodyNode->getTransform()
+                         * Vector3d(math::random(-0.2, 0.2),
+                                    math::random(-0.2, 0.2),
+                                    math::random(-0.2, 0.2));
+
+        double minDistance = std::numeric_limits<double>::infinity();
+        for (size_t l = 0; l < numPointMasses; ++l)
+        {
+          minDistance = std::min(
+              minDistance,
+              (softBodyNode->getPointMass(l)->getWorldPosition()
+               - point).norm());
+        }
+
+        size_t index = softBodyNode->findNearestPointMass(point);
+        ASSERT_TRUE(index < numPointMasses);
+        EXPECT_NEAR((softBodyNode->getPointMass(index)->getWorldPosition()
+                     - point).norm(), minDistance, 1e-12);
+      }
+    }
+  }
+
+  delete myWorld;
+}
+
+//==============================================================================
+TEST_F(SoftDynamicsTest, softContactsWithoutTriangles)
+{
+  simulation::World* myWorld = new simulation::World();
+  constraint::ConstraintSolver* solver = myWorld->getConstraintSolver();
+  solver->setCollisionDetector(new collision::DARTCollisionDetector());
+
+  // Ground whose top face is at z = 0
+  dynamics::BodyNode* groundBody = new dynamics::BodyNode("ground");
+  groundBody->addCollisionShape(
+        new dynamics::BoxShape(Vector3d(4.0, 4.0, 0.2)));
+  dynamics::WeldJoint* groundJoint = new dynamics::WeldJoint("groundJoint");
+  groundJoint->setTransformFromParentBodyNode(
+        Isometry3d(Translation3d(0.0, 0.0, -0.1)));
+  groundBody->setParentJoint(groundJoint);
+  dynamics::Skeleton* ground = new dynamics::Skeleton("ground");
+  ground->addBodyNode(groundBody);
+  myWorld->addSkeleton(ground);
+
+  // Soft box that sinks into the ground and moves toward it. The DART
+  // detector collides the soft mesh as the convex hull of the point masses
+  // and reports no triangles.
+  dynamics::SoftBodyNode* softBody = new dynamics::SoftBodyNode("soft");
+  dynamics::SoftBodyNodeHelper::setBox(softBody, Vector3d::Constant(0.5),
+                                       Isometry3d::Identity(),
+                                       Vector3i(3, 3, 3), 1.0);
+  softBody->addCollisionShape(new dynamics::SoftMeshShape(softBody));
+  softBody->setParentJoint(new dynamics::FreeJoint("softJoint"));
+  dynamics::Skeleton* softBox = new dynamics::Skeleton("softBox");
+  softBox->addBodyNode(softBody);
+  myWorld->addSkeleton(softBox);
+
+  Vector6d positions = Vector6d::Zero();
+  positions[3] = 0.1;
+  positions[5] = 0.24;
+  softBox->setPositions(positions);
+  Vector6d velocities = Vector6d::Zero();
+  velocities[5] = -1.0;
+  softBox->setVelocities(velocities);
+  softBox->computeForwardKinematics(true, true, false);
+
+  ground->computeForwardDynamics();
+  softBox->computeForwardDynamics();
+  solver->solve();
+
+  collision::CollisionDetector* detector = solver->getCollisionDetector();
+  ASSERT_TRUE(detector->getNumContacts() > 0u);
+  for (size_t i = 0; i < detector->getNumContacts(); ++i)
+  {
+    const collision::Contact& contact = detector->getContact(i);
+    EXPECT_EQ(contact.triID1, -1);
+    EXPECT_EQ(contact.triID2, -1);
+  }
+
+  // The impulses are applied to the point masses that are nearest to the
+  // contacts, which are found from the point mass grid
+  size_t numPushedPointMasses = 0;
+  for (size_t i = 0; i < softBody->getNumPointMasses(); ++i)
+  {
+    dynamics::PointMass* pointMass = softBody->getPointMass(i);
+    if (pointMass->getConstraintImpulses().isZero())
+      continue;
+
+    ++numPushedPointMasses;
+    bool isNearest = false;
+    for (size_t j = 0; j < detector->getNumContacts(); ++j)
+    {
+      const Vector3d& point = detector->getContact(j).point;
+      double minDistance = std::numeric_limits<double>::infinity();
+      for (size_t k = 0; k < softBody->getNumPointMasses(); ++k)
+      {
+        minDistance = std::min(
+            minDistance,
+            (softBody->getPointMass(k)->getWorldPosition() - point).norm());
+      }
+
+      if ((pointMass->getWorldPosition() - point).norm() <= minDistance)
+        isNearest = true;
+    }
+    EXPECT_TRUE(isNearest);
+  }
+  EXPECT_TRUE(numPushedPointMasses > 0u);
+
+  delete myWorld;
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
@@ -41,7 +41,10 @@
 #include "dart/math/Geometry.h"
 #include "dart/dynamics/BodyNode.h"
 #include "dart/dynamics/RevoluteJoint.h"
+#include "dart/dynamics/SimpleFrame.h"
 #include "dart/dynamics/Skeleton.h"
+#include "dart/collision/RayCaster.h"
+#include "dart/simulation/RangeSensor.h"
 #include "dart/simulation/World.h"
 
 using namespace dart;
@@ -154,6 +157,108 @@ TEST(WORLD, ADDING_AND_REMOVING_SKELETONS)
     delete world;
 }
 
+/******************************************************************************/
+TEST(WORLD, PARALLEL_STEPPING)
+{
+    const size_t numSkeletons = 8;
+    const int nSteps = 50;
+
+    World* serialWorld = new World;
+    World* parallelWorld = new World;
+    parallelWorld->setNumThreads(4);
+    EXPECT_EQ(parallelWorld->getNumThreads(), 4u);
+
+    for (size_t i = 0; i < numSkeletons; ++i)
+    {
+        Skeleton* skel1 = createNLinkRobot(3 + i, Vector3d(0.3, 0.3, 1.0),
+                                           DOF_ROLL);
+        Skeleton* skel2 = createNLinkRobot(3 + i, Vector3d(0.3, 0.3, 1.0),
+                                           DOF_ROLL);
+        serialWorld->addSkeleton(skel1);
+        parallelWorld->addSkeleton(skel2);
+
+        Eigen::VectorXd q = Eigen::VectorXd::Constant(skel1->getNumDofs(),
+                                                      0.1 * (i + 1));
+        skel1->setPositions(q);
+        skel2->setPositions(q);
+        skel1->computeForwardKinematics(true, true, false);
+        skel2->computeForwardKinematics(true, true, false);
+    }
+
+    for (int i = 0; i < nSteps; ++i)
+    {
+        serialWorld->step();
+        parallelWorld->step();
+    }
+
+    // The parallel path must give bit-identical results to the serial one
+    for (size_t i = 0; i < numSkeletons; ++i)
+    {
+        Skeleton* skel1 = serialWorld->getSkeleton(i);
+        Skeleton* skel2 = parallelWorld->getSkeleton(i);
+        for (size_t j = 0; j < skel1->getNumDofs(); ++j)
+        {
+            EXPECT_EQ(skel1->getPosition(j), skel2->getPosition(j));
+            EXPECT_EQ(skel1->getVelocity(j), skel2->getVelocity(j));
+        }
+    }
+
+    delete serialWorld;
+    delete parallelWorld;
+}
+
+/******************************************************************************/
+TEST(WORLD, RANGE_SENSOR)
+{
+    World* world = new World;
+    world->setGravity(Eigen::Vector3d::Zero());
+
+    Skeleton* box = createBox(Eigen::Vector3d::Ones(),
+                              Eigen::Vector3d(2.0, 0.0, 0.0));
+    world->addSkeleton(box);
+
+    // A planar scanner at the origin with one ray per degree
+    SimpleFrame frame(Frame::World(), "sensor");
+    RangeSensor sensor(&frame);
+    world->addSensor(&sensor);
+    EXPECT_EQ(world->getNumSensors(), 1u);
+    EXPECT_EQ(world->getSensor(0), &sensor);
+    EXPECT_EQ(sensor.getNumRows(), 1u);
+    EXPECT_EQ(sensor.getNumColumns(), 360u);
+
+    world->step();
+
+    // The ray along the x-axis hits the box
+    const collision::RayHit& hit = sensor.getHit(0, 180);
+    EXPECT_TRUE(hit.isHit);
+    EXPECT_NEAR(hit.distance, 1.5, 1e-6);
+    EXPECT_EQ(hit.bodyNode, box->getBodyNode(0));
+
+    // The opposite ray does not hit anything
+    EXPECT_FALSE(sensor.getHit(0, 0).isHit);
+    Eigen::MatrixXd ranges = sensor.getRanges();
+    EXPECT_EQ(ranges(0, 0), sensor.getMaxRange());
+    EXPECT_NEAR(ranges(0, 180), 1.5, 1e-6);
+
+    // The sensor follows its frame
+    Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+    transform.translation() = Eigen::Vector3d(0.5, 0.0, 0.0);
+    frame.setRelativeTransform(transform);
+    world->step();
+    EXPECT_NEAR(sensor.getHit(0, 180).distance, 1.0, 1e-6);
+
+    // Withdrawn skeletons are not scanned any more
+    world->withdrawSkeleton(box);
+    world->step();
+    EXPECT_FALSE(sensor.getHit(0, 180).isHit);
+
+    world->removeSensor(&sensor);
+    EXPECT_EQ(world->getNumSensors(), 0u);
+
+    delete world;
+    delete box;
+}
+
 /******************************************************************************/
 int main(int argc, char* argv[])
 {